@@ -0,0 +1,149 @@
+// Batch admission benchmark: thread limit only, an in-order byte semaphore, and the admission queue
+// Build: c++ -O2 -std=c++17 -pthread -Ilib bench/byte_budget_bench.cc lib/byte_budget.cc -o build/byte_budget_bench
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "byte_budget.h"
+
+// Screenshots and 200-megapixel scans; work time grows with size
+const size_t kInputs = 200;
+const size_t kSmallBytes = 8u << 20;
+const size_t kLargeBytes = 800u << 20;
+const size_t kBudget = 1024u << 20;
+const int kThreads = 8;
+const double kSmallMs = 2.0;
+const double kLargeMs = 30.0;
+
+struct Input {
+    size_t bytes;
+    double work_ms;
+};
+
+enum Policy { kThreadsOnly, kInOrder, kAdmission };
+
+struct Run {
+    double elapsed_ms = 0.0;
+    size_t peak_bytes = 0;
+    double small_p50_ms = 0.0;
+    double small_p90_ms = 0.0;
+    size_t deferred = 0;
+    bool complete = false;
+};
+
+static size_t EstimateInput(void* context, size_t index) {
+    return static_cast<const std::vector<Input>*>(context)->at(index).bytes;
+}
+
+// Counting semaphore over worker threads
+struct Slots {
+    std::mutex mutex;
+    std::condition_variable freed;
+    int available = kThreads;
+
+    void Take() {
+        std::unique_lock<std::mutex> lock(mutex);
+        freed.wait(lock, [this] { return available > 0; });
+        available--;
+    }
+
+    void Give() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            available++;
+        }
+        freed.notify_one();
+    }
+};
+
+static Run RunBatch(const std::vector<Input>& inputs, Policy policy) {
+    Run run;
+    OCRByteBudget* budget = ocr_byte_budget_create(policy == kThreadsOnly ? 0 : kBudget);
+    OCRAdmission* admission = ocr_admission_create(budget, inputs.size(), EstimateInput, (void*)&inputs);
+    if (!budget || !admission) {
+        ocr_admission_free(admission);
+        ocr_byte_budget_free(budget);
+        return run;
+    }
+
+    Slots slots;
+    std::vector<std::thread> workers;
+    std::vector<double> finished(inputs.size(), -1.0);
+    std::atomic<size_t> done(0);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    size_t next = 0;
+    while (true) {
+        size_t index;
+        size_t bytes;
+        if (policy == kAdmission) {
+            if (!ocr_admission_next(admission, &index, &bytes)) break;
+        } else {
+            if (next == inputs.size()) break;
+            index = next++;
+            bytes = inputs[index].bytes;
+            ocr_byte_budget_acquire(budget, bytes);
+        }
+        slots.Take();
+        workers.emplace_back([&, index, bytes] {
+            std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(inputs[index].work_ms));
+            finished[index] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            ocr_byte_budget_release(budget, bytes);
+            done++;
+            slots.Give();
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    run.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    run.peak_bytes = ocr_byte_budget_peak(budget);
+    ocr_admission_stats(admission, &run.deferred, NULL);
+
+    std::vector<double> small;
+    run.complete = done.load() == inputs.size();
+    for (size_t i = 0; i < inputs.size(); i++) {
+        run.complete = run.complete && finished[i] >= 0.0;
+        if (inputs[i].bytes == kSmallBytes) small.push_back(finished[i]);
+    }
+    std::sort(small.begin(), small.end());
+    run.small_p50_ms = small[small.size() / 2];
+    run.small_p90_ms = small[small.size() * 9 / 10];
+
+    ocr_admission_free(admission);
+    ocr_byte_budget_free(budget);
+    return run;
+}
+
+int main() {
+    std::vector<Input> inputs;
+    for (size_t i = 0; i < kInputs; i++) {
+        // Large scans come in a burst of four, as when a folder of scans sits among screenshots
+        bool large = i % 50 < 4;
+        inputs.push_back({large ? kLargeBytes : kSmallBytes, large ? kLargeMs : kSmallMs});
+    }
+
+    const char* names[] = {"threads only", "byte semaphore", "admission queue"};
+    Run runs[3];
+    for (int policy = kThreadsOnly; policy <= kAdmission; policy++) {
+        runs[policy] = RunBatch(inputs, (Policy)policy);
+        printf("%-16s peak %5zu MB, %6.1f ms total, screenshots done by p50 %6.1f ms / p90 %6.1f ms, %zu set aside\n",
+               names[policy], runs[policy].peak_bytes >> 20, runs[policy].elapsed_ms, runs[policy].small_p50_ms,
+               runs[policy].small_p90_ms, runs[policy].deferred);
+    }
+
+    bool ok = runs[kThreadsOnly].complete && runs[kInOrder].complete && runs[kAdmission].complete &&
+              runs[kThreadsOnly].peak_bytes > kBudget && runs[kInOrder].peak_bytes <= kBudget &&
+              runs[kAdmission].peak_bytes <= kBudget && runs[kAdmission].deferred > 0 &&
+              runs[kAdmission].small_p90_ms < runs[kInOrder].small_p90_ms;
+    if (!ok) {
+        fprintf(stderr, "admission exceeded the budget, lost an input or held screenshots behind scans\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,132 @@
+// Fast-then-accurate cascade benchmark with a simulated two-speed recognizer
+// Build: c++ -O2 -std=c++17 -Ilib bench/cascade_bench.cc lib/cascade.cc lib/region_util.cc -o build/cascade_bench
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "cascade.h"
+
+// Relative cost per unit of recognized area; Vision's accurate path is several times slower
+static const double kFastCost = 1.0;
+static const double kAccurateCost = 5.0;
+static const double kAspectRatio = 1.0;  // word boxes are laid out in a square page
+
+struct Word {
+    std::string text;
+    double x;
+    double y;
+    double width;
+    double height;
+    bool hard;  // misread with low confidence by the fast pass
+};
+
+// Fake recognizer: the fast pass garbles hard words, the accurate pass reads every
+// word whose center lies in the region. Cost is charged per unit of region area
+struct FakeRecognizer {
+    std::vector<Word> words;
+    double cost = 0.0;
+    size_t calls = 0;
+};
+
+static bool Recognize(void* context, OCRRecognitionLevel level, const OCRRegion* region,
+                      TextObservation** observations, size_t* count) {
+    FakeRecognizer* recognizer = static_cast<FakeRecognizer*>(context);
+    bool fast = level == OCR_RECOGNITION_LEVEL_FAST;
+    recognizer->cost += region->width * region->height * (fast ? kFastCost : kAccurateCost);
+    recognizer->calls++;
+
+    std::vector<TextObservation> found;
+    for (const Word& word : recognizer->words) {
+        double cx = word.x + word.width * 0.5;
+        double cy = word.y + word.height * 0.5;
+        if (cx < region->x || cx > region->x + region->width || cy < region->y || cy > region->y + region->height) {
+            continue;
+        }
+        bool garbled = fast && word.hard;
+        TextObservation obs = {};
+        obs.text = strdup(garbled ? "?" : word.text.c_str());
+        obs.confidence = garbled ? 0.3 : 1.0;
+        obs.x = word.x;
+        obs.y = word.y;
+        obs.width = word.width;
+        obs.height = word.height;
+        found.push_back(obs);
+    }
+
+    *observations = NULL;
+    *count = found.size();
+    if (!found.empty()) {
+        *observations = static_cast<TextObservation*>(malloc(sizeof(TextObservation) * found.size()));
+        memcpy(*observations, found.data(), sizeof(TextObservation) * found.size());
+    }
+    return true;
+}
+
+// A page of rows x columns words, one in every `hard_every` misread by the fast pass
+static std::vector<Word> MakePage(size_t rows, size_t columns, size_t hard_every, std::mt19937& rng) {
+    std::uniform_int_distribution<size_t> pick(0, hard_every - 1);
+    std::vector<Word> words;
+    double row_height = 1.0 / rows;
+    double column_width = 1.0 / columns;
+    for (size_t r = 0; r < rows; r++) {
+        for (size_t c = 0; c < columns; c++) {
+            Word word;
+            word.text = "w" + std::to_string(r * columns + c);
+            word.x = c * column_width + column_width * 0.1;
+            word.y = 1.0 - (r + 1) * row_height + row_height * 0.2;
+            word.width = column_width * 0.8;
+            word.height = row_height * 0.6;
+            word.hard = hard_every > 0 && pick(rng) == 0;
+            words.push_back(word);
+        }
+    }
+    return words;
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 20;
+    std::mt19937 rng(11);
+    // rows, columns, one hard word in every N (1 = all hard, forcing a full accurate pass)
+    const size_t pages[][3] = {{40, 8, 1000000}, {40, 8, 50}, {40, 8, 10}, {40, 8, 1}, {200, 20, 25}};
+
+    for (const auto& page : pages) {
+        FakeRecognizer recognizer;
+        recognizer.words = MakePage(page[0], page[1], page[2], rng);
+        double total_ms = 0.0;
+        OCRCascadeStats stats;
+
+        for (int i = 0; i < iterations; i++) {
+            recognizer.cost = 0.0;
+            recognizer.calls = 0;
+            TextObservation* observations = NULL;
+            size_t count = 0;
+
+            auto start = std::chrono::steady_clock::now();
+            bool ok = ocr_cascade_recognize(0.5, kAspectRatio, Recognize, &recognizer, &observations, &count, &stats);
+            auto end = std::chrono::steady_clock::now();
+            total_ms += std::chrono::duration<double, std::milli>(end - start).count();
+
+            size_t correct = 0;
+            for (size_t j = 0; j < count; j++) {
+                correct += observations[j].confidence >= 0.5 && observations[j].text[0] == 'w';
+            }
+            if (!ok || count != recognizer.words.size() || correct != count) {
+                fprintf(stderr, "unexpected merge: %zu observations, %zu correct (expected %zu)\n",
+                        count, correct, recognizer.words.size());
+                return 1;
+            }
+            ocr_observations_free(observations, count);
+        }
+
+        printf("%6zu words, %4zu escalated: %3zu regions%s, cost %.2fx of accurate-only, %.3f ms/page\n",
+               recognizer.words.size(), stats.escalated_count, stats.region_count,
+               stats.image_escalated ? " (full image)" : "", recognizer.cost / kAccurateCost,
+               total_ms / iterations);
+    }
+    return 0;
+}
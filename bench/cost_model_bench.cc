@@ -0,0 +1,81 @@
+// Latency budget planning benchmark against a simulated machine
+// Build: c++ -O2 -std=c++17 -Ilib bench/cost_model_bench.cc lib/cost_model.cc -o build/cost_model_bench
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "cost_model.h"
+
+// True costs of the simulated machine, deliberately far from the built-in priors
+struct Machine {
+    double overhead_ms[2];
+    double ns_per_pixel[2];
+};
+
+static double Run(const Machine& machine, OCRRecognitionLevel level, double pixels, std::mt19937& rng) {
+    std::lognormal_distribution<double> noise(0.0, 0.15);
+    size_t i = level == OCR_RECOGNITION_LEVEL_FAST ? 0 : 1;
+    return (machine.overhead_ms[i] + machine.ns_per_pixel[i] * pixels / 1e6) * noise(rng);
+}
+
+int main(int argc, char** argv) {
+    int calls = argc > 1 ? atoi(argv[1]) : 2000;
+    const int warmup = 50;
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<int> side(600, 4000);
+    const Machine machines[] = {
+        {{10.0, 70.0}, {20.0, 200.0}},   // slower than the priors
+        {{5.0, 20.0}, {8.0, 40.0}},      // faster than the priors
+    };
+    const double budgets[] = {100.0, 300.0, 1000.0};
+
+    for (const Machine& machine : machines) {
+        for (double budget : budgets) {
+            OCRCostModel* model = ocr_cost_model_create();
+            int met = 0;
+            int feasible = 0;
+            int accurate = 0;
+            int downscaled = 0;
+            double plan_ns = 0.0;
+
+            for (int call = 0; call < calls; call++) {
+                size_t width = side(rng);
+                size_t height = side(rng);
+
+                auto start = std::chrono::steady_clock::now();
+                OCRCostPlan plan = ocr_cost_model_plan(model, budget, width, height);
+                auto end = std::chrono::steady_clock::now();
+                plan_ns += std::chrono::duration<double, std::nano>(end - start).count();
+
+                double pixels = (double)width * height * plan.scale * plan.scale;
+                double elapsed = Run(machine, plan.level, pixels, rng);
+                ocr_cost_model_record(model, plan.level, pixels, elapsed);
+
+                if (call >= warmup && plan.within_budget) {
+                    feasible++;
+                    met += elapsed <= budget;
+                    accurate += plan.level == OCR_RECOGNITION_LEVEL_ACCURATE;
+                    downscaled += plan.scale < 1.0;
+                }
+            }
+            ocr_cost_model_free(model);
+
+            double hit_rate = feasible > 0 ? (double)met / feasible : 1.0;
+            printf("machine %.0f/%.0f ns/px, budget %5.0f ms: %5.1f%% within budget, %5.1f%% accurate, "
+                   "%5.1f%% downscaled, plan %.0f ns\n",
+                   machine.ns_per_pixel[0], machine.ns_per_pixel[1], budget, hit_rate * 100.0,
+                   feasible > 0 ? 100.0 * accurate / feasible : 0.0,
+                   feasible > 0 ? 100.0 * downscaled / feasible : 0.0, plan_ns / calls);
+            // Noise alone puts plans sitting right at the budget over it about half the time,
+            // so a converged model still misses a few percent
+            if (hit_rate < 0.8) {
+                fprintf(stderr, "model failed to converge\n");
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,184 @@
+// Incremental frame OCR benchmark with a simulated screen and recognizer
+// Build: c++ -O2 -std=c++17 -Ilib bench/frame_diff_bench.cc lib/frame_diff.cc lib/cascade.cc lib/region_util.cc -o build/frame_diff_bench
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "frame_diff.h"
+
+struct Word {
+    std::string text;
+    double x;
+    double y;
+    double width;
+    double height;
+};
+
+// Screen of rows x columns words; each word is drawn as a block whose pixels
+// depend on its text, so editing a word changes exactly its own pixels
+struct Screen {
+    size_t width;
+    size_t height;
+    std::vector<Word> words;
+    std::vector<uint8_t> pixels;
+    size_t edits = 0;
+
+    void Draw(const Word& word) {
+        size_t x0 = (size_t)(word.x * width);
+        size_t x1 = (size_t)((word.x + word.width) * width);
+        size_t y0 = (size_t)((1.0 - word.y - word.height) * height);
+        size_t y1 = (size_t)((1.0 - word.y) * height);
+        uint32_t seed = (uint32_t)std::hash<std::string>()(word.text);
+        for (size_t y = y0; y < y1; y++) {
+            for (size_t x = x0; x < x1; x++) {
+                uint32_t value = seed ^ (uint32_t)(x * 2654435761u) ^ (uint32_t)(y * 40503u);
+                memcpy(&pixels[(y * width + x) * 4], &value, 4);
+            }
+        }
+    }
+};
+
+static Screen MakeScreen(size_t width, size_t height, size_t rows, size_t columns) {
+    Screen screen;
+    screen.width = width;
+    screen.height = height;
+    screen.pixels.assign(width * height * 4, 0xFF);
+    double row_height = 1.0 / rows;
+    double column_width = 1.0 / columns;
+    for (size_t r = 0; r < rows; r++) {
+        for (size_t c = 0; c < columns; c++) {
+            Word word;
+            word.text = "w" + std::to_string(r * columns + c);
+            word.x = c * column_width + column_width * 0.1;
+            word.y = 1.0 - (r + 1) * row_height + row_height * 0.2;
+            word.width = column_width * 0.8;
+            word.height = row_height * 0.6;
+            screen.words.push_back(word);
+            screen.Draw(word);
+        }
+    }
+    return screen;
+}
+
+struct FakeRecognizer {
+    const Screen* screen = NULL;
+    double area = 0.0;
+};
+
+// Reads every word centered in the region; cost is the recognized area
+static bool Recognize(void* context, OCRRecognitionLevel level, const OCRRegion* region,
+                      TextObservation** observations, size_t* count) {
+    (void)level;
+    FakeRecognizer* recognizer = static_cast<FakeRecognizer*>(context);
+    recognizer->area += region->width * region->height;
+
+    std::vector<TextObservation> found;
+    for (const Word& word : recognizer->screen->words) {
+        double cx = word.x + word.width * 0.5;
+        double cy = word.y + word.height * 0.5;
+        if (cx < region->x || cx > region->x + region->width || cy < region->y || cy > region->y + region->height) {
+            continue;
+        }
+        TextObservation obs = {};
+        obs.text = strdup(word.text.c_str());
+        obs.confidence = 1.0;
+        obs.x = word.x;
+        obs.y = word.y;
+        obs.width = word.width;
+        obs.height = word.height;
+        found.push_back(obs);
+    }
+
+    *observations = NULL;
+    *count = found.size();
+    if (!found.empty()) {
+        *observations = static_cast<TextObservation*>(malloc(sizeof(TextObservation) * found.size()));
+        memcpy(*observations, found.data(), sizeof(TextObservation) * found.size());
+    }
+    return true;
+}
+
+static bool Matches(const Screen& screen, const TextObservation* observations, size_t count) {
+    if (count != screen.words.size()) {
+        return false;
+    }
+    std::vector<std::string> expected, actual;
+    for (const Word& word : screen.words) expected.push_back(word.text);
+    for (size_t i = 0; i < count; i++) actual.push_back(observations[i].text);
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    return expected == actual;
+}
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? atoi(argv[1]) : 200;
+    std::mt19937 rng(17);
+    // words edited per frame: a blinking cursor, someone typing, a scrolling log
+    const size_t edits_per_frame[] = {1, 3, 40};
+
+    for (size_t edits : edits_per_frame) {
+        Screen screen = MakeScreen(1920, 1080, 50, 12);
+        std::uniform_int_distribution<size_t> pick(0, screen.words.size() - 1);
+        OCRFrameDiff* diff = ocr_frame_diff_create(0);
+        FakeRecognizer recognizer;
+        recognizer.screen = &screen;
+        TextObservation* previous = NULL;
+        size_t previous_count = 0;
+        double diff_ms = 0.0;
+        double area = 0.0;
+        size_t full_frames = 0;
+
+        for (int frame = 0; frame < frames; frame++) {
+            if (frame > 0) {
+                for (size_t e = 0; e < edits; e++) {
+                    Word& word = screen.words[pick(rng)];
+                    word.text = "e" + std::to_string(screen.edits++);
+                    screen.Draw(word);
+                }
+            }
+
+            OCRFrameDelta delta = {};
+            auto start = std::chrono::steady_clock::now();
+            bool ok = ocr_frame_diff_update(diff, screen.pixels.data(), screen.width, screen.height,
+                                            screen.width * 4, &delta);
+            auto end = std::chrono::steady_clock::now();
+            if (frame > 0) {
+                diff_ms += std::chrono::duration<double, std::milli>(end - start).count();
+            }
+
+            recognizer.area = 0.0;
+            TextObservation* observations = NULL;
+            size_t count = 0;
+            ok = ok && ocr_frame_merge(previous, previous_count, OCR_RECOGNITION_LEVEL_ACCURATE, Recognize,
+                                       &recognizer, &delta, &observations, &count);
+            if (!ok || !Matches(screen, observations, count) ||
+                delta.carried_count + delta.added_count != count) {
+                fprintf(stderr, "frame %d: %zu observations do not match the %zu words on screen\n",
+                        frame, count, screen.words.size());
+                return 1;
+            }
+            if (frame > 0) {
+                area += recognizer.area;
+                full_frames += delta.full_frame;
+            }
+            ocr_frame_delta_free(&delta);
+            ocr_observations_free(previous, previous_count);
+            previous = observations;
+            previous_count = count;
+        }
+        ocr_observations_free(previous, previous_count);
+        ocr_frame_diff_free(diff);
+
+        double mb = (double)screen.pixels.size() / (1024.0 * 1024.0);
+        printf("%3zu edits/frame: diff %.3f ms/frame (%.1f GB/s), recognized %5.1f%% of the screen, %zu full frames\n",
+               edits, diff_ms / (frames - 1), mb * (frames - 1) / diff_ms, 100.0 * area / (frames - 1),
+               full_frames);
+    }
+    return 0;
+}
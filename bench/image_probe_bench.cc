@@ -0,0 +1,271 @@
+// Image header probing and signature sniffing benchmark with a mutation fuzz pass over PNG, JPEG,
+// TIFF and GIF headers
+// Build: c++ -O2 -std=c++17 -Ilib bench/image_probe_bench.cc lib/image_probe.cc lib/ocr_error.cc -o build/image_probe_bench
+// Add -fsanitize=address,undefined to check the fuzz pass for out-of-bounds reads
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "image_probe.h"
+
+typedef std::vector<uint8_t> Bytes;
+
+static void Put16(Bytes& out, uint32_t value, bool little_endian) {
+    if (little_endian) {
+        out.push_back(value & 0xFF);
+        out.push_back(value >> 8 & 0xFF);
+    } else {
+        out.push_back(value >> 8 & 0xFF);
+        out.push_back(value & 0xFF);
+    }
+}
+
+static void Put32(Bytes& out, uint32_t value, bool little_endian) {
+    if (little_endian) {
+        Put16(out, value & 0xFFFF, true);
+        Put16(out, value >> 16, true);
+    } else {
+        Put16(out, value >> 16, false);
+        Put16(out, value & 0xFFFF, false);
+    }
+}
+
+static void PutChunk(Bytes& out, const char* type, const Bytes& data) {
+    Put32(out, (uint32_t)data.size(), false);
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    Put32(out, 0, false);  // CRC, not checked by the probe
+}
+
+// Animated PNG, 16-bit RGBA, with image data padding standing in for pixels
+static Bytes MakePng(size_t payload) {
+    Bytes out = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    Bytes header;
+    Put32(header, 3000, false);
+    Put32(header, 2000, false);
+    header.insert(header.end(), {16, 6, 0, 0, 0});
+    PutChunk(out, "IHDR", header);
+    PutChunk(out, "tEXt", Bytes(40, 'x'));
+    Bytes control;
+    Put32(control, 12, false);
+    Put32(control, 0, false);
+    PutChunk(out, "acTL", control);
+    PutChunk(out, "IDAT", Bytes(payload, 0));
+    PutChunk(out, "IEND", Bytes());
+    return out;
+}
+
+// Baseline JPEG whose frame header follows a 30 KB EXIF segment, as in camera files
+static Bytes MakeJpeg(size_t payload) {
+    Bytes out = {0xFF, 0xD8, 0xFF, 0xE1};
+    Put16(out, 30000, false);
+    out.insert(out.end(), 30000 - 2, 0);
+    out.insert(out.end(), {0xFF, 0xFF, 0xC0});  // a fill byte before the marker
+    Put16(out, 17, false);
+    out.push_back(8);
+    Put16(out, 3024, false);
+    Put16(out, 4032, false);
+    out.push_back(3);
+    out.insert(out.end(), 9, 0);
+    out.insert(out.end(), {0xFF, 0xDA});
+    Put16(out, 2, false);
+    out.insert(out.end(), payload, 0);
+    out.insert(out.end(), {0xFF, 0xD9});
+    return out;
+}
+
+// Multi-page TIFF; the first directory holds the tags, the others only chain
+static Bytes MakeTiff(bool little_endian, size_t pages) {
+    Bytes out;
+    if (little_endian) {
+        out.insert(out.end(), {'I', 'I', '*', 0});
+    } else {
+        out.insert(out.end(), {'M', 'M', 0, '*'});
+    }
+    Put32(out, 8, little_endian);
+    for (size_t page = 0; page < pages; page++) {
+        // Width as LONG, height and samples as SHORT, BitsPerSample as a SHORT array at an offset
+        const uint32_t entries = 4;
+        size_t directory = out.size();
+        size_t next = directory + 2 + entries * 12 + 4 + 6;
+        Put16(out, entries, little_endian);
+        Put16(out, 256, little_endian); Put16(out, 4, little_endian); Put32(out, 1, little_endian); Put32(out, 2480, little_endian);
+        Put16(out, 257, little_endian); Put16(out, 3, little_endian); Put32(out, 1, little_endian);
+        Put16(out, 3508, little_endian); Put16(out, 0, little_endian);
+        Put16(out, 258, little_endian); Put16(out, 3, little_endian); Put32(out, 3, little_endian);
+        Put32(out, (uint32_t)(directory + 2 + entries * 12 + 4), little_endian);
+        Put16(out, 277, little_endian); Put16(out, 3, little_endian); Put32(out, 1, little_endian);
+        Put16(out, 3, little_endian); Put16(out, 0, little_endian);
+        Put32(out, page + 1 < pages ? (uint32_t)next : 0, little_endian);
+        Put16(out, 16, little_endian); Put16(out, 16, little_endian); Put16(out, 16, little_endian);
+    }
+    return out;
+}
+
+// GIF with a global table, a comment extension and three frames, one with a local table
+static Bytes MakeGif() {
+    Bytes out = {'G', 'I', 'F', '8', '9', 'a'};
+    Put16(out, 640, true);
+    Put16(out, 480, true);
+    out.insert(out.end(), {0xF7, 0, 0});
+    out.insert(out.end(), 3 * 256, 0);
+    out.insert(out.end(), {0x21, 0xFE, 5, 'h', 'e', 'l', 'l', 'o', 0});
+    for (int frame = 0; frame < 3; frame++) {
+        out.push_back(0x2C);
+        Put16(out, 0, true); Put16(out, 0, true); Put16(out, 640, true); Put16(out, 480, true);
+        bool local = frame == 1;
+        out.push_back(local ? 0x81 : 0);
+        if (local) out.insert(out.end(), 12, 0);
+        out.push_back(8);
+        out.insert(out.end(), {4, 1, 2, 3, 4, 2, 5, 6, 0});
+    }
+    out.push_back(0x3B);
+    return out;
+}
+
+struct Sample {
+    const char* name;
+    Bytes data;
+    OCRImageFormat format;
+    size_t width;
+    size_t height;
+    int bits;
+    int components;
+    size_t frames;
+};
+
+int main() {
+    std::vector<Sample> samples = {
+        {"png", MakePng(1 << 20), OCR_IMAGE_FORMAT_PNG, 3000, 2000, 16, 4, 12},
+        {"jpeg", MakeJpeg(1 << 20), OCR_IMAGE_FORMAT_JPEG, 4032, 3024, 8, 3, 1},
+        {"tiff le", MakeTiff(true, 5), OCR_IMAGE_FORMAT_TIFF, 2480, 3508, 16, 3, 5},
+        {"tiff be", MakeTiff(false, 1), OCR_IMAGE_FORMAT_TIFF, 2480, 3508, 16, 3, 1},
+        {"gif", MakeGif(), OCR_IMAGE_FORMAT_GIF, 640, 480, 8, 1, 3},
+    };
+    bool ok = true;
+
+    for (const Sample& sample : samples) {
+        OCRImageInfo info;
+        bool probed = ocr_image_probe(sample.data.data(), sample.data.size(), &info);
+        bool match = probed && info.format == sample.format && info.width == sample.width &&
+                     info.height == sample.height && info.bits_per_component == sample.bits &&
+                     info.components == sample.components && info.frame_count == sample.frames;
+        ok = ok && match && ocr_image_sniff(sample.data.data(), OCR_IMAGE_SIGNATURE_BYTES) == sample.format;
+
+        const int iterations = 100000;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            ocr_image_probe(sample.data.data(), sample.data.size(), &info);
+        }
+        double elapsed_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        printf("%-8s %zux%zu, %2d bits x %d, %2zu frames, %6.1f MB decoded, probe %.0f ns %s\n", sample.name,
+               info.width, info.height, info.bits_per_component, info.components, info.frame_count,
+               ocr_image_decoded_bytes(&info) / 1e6, elapsed_ns / iterations, match ? "" : "WRONG");
+    }
+
+    // Files are mapped, so probing a large file costs the same as a small one
+    std::string path = "build/image_probe_bench.tmp";
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file) {
+        Bytes large = MakeJpeg(64 << 20);
+        fwrite(large.data(), 1, large.size(), file);
+        fclose(file);
+        OCRImageInfo info;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        bool probed = ocr_image_probe_file(path.c_str(), &info, NULL);
+        double elapsed_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        printf("64 MB file probed in %.0f us\n", elapsed_us);
+        ok = ok && probed && info.width == 4032;
+
+        // Read by signature although the name says otherwise
+        void* contents = NULL;
+        size_t length = 0;
+        OCRImageFormat format = OCR_IMAGE_FORMAT_UNKNOWN;
+        start = std::chrono::steady_clock::now();
+        OCRErrorCode code = ocr_image_read_file(path.c_str(), &contents, &length, &format);
+        elapsed_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        printf("64 MB file read in %.0f us\n", elapsed_us);
+        ok = ok && code == OCR_OK && format == OCR_IMAGE_FORMAT_JPEG && length == large.size() &&
+             memcmp(contents, large.data(), length) == 0;
+        free(contents);
+
+        // Other formats are refused from the signature alone
+        file = fopen(path.c_str(), "wb");
+        if (file) {
+            fputs("not an image, despite any extension", file);
+            fclose(file);
+            ok = ok && ocr_image_read_file(path.c_str(), &contents, &length, NULL) == OCR_ERROR_UNSUPPORTED_FORMAT &&
+                 !contents;
+        }
+        remove(path.c_str());
+    }
+    OCRImageInfo missing_info;
+    OCRErrorCode probe_error = OCR_OK;
+    ok = ok && !ocr_image_probe_file("build/does-not-exist.png", &missing_info, &probe_error) &&
+         probe_error == OCR_ERROR_FILE_NOT_FOUND;
+    void* contents = NULL;
+    size_t length = 0;
+    ok = ok && ocr_image_read_file("build/does-not-exist.png", &contents, &length, NULL) == OCR_ERROR_FILE_NOT_FOUND &&
+         ocr_image_read_file("build", &contents, &length, NULL) == OCR_ERROR_FILE_NOT_FOUND;
+
+    // Signatures of the formats the probe leaves to the decoder, and text that starts alike
+    const struct {
+        const char* bytes;
+        size_t length;
+        OCRImageFormat format;
+    } signatures[] = {
+        {"RIFF\x10\0\0\0WEBPVP8 ", 16, OCR_IMAGE_FORMAT_WEBP},
+        {"\0\0\0\x18" "ftypheic\0\0\0\0", 16, OCR_IMAGE_FORMAT_HEIF},
+        {"\0\0\0\x1c" "ftypavif\0\0\0\0", 16, OCR_IMAGE_FORMAT_HEIF},
+        {"BM6\0\x0c\0\0\0\0\0\x36\0", 12, OCR_IMAGE_FORMAT_BMP},
+        {"\0\0\0\x18" "ftypmp42\0\0\0\0", 16, OCR_IMAGE_FORMAT_UNKNOWN},
+        {"BMW drivers manual", 18, OCR_IMAGE_FORMAT_UNKNOWN},
+        {"RIFF\x10\0\0\0WAVEfmt ", 16, OCR_IMAGE_FORMAT_UNKNOWN},
+        {"GIF8", 4, OCR_IMAGE_FORMAT_UNKNOWN},
+    };
+    for (const auto& signature : signatures) {
+        ok = ok && ocr_image_sniff(signature.bytes, signature.length) == signature.format;
+    }
+
+    // Fuzz: every truncation, then random byte flips over the header region
+    std::mt19937 rng(7);
+    size_t accepted = 0;
+    size_t runs = 0;
+    for (const Sample& sample : samples) {
+        size_t header = std::min(sample.data.size(), (size_t)40000);
+        for (size_t length = 0; length <= header; length += length < 2048 ? 1 : 97) {
+            Bytes copy(sample.data.begin(), sample.data.begin() + length);
+            OCRImageInfo info;
+            accepted += ocr_image_probe(copy.data(), copy.size(), &info);
+            runs++;
+        }
+        std::uniform_int_distribution<size_t> position(0, std::min(header, (size_t)2048) - 1);
+        std::uniform_int_distribution<int> byte(0, 255);
+        for (int i = 0; i < 20000; i++) {
+            Bytes copy(sample.data.begin(), sample.data.begin() + header);
+            for (int flips = 1 + i % 8; flips > 0; flips--) {
+                copy[position(rng)] = (uint8_t)byte(rng);
+            }
+            OCRImageInfo info;
+            if (ocr_image_probe(copy.data(), copy.size(), &info)) {
+                accepted++;
+                ok = ok && info.width > 0 && info.height > 0 && ocr_image_decoded_bytes(&info) > 0;
+            }
+            runs++;
+        }
+    }
+    printf("fuzz: %zu inputs, %zu accepted\n", runs, accepted);
+
+    if (!ok) {
+        fprintf(stderr, "image probe misread a header\n");
+        return 1;
+    }
+    return 0;
+}
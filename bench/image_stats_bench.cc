@@ -0,0 +1,106 @@
+// Blank page detection benchmark on simulated downsampled scans
+// Build: c++ -O2 -std=c++17 -Ilib bench/image_stats_bench.cc lib/image_stats.cc -o build/image_stats_bench
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "image_stats.h"
+
+// A letter page drawn at most 512 pixels on a side, as ocr.mm checks it
+const size_t kWidth = 396;
+const size_t kHeight = 512;
+
+// Same defaults as OCROptions
+const double kMinStddev = 1.0;
+const double kMinEdgeDensity = 0.0002;
+
+// Paper with scanner noise, uneven illumination and a few dust specks
+static std::vector<uint8_t> MakePaper(std::mt19937& rng, int base) {
+    std::vector<uint8_t> gray(kWidth * kHeight);
+    std::normal_distribution<double> noise(0.0, 2.5);
+    for (size_t y = 0; y < kHeight; y++) {
+        for (size_t x = 0; x < kWidth; x++) {
+            double shade = base - 10.0 * y / kHeight + 4.0 * x / kWidth + noise(rng);
+            gray[y * kWidth + x] = (uint8_t)std::clamp(shade, 0.0, 255.0);
+        }
+    }
+    std::uniform_int_distribution<size_t> px(0, kWidth * kHeight - 1);
+    for (int i = 0; i < 12; i++) {
+        gray[px(rng)] = (uint8_t)std::max(0, base - 60);
+    }
+    return gray;
+}
+
+// A word of thin glyph strokes at the size of body text on a downsampled page
+static void DrawWord(std::vector<uint8_t>& gray, size_t x0, size_t y0, int glyphs) {
+    for (int g = 0; g < glyphs; g++) {
+        size_t gx = x0 + g * 5;
+        for (size_t y = y0; y < y0 + 7 && y < kHeight; y++) {
+            for (size_t x = gx; x < gx + 3 && x < kWidth; x++) {
+                bool stroke = x == gx || x == gx + 2 || y == y0 + 3 || (g % 2 && y == y0);
+                if (stroke) {
+                    gray[y * kWidth + x] = 90;
+                }
+            }
+        }
+    }
+}
+
+int main() {
+    std::mt19937 rng(42);
+    struct Page {
+        const char* name;
+        std::vector<uint8_t> gray;
+        bool blank;
+    };
+    std::vector<Page> pages;
+    pages.push_back({"white separator", MakePaper(rng, 232), true});
+    pages.push_back({"grey separator", MakePaper(rng, 150), true});
+    pages.push_back({"black separator", MakePaper(rng, 24), true});
+    std::vector<uint8_t> flat(kWidth * kHeight, 255);
+    pages.push_back({"digital white", flat, true});
+
+    std::vector<uint8_t> number(kWidth * kHeight, 255);
+    DrawWord(number, kWidth / 2, kHeight - 30, 2);
+    pages.push_back({"clean page number", number, false});
+    std::vector<uint8_t> word = MakePaper(rng, 232);
+    DrawWord(word, 40, 40, 6);
+    pages.push_back({"single word", word, false});
+    std::vector<uint8_t> text = MakePaper(rng, 232);
+    for (size_t y = 40; y + 12 < kHeight - 40; y += 12) {
+        for (size_t x = 40; x + 40 < kWidth - 40; x += 45) {
+            DrawWord(text, x, y, 7);
+        }
+    }
+    pages.push_back({"text page", text, false});
+
+    size_t wrong = 0;
+    for (const Page& page : pages) {
+        OCRImageStats stats;
+        ocr_image_stats(page.gray.data(), kWidth, kHeight, kWidth, &stats);
+        bool blank = ocr_image_is_blank(&stats, kMinStddev, kMinEdgeDensity);
+        wrong += blank != page.blank;
+        printf("%-18s mean %6.1f  stddev %5.2f  edge density %.5f  -> %s%s\n", page.name, stats.mean, stats.stddev,
+               stats.edge_density, blank ? "blank" : "recognize", blank != page.blank ? "  (WRONG)" : "");
+    }
+
+    const int rounds = 2000;
+    OCRImageStats stats;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        ocr_image_stats(pages[i % pages.size()].gray.data(), kWidth, kHeight, kWidth, &stats);
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("stats over %zux%zu: %.3f ms/page (%.0f Mpixel/s)\n", kWidth, kHeight, ms / rounds,
+           (double)kWidth * kHeight * rounds / 1e6 / (ms / 1000.0));
+
+    if (wrong > 0) {
+        fprintf(stderr, "%zu pages misclassified with the default thresholds\n", wrong);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+// Layout reconstruction benchmark on synthetic dense pages
+// Build: c++ -O2 -std=c++17 -Ilib bench/layout_bench.cc lib/layout.cc -o build/layout_bench
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "layout.h"
+
+struct Page {
+    std::vector<std::string> words;
+    std::vector<TextObservation> observations;
+    size_t expected_lines = 0;
+};
+
+// Two columns of paragraphs, several words per line, small vertical jitter
+static Page MakePage(size_t lines_per_column, size_t words_per_line, std::mt19937& rng) {
+    Page page;
+    std::uniform_real_distribution<double> jitter(-0.0002, 0.0002);
+    double line_height = 0.9 / lines_per_column;
+    double glyph_height = line_height * 0.7;
+    double word_width = glyph_height * 3.0;
+    double word_advance = glyph_height * 3.4;
+    double column_width = word_advance * words_per_line;
+    double gutter = glyph_height * 4.0;
+
+    page.words.reserve(2 * lines_per_column * words_per_line);
+    for (int column = 0; column < 2; column++) {
+        double left = 0.05 + column * (column_width + gutter);
+        double top = 0.95;
+        for (size_t line = 0; line < lines_per_column; line++) {
+            if (line > 0 && line % 8 == 0) {
+                top -= line_height;  // paragraph break
+            }
+            double bottom = top - glyph_height;
+            for (size_t word = 0; word < words_per_line; word++) {
+                page.words.push_back("c" + std::to_string(column) + "l" + std::to_string(line) + "w" + std::to_string(word));
+                TextObservation obs;
+                obs.text = NULL;
+                obs.confidence = 1.0;
+                obs.x = left + word * word_advance;
+                obs.y = bottom + jitter(rng);
+                obs.width = word_width;
+                obs.height = glyph_height;
+                page.observations.push_back(obs);
+            }
+            page.expected_lines++;
+            top -= line_height;
+        }
+    }
+    for (size_t i = 0; i < page.observations.size(); i++) {
+        page.observations[i].text = page.words[i].c_str();
+    }
+    std::shuffle(page.observations.begin(), page.observations.end(), rng);
+    return page;
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 20;
+    std::mt19937 rng(42);
+    const size_t sizes[][2] = {{50, 10}, {200, 10}, {500, 20}, {1000, 50}};
+
+    for (const auto& size : sizes) {
+        Page page = MakePage(size[0], size[1], rng);
+        std::vector<TextObservation> work;
+        OCRLayout layout;
+        double total_ms = 0.0;
+
+        for (int i = 0; i < iterations; i++) {
+            work = page.observations;
+            auto start = std::chrono::steady_clock::now();
+            bool ok = ocr_layout_build(work.data(), work.size(), &layout);
+            char* text = ok ? ocr_layout_join_text(work.data(), &layout) : NULL;
+            auto end = std::chrono::steady_clock::now();
+            total_ms += std::chrono::duration<double, std::milli>(end - start).count();
+
+            if (!ok || !text || layout.line_count != page.expected_lines || layout.column_count != 2 ||
+                std::string(work[0].text) != "c0l0w0") {
+                fprintf(stderr, "unexpected layout: %zu lines (expected %zu), %zu columns\n",
+                        layout.line_count, page.expected_lines, layout.column_count);
+                return 1;
+            }
+            free(text);
+            ocr_layout_free(&layout);
+        }
+
+        printf("%8zu observations: %9.3f ms/page\n", page.observations.size(), total_ms / iterations);
+    }
+    return 0;
+}
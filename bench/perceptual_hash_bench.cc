@@ -0,0 +1,114 @@
+// Perceptual hash benchmark on simulated video frames with compression noise
+// Build: c++ -O2 -std=c++17 -Ilib bench/perceptual_hash_bench.cc lib/perceptual_hash.cc -o build/perceptual_hash_bench
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "perceptual_hash.h"
+
+const size_t kWidth = 1280;
+const size_t kHeight = 720;
+
+// A slide: light background with dark text-like strokes in random lines
+static std::vector<uint8_t> MakeSlide(std::mt19937& rng) {
+    std::vector<uint8_t> pixels(kWidth * kHeight * 4, 235);
+    std::uniform_int_distribution<int> lines(4, 14);
+    std::uniform_int_distribution<int> words(2, 9);
+    std::uniform_int_distribution<int> length(30, 160);
+    std::uniform_int_distribution<int> gap(10, 40);
+    int line_count = lines(rng);
+    for (int l = 0; l < line_count; l++) {
+        size_t y0 = 40 + l * (kHeight - 80) / line_count;
+        size_t x = 40;
+        int word_count = words(rng);
+        for (int w = 0; w < word_count && x < kWidth - 40; w++) {
+            size_t x1 = std::min(kWidth - 40, x + length(rng));
+            for (size_t y = y0; y < y0 + 24 && y < kHeight; y++) {
+                for (size_t px = x; px < x1; px++) {
+                    uint8_t* p = &pixels[(y * kWidth + px) * 4];
+                    p[0] = p[1] = p[2] = ((px / 3 + y / 2) % 3) ? 30 : 120;
+                }
+            }
+            x = x1 + gap(rng);
+        }
+    }
+    return pixels;
+}
+
+// Re-encoding noise: small per-channel jitter plus an occasional brightness shift
+static std::vector<uint8_t> AddNoise(const std::vector<uint8_t>& source, std::mt19937& rng) {
+    std::uniform_int_distribution<int> jitter(-6, 6);
+    std::uniform_int_distribution<int> shift(-4, 4);
+    int offset = shift(rng);
+    std::vector<uint8_t> pixels(source.size());
+    for (size_t i = 0; i < source.size(); i++) {
+        pixels[i] = (uint8_t)std::clamp((int)source[i] + offset + jitter(rng), 0, 255);
+    }
+    return pixels;
+}
+
+int main(int argc, char** argv) {
+    int slides = argc > 1 ? atoi(argv[1]) : 40;
+    const int copies = 4;
+    const int max_distance = 3;
+    std::mt19937 rng(23);
+
+    std::vector<std::vector<uint8_t>> frames;
+    std::vector<int> truth;
+    for (int s = 0; s < slides; s++) {
+        std::vector<uint8_t> slide = MakeSlide(rng);
+        for (int c = 0; c < copies; c++) {
+            frames.push_back(AddNoise(slide, rng));
+            truth.push_back(s);
+        }
+    }
+
+    std::vector<uint64_t> hashes(frames.size());
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < frames.size(); i++) {
+        hashes[i] = ocr_perceptual_hash(frames[i].data(), kWidth, kHeight, kWidth * 4);
+    }
+    double hash_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    int same_max = 0;
+    int different_min = 64;
+    for (size_t i = 0; i < frames.size(); i++) {
+        for (size_t j = i + 1; j < frames.size(); j++) {
+            int distance = ocr_hash_distance(hashes[i], hashes[j]);
+            if (truth[i] == truth[j]) {
+                same_max = std::max(same_max, distance);
+            } else {
+                different_min = std::min(different_min, distance);
+            }
+        }
+    }
+
+    OCRDuplicateIndex* index = ocr_duplicate_index_create(max_distance);
+    size_t skipped = 0;
+    size_t wrong = 0;
+    for (size_t i = 0; i < frames.size(); i++) {
+        size_t original = 0;
+        if (ocr_duplicate_index_match(index, hashes[i], i, &original)) {
+            skipped++;
+            wrong += truth[original] != truth[i];
+        }
+    }
+    ocr_duplicate_index_free(index);
+
+    double mpix = (double)kWidth * kHeight * frames.size() / 1e6;
+    printf("%zu frames of %zux%zu: hash %.3f ms/frame (%.0f Mpixel/s)\n", frames.size(), kWidth, kHeight,
+           hash_ms / frames.size(), mpix / (hash_ms / 1000.0));
+    printf("distance between noisy copies <= %d, between different slides >= %d\n", same_max, different_min);
+    printf("max distance %d: skipped %zu of %zu frames (%zu expected), %zu wrong matches\n", max_distance,
+           skipped, frames.size(), (size_t)(slides * (copies - 1)), wrong);
+    if (wrong > 0 || skipped < (size_t)(slides * (copies - 1)) * 9 / 10) {
+        fprintf(stderr, "duplicate detection is unreliable at this distance\n");
+        return 1;
+    }
+    return 0;
+}
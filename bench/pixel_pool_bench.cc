@@ -0,0 +1,153 @@
+// Pixel pool benchmark against malloc: decode-sized buffers filled and freed by several threads
+// Build: c++ -O2 -std=c++17 -pthread -Ilib bench/pixel_pool_bench.cc lib/pixel_pool.cc -o build/pixel_pool_bench
+// Page faults come from getrusage and resident size from /proc, so the comparison is meant for Linux
+
+#include <sys/resource.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "pixel_pool.h"
+
+const int kThreads = 8;
+const int kIterations = 150;
+
+// RGBA sizes of common screenshots, with an occasional A4 scan at 300 dpi
+const size_t kSizes[] = {
+    1440 * 900 * 4, 1920 * 1080 * 4, 2560 * 1600 * 4, 2880 * 1800 * 4, 1170 * 2532 * 4, 2480 * 3508 * 4,
+};
+const size_t kSizeWeights[] = {4, 6, 3, 3, 4, 1};
+
+struct Run {
+    double elapsed_ms = 0.0;
+    long page_faults = 0;
+    long resident_mb = -1;
+    uint64_t checksum = 0;
+};
+
+// Resident set size in MB, -1 where /proc is not available
+static long ResidentMegabytes() {
+    FILE* file = fopen("/proc/self/statm", "r");
+    if (!file) {
+        return -1;
+    }
+    long pages = 0;
+    long resident = 0;
+    int read = fscanf(file, "%ld %ld", &pages, &resident);
+    fclose(file);
+    return read == 2 ? resident * 4096 / (1 << 20) : -1;
+}
+
+static long PageFaults() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_minflt;
+}
+
+// Each iteration stands for one decode: take a buffer, write every byte, read a few back.
+// Half of the buffers are handed to another thread to free, as data providers do
+static Run RunWorkload(OCRPixelPool* pool) {
+    Run run;
+    std::atomic<void*> handoff(nullptr);
+    std::atomic<uint64_t> checksum(0);
+    long faults = PageFaults();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&, t] {
+            std::mt19937 rng(t + 1);
+            std::discrete_distribution<size_t> pick(std::begin(kSizeWeights), std::end(kSizeWeights));
+            uint64_t sum = 0;
+            for (int i = 0; i < kIterations; i++) {
+                size_t bytes = kSizes[pick(rng)];
+                uint8_t* pixels = static_cast<uint8_t*>(pool ? ocr_pixel_pool_acquire(pool, bytes) : malloc(bytes));
+                if (!pixels) {
+                    continue;
+                }
+                memset(pixels, (int)(i & 0xFF), bytes);
+                sum += pixels[0] + pixels[bytes / 2] + pixels[bytes - 1];
+                if (i % 2 == 0) {
+                    pixels = static_cast<uint8_t*>(handoff.exchange(pixels));
+                }
+                if (pool) {
+                    ocr_pixel_pool_release(pool, pixels);
+                } else {
+                    free(pixels);
+                }
+            }
+            checksum += sum;
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    void* last = handoff.exchange(nullptr);
+    if (pool) {
+        ocr_pixel_pool_release(pool, last);
+    } else {
+        free(last);
+    }
+
+    run.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    run.page_faults = PageFaults() - faults;
+    run.resident_mb = ResidentMegabytes();
+    run.checksum = checksum.load();
+    return run;
+}
+
+int main() {
+    bool ok = true;
+
+    // Every request gets an aligned buffer of at least its size; ASAN catches writes past it
+    OCRPixelPool* pool = ocr_pixel_pool_create((size_t)1 << 30);
+    if (!pool) {
+        return 1;
+    }
+    for (size_t bytes : {(size_t)0, (size_t)1, (size_t)16384, (size_t)16385, (size_t)20480, (size_t)20481, (size_t)1 << 20,
+                         ((size_t)1 << 20) + 1, (size_t)3000 * 2000 * 4}) {
+        uint8_t* buffer = static_cast<uint8_t*>(ocr_pixel_pool_acquire(pool, bytes));
+        ok = ok && buffer && (uintptr_t)buffer % 64 == 0;
+        if (buffer && bytes > 0) {
+            buffer[bytes - 1] = 1;
+        }
+        ocr_pixel_pool_release(pool, buffer);
+    }
+    ocr_pixel_pool_trim(pool, 0);
+
+    Run plain = RunWorkload(NULL);
+    Run pooled = RunWorkload(pool);
+    OCRPixelPoolStats stats;
+    ocr_pixel_pool_stats(pool, &stats);
+    printf("malloc  %7.1f ms, %8ld page faults, resident after %5ld MB\n", plain.elapsed_ms, plain.page_faults,
+           plain.resident_mb);
+    printf("pool    %7.1f ms, %8ld page faults, resident after %5ld MB\n", pooled.elapsed_ms, pooled.page_faults,
+           pooled.resident_mb);
+    printf("pool    %zu acquired, %.1f%% reused, high water %zu MB, %zu MB cached\n", stats.acquired,
+           stats.acquired ? 100.0 * stats.reused / stats.acquired : 0.0, stats.high_water_bytes >> 20,
+           stats.cached_bytes >> 20);
+
+    size_t cached = stats.cached_bytes;
+    size_t freed = ocr_pixel_pool_trim(pool, 0);
+    OCRPixelPoolStats trimmed;
+    ocr_pixel_pool_stats(pool, &trimmed);
+    long resident = ResidentMegabytes();
+    printf("trim    %zu MB freed, resident %ld MB\n", freed >> 20, resident);
+
+    ok = ok && plain.checksum == pooled.checksum && stats.in_use_bytes == 0 && stats.reused * 2 > stats.acquired &&
+         pooled.page_faults < plain.page_faults && freed == cached && trimmed.cached_bytes == 0;
+    ocr_pixel_pool_free(pool);
+
+    if (!ok) {
+        fprintf(stderr, "pixel pool lost a buffer, reused too little or faulted more than malloc\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,168 @@
+// Preprocessing kernel benchmark against scalar references on a simulated page scan
+// Build: c++ -O2 -std=c++17 -Ilib bench/preprocess_bench.cc lib/preprocess.cc -o build/preprocess_bench
+// Add -mavx2 to measure the AVX2 gray conversion
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "preprocess.h"
+
+// A4 at 300 dpi
+const size_t kWidth = 2480;
+const size_t kHeight = 3508;
+const int kRounds = 5;
+
+// A faded scan: grey-blue paper, washed-out text strokes and sensor noise
+static std::vector<uint8_t> MakeScan() {
+    std::mt19937 rng(7);
+    std::normal_distribution<double> noise(0.0, 3.0);
+    std::vector<uint8_t> rgba(kWidth * kHeight * 4);
+    for (size_t y = 0; y < kHeight; y++) {
+        bool text_row = (y / 40) % 2 == 1 && y > 200 && y < kHeight - 200;
+        for (size_t x = 0; x < kWidth; x++) {
+            bool ink = text_row && x > 200 && x < kWidth - 200 && (x / 4 + y / 9) % 5 == 0;
+            double level = (ink ? 120.0 : 205.0) + noise(rng);
+            uint8_t* p = &rgba[(y * kWidth + x) * 4];
+            p[0] = (uint8_t)std::clamp(level - 6.0, 0.0, 255.0);
+            p[1] = (uint8_t)std::clamp(level, 0.0, 255.0);
+            p[2] = (uint8_t)std::clamp(level + 10.0, 0.0, 255.0);
+            p[3] = 255;
+        }
+    }
+    return rgba;
+}
+
+static void ReferenceGray(const std::vector<uint8_t>& rgba, std::vector<uint8_t>& gray) {
+    for (size_t i = 0; i < kWidth * kHeight; i++) {
+        const uint8_t* p = &rgba[i * 4];
+        gray[i] = (uint8_t)((77 * p[0] + 150 * p[1] + 29 * p[2] + 128) >> 8);
+    }
+}
+
+// Exact area average in floating point
+static void ReferenceResize(const std::vector<uint8_t>& src, size_t dst_width, size_t dst_height,
+                            std::vector<double>& dst) {
+    double sx = (double)kWidth / dst_width;
+    double sy = (double)kHeight / dst_height;
+    for (size_t i = 0; i < dst_height; i++) {
+        for (size_t j = 0; j < dst_width; j++) {
+            double y0 = i * sy, y1 = y0 + sy, x0 = j * sx, x1 = x0 + sx;
+            double sum = 0.0;
+            for (size_t y = (size_t)y0; y < y1 && y < kHeight; y++) {
+                double wy = std::min(y1, y + 1.0) - std::max(y0, (double)y);
+                for (size_t x = (size_t)x0; x < x1 && x < kWidth; x++) {
+                    double wx = std::min(x1, x + 1.0) - std::max(x0, (double)x);
+                    sum += wx * wy * src[y * kWidth + x];
+                }
+            }
+            dst[i * dst_width + j] = sum / (sx * sy);
+        }
+    }
+}
+
+// Percentile stretch with the same clipping and 8.8 fixed-point scale as the kernel
+static void ReferenceStretch(std::vector<uint8_t>& gray, double clip) {
+    std::vector<uint64_t> histogram(256);
+    for (uint8_t level : gray) {
+        histogram[level]++;
+    }
+    uint64_t clipped = (uint64_t)(clip * gray.size());
+    int low = 0;
+    for (uint64_t below = histogram[0]; below <= clipped; below += histogram[++low]) {
+    }
+    int high = 255;
+    for (uint64_t above = histogram[255]; above <= clipped; above += histogram[--high]) {
+    }
+    uint32_t scale = (255 * 256 + (high - low) / 2) / (high - low);
+    for (uint8_t& level : gray) {
+        level = (uint8_t)std::min(255u, ((uint32_t)std::max(0, level - low) * scale) >> 8);
+    }
+}
+
+template <typename F>
+static double TimeMs(F f) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kRounds; i++) {
+        f();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / kRounds;
+}
+
+int main() {
+    std::vector<uint8_t> rgba = MakeScan();
+    std::vector<uint8_t> gray(kWidth * kHeight);
+    std::vector<uint8_t> expected(kWidth * kHeight);
+    double mpix = kWidth * kHeight / 1e6;
+    bool ok = true;
+
+    double reference_ms = TimeMs([&] { ReferenceGray(rgba, expected); });
+    double gray_ms = TimeMs([&] { ocr_rgba_to_gray(rgba.data(), kWidth, kHeight, kWidth * 4, gray.data(), kWidth); });
+    bool gray_equal = gray == expected;
+    ok = ok && gray_equal;
+    printf("rgba->gray       %7.2f ms (%5.0f Mpixel/s), scalar %7.2f ms, %.1fx, %s\n", gray_ms, mpix / gray_ms * 1000,
+           reference_ms, reference_ms / gray_ms, gray_equal ? "identical" : "MISMATCH");
+
+    // Downscale factors seen when fitting scans to a latency budget
+    const double factors[] = {0.5, 0.37, 0.25};
+    for (double factor : factors) {
+        size_t dst_width = (size_t)std::lround(kWidth * factor);
+        size_t dst_height = (size_t)std::lround(kHeight * factor);
+        std::vector<uint8_t> small(dst_width * dst_height);
+        double resize_ms = TimeMs([&] {
+            ocr_resize_area(gray.data(), kWidth, kHeight, kWidth, small.data(), dst_width, dst_height, dst_width);
+        });
+        std::vector<double> exact(dst_width * dst_height);
+        ReferenceResize(gray, dst_width, dst_height, exact);
+        double max_error = 0.0;
+        for (size_t i = 0; i < small.size(); i++) {
+            max_error = std::max(max_error, std::fabs(small[i] - exact[i]));
+        }
+        // Fixed-point weights and the final rounding stay within a level of the exact mean
+        ok = ok && max_error <= 1.0;
+        printf("resize x%.2f     %7.2f ms (%5.0f Mpixel/s in), max error %.2f levels\n", factor, resize_ms,
+               mpix / resize_ms * 1000, max_error);
+    }
+
+    std::vector<uint8_t> stretched = gray;
+    double stretch_ms = TimeMs([&] {
+        stretched = gray;
+        ocr_normalize_contrast(stretched.data(), kWidth, kHeight, kWidth, 0.005);
+    });
+    std::vector<uint8_t> reference = gray;
+    ReferenceStretch(reference, 0.005);
+    bool stretch_equal = stretched == reference;
+    uint8_t low = *std::min_element(stretched.begin(), stretched.end());
+    uint8_t high = *std::max_element(stretched.begin(), stretched.end());
+    uint8_t in_low = *std::min_element(gray.begin(), gray.end());
+    uint8_t in_high = *std::max_element(gray.begin(), gray.end());
+    ok = ok && stretch_equal && low == 0 && high == 255;
+    printf("contrast         %7.2f ms (%5.0f Mpixel/s, includes copy), range %u-%u -> %u-%u, %s\n", stretch_ms,
+           mpix / stretch_ms * 1000, in_low, in_high, low, high, stretch_equal ? "identical" : "MISMATCH");
+
+    // A two-level row with clipped outliers: the scale is near its maximum, and outliers far
+    // above the low level must saturate to white rather than wrap
+    std::vector<uint8_t> narrow(1024);
+    for (size_t i = 0; i < narrow.size(); i++) {
+        narrow[i] = 100 + i % 2;
+    }
+    narrow[17] = 250;
+    narrow[900] = 250;
+    std::vector<uint8_t> narrow_reference = narrow;
+    ocr_normalize_contrast(narrow.data(), narrow.size(), 1, narrow.size(), 0.005);
+    ReferenceStretch(narrow_reference, 0.005);
+    bool narrow_equal = narrow == narrow_reference && narrow[17] == 255 && narrow[900] == 255;
+    ok = ok && narrow_equal;
+    printf("contrast narrow  levels 100-101 with outliers at 250 -> %u, %s\n", narrow[17],
+           narrow_equal ? "identical" : "MISMATCH");
+
+    if (!ok) {
+        fprintf(stderr, "preprocessing kernels disagree with the references\n");
+        return 1;
+    }
+    return 0;
+}
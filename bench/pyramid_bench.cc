@@ -0,0 +1,224 @@
+// Pyramid recognition benchmark with a simulated resolution-limited recognizer
+// Build: c++ -O2 -std=c++17 -Ilib bench/pyramid_bench.cc lib/pyramid.cc lib/cascade.cc lib/region_util.cc -o build/pyramid_bench
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "pyramid.h"
+
+// A poster: mostly empty, a few headlines, a block of body text and small captions
+const size_t kWidth = 6000;
+const size_t kHeight = 4000;
+const double kDetectScale = 0.25;
+
+// Text is found from about 3 pixels of height, but only read from 8
+const double kMinDetectPixels = 3.0;
+const double kMinReadPixels = 8.0;
+
+// Relative cost of a recognition: a fixed per-request part plus a part per megapixel
+const double kCallCost = 0.05;
+const double kMegapixelCost = 1.0;
+
+struct Word {
+    std::string text;
+    double x;
+    double y;
+    double width;
+    double height;
+};
+
+struct FakeRecognizer {
+    std::vector<Word> words;
+    std::mt19937 rng{11};
+    double cost = 0.0;
+    size_t calls = 0;
+};
+
+static void Charge(FakeRecognizer& recognizer, double pixels) {
+    recognizer.cost += kCallCost + pixels / 1e6 * kMegapixelCost;
+    recognizer.calls++;
+}
+
+static TextObservation MakeObservation(const char* text, double x, double y, double width, double height) {
+    TextObservation obs = {};
+    obs.text = strdup(text);
+    obs.confidence = 1.0;
+    obs.x = x;
+    obs.y = y;
+    obs.width = width;
+    obs.height = height;
+    return obs;
+}
+
+static void Publish(const std::vector<TextObservation>& found, TextObservation** observations, size_t* count) {
+    *observations = NULL;
+    *count = found.size();
+    if (!found.empty()) {
+        *observations = static_cast<TextObservation*>(malloc(sizeof(TextObservation) * found.size()));
+        memcpy(*observations, found.data(), sizeof(TextObservation) * found.size());
+    }
+}
+
+// Whole image at the given scale: words at least min_pixels tall are returned, with
+// boxes as loose as one downscaled pixel when detecting
+static void RecognizeImage(FakeRecognizer& recognizer, double scale, bool detect, TextObservation** observations,
+                           size_t* count) {
+    double width = kWidth * scale;
+    double height = kHeight * scale;
+    Charge(recognizer, width * height);
+    std::uniform_real_distribution<double> jitter(-1.0, 1.0);
+    std::vector<TextObservation> found;
+    for (const Word& word : recognizer.words) {
+        if (word.height * height < (detect ? kMinDetectPixels : kMinReadPixels)) {
+            continue;
+        }
+        double dx = detect ? jitter(recognizer.rng) / width : 0.0;
+        double dy = detect ? jitter(recognizer.rng) / height : 0.0;
+        found.push_back(MakeObservation(detect ? "?" : word.text.c_str(), word.x + dx, word.y + dy, word.width,
+                                        word.height));
+    }
+    Publish(found, observations, count);
+}
+
+// Full-resolution crop: words lying wholly inside are read, in crop-relative coordinates
+static void RecognizeCrop(FakeRecognizer& recognizer, const OCRRegion& region, TextObservation** observations,
+                          size_t* count) {
+    Charge(recognizer, region.width * kWidth * region.height * kHeight);
+    std::vector<TextObservation> found;
+    for (const Word& word : recognizer.words) {
+        bool inside = word.x >= region.x && word.y >= region.y && word.x + word.width <= region.x + region.width &&
+                      word.y + word.height <= region.y + region.height;
+        if (!inside || word.height * kHeight < kMinReadPixels) {
+            continue;
+        }
+        found.push_back(MakeObservation(word.text.c_str(), (word.x - region.x) / region.width,
+                                        (word.y - region.y) / region.height, word.width / region.width,
+                                        word.height / region.height));
+    }
+    Publish(found, observations, count);
+}
+
+static void AddLines(std::vector<Word>& words, const char* prefix, double x, double y, size_t lines, size_t per_line,
+                     double line_pixels) {
+    double height = line_pixels / kHeight;
+    double word_width = line_pixels * 3.0 / kWidth;
+    for (size_t l = 0; l < lines; l++) {
+        for (size_t w = 0; w < per_line; w++) {
+            words.push_back({std::string(prefix) + std::to_string(l) + "-" + std::to_string(w),
+                             x + w * word_width * 1.3, y - l * height * 1.6, word_width, height});
+        }
+    }
+}
+
+// Words read, each exactly once and at its true position
+static size_t CountCorrect(const std::vector<Word>& words, const TextObservation* observations, size_t count,
+                           bool* exact) {
+    size_t correct = 0;
+    std::vector<bool> seen(words.size(), false);
+    for (size_t i = 0; i < count; i++) {
+        const TextObservation& obs = observations[i];
+        for (size_t w = 0; w < words.size(); w++) {
+            if (words[w].text != obs.text) {
+                continue;
+            }
+            bool placed = std::fabs(obs.x - words[w].x) < 1e-9 && std::fabs(obs.y - words[w].y) < 1e-9 &&
+                          std::fabs(obs.width - words[w].width) < 1e-9 && std::fabs(obs.height - words[w].height) < 1e-9;
+            if (seen[w] || !placed) {
+                *exact = false;
+            } else {
+                seen[w] = true;
+                correct++;
+            }
+        }
+    }
+    return correct;
+}
+
+int main() {
+    FakeRecognizer recognizer;
+    AddLines(recognizer.words, "title", 0.10, 0.90, 2, 4, 120.0);
+    AddLines(recognizer.words, "body", 0.55, 0.60, 18, 8, 24.0);
+    AddLines(recognizer.words, "caption", 0.08, 0.30, 2, 5, 20.0);
+    AddLines(recognizer.words, "footnote", 0.70, 0.05, 1, 6, 14.0);
+    const size_t total = recognizer.words.size();
+    bool ok = true;
+
+    // Full resolution everywhere
+    TextObservation* full = NULL;
+    size_t full_count = 0;
+    RecognizeImage(recognizer, 1.0, false, &full, &full_count);
+    bool full_exact = true;
+    size_t full_correct = CountCorrect(recognizer.words, full, full_count, &full_exact);
+    double full_cost = recognizer.cost;
+    ocr_observations_free(full, full_count);
+
+    // Detection resolution only
+    recognizer.cost = 0.0;
+    TextObservation* small = NULL;
+    size_t small_count = 0;
+    RecognizeImage(recognizer, kDetectScale, false, &small, &small_count);
+    bool small_exact = true;
+    size_t small_correct = CountCorrect(recognizer.words, small, small_count, &small_exact);
+    double small_cost = recognizer.cost;
+    ocr_observations_free(small, small_count);
+
+    // Pyramid: detect small, read the planned crops at full resolution
+    recognizer.cost = 0.0;
+    recognizer.calls = 0;
+    TextObservation* detected = NULL;
+    size_t detected_count = 0;
+    RecognizeImage(recognizer, kDetectScale, true, &detected, &detected_count);
+    double detect_cost = recognizer.cost;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    OCRRegion* regions = NULL;
+    size_t region_count = 0;
+    double covered = 0.0;
+    ok = ok && ocr_pyramid_plan(detected, detected_count, kWidth, kHeight, &regions, &region_count, &covered);
+    double plan_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    ocr_observations_free(detected, detected_count);
+
+    std::vector<TextObservation*> crops(region_count, NULL);
+    std::vector<size_t> crop_counts(region_count, 0);
+    double slowest_crop = 0.0;
+    for (size_t r = 0; r < region_count; r++) {
+        double before = recognizer.cost;
+        RecognizeCrop(recognizer, regions[r], &crops[r], &crop_counts[r]);
+        slowest_crop = std::max(slowest_crop, recognizer.cost - before);
+    }
+    double pyramid_cost = recognizer.cost;
+
+    start = std::chrono::steady_clock::now();
+    TextObservation* merged = NULL;
+    size_t merged_count = 0;
+    size_t dropped = 0;
+    ok = ok && ocr_pyramid_merge(regions, region_count, crops.data(), crop_counts.data(), 0.0, &merged, &merged_count,
+                                 &dropped);
+    double merge_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    bool pyramid_exact = true;
+    size_t pyramid_correct = CountCorrect(recognizer.words, merged, merged_count, &pyramid_exact);
+    ocr_observations_free(merged, merged_count);
+    free(regions);
+
+    printf("%zu words on a %zux%zu poster\n", total, kWidth, kHeight);
+    printf("full resolution    %3zu read, cost %6.2f\n", full_correct, full_cost);
+    printf("x%.2f only         %3zu read, cost %6.2f\n", kDetectScale, small_correct, small_cost);
+    printf("pyramid            %3zu read, cost %6.2f (%zu crops over %.1f%% of the image, %s coordinates)\n",
+           pyramid_correct, pyramid_cost, region_count, covered * 100.0, pyramid_exact ? "exact" : "WRONG");
+    printf("  in parallel: critical path %.2f; plan %.1f us, merge %.1f us\n", detect_cost + slowest_crop, plan_us,
+           merge_us);
+
+    ok = ok && full_correct == total && pyramid_correct == total && pyramid_exact && pyramid_cost < full_cost;
+    if (!ok) {
+        fprintf(stderr, "pyramid lost words, misplaced them or cost more than full resolution\n");
+        return 1;
+    }
+    return 0;
+}
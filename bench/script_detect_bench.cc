@@ -0,0 +1,93 @@
+// Script detection and language routing benchmark over mixed-script page texts
+// Build: c++ -O2 -std=c++17 -Ilib bench/script_detect_bench.cc lib/script_detect.cc -o build/script_detect_bench
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "script_detect.h"
+
+const char* kLanguages = "en-US,fr-FR,zh-Hans,zh-Hant,ja-JP,ko-KR,ru-RU";
+const double kMinShare = 0.05;
+
+struct Page {
+    const char* name;
+    const char* text;
+    const char* expected;
+};
+
+// What a script pass reads; stray Latin in the CJK pages stays under the share threshold
+const Page kPages[] = {
+    {"english", "Quarterly revenue grew 12% to $4.2M, driven by subscription renewals.", "en-US,fr-FR"},
+    {"french", "Le chiffre d'affaires a progressé de 12 % grâce aux réabonnements.", "en-US,fr-FR"},
+    {"chinese", "第三季度营业收入增长百分之十二，主要来自订阅续费。", "zh-Hans,zh-Hant"},
+    {"japanese", "第3四半期の売上高は前年同期比12%増加しました。", "ja-JP"},
+    {"korean", "3분기 매출은 구독 갱신에 힘입어 12% 증가했습니다.", "ko-KR"},
+    {"russian", "Выручка за квартал выросла на 12% благодаря продлению подписок.", "ru-RU"},
+    {"mixed", "Invoice 请款单 No. 2024-118: total amount 合计 ¥12,800", "en-US,fr-FR,zh-Hans,zh-Hant"},
+    {"japanese with a brand", "新型のiPhoneを発売しました。価格は十二万円からです。", "en-US,fr-FR,ja-JP"},
+    {"chinese with a unit", "本月用电量共计三百二十千瓦时，较上月下降百分之八，其中峰时段用电约占四成，谷时段约占六成，合计电费人民币一百八十元整，功率kW",
+     "zh-Hans,zh-Hant"},
+    {"digits only", "2024-11-18 12:30 #4471", kLanguages},
+};
+
+static size_t CountLanguages(const char* languages) {
+    size_t count = 1;
+    for (const char* c = languages; *c; c++) {
+        count += *c == ',';
+    }
+    return count;
+}
+
+int main() {
+    bool ok = true;
+    size_t configured = CountLanguages(kLanguages);
+    size_t kept = 0;
+    for (const Page& page : kPages) {
+        OCRScriptHistogram histogram = {};
+        ocr_script_count(page.text, &histogram);
+        unsigned scripts = ocr_script_detect(&histogram, kMinShare);
+        char* routed = NULL;
+        if (!ocr_route_languages(kLanguages, scripts, &routed)) {
+            fprintf(stderr, "routing failed for %s\n", page.name);
+            return 1;
+        }
+        bool match = strcmp(routed, page.expected) == 0;
+        ok = ok && match;
+        kept += CountLanguages(routed);
+        printf("%-22s %3zu letters -> %-28s %s\n", page.name, histogram.total, routed, match ? "" : "WRONG");
+        free(routed);
+    }
+    printf("languages per page: %zu configured, %.1f routed on average\n", configured,
+           (double)kept / (sizeof(kPages) / sizeof(kPages[0])));
+
+    // Counting cost over a page worth of text, which is negligible next to a recognition
+    std::string body;
+    for (int i = 0; i < 200; i++) {
+        body += kPages[i % (sizeof(kPages) / sizeof(kPages[0]))].text;
+        body += '\n';
+    }
+    const int iterations = 2000;
+    OCRScriptHistogram histogram = {};
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        ocr_script_count(body.c_str(), &histogram);
+    }
+    double elapsed_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    printf("counting: %.1f us per %zu-byte page, %.0f MB/s\n", elapsed_us / iterations, body.size(),
+           body.size() * (double)iterations / elapsed_us);
+
+    // Malformed input is skipped without reading past the terminator
+    const char malformed[] = {'a', (char)0xE4, (char)0xB8, '\0'};
+    OCRScriptHistogram broken = {};
+    ocr_script_count(malformed, &broken);
+    ok = ok && broken.total == 1 && histogram.total > 0;
+
+    if (!ok) {
+        fprintf(stderr, "script detection routed a page to the wrong languages\n");
+        return 1;
+    }
+    return 0;
+}
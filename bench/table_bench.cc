@@ -0,0 +1,71 @@
+// Table reconstruction benchmark on synthetic grid layouts
+// Build: c++ -O2 -std=c++17 -Ilib bench/table_bench.cc lib/table.cc -o build/table_bench
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "table.h"
+
+// A title spanning the whole table, then rows x columns cells of ragged width,
+// some of them split into two observations
+static std::vector<TextObservation> MakeTable(size_t rows, size_t columns, std::mt19937& rng) {
+    std::uniform_real_distribution<double> fill(0.3, 0.9);
+    std::uniform_real_distribution<double> jitter(-0.05, 0.05);
+    std::vector<TextObservation> observations;
+    double row_height = 1.0 / (rows + 2);
+    double glyph_height = row_height * 0.6;
+    double column_width = 1.0 / columns;
+
+    observations.push_back({"title", 1.0, 0.0, 1.0 - row_height, 1.0, glyph_height, NULL, 0});
+    for (size_t r = 0; r < rows; r++) {
+        double y = 1.0 - (r + 2) * row_height + jitter(rng) * glyph_height;
+        for (size_t c = 0; c < columns; c++) {
+            double width = column_width * fill(rng) * 0.8;
+            double x = c * column_width;
+            if ((r + c) % 7 == 0) {
+                observations.push_back({"cell", 1.0, x, y, width * 0.45, glyph_height, NULL, 0});
+                observations.push_back({"cell", 1.0, x + width * 0.55, y, width * 0.45, glyph_height, NULL, 0});
+            } else {
+                observations.push_back({"cell", 1.0, x, y, width, glyph_height, NULL, 0});
+            }
+        }
+    }
+    std::shuffle(observations.begin(), observations.end(), rng);
+    return observations;
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 20;
+    std::mt19937 rng(7);
+    const size_t sizes[][2] = {{20, 5}, {100, 10}, {500, 20}, {2000, 50}};
+
+    for (const auto& size : sizes) {
+        std::vector<TextObservation> observations = MakeTable(size[0], size[1], rng);
+        OCRTable table;
+        double total_ms = 0.0;
+
+        for (int i = 0; i < iterations; i++) {
+            auto start = std::chrono::steady_clock::now();
+            bool ok = ocr_table_build(observations.data(), observations.size(), &table);
+            auto end = std::chrono::steady_clock::now();
+            total_ms += std::chrono::duration<double, std::milli>(end - start).count();
+
+            size_t expected_cells = size[0] * size[1] + 1;
+            if (!ok || table.row_count != size[0] + 1 || table.column_count != size[1] ||
+                table.cell_count != expected_cells || table.cells[0].column_span != size[1]) {
+                fprintf(stderr, "unexpected grid: %zu x %zu, %zu cells (expected %zu x %zu, %zu cells)\n",
+                        table.row_count, table.column_count, table.cell_count,
+                        size[0] + 1, size[1], expected_cells);
+                return 1;
+            }
+            ocr_table_free(&table);
+        }
+
+        printf("%8zu cells: %9.3f ms/page\n", size[0] * size[1], total_ms / iterations);
+    }
+    return 0;
+}
@@ -3,7 +3,24 @@
         "target_name": "mac_system_ocr",
         "sources": [
             "lib/binding.c",
-            "lib/ocr.mm"
+            "lib/ocr.mm",
+            "lib/layout.cc",
+            "lib/spatial_index.cc",
+            "lib/table.cc",
+            "lib/inverted_index.cc",
+            "lib/cascade.cc",
+            "lib/cost_model.cc",
+            "lib/frame_diff.cc",
+            "lib/perceptual_hash.cc",
+            "lib/image_stats.cc",
+            "lib/preprocess.cc",
+            "lib/pyramid.cc",
+            "lib/region_util.cc",
+            "lib/script_detect.cc",
+            "lib/image_probe.cc",
+            "lib/byte_budget.cc",
+            "lib/pixel_pool.cc",
+            "lib/ocr_error.cc"
         ],
         "include_dirs": [
             "<!@(node -p \"require('node-api-headers').include\")"
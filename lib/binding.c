@@ -3,8 +3,8 @@
 #include <string.h>
 #include "ocr.h"
 
-extern CGImageRef CreateCGImageFromPath(const char* path, char** error);
-extern CGImageRef CreateCGImageFromBuffer(const void* buffer, size_t length, char** error);
+extern CGImageRef CreateCGImageFromPath(const char* path, OCRErrorCode* error);
+extern CGImageRef CreateCGImageFromBuffer(const void* buffer, size_t length, OCRErrorCode* error);
 
 typedef struct {
     napi_async_work work;
@@ -12,7 +12,7 @@ typedef struct {
     char* image_path;
     OCROptions options;
     OCRResult* result;
-    char* error_message;
+    OCRErrorCode error_code;
 } OCRWork;
 
 typedef struct {
@@ -22,7 +22,7 @@ typedef struct {
     size_t count;
     OCRBatchOptions options;
     OCRBatchResult* result;
-    char* error_message;
+    OCRErrorCode error_code;
 } BatchOCRWork;
 
 typedef struct {
@@ -32,7 +32,7 @@ typedef struct {
     size_t buffer_length;
     OCROptions options;
     OCRResult* result;
-    char* error_message;
+    OCRErrorCode error_code;
 } OCRBufferWork;
 
 typedef struct {
@@ -43,23 +43,459 @@ typedef struct {
     size_t count;
     OCRBatchOptions options;
     OCRBatchResult* result;
-    char* error_message;
+    OCRErrorCode error_code;
 } BatchBufferOCRWork;
 
+typedef struct {
+    napi_async_work work;
+    napi_deferred deferred;
+    OCRInput input;
+    OCROptions* option_sets;
+    size_t count;
+    OCRBatchResult* result;
+    OCRErrorCode error_code;
+} OptionSetsWork;
+
+typedef struct {
+    napi_async_work work;
+    napi_deferred deferred;
+    OCRInput* inputs;
+    size_t count;
+    OCRBatchOptions options;
+    OCRFindOptions find_options;
+    OCRFindResult* result;
+} FindTextWork;
+
+typedef struct {
+    napi_async_work work;
+    napi_deferred deferred;
+    OCRInput* inputs;
+    size_t count;
+    OCRBatchOptions options;
+    char* index_path;
+    OCRIndexBuildResult* result;
+} BuildIndexWork;
+
+// Index handles outlive closeIndex() so a closed index is detected instead of reused
+typedef struct {
+    OCRIndex* index;
+} IndexHandle;
+
+// Frame sessions closed while a frame is in flight are freed when that frame completes
+typedef struct {
+    OCRFrameSession* session;
+    size_t pending;
+    bool closed;
+} FrameSessionHandle;
+
+typedef struct {
+    napi_async_work work;
+    napi_deferred deferred;
+    FrameSessionHandle* handle;
+    napi_ref handle_ref;
+    OCRInput input;
+    OCRResult* result;
+    OCRErrorCode error_code;
+} FrameWork;
+
+// Reject with the constant message of code, and its name as error.code so callers
+// can branch on the failure without parsing the message
+static napi_value CreateCodedError(napi_env env, OCRErrorCode code) {
+    napi_value error, error_code, error_msg;
+    napi_create_string_utf8(env, ocr_error_name(code), NAPI_AUTO_LENGTH, &error_code);
+    napi_create_string_utf8(env, ocr_error_message(code), NAPI_AUTO_LENGTH, &error_msg);
+    napi_create_error(env, error_code, error_msg, &error);
+    return error;
+}
+
+static void RejectWithCode(napi_env env, napi_deferred deferred, OCRErrorCode code) {
+    napi_reject_deferred(env, deferred, CreateCodedError(env, code));
+}
+
+// For synchronous calls; the caller returns NULL afterwards
+static void ThrowWithCode(napi_env env, OCRErrorCode code) {
+    napi_throw(env, CreateCodedError(env, code));
+}
+
+static napi_value CreateLayoutNodeArray(napi_env env, const OCRLayoutNode* nodes, size_t count) {
+    napi_value array;
+    napi_create_array_with_length(env, count, &array);
+    for (size_t i = 0; i < count; i++) {
+        const OCRLayoutNode* node = &nodes[i];
+        napi_value node_obj, node_x, node_y, node_width, node_height, node_start, node_count;
+        
+        napi_create_object(env, &node_obj);
+        napi_create_double(env, node->x, &node_x);
+        napi_create_double(env, node->y, &node_y);
+        napi_create_double(env, node->width, &node_width);
+        napi_create_double(env, node->height, &node_height);
+        napi_create_uint32(env, (uint32_t)node->first, &node_start);
+        napi_create_uint32(env, (uint32_t)node->count, &node_count);
+        
+        napi_set_named_property(env, node_obj, "x", node_x);
+        napi_set_named_property(env, node_obj, "y", node_y);
+        napi_set_named_property(env, node_obj, "width", node_width);
+        napi_set_named_property(env, node_obj, "height", node_height);
+        napi_set_named_property(env, node_obj, "start", node_start);
+        napi_set_named_property(env, node_obj, "count", node_count);
+        
+        napi_set_element(env, array, i, node_obj);
+    }
+    return array;
+}
+
+static napi_value CreateTableBandArray(napi_env env, const OCRTableBand* bands, size_t count) {
+    napi_value array;
+    napi_create_array_with_length(env, count, &array);
+    for (size_t i = 0; i < count; i++) {
+        napi_value band_obj, band_start, band_end;
+        
+        napi_create_object(env, &band_obj);
+        napi_create_double(env, bands[i].start, &band_start);
+        napi_create_double(env, bands[i].end, &band_end);
+        
+        napi_set_named_property(env, band_obj, "start", band_start);
+        napi_set_named_property(env, band_obj, "end", band_end);
+        
+        napi_set_element(env, array, i, band_obj);
+    }
+    return array;
+}
+
+static napi_value CreateTableObject(napi_env env, const OCRTable* table) {
+    napi_value table_obj, rows, columns, cells;
+    napi_create_object(env, &table_obj);
+    
+    rows = CreateTableBandArray(env, table->rows, table->row_count);
+    columns = CreateTableBandArray(env, table->columns, table->column_count);
+    
+    napi_create_array_with_length(env, table->cell_count, &cells);
+    for (size_t i = 0; i < table->cell_count; i++) {
+        const OCRTableCell* cell = &table->cells[i];
+        napi_value cell_obj, cell_row, cell_column, cell_span, cell_x, cell_y, cell_width, cell_height, cell_ids;
+        
+        napi_create_object(env, &cell_obj);
+        napi_create_uint32(env, (uint32_t)cell->row, &cell_row);
+        napi_create_uint32(env, (uint32_t)cell->column, &cell_column);
+        napi_create_uint32(env, (uint32_t)cell->column_span, &cell_span);
+        napi_create_double(env, cell->x, &cell_x);
+        napi_create_double(env, cell->y, &cell_y);
+        napi_create_double(env, cell->width, &cell_width);
+        napi_create_double(env, cell->height, &cell_height);
+        napi_create_array_with_length(env, cell->count, &cell_ids);
+        for (size_t j = 0; j < cell->count; j++) {
+            napi_value id;
+            napi_create_uint32(env, (uint32_t)table->observation_ids[cell->first + j], &id);
+            napi_set_element(env, cell_ids, j, id);
+        }
+        
+        napi_set_named_property(env, cell_obj, "row", cell_row);
+        napi_set_named_property(env, cell_obj, "column", cell_column);
+        napi_set_named_property(env, cell_obj, "columnSpan", cell_span);
+        napi_set_named_property(env, cell_obj, "x", cell_x);
+        napi_set_named_property(env, cell_obj, "y", cell_y);
+        napi_set_named_property(env, cell_obj, "width", cell_width);
+        napi_set_named_property(env, cell_obj, "height", cell_height);
+        napi_set_named_property(env, cell_obj, "observations", cell_ids);
+        
+        napi_set_element(env, cells, i, cell_obj);
+    }
+    
+    napi_set_named_property(env, table_obj, "rows", rows);
+    napi_set_named_property(env, table_obj, "columns", columns);
+    napi_set_named_property(env, table_obj, "cells", cells);
+    return table_obj;
+}
+
+static void FinalizeSpatialIndex(napi_env env, void* data, void* hint) {
+    ocr_spatial_index_free((OCRSpatialIndex*)data);
+}
+
+static napi_value CreateFrameDeltaObject(napi_env env, const OCRFrameDelta* frame) {
+    napi_value delta, added, removed, regions, carried, tiles, changed_tiles, full_frame, duplicate;
+    napi_create_object(env, &delta);
+    
+    napi_create_array_with_length(env, frame->added_count, &added);
+    for (size_t i = 0; frame->added && i < frame->added_count; i++) {
+        napi_value index;
+        napi_create_uint32(env, (uint32_t)frame->added[i], &index);
+        napi_set_element(env, added, i, index);
+    }
+    
+    napi_create_array_with_length(env, frame->removed_count, &removed);
+    for (size_t i = 0; i < frame->removed_count; i++) {
+        const TextObservation* obs = &frame->removed[i];
+        napi_value obs_obj, obs_text, obs_confidence, obs_x, obs_y, obs_width, obs_height;
+        napi_create_object(env, &obs_obj);
+        napi_create_string_utf8(env, obs->text, NAPI_AUTO_LENGTH, &obs_text);
+        napi_create_double(env, obs->confidence, &obs_confidence);
+        napi_create_double(env, obs->x, &obs_x);
+        napi_create_double(env, obs->y, &obs_y);
+        napi_create_double(env, obs->width, &obs_width);
+        napi_create_double(env, obs->height, &obs_height);
+        napi_set_named_property(env, obs_obj, "text", obs_text);
+        napi_set_named_property(env, obs_obj, "confidence", obs_confidence);
+        napi_set_named_property(env, obs_obj, "x", obs_x);
+        napi_set_named_property(env, obs_obj, "y", obs_y);
+        napi_set_named_property(env, obs_obj, "width", obs_width);
+        napi_set_named_property(env, obs_obj, "height", obs_height);
+        napi_set_element(env, removed, i, obs_obj);
+    }
+    
+    napi_create_array_with_length(env, frame->region_count, &regions);
+    for (size_t i = 0; i < frame->region_count; i++) {
+        napi_value region, x, y, width, height;
+        napi_create_object(env, &region);
+        napi_create_double(env, frame->regions[i].x, &x);
+        napi_create_double(env, frame->regions[i].y, &y);
+        napi_create_double(env, frame->regions[i].width, &width);
+        napi_create_double(env, frame->regions[i].height, &height);
+        napi_set_named_property(env, region, "x", x);
+        napi_set_named_property(env, region, "y", y);
+        napi_set_named_property(env, region, "width", width);
+        napi_set_named_property(env, region, "height", height);
+        napi_set_element(env, regions, i, region);
+    }
+    
+    napi_create_uint32(env, (uint32_t)frame->carried_count, &carried);
+    napi_create_uint32(env, (uint32_t)frame->tile_count, &tiles);
+    napi_create_uint32(env, (uint32_t)frame->changed_tile_count, &changed_tiles);
+    napi_get_boolean(env, frame->full_frame, &full_frame);
+    napi_get_boolean(env, frame->duplicate, &duplicate);
+    napi_set_named_property(env, delta, "added", added);
+    napi_set_named_property(env, delta, "removed", removed);
+    napi_set_named_property(env, delta, "carried", carried);
+    napi_set_named_property(env, delta, "regions", regions);
+    napi_set_named_property(env, delta, "tiles", tiles);
+    napi_set_named_property(env, delta, "changedTiles", changed_tiles);
+    napi_set_named_property(env, delta, "fullFrame", full_frame);
+    napi_set_named_property(env, delta, "duplicate", duplicate);
+    return delta;
+}
+
+static napi_value CreateResultObject(napi_env env, OCRResult* result) {
+    napi_value obj, text, confidence, observations, lines, paragraphs, columns;
+    napi_create_object(env, &obj);
+
+    if (result && result->text) {
+        napi_create_string_utf8(env, result->text, NAPI_AUTO_LENGTH, &text);
+    } else {
+        napi_get_null(env, &text);
+    }
+    napi_set_named_property(env, obj, "text", text);
+
+    napi_create_double(env, result ? result->confidence : 0.0, &confidence);
+    napi_set_named_property(env, obj, "confidence", confidence);
+
+    // Add observations array
+    if (result && result->observations && result->observation_count > 0) {
+        napi_create_array_with_length(env, result->observation_count, &observations);
+        for (size_t i = 0; i < result->observation_count; i++) {
+            TextObservation* obs = &result->observations[i];
+            napi_value obs_obj, obs_text, obs_confidence, obs_x, obs_y, obs_width, obs_height;
+            
+            napi_create_object(env, &obs_obj);
+            napi_create_string_utf8(env, obs->text, NAPI_AUTO_LENGTH, &obs_text);
+            napi_create_double(env, obs->confidence, &obs_confidence);
+            napi_create_double(env, obs->x, &obs_x);
+            napi_create_double(env, obs->y, &obs_y);
+            napi_create_double(env, obs->width, &obs_width);
+            napi_create_double(env, obs->height, &obs_height);
+            
+            napi_set_named_property(env, obs_obj, "text", obs_text);
+            napi_set_named_property(env, obs_obj, "confidence", obs_confidence);
+            napi_set_named_property(env, obs_obj, "x", obs_x);
+            napi_set_named_property(env, obs_obj, "y", obs_y);
+            napi_set_named_property(env, obs_obj, "width", obs_width);
+            napi_set_named_property(env, obs_obj, "height", obs_height);
+            
+            if (obs->candidate_count > 0) {
+                napi_value candidates;
+                napi_create_array_with_length(env, obs->candidate_count, &candidates);
+                for (size_t c = 0; c < obs->candidate_count; c++) {
+                    napi_value candidate_obj, candidate_text, candidate_confidence;
+                    napi_create_object(env, &candidate_obj);
+                    napi_create_string_utf8(env, obs->candidates[c].text, NAPI_AUTO_LENGTH, &candidate_text);
+                    napi_create_double(env, obs->candidates[c].confidence, &candidate_confidence);
+                    napi_set_named_property(env, candidate_obj, "text", candidate_text);
+                    napi_set_named_property(env, candidate_obj, "confidence", candidate_confidence);
+                    napi_set_element(env, candidates, c, candidate_obj);
+                }
+                napi_set_named_property(env, obs_obj, "candidates", candidates);
+            }
+            
+            napi_set_element(env, observations, i, obs_obj);
+        }
+    } else {
+        napi_create_array_with_length(env, 0, &observations);
+    }
+    napi_set_named_property(env, obj, "observations", observations);
+
+    napi_value dropped;
+    napi_create_uint32(env, result ? (uint32_t)result->dropped_count : 0, &dropped);
+    napi_set_named_property(env, obj, "droppedObservations", dropped);
+
+    // The cascade always runs a fast pass or escalates an empty one, so zero stats mean it was not used
+    if (result && (result->cascade.fast_count > 0 || result->cascade.image_escalated)) {
+        napi_value cascade, fast_count, escalated_count, region_count, image_escalated;
+        napi_create_object(env, &cascade);
+        napi_create_uint32(env, (uint32_t)result->cascade.fast_count, &fast_count);
+        napi_create_uint32(env, (uint32_t)result->cascade.escalated_count, &escalated_count);
+        napi_create_uint32(env, (uint32_t)result->cascade.region_count, &region_count);
+        napi_get_boolean(env, result->cascade.image_escalated, &image_escalated);
+        napi_set_named_property(env, cascade, "fastObservations", fast_count);
+        napi_set_named_property(env, cascade, "escalatedObservations", escalated_count);
+        napi_set_named_property(env, cascade, "regions", region_count);
+        napi_set_named_property(env, cascade, "imageEscalated", image_escalated);
+        napi_set_named_property(env, obj, "cascade", cascade);
+    }
+
+    if (result && result->budget.applied) {
+        napi_value budget, level, scale, predicted, elapsed, within_budget;
+        napi_create_object(env, &budget);
+        napi_create_int32(env, (int32_t)result->budget.level, &level);
+        napi_create_double(env, result->budget.scale, &scale);
+        napi_create_double(env, result->budget.predicted_ms, &predicted);
+        napi_create_double(env, result->budget.elapsed_ms, &elapsed);
+        napi_get_boolean(env, result->budget.within_budget, &within_budget);
+        napi_set_named_property(env, budget, "recognitionLevel", level);
+        napi_set_named_property(env, budget, "scale", scale);
+        napi_set_named_property(env, budget, "predictedMs", predicted);
+        napi_set_named_property(env, budget, "elapsedMs", elapsed);
+        napi_set_named_property(env, budget, "withinBudget", within_budget);
+        napi_set_named_property(env, obj, "budget", budget);
+    }
+    
+    if (result && result->pyramid.applied) {
+        napi_value pyramid, detected, regions, covered;
+        napi_create_object(env, &pyramid);
+        napi_create_uint32(env, (uint32_t)result->pyramid.detected_count, &detected);
+        napi_create_uint32(env, (uint32_t)result->pyramid.region_count, &regions);
+        napi_create_double(env, result->pyramid.covered_area, &covered);
+        napi_set_named_property(env, pyramid, "detectedObservations", detected);
+        napi_set_named_property(env, pyramid, "regions", regions);
+        napi_set_named_property(env, pyramid, "coveredArea", covered);
+        napi_set_named_property(env, obj, "pyramid", pyramid);
+    }
+    
+    // Every recognized frame compares at least one tile, so a zero count means no frame session
+    if (result && (result->frame.tile_count > 0 || result->frame.duplicate)) {
+        napi_set_named_property(env, obj, "delta", CreateFrameDeltaObject(env, &result->frame));
+    }
+    
+    napi_value blank;
+    napi_get_boolean(env, result && result->blank, &blank);
+    napi_set_named_property(env, obj, "blank", blank);
+    
+    napi_value rotation;
+    napi_create_int32(env, result ? result->rotation : 0, &rotation);
+    napi_set_named_property(env, obj, "rotation", rotation);
+    
+    napi_value routing;
+    if (result && result->routing.applied) {
+        static const char* const script_names[OCR_SCRIPT_COUNT] = {
+            "latin", "han", "kana", "hangul", "cyrillic", "arabic", "thai"
+        };
+        napi_value scripts, languages, probe_ms, recognize_ms;
+        napi_create_object(env, &routing);
+        napi_create_array(env, &scripts);
+        uint32_t script_count = 0;
+        for (int i = 0; i < OCR_SCRIPT_COUNT; i++) {
+            if (result->routing.scripts & (1u << i)) {
+                napi_value name;
+                napi_create_string_utf8(env, script_names[i], NAPI_AUTO_LENGTH, &name);
+                napi_set_element(env, scripts, script_count++, name);
+            }
+        }
+        napi_create_string_utf8(env, result->routing.languages ? result->routing.languages : "", NAPI_AUTO_LENGTH, &languages);
+        napi_create_double(env, result->routing.probe_ms, &probe_ms);
+        napi_create_double(env, result->routing.recognize_ms, &recognize_ms);
+        napi_set_named_property(env, routing, "scripts", scripts);
+        napi_set_named_property(env, routing, "languages", languages);
+        napi_set_named_property(env, routing, "probeMs", probe_ms);
+        napi_set_named_property(env, routing, "recognizeMs", recognize_ms);
+    } else {
+        napi_get_null(env, &routing);
+    }
+    napi_set_named_property(env, obj, "routing", routing);
+    
+    napi_value duplicate_of;
+    if (result && result->duplicate) {
+        napi_create_uint32(env, (uint32_t)result->duplicate_of, &duplicate_of);
+    } else {
+        napi_get_null(env, &duplicate_of);
+    }
+    napi_set_named_property(env, obj, "duplicateOf", duplicate_of);
+    
+    // Batches report failures per input instead of rejecting; a NULL result could not be allocated
+    OCRErrorCode code = result ? result->error_code : OCR_ERROR_OUT_OF_MEMORY;
+    napi_value item_error;
+    if (code != OCR_OK) {
+        napi_value error_code, error_msg;
+        napi_create_object(env, &item_error);
+        napi_create_string_utf8(env, ocr_error_name(code), NAPI_AUTO_LENGTH, &error_code);
+        napi_create_string_utf8(env, ocr_error_message(code), NAPI_AUTO_LENGTH, &error_msg);
+        napi_set_named_property(env, item_error, "code", error_code);
+        napi_set_named_property(env, item_error, "message", error_msg);
+    } else {
+        napi_get_null(env, &item_error);
+    }
+    napi_set_named_property(env, obj, "error", item_error);
+    
+    napi_value attempts;
+    napi_create_int32(env, result && result->attempts > 0 ? result->attempts : 1, &attempts);
+    napi_set_named_property(env, obj, "attempts", attempts);
+    
+    if (result && result->hedge.launched) {
+        napi_value hedge, launched, won;
+        napi_create_object(env, &hedge);
+        napi_get_boolean(env, result->hedge.launched, &launched);
+        napi_get_boolean(env, result->hedge.won, &won);
+        napi_set_named_property(env, hedge, "launched", launched);
+        napi_set_named_property(env, hedge, "won", won);
+        napi_set_named_property(env, obj, "hedge", hedge);
+    }
+
+    // Add layout hierarchy (lines -> observations, paragraphs -> lines, columns -> paragraphs)
+    if (result) {
+        lines = CreateLayoutNodeArray(env, result->layout.lines, result->layout.line_count);
+        paragraphs = CreateLayoutNodeArray(env, result->layout.paragraphs, result->layout.paragraph_count);
+        columns = CreateLayoutNodeArray(env, result->layout.columns, result->layout.column_count);
+    } else {
+        napi_create_array_with_length(env, 0, &lines);
+        napi_create_array_with_length(env, 0, &paragraphs);
+        napi_create_array_with_length(env, 0, &columns);
+    }
+    napi_set_named_property(env, obj, "lines", lines);
+    napi_set_named_property(env, obj, "paragraphs", paragraphs);
+    napi_set_named_property(env, obj, "columns", columns);
+
+    if (result && result->table.cells) {
+        napi_value table = CreateTableObject(env, &result->table);
+        napi_set_named_property(env, obj, "table", table);
+    }
+
+    // Hand the spatial index over to JS, it is released by the garbage collector
+    if (result && result->spatial_index) {
+        napi_value spatial_index;
+        if (napi_create_external(env, result->spatial_index, FinalizeSpatialIndex, NULL, &spatial_index) == napi_ok) {
+            result->spatial_index = NULL;
+            napi_set_named_property(env, obj, "spatialIndex", spatial_index);
+        }
+    }
+
+    return obj;
+}
+
 void ExecuteOCR(napi_env env, void* data) {
     OCRWork* work = (OCRWork*)data;
     
-    char* error = NULL;
+    OCRErrorCode error = OCR_OK;
     CGImageRef image = CreateCGImageFromPath(work->image_path, &error);
     
     if (!image) {
-        if (error) {
-            work->error_message = error;
-            return;
-        } else {
-            work->error_message = strdup("Failed to create image from path");
-            return;
-        }
+        work->error_code = error != OCR_OK ? error : OCR_ERROR_DECODE_FAILED;
+        return;
     }
     
     work->result = perform_ocr(image, &work->options);
@@ -70,71 +506,19 @@ void ExecuteOCR(napi_env env, void* data) {
 void CompleteOCR(napi_env env, napi_status status, void* data) {
     OCRWork* work = (OCRWork*)data;
     
-    if (work->error_message) {
-        napi_value error, error_msg;
-        napi_create_string_utf8(env, work->error_message, NAPI_AUTO_LENGTH, &error_msg);
-        napi_create_error(env, NULL, error_msg, &error);
-        napi_reject_deferred(env, work->deferred, error);
-        free(work->error_message);
+    if (work->error_code != OCR_OK) {
+        RejectWithCode(env, work->deferred, work->error_code);
     }
     else if (work->result && work->result->error) {
-        napi_value error, error_msg;
-        napi_create_string_utf8(env, work->result->error, NAPI_AUTO_LENGTH, &error_msg);
-        napi_create_error(env, NULL, error_msg, &error);
-        napi_reject_deferred(env, work->deferred, error);
+        RejectWithCode(env, work->deferred, work->result->error_code);
     }
 
     else if (work->result) {
-        napi_value obj, text, confidence, observations;
-        napi_create_object(env, &obj);
-
-        if (work->result->text) {
-            napi_create_string_utf8(env, work->result->text, NAPI_AUTO_LENGTH, &text);
-            napi_set_named_property(env, obj, "text", text);
-        } else {
-            napi_get_null(env, &text);
-            napi_set_named_property(env, obj, "text", text);
-        }
-        
-        napi_create_double(env, work->result->confidence, &confidence);
-        napi_set_named_property(env, obj, "confidence", confidence);
-        
-        // Add observations array
-        if (work->result->observations && work->result->observation_count > 0) {
-            napi_create_array_with_length(env, work->result->observation_count, &observations);
-            for (size_t i = 0; i < work->result->observation_count; i++) {
-                TextObservation* obs = &work->result->observations[i];
-                napi_value obs_obj, obs_text, obs_confidence, obs_x, obs_y, obs_width, obs_height;
-                
-                napi_create_object(env, &obs_obj);
-                napi_create_string_utf8(env, obs->text, NAPI_AUTO_LENGTH, &obs_text);
-                napi_create_double(env, obs->confidence, &obs_confidence);
-                napi_create_double(env, obs->x, &obs_x);
-                napi_create_double(env, obs->y, &obs_y);
-                napi_create_double(env, obs->width, &obs_width);
-                napi_create_double(env, obs->height, &obs_height);
-                
-                napi_set_named_property(env, obs_obj, "text", obs_text);
-                napi_set_named_property(env, obs_obj, "confidence", obs_confidence);
-                napi_set_named_property(env, obs_obj, "x", obs_x);
-                napi_set_named_property(env, obs_obj, "y", obs_y);
-                napi_set_named_property(env, obs_obj, "width", obs_width);
-                napi_set_named_property(env, obs_obj, "height", obs_height);
-                
-                napi_set_element(env, observations, i, obs_obj);
-            }
-        } else {
-            napi_create_array_with_length(env, 0, &observations);
-        }
-        napi_set_named_property(env, obj, "observations", observations);
-        
+        napi_value obj = CreateResultObject(env, work->result);
         napi_resolve_deferred(env, work->deferred, obj);
     }
     else {
-        napi_value error, error_msg;
-        napi_create_string_utf8(env, "Unknown error occurred", NAPI_AUTO_LENGTH, &error_msg);
-        napi_create_error(env, NULL, error_msg, &error);
-        napi_reject_deferred(env, work->deferred, error);
+        RejectWithCode(env, work->deferred, OCR_ERROR_OUT_OF_MEMORY);
     }
     
     // 清理资源
@@ -157,30 +541,46 @@ static bool GetOptionsFromObject(napi_env env, napi_value options, OCROptions* o
     out_options->languages = "en-US";
     out_options->recognition_level = OCR_RECOGNITION_LEVEL_ACCURATE;
     out_options->min_confidence = 0.0;
+    out_options->min_observation_confidence = 0.0;
+    out_options->min_box_size = 0.0;
+    out_options->candidates = 0;
+    out_options->cascade_threshold = 0.0;
+    out_options->latency_budget_ms = 0.0;
+    out_options->hedge_after_ms = 0.0;
+    out_options->hedge_fast = false;
+    out_options->spatial_index = false;
+    out_options->detect_table = false;
+    out_options->skip_duplicates = false;
+    out_options->duplicate_distance = OCR_DEFAULT_DUPLICATE_DISTANCE;
+    out_options->reject_blank = false;
+    out_options->blank_min_stddev = 0.0;
+    out_options->blank_min_edge_density = 0.0;
+    out_options->grayscale = false;
+    out_options->normalize_contrast = false;
+    out_options->preprocess_scale = 1.0;
+    out_options->auto_rotate = false;
+    out_options->auto_rotate_threshold = 0.0;
+    out_options->pyramid = false;
+    out_options->pyramid_scale = 0.0;
+    out_options->detect_only = false;
+    out_options->route_languages = false;
     
     if (options == NULL) {
         return true;
     }
     
-    napi_value languages, recognition_level, min_confidence;
-    
-    // 获取语言设置
-    if (napi_get_named_property(env, options, "languages", &languages) == napi_ok) {
-        size_t lang_length;
-        if (napi_get_value_string_utf8(env, languages, NULL, 0, &lang_length) == napi_ok) {
-            char* langs = (char*)malloc(lang_length + 1);
-            if (napi_get_value_string_utf8(env, languages, langs, lang_length + 1, NULL) == napi_ok) {
-                out_options->languages = langs;
-            } else {
-                free(langs);
-            }
-        }
-    }
+    napi_value languages, recognition_level, min_confidence, spatial_index, detect_table;
+    napi_value min_observation_confidence, min_box_size, candidates, cascade_threshold, latency_budget;
+    napi_value hedge_after, hedge_fast, skip_duplicates, duplicate_distance;
+    napi_value reject_blank, blank_min_stddev, blank_min_edge_density;
+    napi_value grayscale, normalize_contrast, preprocess_scale, auto_rotate, auto_rotate_threshold;
+    napi_value pyramid, pyramid_scale, mode, route_languages;
     
     if (napi_get_named_property(env, options, "recognitionLevel", &recognition_level) == napi_ok) {
         int32_t level;
         if (napi_get_value_int32(env, recognition_level, &level) == napi_ok) {
-            if (level != OCR_RECOGNITION_LEVEL_FAST && level != OCR_RECOGNITION_LEVEL_ACCURATE) {
+            if (level != OCR_RECOGNITION_LEVEL_FAST && level != OCR_RECOGNITION_LEVEL_ACCURATE &&
+                level != OCR_RECOGNITION_LEVEL_CASCADE) {
                 return false;
             }
             out_options->recognition_level = (OCRRecognitionLevel)level;
@@ -194,6 +594,216 @@ static bool GetOptionsFromObject(napi_env env, napi_value options, OCROptions* o
         }
     }
     
+    if (napi_get_named_property(env, options, "minObservationConfidence", &min_observation_confidence) == napi_ok) {
+        double conf;
+        if (napi_get_value_double(env, min_observation_confidence, &conf) == napi_ok) {
+            out_options->min_observation_confidence = conf;
+        }
+    }
+    
+    if (napi_get_named_property(env, options, "minBoxSize", &min_box_size) == napi_ok) {
+        double size;
+        if (napi_get_value_double(env, min_box_size, &size) == napi_ok) {
+            out_options->min_box_size = size;
+        }
+    }
+    
+    if (napi_get_named_property(env, options, "candidates", &candidates) == napi_ok) {
+        int32_t limit;
+        if (napi_get_value_int32(env, candidates, &limit) == napi_ok) {
+            if (limit < 0 || limit > 10) {
+                return false;
+            }
+            out_options->candidates = limit;
+        }
+    }
+    
+    if (napi_get_named_property(env, options, "cascadeThreshold", &cascade_threshold) == napi_ok) {
+        double threshold;
+        if (napi_get_value_double(env, cascade_threshold, &threshold) == napi_ok) {
+            out_options->cascade_threshold = threshold;
+        }
+    }
+    
+    if (napi_get_named_property(env, options, "latencyBudgetMs", &latency_budget) == napi_ok) {
+        double budget;
+        if (napi_get_value_double(env, latency_budget, &budget) == napi_ok) {
+            if (budget < 0.0) {
+                return false;
+            }
+            out_options->latency_budget_ms = budget;
+        }
+    }
+    
+    if (napi_get_named_property(env, options, "hedgeAfterMs", &hedge_after) == napi_ok) {
+        double delay;
+        if (napi_get_value_double(env, hedge_after, &delay) == napi_ok) {
+            if (delay < 0.0) {
+                return false;
+            }
+            out_options->hedge_after_ms = delay;
+        }
+    }
+    
+    if (napi_get_named_property(env, options, "hedgeFast", &hedge_fast) == napi_ok) {
+        bool enabled;
+        if (napi_get_value_bool(env, hedge_fast, &enabled) == napi_ok) {
+            out_options->hedge_fast = enabled;
+        }
+    }
+    
+    if (napi_get_named_property(env, options, "spatialIndex", &spatial_index) == napi_ok) {
+        bool enabled;
+        if (napi_get_value_bool(env, spatial_index, &enabled) == napi_ok) {
+            out_options->spatial_index = enabled;
+        }
+    }
+    
+    if (napi_get_named_property(env, options, "detectTable", &detect_table) == napi_ok) {
+        bool enabled;
+        if (napi_get_value_bool(env, detect_table, &enabled) == napi_ok) {
+            out_options->detect_table = enabled;
+        }
+    }
+    
+    if (napi_get_named_property(env, options, "skipDuplicates", &skip_duplicates) == napi_ok) {
+        bool enabled;
+        if (napi_get_value_bool(env, skip_duplicates, &enabled) == napi_ok) {
+            out_options->skip_duplicates = enabled;
+        }
+    }
+    
+    if (napi_get_named_property(env, options, "duplicateDistance", &duplicate_distance) == napi_ok) {
+        int32_t distance;
+        if (napi_get_value_int32(env, duplicate_distance, &distance) == napi_ok) {
+            if (distance < 0 || distance > 64) {
+                return false;
+            }
+            out_options->duplicate_distance = distance;
+        }
+    }
+    
+    if (napi_get_named_property(env, options, "rejectBlank", &reject_blank) == napi_ok) {
+        bool enabled;
+        if (napi_get_value_bool(env, reject_blank, &enabled) == napi_ok) {
+            out_options->reject_blank = enabled;
+        }
+    }
+    
+    if (napi_get_named_property(env, options, "blankMinStdDev", &blank_min_stddev) == napi_ok) {
+        double stddev;
+        if (napi_get_value_double(env, blank_min_stddev, &stddev) == napi_ok) {
+            if (stddev < 0.0) {
+                return false;
+            }
+            out_options->blank_min_stddev = stddev;
+        }
+    }
+    
+    if (napi_get_named_property(env, options, "blankMinEdgeDensity", &blank_min_edge_density) == napi_ok) {
+        double density;
+        if (napi_get_value_double(env, blank_min_edge_density, &density) == napi_ok) {
+            if (density < 0.0 || density > 1.0) {
+                return false;
+            }
+            out_options->blank_min_edge_density = density;
+        }
+    }
+    
+    if (napi_get_named_property(env, options, "grayscale", &grayscale) == napi_ok) {
+        bool enabled;
+        if (napi_get_value_bool(env, grayscale, &enabled) == napi_ok) {
+            out_options->grayscale = enabled;
+        }
+    }
+    
+    if (napi_get_named_property(env, options, "normalizeContrast", &normalize_contrast) == napi_ok) {
+        bool enabled;
+        if (napi_get_value_bool(env, normalize_contrast, &enabled) == napi_ok) {
+            out_options->normalize_contrast = enabled;
+        }
+    }
+    
+    if (napi_get_named_property(env, options, "preprocessScale", &preprocess_scale) == napi_ok) {
+        double scale;
+        if (napi_get_value_double(env, preprocess_scale, &scale) == napi_ok) {
+            if (scale <= 0.0 || scale > 1.0) {
+                return false;
+            }
+            out_options->preprocess_scale = scale;
+        }
+    }
+    
+    if (napi_get_named_property(env, options, "autoRotate", &auto_rotate) == napi_ok) {
+        bool enabled;
+        if (napi_get_value_bool(env, auto_rotate, &enabled) == napi_ok) {
+            out_options->auto_rotate = enabled;
+        }
+    }
+    
+    if (napi_get_named_property(env, options, "autoRotateThreshold", &auto_rotate_threshold) == napi_ok) {
+        double threshold;
+        if (napi_get_value_double(env, auto_rotate_threshold, &threshold) == napi_ok) {
+            if (threshold < 0.0 || threshold > 1.0) {
+                return false;
+            }
+            out_options->auto_rotate_threshold = threshold;
+        }
+    }
+    
+    if (napi_get_named_property(env, options, "pyramid", &pyramid) == napi_ok) {
+        bool enabled;
+        if (napi_get_value_bool(env, pyramid, &enabled) == napi_ok) {
+            out_options->pyramid = enabled;
+        }
+    }
+    
+    if (napi_get_named_property(env, options, "pyramidScale", &pyramid_scale) == napi_ok) {
+        double scale;
+        if (napi_get_value_double(env, pyramid_scale, &scale) == napi_ok) {
+            if (scale < 0.0 || scale >= 1.0) {
+                return false;
+            }
+            out_options->pyramid_scale = scale;
+        }
+    }
+    
+    if (napi_get_named_property(env, options, "mode", &mode) == napi_ok) {
+        char name[16];
+        if (napi_get_value_string_utf8(env, mode, name, sizeof(name), NULL) == napi_ok) {
+            if (strcmp(name, "detect") == 0) {
+                out_options->detect_only = true;
+            } else if (strcmp(name, "recognize") != 0) {
+                return false;
+            }
+        }
+    }
+    
+    if (napi_get_named_property(env, options, "routeLanguages", &route_languages) == napi_ok) {
+        bool enabled;
+        if (napi_get_value_bool(env, route_languages, &enabled) == napi_ok) {
+            out_options->route_languages = enabled;
+        }
+    }
+    
+    // Languages are copied last, so a rejected option never leaves a buffer to free
+    if (napi_get_named_property(env, options, "languages", &languages) == napi_ok) {
+        size_t lang_length;
+        if (napi_get_value_string_utf8(env, languages, NULL, 0, &lang_length) == napi_ok) {
+            char* langs = (char*)malloc(lang_length + 1);
+            if (!langs) {
+                return false;
+            }
+            if (napi_get_value_string_utf8(env, languages, langs, lang_length + 1, NULL) == napi_ok &&
+                strcmp(langs, "en-US") != 0) {
+                out_options->languages = langs;
+            } else {
+                // The default stays the literal, which callers never free
+                free(langs);
+            }
+        }
+    }
+    
     return true;
 }
 
@@ -236,7 +846,7 @@ napi_value Recognize(napi_env env, napi_callback_info info) {
     work->image_path = (char*)malloc(path_length + 1);
     work->deferred = deferred;
     work->result = NULL;
-    work->error_message = NULL;
+    work->error_code = OCR_OK;
     
     if (!work->image_path) {
         free(work);
@@ -269,7 +879,7 @@ napi_value Recognize(napi_env env, napi_callback_info info) {
         if (!GetOptionsFromObject(env, args[1], &work->options)) {
             free(work->image_path);
             free(work);
-            napi_throw_error(env, NULL, "Invalid options");
+            ThrowWithCode(env, OCR_ERROR_INVALID_ARGUMENT);
             return NULL;
         }
     } else {
@@ -318,20 +928,11 @@ void CompleteBatchOCR(napi_env env, napi_status status, void* data) {
     
     
     
-    if (work->error_message) {
-        
-        napi_value error, error_msg;
-        napi_create_string_utf8(env, work->error_message, NAPI_AUTO_LENGTH, &error_msg);
-        napi_create_error(env, NULL, error_msg, &error);
-        napi_reject_deferred(env, work->deferred, error);
-        free(work->error_message);
+    if (work->error_code != OCR_OK) {
+        RejectWithCode(env, work->deferred, work->error_code);
     }
     else if (work->result && work->result->error) {
-        
-        napi_value error, error_msg;
-        napi_create_string_utf8(env, work->result->error, NAPI_AUTO_LENGTH, &error_msg);
-        napi_create_error(env, NULL, error_msg, &error);
-        napi_reject_deferred(env, work->deferred, error);
+        RejectWithCode(env, work->deferred, work->result->error_code);
     }
     else if (work->result) {
         
@@ -339,56 +940,7 @@ void CompleteBatchOCR(napi_env env, napi_status status, void* data) {
         napi_create_array_with_length(env, work->result->count, &results_array);
 
         for (size_t i = 0; i < work->result->count; i++) {
-            OCRResult* result = work->result->results[i];
-            
-            
-            napi_value obj, text, confidence, observations;
-            napi_create_object(env, &obj);
-
-            if (result && result->text) {
-                napi_create_string_utf8(env, result->text, NAPI_AUTO_LENGTH, &text);
-            } else {
-                napi_get_null(env, &text);
-            }
-            napi_set_named_property(env, obj, "text", text);
-
-            if (result) {
-                
-                napi_create_double(env, result->confidence, &confidence);
-            } else {
-                napi_create_double(env, 0.0, &confidence);
-            }
-            napi_set_named_property(env, obj, "confidence", confidence);
-
-            // Add observations array
-            if (result && result->observations && result->observation_count > 0) {
-                napi_create_array_with_length(env, result->observation_count, &observations);
-                for (size_t j = 0; j < result->observation_count; j++) {
-                    TextObservation* obs = &result->observations[j];
-                    napi_value obs_obj, obs_text, obs_confidence, obs_x, obs_y, obs_width, obs_height;
-                    
-                    napi_create_object(env, &obs_obj);
-                    napi_create_string_utf8(env, obs->text, NAPI_AUTO_LENGTH, &obs_text);
-                    napi_create_double(env, obs->confidence, &obs_confidence);
-                    napi_create_double(env, obs->x, &obs_x);
-                    napi_create_double(env, obs->y, &obs_y);
-                    napi_create_double(env, obs->width, &obs_width);
-                    napi_create_double(env, obs->height, &obs_height);
-                    
-                    napi_set_named_property(env, obs_obj, "text", obs_text);
-                    napi_set_named_property(env, obs_obj, "confidence", obs_confidence);
-                    napi_set_named_property(env, obs_obj, "x", obs_x);
-                    napi_set_named_property(env, obs_obj, "y", obs_y);
-                    napi_set_named_property(env, obs_obj, "width", obs_width);
-                    napi_set_named_property(env, obs_obj, "height", obs_height);
-                    
-                    napi_set_element(env, observations, j, obs_obj);
-                }
-            } else {
-                napi_create_array_with_length(env, 0, &observations);
-            }
-            napi_set_named_property(env, obj, "observations", observations);
-
+            napi_value obj = CreateResultObject(env, work->result->results[i]);
             napi_set_element(env, results_array, i, obj);
         }
 
@@ -404,11 +956,7 @@ void CompleteBatchOCR(napi_env env, napi_status status, void* data) {
         napi_resolve_deferred(env, work->deferred, results_array);
     }
     else {
-        
-        napi_value error, error_msg;
-        napi_create_string_utf8(env, "Unknown error occurred", NAPI_AUTO_LENGTH, &error_msg);
-        napi_create_error(env, NULL, error_msg, &error);
-        napi_reject_deferred(env, work->deferred, error);
+        RejectWithCode(env, work->deferred, OCR_ERROR_OUT_OF_MEMORY);
     }
     
     // Cleanup
@@ -433,23 +981,41 @@ static bool GetBatchOptionsFromObject(napi_env env, napi_value options, OCRBatch
     out_options->ocr_options.languages = "en-US";
     out_options->ocr_options.recognition_level = OCR_RECOGNITION_LEVEL_ACCURATE;
     out_options->ocr_options.min_confidence = 0.0;
+    out_options->ocr_options.min_observation_confidence = 0.0;
+    out_options->ocr_options.min_box_size = 0.0;
+    out_options->ocr_options.candidates = 0;
+    out_options->ocr_options.cascade_threshold = 0.0;
+    out_options->ocr_options.latency_budget_ms = 0.0;
+    out_options->ocr_options.hedge_after_ms = 0.0;
+    out_options->ocr_options.hedge_fast = false;
+    out_options->ocr_options.spatial_index = false;
+    out_options->ocr_options.detect_table = false;
+    out_options->ocr_options.skip_duplicates = false;
+    out_options->ocr_options.duplicate_distance = OCR_DEFAULT_DUPLICATE_DISTANCE;
+    out_options->ocr_options.reject_blank = false;
+    out_options->ocr_options.blank_min_stddev = 0.0;
+    out_options->ocr_options.blank_min_edge_density = 0.0;
+    out_options->ocr_options.grayscale = false;
+    out_options->ocr_options.normalize_contrast = false;
+    out_options->ocr_options.preprocess_scale = 1.0;
+    out_options->ocr_options.auto_rotate = false;
+    out_options->ocr_options.auto_rotate_threshold = 0.0;
+    out_options->ocr_options.pyramid = false;
+    out_options->ocr_options.pyramid_scale = 0.0;
+    out_options->ocr_options.detect_only = false;
+    out_options->ocr_options.route_languages = false;
     out_options->max_threads = 0;
     out_options->batch_size = 1;
+    out_options->max_in_flight_bytes = 0;
+    out_options->max_retries = 0;
+    out_options->retry_backoff_ms = 0.0;
     
     if (options == NULL) {
         return true;
     }
     
-    // Get OCR options
-    napi_value ocr_options;
-    if (napi_get_named_property(env, options, "ocrOptions", &ocr_options) == napi_ok) {
-        if (!GetOptionsFromObject(env, ocr_options, &out_options->ocr_options)) {
-            return false;
-        }
-    }
-    
     // Get batch specific options
-    napi_value max_threads, batch_size;
+    napi_value max_threads, batch_size, max_in_flight_bytes, max_retries, retry_backoff;
     
     if (napi_get_named_property(env, options, "maxThreads", &max_threads) == napi_ok) {
         int32_t threads;
@@ -465,13 +1031,51 @@ static bool GetBatchOptionsFromObject(napi_env env, napi_value options, OCRBatch
         }
     }
     
-    return true;
-}
-
-napi_value RecognizeBatch(napi_env env, napi_callback_info info) {
-    size_t argc = 2;
-    napi_value args[2];
-    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+    if (napi_get_named_property(env, options, "maxInFlightBytes", &max_in_flight_bytes) == napi_ok) {
+        int64_t bytes;
+        if (napi_get_value_int64(env, max_in_flight_bytes, &bytes) == napi_ok) {
+            if (bytes < 0) {
+                return false;
+            }
+            out_options->max_in_flight_bytes = (size_t)bytes;
+        }
+    }
+    
+    if (napi_get_named_property(env, options, "maxRetries", &max_retries) == napi_ok) {
+        int32_t retries;
+        if (napi_get_value_int32(env, max_retries, &retries) == napi_ok) {
+            if (retries < 0 || retries > 10) {
+                return false;
+            }
+            out_options->max_retries = retries;
+        }
+    }
+    
+    if (napi_get_named_property(env, options, "retryBackoffMs", &retry_backoff) == napi_ok) {
+        double backoff;
+        if (napi_get_value_double(env, retry_backoff, &backoff) == napi_ok) {
+            if (!(backoff >= 0.0)) {
+                return false;
+            }
+            out_options->retry_backoff_ms = backoff;
+        }
+    }
+    
+    // Get OCR options last; they may hold the only allocation
+    napi_value ocr_options;
+    if (napi_get_named_property(env, options, "ocrOptions", &ocr_options) == napi_ok) {
+        if (!GetOptionsFromObject(env, ocr_options, &out_options->ocr_options)) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+napi_value RecognizeBatch(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
     
     if (argc < 1) {
         napi_throw_error(env, NULL, "Wrong number of arguments");
@@ -508,7 +1112,7 @@ napi_value RecognizeBatch(napi_env env, napi_callback_info info) {
     work->count = array_length;
     work->deferred = deferred;
     work->result = NULL;
-    work->error_message = NULL;
+    work->error_code = OCR_OK;
     
     if (!work->image_paths) {
         free(work);
@@ -546,7 +1150,7 @@ napi_value RecognizeBatch(napi_env env, napi_callback_info info) {
             }
             free(work->image_paths);
             free(work);
-            napi_throw_error(env, NULL, "Invalid options");
+            ThrowWithCode(env, OCR_ERROR_INVALID_ARGUMENT);
             return NULL;
         }
     } else {
@@ -594,17 +1198,12 @@ napi_value RecognizeBatch(napi_env env, napi_callback_info info) {
 void ExecuteBufferOCR(napi_env env, void* data) {
     OCRBufferWork* work = (OCRBufferWork*)data;
     
-    char* error = NULL;
+    OCRErrorCode error = OCR_OK;
     CGImageRef image = CreateCGImageFromBuffer(work->buffer_data, work->buffer_length, &error);
     
     if (!image) {
-        if (error) {
-            work->error_message = error;
-            return;
-        } else {
-            work->error_message = strdup("Failed to create image from buffer");
-            return;
-        }
+        work->error_code = error != OCR_OK ? error : OCR_ERROR_DECODE_FAILED;
+        return;
     }
     
     work->result = perform_ocr(image, &work->options);
@@ -615,75 +1214,19 @@ void ExecuteBufferOCR(napi_env env, void* data) {
 void CompleteBufferOCR(napi_env env, napi_status status, void* data) {
     OCRBufferWork* work = (OCRBufferWork*)data;
     
-    if (work->error_message) {
-        napi_value error, error_msg;
-        napi_create_string_utf8(env, work->error_message, NAPI_AUTO_LENGTH, &error_msg);
-        if (strstr(work->error_message, "must be a Buffer") != NULL ||
-            strstr(work->error_message, "argument type") != NULL) {
-            napi_create_type_error(env, NULL, error_msg, &error);
-        } else {
-            napi_create_error(env, NULL, error_msg, &error);
-        }
-        napi_reject_deferred(env, work->deferred, error);
-        free(work->error_message);
+    // Argument type errors are thrown before the work is queued, so every failure here has a code
+    if (work->error_code != OCR_OK) {
+        RejectWithCode(env, work->deferred, work->error_code);
     }
     else if (work->result && work->result->error) {
-        napi_value error, error_msg;
-        napi_create_string_utf8(env, work->result->error, NAPI_AUTO_LENGTH, &error_msg);
-        napi_create_error(env, NULL, error_msg, &error);
-        napi_reject_deferred(env, work->deferred, error);
+        RejectWithCode(env, work->deferred, work->result->error_code);
     }
     else if (work->result) {
-        napi_value obj, text, confidence, observations;
-        napi_create_object(env, &obj);
-
-        if (work->result->text) {
-            napi_create_string_utf8(env, work->result->text, NAPI_AUTO_LENGTH, &text);
-            napi_set_named_property(env, obj, "text", text);
-        } else {
-            napi_get_null(env, &text);
-            napi_set_named_property(env, obj, "text", text);
-        }
-        
-        napi_create_double(env, work->result->confidence, &confidence);
-        napi_set_named_property(env, obj, "confidence", confidence);
-        
-        // Add observations array
-        if (work->result->observations && work->result->observation_count > 0) {
-            napi_create_array_with_length(env, work->result->observation_count, &observations);
-            for (size_t i = 0; i < work->result->observation_count; i++) {
-                TextObservation* obs = &work->result->observations[i];
-                napi_value obs_obj, obs_text, obs_confidence, obs_x, obs_y, obs_width, obs_height;
-                
-                napi_create_object(env, &obs_obj);
-                napi_create_string_utf8(env, obs->text, NAPI_AUTO_LENGTH, &obs_text);
-                napi_create_double(env, obs->confidence, &obs_confidence);
-                napi_create_double(env, obs->x, &obs_x);
-                napi_create_double(env, obs->y, &obs_y);
-                napi_create_double(env, obs->width, &obs_width);
-                napi_create_double(env, obs->height, &obs_height);
-                
-                napi_set_named_property(env, obs_obj, "text", obs_text);
-                napi_set_named_property(env, obs_obj, "confidence", obs_confidence);
-                napi_set_named_property(env, obs_obj, "x", obs_x);
-                napi_set_named_property(env, obs_obj, "y", obs_y);
-                napi_set_named_property(env, obs_obj, "width", obs_width);
-                napi_set_named_property(env, obs_obj, "height", obs_height);
-                
-                napi_set_element(env, observations, i, obs_obj);
-            }
-        } else {
-            napi_create_array_with_length(env, 0, &observations);
-        }
-        napi_set_named_property(env, obj, "observations", observations);
-        
+        napi_value obj = CreateResultObject(env, work->result);
         napi_resolve_deferred(env, work->deferred, obj);
     }
     else {
-        napi_value error, error_msg;
-        napi_create_string_utf8(env, "Unknown error occurred", NAPI_AUTO_LENGTH, &error_msg);
-        napi_create_error(env, NULL, error_msg, &error);
-        napi_reject_deferred(env, work->deferred, error);
+        RejectWithCode(env, work->deferred, OCR_ERROR_OUT_OF_MEMORY);
     }
     
     // 清理资源
@@ -739,7 +1282,7 @@ napi_value RecognizeBuffer(napi_env env, napi_callback_info info) {
     work->buffer_length = buffer_length;
     work->deferred = deferred;
     work->result = NULL;
-    work->error_message = NULL;
+    work->error_code = OCR_OK;
     
     // Verify second argument is an object if provided
     if (argc > 1 && args[1] != NULL) {
@@ -758,7 +1301,7 @@ napi_value RecognizeBuffer(napi_env env, napi_callback_info info) {
         if (!GetOptionsFromObject(env, args[1], &work->options)) {
             free(work->buffer_data);
             free(work);
-            napi_throw_error(env, NULL, "Invalid options");
+            ThrowWithCode(env, OCR_ERROR_INVALID_ARGUMENT);
             return NULL;
         }
     } else {
@@ -815,82 +1358,25 @@ void ExecuteBatchBufferOCR(napi_env env, void* data) {
 void CompleteBatchBufferOCR(napi_env env, napi_status status, void* data) {
     BatchBufferOCRWork* work = (BatchBufferOCRWork*)data;
     
-    if (work->error_message) {
-        napi_value error, error_msg;
-        napi_create_string_utf8(env, work->error_message, NAPI_AUTO_LENGTH, &error_msg);
-        napi_create_error(env, NULL, error_msg, &error);
-        napi_reject_deferred(env, work->deferred, error);
-        free(work->error_message);
+    if (work->error_code != OCR_OK) {
+        RejectWithCode(env, work->deferred, work->error_code);
     }
     else if (work->result && work->result->error) {
-        napi_value error, error_msg;
-        napi_create_string_utf8(env, work->result->error, NAPI_AUTO_LENGTH, &error_msg);
-        napi_create_error(env, NULL, error_msg, &error);
-        napi_reject_deferred(env, work->deferred, error);
+        RejectWithCode(env, work->deferred, work->result->error_code);
     }
     else if (work->result) {
         napi_value results_array;
         napi_create_array_with_length(env, work->result->count, &results_array);
 
         for (size_t i = 0; i < work->result->count; i++) {
-            OCRResult* result = work->result->results[i];
-            
-            napi_value obj, text, confidence, observations;
-            napi_create_object(env, &obj);
-
-            if (result && result->text) {
-                napi_create_string_utf8(env, result->text, NAPI_AUTO_LENGTH, &text);
-            } else {
-                napi_get_null(env, &text);
-            }
-            napi_set_named_property(env, obj, "text", text);
-
-            if (result) {
-                napi_create_double(env, result->confidence, &confidence);
-            } else {
-                napi_create_double(env, 0.0, &confidence);
-            }
-            napi_set_named_property(env, obj, "confidence", confidence);
-
-            // Add observations array
-            if (result && result->observations && result->observation_count > 0) {
-                napi_create_array_with_length(env, result->observation_count, &observations);
-                for (size_t j = 0; j < result->observation_count; j++) {
-                    TextObservation* obs = &result->observations[j];
-                    napi_value obs_obj, obs_text, obs_confidence, obs_x, obs_y, obs_width, obs_height;
-                    
-                    napi_create_object(env, &obs_obj);
-                    napi_create_string_utf8(env, obs->text, NAPI_AUTO_LENGTH, &obs_text);
-                    napi_create_double(env, obs->confidence, &obs_confidence);
-                    napi_create_double(env, obs->x, &obs_x);
-                    napi_create_double(env, obs->y, &obs_y);
-                    napi_create_double(env, obs->width, &obs_width);
-                    napi_create_double(env, obs->height, &obs_height);
-                    
-                    napi_set_named_property(env, obs_obj, "text", obs_text);
-                    napi_set_named_property(env, obs_obj, "confidence", obs_confidence);
-                    napi_set_named_property(env, obs_obj, "x", obs_x);
-                    napi_set_named_property(env, obs_obj, "y", obs_y);
-                    napi_set_named_property(env, obs_obj, "width", obs_width);
-                    napi_set_named_property(env, obs_obj, "height", obs_height);
-                    
-                    napi_set_element(env, observations, j, obs_obj);
-                }
-            } else {
-                napi_create_array_with_length(env, 0, &observations);
-            }
-            napi_set_named_property(env, obj, "observations", observations);
-
+            napi_value obj = CreateResultObject(env, work->result->results[i]);
             napi_set_element(env, results_array, i, obj);
         }
 
         napi_resolve_deferred(env, work->deferred, results_array);
     }
     else {
-        napi_value error, error_msg;
-        napi_create_string_utf8(env, "Unknown error occurred", NAPI_AUTO_LENGTH, &error_msg);
-        napi_create_error(env, NULL, error_msg, &error);
-        napi_reject_deferred(env, work->deferred, error);
+        RejectWithCode(env, work->deferred, OCR_ERROR_OUT_OF_MEMORY);
     }
     
     // Cleanup
@@ -956,7 +1442,7 @@ napi_value RecognizeBatchFromBuffer(napi_env env, napi_callback_info info) {
     work->count = array_length;
     work->deferred = deferred;
     work->result = NULL;
-    work->error_message = NULL;
+    work->error_code = OCR_OK;
     
     if (!work->buffer_data || !work->buffer_lengths) {
         if (work->buffer_data) free(work->buffer_data);
@@ -1009,7 +1495,7 @@ napi_value RecognizeBatchFromBuffer(napi_env env, napi_callback_info info) {
             free(work->buffer_data);
             free(work->buffer_lengths);
             free(work);
-            napi_throw_error(env, NULL, "Invalid options");
+            ThrowWithCode(env, OCR_ERROR_INVALID_ARGUMENT);
             return NULL;
         }
     } else {
@@ -1055,22 +1541,1338 @@ napi_value RecognizeBatchFromBuffer(napi_env env, napi_callback_info info) {
     return promise;
 }
 
-napi_value Init(napi_env env, napi_value exports) {
-    napi_value recognize_fn;
-    napi_create_function(env, NULL, 0, Recognize, NULL, &recognize_fn);
-    napi_set_named_property(env, exports, "recognize", recognize_fn);
+static void FreeInputs(OCRInput* inputs, size_t count) {
+    if (!inputs) return;
     
-    napi_value recognize_buffer_fn;
-    napi_create_function(env, NULL, 0, RecognizeBuffer, NULL, &recognize_buffer_fn);
-    napi_set_named_property(env, exports, "recognizeBuffer", recognize_buffer_fn);
+    for (size_t i = 0; i < count; i++) {
+        free((void*)inputs[i].path);
+        free((void*)inputs[i].buffer);
+    }
+    free(inputs);
+}
+
+// Copy a JS array of path strings and Buffers so it can be used off the main thread
+static OCRInput* GetInputsFromArray(napi_env env, napi_value array, size_t* out_count) {
+    bool is_array;
+    if (napi_is_array(env, array, &is_array) != napi_ok || !is_array) {
+        napi_throw_type_error(env, NULL, "First argument must be an array of image paths or buffers");
+        return NULL;
+    }
     
-    napi_value recognize_batch_fn;
-    napi_create_function(env, NULL, 0, RecognizeBatch, NULL, &recognize_batch_fn);
-    napi_set_named_property(env, exports, "recognizeBatch", recognize_batch_fn);
+    uint32_t array_length;
+    napi_get_array_length(env, array, &array_length);
+    if (array_length == 0) {
+        napi_throw_error(env, NULL, "Inputs array cannot be empty");
+        return NULL;
+    }
     
-    napi_value recognize_batch_buffer_fn;
-    napi_create_function(env, NULL, 0, RecognizeBatchFromBuffer, NULL, &recognize_batch_buffer_fn);
-    napi_set_named_property(env, exports, "recognizeBatchFromBuffer", recognize_batch_buffer_fn);
+    OCRInput* inputs = (OCRInput*)calloc(array_length, sizeof(OCRInput));
+    if (!inputs) {
+        napi_throw_error(env, NULL, "Failed to allocate memory for inputs");
+        return NULL;
+    }
+    
+    for (uint32_t i = 0; i < array_length; i++) {
+        napi_value element;
+        napi_valuetype type;
+        napi_get_element(env, array, i, &element);
+        napi_typeof(env, element, &type);
+        
+        if (type == napi_string) {
+            size_t path_length;
+            napi_get_value_string_utf8(env, element, NULL, 0, &path_length);
+            char* path = (char*)malloc(path_length + 1);
+            if (!path) {
+                FreeInputs(inputs, array_length);
+                napi_throw_error(env, NULL, "Failed to allocate memory for image path");
+                return NULL;
+            }
+            napi_get_value_string_utf8(env, element, path, path_length + 1, NULL);
+            inputs[i].path = path;
+            continue;
+        }
+        
+        void* buffer_data;
+        size_t buffer_length;
+        if (napi_get_buffer_info(env, element, &buffer_data, &buffer_length) != napi_ok) {
+            FreeInputs(inputs, array_length);
+            napi_throw_type_error(env, NULL, "Array elements must be image paths or Buffers");
+            return NULL;
+        }
+        void* copy = malloc(buffer_length > 0 ? buffer_length : 1);
+        if (!copy) {
+            FreeInputs(inputs, array_length);
+            napi_throw_error(env, NULL, "Failed to allocate memory for buffer");
+            return NULL;
+        }
+        memcpy(copy, buffer_data, buffer_length);
+        inputs[i].buffer = copy;
+        inputs[i].length = buffer_length;
+    }
+    
+    *out_count = array_length;
+    return inputs;
+}
+
+static void FreeOptionSetsWork(OptionSetsWork* work) {
+    if (work->option_sets) {
+        for (size_t i = 0; i < work->count; i++) {
+            if (work->option_sets[i].languages && strcmp(work->option_sets[i].languages, "en-US") != 0) {
+                free((void*)work->option_sets[i].languages);
+            }
+        }
+        free(work->option_sets);
+    }
+    free((void*)work->input.path);
+    free((void*)work->input.buffer);
+    free(work);
+}
+
+void ExecuteOptionSets(napi_env env, void* data) {
+    OptionSetsWork* work = (OptionSetsWork*)data;
+    
+    OCRErrorCode error = OCR_OK;
+    CGImageRef image = work->input.path ?
+        CreateCGImageFromPath(work->input.path, &error) :
+        CreateCGImageFromBuffer(work->input.buffer, work->input.length, &error);
+    if (!image) {
+        work->error_code = error != OCR_OK ? error : OCR_ERROR_DECODE_FAILED;
+        return;
+    }
+    
+    work->result = perform_ocr_option_sets(image, work->option_sets, work->count);
+    CGImageRelease(image);
+}
+
+void CompleteOptionSets(napi_env env, napi_status status, void* data) {
+    OptionSetsWork* work = (OptionSetsWork*)data;
+    
+    // Like a single recognition, the call fails if any option set failed
+    OCRErrorCode code = work->error_code;
+    if (code == OCR_OK && !work->result) {
+        code = OCR_ERROR_OUT_OF_MEMORY;
+    }
+    if (code == OCR_OK && work->result->error) {
+        code = work->result->error_code;
+    }
+    for (size_t i = 0; code == OCR_OK && i < work->result->count; i++) {
+        OCRResult* result = work->result->results[i];
+        if (!result) {
+            code = OCR_ERROR_OUT_OF_MEMORY;
+        } else if (result->error) {
+            code = result->error_code;
+        }
+    }
+    
+    if (code != OCR_OK) {
+        RejectWithCode(env, work->deferred, code);
+    } else {
+        napi_value results_array;
+        napi_create_array_with_length(env, work->result->count, &results_array);
+        for (size_t i = 0; i < work->result->count; i++) {
+            napi_set_element(env, results_array, i, CreateResultObject(env, work->result->results[i]));
+        }
+        napi_resolve_deferred(env, work->deferred, results_array);
+    }
+    
+    free_ocr_batch_result(work->result);
+    napi_delete_async_work(env, work->work);
+    FreeOptionSetsWork(work);
+}
+
+// recognizeOptionSets(pathOrBuffer, optionSets): decode once, recognize once per option set
+napi_value RecognizeOptionSets(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+    
+    if (argc < 2) {
+        napi_throw_error(env, NULL, "Wrong number of arguments");
+        return NULL;
+    }
+    
+    bool is_array;
+    uint32_t set_count = 0;
+    if (napi_is_array(env, args[1], &is_array) != napi_ok || !is_array ||
+        napi_get_array_length(env, args[1], &set_count) != napi_ok || set_count == 0) {
+        napi_throw_type_error(env, NULL, "Option sets must be a non-empty array");
+        return NULL;
+    }
+    
+    OptionSetsWork* work = (OptionSetsWork*)calloc(1, sizeof(OptionSetsWork));
+    if (!work) {
+        napi_throw_error(env, NULL, "Failed to allocate memory");
+        return NULL;
+    }
+    
+    napi_valuetype type;
+    napi_typeof(env, args[0], &type);
+    if (type == napi_string) {
+        size_t path_length;
+        napi_get_value_string_utf8(env, args[0], NULL, 0, &path_length);
+        char* path = (char*)malloc(path_length + 1);
+        if (!path) {
+            FreeOptionSetsWork(work);
+            napi_throw_error(env, NULL, "Failed to allocate memory for image path");
+            return NULL;
+        }
+        napi_get_value_string_utf8(env, args[0], path, path_length + 1, NULL);
+        work->input.path = path;
+    } else {
+        void* buffer_data;
+        size_t buffer_length;
+        if (napi_get_buffer_info(env, args[0], &buffer_data, &buffer_length) != napi_ok || buffer_length == 0) {
+            FreeOptionSetsWork(work);
+            napi_throw_type_error(env, NULL, "First argument must be an image path or a non-empty Buffer");
+            return NULL;
+        }
+        void* copy = malloc(buffer_length);
+        if (!copy) {
+            FreeOptionSetsWork(work);
+            napi_throw_error(env, NULL, "Failed to allocate memory for buffer");
+            return NULL;
+        }
+        memcpy(copy, buffer_data, buffer_length);
+        work->input.buffer = copy;
+        work->input.length = buffer_length;
+    }
+    
+    // Zeroed, so sets parsed before a failure are the only ones with languages to free
+    work->option_sets = (OCROptions*)calloc(set_count, sizeof(OCROptions));
+    if (!work->option_sets) {
+        FreeOptionSetsWork(work);
+        napi_throw_error(env, NULL, "Failed to allocate memory for option sets");
+        return NULL;
+    }
+    work->count = set_count;
+    for (uint32_t i = 0; i < set_count; i++) {
+        napi_value set;
+        napi_get_element(env, args[1], i, &set);
+        if (!GetOptionsFromObject(env, set, &work->option_sets[i])) {
+            FreeOptionSetsWork(work);
+            ThrowWithCode(env, OCR_ERROR_INVALID_ARGUMENT);
+            return NULL;
+        }
+    }
+    
+    napi_value promise;
+    napi_create_promise(env, &work->deferred, &promise);
+    
+    napi_value resource_name;
+    napi_create_string_utf8(env, "OCROptionSets", NAPI_AUTO_LENGTH, &resource_name);
+    
+    napi_status status = napi_create_async_work(env,
+                                              NULL,
+                                              resource_name,
+                                              ExecuteOptionSets,
+                                              CompleteOptionSets,
+                                              work,
+                                              &work->work);
+    
+    if (status != napi_ok) {
+        FreeOptionSetsWork(work);
+        napi_throw_error(env, NULL, "Failed to create async work");
+        return NULL;
+    }
+    
+    napi_queue_async_work(env, work->work);
+    
+    return promise;
+}
+
+void ExecuteFindText(napi_env env, void* data) {
+    FindTextWork* work = (FindTextWork*)data;
+    work->result = perform_batch_find_text(work->inputs, work->count, &work->options, &work->find_options);
+}
+
+void CompleteFindText(napi_env env, napi_status status, void* data) {
+    FindTextWork* work = (FindTextWork*)data;
+    
+    if (work->result && work->result->error) {
+        RejectWithCode(env, work->deferred, work->result->error_code);
+    }
+    else if (work->result) {
+        napi_value obj, matches, processed, failed, skipped;
+        napi_create_object(env, &obj);
+        
+        napi_create_array_with_length(env, work->result->match_count, &matches);
+        for (size_t i = 0; i < work->result->match_count; i++) {
+            const OCRTextMatch* match = &work->result->matches[i];
+            napi_value match_obj, match_index, match_observation, match_text, match_start, match_length;
+            napi_value match_confidence, match_x, match_y, match_width, match_height;
+            
+            napi_create_object(env, &match_obj);
+            napi_create_uint32(env, (uint32_t)match->input_index, &match_index);
+            napi_create_uint32(env, (uint32_t)match->observation_index, &match_observation);
+            napi_create_string_utf8(env, match->text, NAPI_AUTO_LENGTH, &match_text);
+            napi_create_uint32(env, (uint32_t)match->match_start, &match_start);
+            napi_create_uint32(env, (uint32_t)match->match_length, &match_length);
+            napi_create_double(env, match->confidence, &match_confidence);
+            napi_create_double(env, match->x, &match_x);
+            napi_create_double(env, match->y, &match_y);
+            napi_create_double(env, match->width, &match_width);
+            napi_create_double(env, match->height, &match_height);
+            
+            napi_set_named_property(env, match_obj, "index", match_index);
+            napi_set_named_property(env, match_obj, "observation", match_observation);
+            napi_set_named_property(env, match_obj, "text", match_text);
+            napi_set_named_property(env, match_obj, "start", match_start);
+            napi_set_named_property(env, match_obj, "length", match_length);
+            napi_set_named_property(env, match_obj, "confidence", match_confidence);
+            napi_set_named_property(env, match_obj, "x", match_x);
+            napi_set_named_property(env, match_obj, "y", match_y);
+            napi_set_named_property(env, match_obj, "width", match_width);
+            napi_set_named_property(env, match_obj, "height", match_height);
+            
+            napi_set_element(env, matches, i, match_obj);
+        }
+        napi_set_named_property(env, obj, "matches", matches);
+        
+        napi_create_uint32(env, (uint32_t)work->result->processed_count, &processed);
+        napi_create_uint32(env, (uint32_t)work->result->failed_count, &failed);
+        napi_create_uint32(env, (uint32_t)work->result->skipped_count, &skipped);
+        napi_set_named_property(env, obj, "processed", processed);
+        napi_set_named_property(env, obj, "failed", failed);
+        napi_set_named_property(env, obj, "skipped", skipped);
+        
+        napi_resolve_deferred(env, work->deferred, obj);
+    }
+    else {
+        RejectWithCode(env, work->deferred, OCR_ERROR_OUT_OF_MEMORY);
+    }
+    
+    // Cleanup
+    free_ocr_find_result(work->result);
+    FreeInputs(work->inputs, work->count);
+    free((void*)work->find_options.pattern);
+    if (work->options.ocr_options.languages && strcmp(work->options.ocr_options.languages, "en-US") != 0) {
+        free((void*)work->options.ocr_options.languages);
+    }
+    napi_delete_async_work(env, work->work);
+    free(work);
+}
+
+static bool GetFindOptionsFromObject(napi_env env, napi_value options, OCRFindOptions* out_options) {
+    out_options->regex = false;
+    out_options->case_insensitive = false;
+    out_options->stop_after = 0;
+    
+    if (options == NULL) {
+        return true;
+    }
+    
+    napi_value regex, case_insensitive, stop_after;
+    
+    if (napi_get_named_property(env, options, "regex", &regex) == napi_ok) {
+        bool enabled;
+        if (napi_get_value_bool(env, regex, &enabled) == napi_ok) {
+            out_options->regex = enabled;
+        }
+    }
+    
+    if (napi_get_named_property(env, options, "caseInsensitive", &case_insensitive) == napi_ok) {
+        bool enabled;
+        if (napi_get_value_bool(env, case_insensitive, &enabled) == napi_ok) {
+            out_options->case_insensitive = enabled;
+        }
+    }
+    
+    if (napi_get_named_property(env, options, "stopAfter", &stop_after) == napi_ok) {
+        int64_t limit;
+        if (napi_get_value_int64(env, stop_after, &limit) == napi_ok) {
+            if (limit < 0) {
+                return false;
+            }
+            out_options->stop_after = (size_t)limit;
+        }
+    }
+    
+    return true;
+}
+
+napi_value FindText(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value args[3];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+    
+    if (argc < 2) {
+        napi_throw_error(env, NULL, "Wrong number of arguments");
+        return NULL;
+    }
+    
+    napi_valuetype pattern_type;
+    if (napi_typeof(env, args[1], &pattern_type) != napi_ok || pattern_type != napi_string) {
+        napi_throw_type_error(env, NULL, "Pattern must be a string");
+        return NULL;
+    }
+    
+    FindTextWork* work = (FindTextWork*)calloc(1, sizeof(FindTextWork));
+    if (!work) {
+        napi_throw_error(env, NULL, "Failed to allocate memory");
+        return NULL;
+    }
+    
+    work->inputs = GetInputsFromArray(env, args[0], &work->count);
+    if (!work->inputs) {
+        free(work);
+        return NULL;
+    }
+    
+    size_t pattern_length;
+    napi_get_value_string_utf8(env, args[1], NULL, 0, &pattern_length);
+    char* pattern = (char*)malloc(pattern_length + 1);
+    if (!pattern) {
+        FreeInputs(work->inputs, work->count);
+        free(work);
+        napi_throw_error(env, NULL, "Failed to allocate memory for pattern");
+        return NULL;
+    }
+    napi_get_value_string_utf8(env, args[1], pattern, pattern_length + 1, NULL);
+    work->find_options.pattern = pattern;
+    
+    napi_value options = argc > 2 ? args[2] : NULL;
+    if (!GetBatchOptionsFromObject(env, options, &work->options) ||
+        !GetFindOptionsFromObject(env, options, &work->find_options)) {
+        if (work->options.ocr_options.languages && strcmp(work->options.ocr_options.languages, "en-US") != 0) {
+            free((void*)work->options.ocr_options.languages);
+        }
+        free(pattern);
+        FreeInputs(work->inputs, work->count);
+        free(work);
+        ThrowWithCode(env, OCR_ERROR_INVALID_ARGUMENT);
+        return NULL;
+    }
+    
+    napi_value promise;
+    napi_create_promise(env, &work->deferred, &promise);
+    
+    // Create async work
+    napi_value resource_name;
+    napi_create_string_utf8(env, "FindText", NAPI_AUTO_LENGTH, &resource_name);
+    
+    napi_status status = napi_create_async_work(env,
+                                              NULL,
+                                              resource_name,
+                                              ExecuteFindText,
+                                              CompleteFindText,
+                                              work,
+                                              &work->work);
+    
+    if (status != napi_ok) {
+        if (work->options.ocr_options.languages && strcmp(work->options.ocr_options.languages, "en-US") != 0) {
+            free((void*)work->options.ocr_options.languages);
+        }
+        free(pattern);
+        FreeInputs(work->inputs, work->count);
+        free(work);
+        napi_throw_error(env, NULL, "Failed to create async work");
+        return NULL;
+    }
+    
+    napi_queue_async_work(env, work->work);
+    
+    return promise;
+}
+
+void ExecuteBuildIndex(napi_env env, void* data) {
+    BuildIndexWork* work = (BuildIndexWork*)data;
+    work->result = perform_batch_index(work->inputs, work->count, &work->options, work->index_path);
+}
+
+void CompleteBuildIndex(napi_env env, napi_status status, void* data) {
+    BuildIndexWork* work = (BuildIndexWork*)data;
+    
+    if (work->result && work->result->error) {
+        RejectWithCode(env, work->deferred, work->result->error_code);
+    }
+    else if (work->result) {
+        napi_value obj, documents, failed, terms, postings;
+        napi_create_object(env, &obj);
+        
+        napi_create_uint32(env, (uint32_t)work->result->document_count, &documents);
+        napi_create_uint32(env, (uint32_t)work->result->failed_count, &failed);
+        napi_create_double(env, (double)work->result->term_count, &terms);
+        napi_create_double(env, (double)work->result->posting_count, &postings);
+        napi_set_named_property(env, obj, "documents", documents);
+        napi_set_named_property(env, obj, "failed", failed);
+        napi_set_named_property(env, obj, "terms", terms);
+        napi_set_named_property(env, obj, "postings", postings);
+        
+        napi_resolve_deferred(env, work->deferred, obj);
+    }
+    else {
+        RejectWithCode(env, work->deferred, OCR_ERROR_OUT_OF_MEMORY);
+    }
+    
+    // Cleanup
+    free_ocr_index_build_result(work->result);
+    FreeInputs(work->inputs, work->count);
+    free(work->index_path);
+    if (work->options.ocr_options.languages && strcmp(work->options.ocr_options.languages, "en-US") != 0) {
+        free((void*)work->options.ocr_options.languages);
+    }
+    napi_delete_async_work(env, work->work);
+    free(work);
+}
+
+static char* GetStringArgument(napi_env env, napi_value value, const char* type_error) {
+    napi_valuetype type;
+    if (napi_typeof(env, value, &type) != napi_ok || type != napi_string) {
+        napi_throw_type_error(env, NULL, type_error);
+        return NULL;
+    }
+    
+    size_t length;
+    napi_get_value_string_utf8(env, value, NULL, 0, &length);
+    char* str = (char*)malloc(length + 1);
+    if (!str) {
+        napi_throw_error(env, NULL, "Failed to allocate memory");
+        return NULL;
+    }
+    napi_get_value_string_utf8(env, value, str, length + 1, NULL);
+    return str;
+}
+
+napi_value BuildIndex(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value args[3];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+    
+    if (argc < 2) {
+        napi_throw_error(env, NULL, "Wrong number of arguments");
+        return NULL;
+    }
+    
+    char* index_path = GetStringArgument(env, args[1], "Index path must be a string");
+    if (!index_path) {
+        return NULL;
+    }
+    
+    BuildIndexWork* work = (BuildIndexWork*)calloc(1, sizeof(BuildIndexWork));
+    if (!work) {
+        free(index_path);
+        napi_throw_error(env, NULL, "Failed to allocate memory");
+        return NULL;
+    }
+    work->index_path = index_path;
+    
+    work->inputs = GetInputsFromArray(env, args[0], &work->count);
+    if (!work->inputs) {
+        free(index_path);
+        free(work);
+        return NULL;
+    }
+    
+    if (!GetBatchOptionsFromObject(env, argc > 2 ? args[2] : NULL, &work->options)) {
+        if (work->options.ocr_options.languages && strcmp(work->options.ocr_options.languages, "en-US") != 0) {
+            free((void*)work->options.ocr_options.languages);
+        }
+        FreeInputs(work->inputs, work->count);
+        free(index_path);
+        free(work);
+        ThrowWithCode(env, OCR_ERROR_INVALID_ARGUMENT);
+        return NULL;
+    }
+    
+    napi_value promise;
+    napi_create_promise(env, &work->deferred, &promise);
+    
+    // Create async work
+    napi_value resource_name;
+    napi_create_string_utf8(env, "BuildIndex", NAPI_AUTO_LENGTH, &resource_name);
+    
+    napi_status status = napi_create_async_work(env,
+                                              NULL,
+                                              resource_name,
+                                              ExecuteBuildIndex,
+                                              CompleteBuildIndex,
+                                              work,
+                                              &work->work);
+    
+    if (status != napi_ok) {
+        if (work->options.ocr_options.languages && strcmp(work->options.ocr_options.languages, "en-US") != 0) {
+            free((void*)work->options.ocr_options.languages);
+        }
+        FreeInputs(work->inputs, work->count);
+        free(index_path);
+        free(work);
+        napi_throw_error(env, NULL, "Failed to create async work");
+        return NULL;
+    }
+    
+    napi_queue_async_work(env, work->work);
+    
+    return promise;
+}
+
+static void FinalizeIndexHandle(napi_env env, void* data, void* hint) {
+    IndexHandle* handle = (IndexHandle*)data;
+    ocr_index_close(handle->index);
+    free(handle);
+}
+
+napi_value OpenIndex(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+    
+    if (argc < 1) {
+        napi_throw_error(env, NULL, "Wrong number of arguments");
+        return NULL;
+    }
+    
+    char* path = GetStringArgument(env, args[0], "Index path must be a string");
+    if (!path) {
+        return NULL;
+    }
+    
+    OCRErrorCode error = OCR_OK;
+    OCRIndex* index = ocr_index_open(path, &error);
+    free(path);
+    if (!index) {
+        ThrowWithCode(env, error);
+        return NULL;
+    }
+    
+    IndexHandle* handle = (IndexHandle*)malloc(sizeof(IndexHandle));
+    if (!handle) {
+        ocr_index_close(index);
+        napi_throw_error(env, NULL, "Failed to allocate memory");
+        return NULL;
+    }
+    handle->index = index;
+    
+    napi_value external;
+    if (napi_create_external(env, handle, FinalizeIndexHandle, NULL, &external) != napi_ok) {
+        ocr_index_close(index);
+        free(handle);
+        napi_throw_error(env, NULL, "Failed to create index handle");
+        return NULL;
+    }
+    return external;
+}
+
+// Returns the open index behind a handle, throwing once it has been closed
+static OCRIndex* GetIndexArgument(napi_env env, napi_value value) {
+    napi_valuetype type;
+    if (napi_typeof(env, value, &type) != napi_ok || type != napi_external) {
+        napi_throw_type_error(env, NULL, "First argument must be an index");
+        return NULL;
+    }
+    IndexHandle* handle;
+    napi_get_value_external(env, value, (void**)&handle);
+    if (!handle->index) {
+        napi_throw_error(env, NULL, "Index is closed");
+        return NULL;
+    }
+    return handle->index;
+}
+
+napi_value LookupIndex(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+    
+    if (argc < 2) {
+        napi_throw_error(env, NULL, "Wrong number of arguments");
+        return NULL;
+    }
+    
+    OCRIndex* index = GetIndexArgument(env, args[0]);
+    if (!index) {
+        return NULL;
+    }
+    char* term = GetStringArgument(env, args[1], "Term must be a string");
+    if (!term) {
+        return NULL;
+    }
+    
+    size_t count = 0;
+    const OCRPosting* postings = ocr_index_lookup(index, term, &count);
+    free(term);
+    
+    napi_value array;
+    napi_create_array_with_length(env, count, &array);
+    for (size_t i = 0; i < count; i++) {
+        napi_value posting_obj, image, observation, position;
+        napi_create_object(env, &posting_obj);
+        napi_create_uint32(env, postings[i].image, &image);
+        napi_create_uint32(env, postings[i].observation, &observation);
+        napi_create_uint32(env, postings[i].position, &position);
+        napi_set_named_property(env, posting_obj, "image", image);
+        napi_set_named_property(env, posting_obj, "observation", observation);
+        napi_set_named_property(env, posting_obj, "position", position);
+        napi_set_element(env, array, i, posting_obj);
+    }
+    return array;
+}
+
+napi_value SearchIndex(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+    
+    if (argc < 2) {
+        napi_throw_error(env, NULL, "Wrong number of arguments");
+        return NULL;
+    }
+    
+    OCRIndex* index = GetIndexArgument(env, args[0]);
+    if (!index) {
+        return NULL;
+    }
+    char* query = GetStringArgument(env, args[1], "Query must be a string");
+    if (!query) {
+        return NULL;
+    }
+    
+    // Count first, then fill an exactly sized array
+    size_t found = ocr_index_search(index, query, NULL, 0);
+    uint32_t* images = (uint32_t*)malloc(sizeof(uint32_t) * (found + 1));
+    if (!images) {
+        free(query);
+        napi_throw_error(env, NULL, "Failed to allocate memory");
+        return NULL;
+    }
+    found = ocr_index_search(index, query, images, found);
+    free(query);
+    
+    napi_value array;
+    napi_create_array_with_length(env, found, &array);
+    for (size_t i = 0; i < found; i++) {
+        napi_value image;
+        napi_create_uint32(env, images[i], &image);
+        napi_set_element(env, array, i, image);
+    }
+    free(images);
+    return array;
+}
+
+napi_value CloseIndex(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+    
+    napi_valuetype type;
+    if (argc < 1 || napi_typeof(env, args[0], &type) != napi_ok || type != napi_external) {
+        napi_throw_type_error(env, NULL, "First argument must be an index");
+        return NULL;
+    }
+    
+    IndexHandle* handle;
+    napi_get_value_external(env, args[0], (void**)&handle);
+    ocr_index_close(handle->index);
+    handle->index = NULL;
+    return NULL;
+}
+
+napi_value Probe(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+    
+    if (argc < 1) {
+        napi_throw_error(env, NULL, "Wrong number of arguments");
+        return NULL;
+    }
+    
+    OCRImageInfo image_info;
+    napi_valuetype type;
+    napi_typeof(env, args[0], &type);
+    if (type == napi_string) {
+        char* path = GetStringArgument(env, args[0], "Image path must be a string");
+        if (!path) {
+            return NULL;
+        }
+        OCRErrorCode error = OCR_OK;
+        bool probed = ocr_image_probe_file(path, &image_info, &error);
+        free(path);
+        if (!probed) {
+            ThrowWithCode(env, error);
+            return NULL;
+        }
+    } else {
+        void* buffer_data;
+        size_t buffer_length;
+        if (napi_get_buffer_info(env, args[0], &buffer_data, &buffer_length) != napi_ok) {
+            napi_throw_type_error(env, NULL, "First argument must be an image path or a Buffer");
+            return NULL;
+        }
+        if (!ocr_image_probe(buffer_data, buffer_length, &image_info)) {
+            ThrowWithCode(env, OCR_ERROR_UNSUPPORTED_FORMAT);
+            return NULL;
+        }
+    }
+    
+    static const char* const format_names[] = {"unknown", "png", "jpeg", "tiff", "gif", "bmp", "webp", "heif"};
+    napi_value obj, format, width, height, bits, components, frames, decoded;
+    napi_create_object(env, &obj);
+    napi_create_string_utf8(env, format_names[image_info.format], NAPI_AUTO_LENGTH, &format);
+    napi_create_double(env, (double)image_info.width, &width);
+    napi_create_double(env, (double)image_info.height, &height);
+    napi_create_int32(env, image_info.bits_per_component, &bits);
+    napi_create_int32(env, image_info.components, &components);
+    napi_create_double(env, (double)image_info.frame_count, &frames);
+    napi_create_double(env, (double)ocr_image_decoded_bytes(&image_info), &decoded);
+    napi_set_named_property(env, obj, "format", format);
+    napi_set_named_property(env, obj, "width", width);
+    napi_set_named_property(env, obj, "height", height);
+    napi_set_named_property(env, obj, "bitsPerComponent", bits);
+    napi_set_named_property(env, obj, "components", components);
+    napi_set_named_property(env, obj, "frameCount", frames);
+    napi_set_named_property(env, obj, "decodedBytes", decoded);
+    return obj;
+}
+
+napi_value GetHedgeStats(napi_env env, napi_callback_info info) {
+    OCRHedgeStats stats;
+    get_ocr_hedge_stats(&stats);
+    
+    napi_value obj, calls, hedged, hedge_wins;
+    napi_create_object(env, &obj);
+    napi_create_double(env, (double)stats.calls, &calls);
+    napi_create_double(env, (double)stats.hedged, &hedged);
+    napi_create_double(env, (double)stats.hedge_wins, &hedge_wins);
+    napi_set_named_property(env, obj, "calls", calls);
+    napi_set_named_property(env, obj, "hedged", hedged);
+    napi_set_named_property(env, obj, "hedgeWins", hedge_wins);
+    return obj;
+}
+
+napi_value GetBlankStats(napi_env env, napi_callback_info info) {
+    OCRBlankStats stats;
+    get_ocr_blank_stats(&stats);
+    
+    napi_value obj, checked, rejected;
+    napi_create_object(env, &obj);
+    napi_create_double(env, (double)stats.checked, &checked);
+    napi_create_double(env, (double)stats.rejected, &rejected);
+    napi_set_named_property(env, obj, "checked", checked);
+    napi_set_named_property(env, obj, "rejected", rejected);
+    return obj;
+}
+
+napi_value GetRoutingStats(napi_env env, napi_callback_info info) {
+    OCRRoutingStats stats;
+    get_ocr_routing_stats(&stats);
+    
+    napi_value obj, routed, narrowed, probe_ms, narrowed_ms, narrowed_megapixels, full_ms, full_megapixels, saved_ms;
+    napi_create_object(env, &obj);
+    napi_create_double(env, (double)stats.routed, &routed);
+    napi_create_double(env, (double)stats.narrowed, &narrowed);
+    napi_create_double(env, stats.probe_ms, &probe_ms);
+    napi_create_double(env, stats.narrowed_ms, &narrowed_ms);
+    napi_create_double(env, stats.narrowed_megapixels, &narrowed_megapixels);
+    napi_create_double(env, stats.full_ms, &full_ms);
+    napi_create_double(env, stats.full_megapixels, &full_megapixels);
+    napi_create_double(env, stats.saved_ms, &saved_ms);
+    napi_set_named_property(env, obj, "routed", routed);
+    napi_set_named_property(env, obj, "narrowed", narrowed);
+    napi_set_named_property(env, obj, "probeMs", probe_ms);
+    napi_set_named_property(env, obj, "narrowedMs", narrowed_ms);
+    napi_set_named_property(env, obj, "narrowedMegapixels", narrowed_megapixels);
+    napi_set_named_property(env, obj, "fullMs", full_ms);
+    napi_set_named_property(env, obj, "fullMegapixels", full_megapixels);
+    napi_set_named_property(env, obj, "savedMs", saved_ms);
+    return obj;
+}
+
+napi_value GetAdmissionStats(napi_env env, napi_callback_info info) {
+    OCRAdmissionStats stats;
+    get_ocr_admission_stats(&stats);
+    
+    napi_value obj, batches, admitted, deferred, wait_ms, peak_in_flight_bytes;
+    napi_create_object(env, &obj);
+    napi_create_double(env, (double)stats.batches, &batches);
+    napi_create_double(env, (double)stats.admitted, &admitted);
+    napi_create_double(env, (double)stats.deferred, &deferred);
+    napi_create_double(env, stats.wait_ms, &wait_ms);
+    napi_create_double(env, (double)stats.peak_in_flight_bytes, &peak_in_flight_bytes);
+    napi_set_named_property(env, obj, "batches", batches);
+    napi_set_named_property(env, obj, "admitted", admitted);
+    napi_set_named_property(env, obj, "deferred", deferred);
+    napi_set_named_property(env, obj, "waitMs", wait_ms);
+    napi_set_named_property(env, obj, "peakInFlightBytes", peak_in_flight_bytes);
+    return obj;
+}
+
+napi_value GetPixelPoolStats(napi_env env, napi_callback_info info) {
+    OCRPixelPoolStats stats;
+    get_ocr_pixel_pool_stats(&stats);
+    
+    napi_value obj, acquired, reused, oversized, in_use_bytes, cached_bytes, high_water_bytes, trimmed_bytes;
+    napi_create_object(env, &obj);
+    napi_create_double(env, (double)stats.acquired, &acquired);
+    napi_create_double(env, (double)stats.reused, &reused);
+    napi_create_double(env, (double)stats.oversized, &oversized);
+    napi_create_double(env, (double)stats.in_use_bytes, &in_use_bytes);
+    napi_create_double(env, (double)stats.cached_bytes, &cached_bytes);
+    napi_create_double(env, (double)stats.high_water_bytes, &high_water_bytes);
+    napi_create_double(env, (double)stats.trimmed_bytes, &trimmed_bytes);
+    napi_set_named_property(env, obj, "acquired", acquired);
+    napi_set_named_property(env, obj, "reused", reused);
+    napi_set_named_property(env, obj, "oversized", oversized);
+    napi_set_named_property(env, obj, "inUseBytes", in_use_bytes);
+    napi_set_named_property(env, obj, "cachedBytes", cached_bytes);
+    napi_set_named_property(env, obj, "highWaterBytes", high_water_bytes);
+    napi_set_named_property(env, obj, "trimmedBytes", trimmed_bytes);
+    return obj;
+}
+
+static void FreeFrameSessionHandle(FrameSessionHandle* handle) {
+    free_ocr_frame_session(handle->session);
+    free(handle);
+}
+
+static void FinalizeFrameSessionHandle(napi_env env, void* data, void* hint) {
+    FrameSessionHandle* handle = (FrameSessionHandle*)data;
+    if (handle->closed) {
+        // Closed with no frame in flight; the session is already gone
+        free(handle);
+        return;
+    }
+    FreeFrameSessionHandle(handle);
+}
+
+napi_value CreateFrameSession(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+    
+    OCROptions options;
+    if (!GetOptionsFromObject(env, argc > 0 ? args[0] : NULL, &options)) {
+        ThrowWithCode(env, OCR_ERROR_INVALID_ARGUMENT);
+        return NULL;
+    }
+    
+    uint32_t tile_size = 0;
+    if (argc > 1) {
+        napi_get_value_uint32(env, args[1], &tile_size);
+    }
+    
+    OCRFrameSession* session = create_ocr_frame_session(&options, tile_size);
+    if (options.languages && strcmp(options.languages, "en-US") != 0) {
+        free((void*)options.languages);
+    }
+    if (!session) {
+        napi_throw_error(env, NULL, "Failed to create frame session");
+        return NULL;
+    }
+    
+    FrameSessionHandle* handle = (FrameSessionHandle*)malloc(sizeof(FrameSessionHandle));
+    if (!handle) {
+        free_ocr_frame_session(session);
+        napi_throw_error(env, NULL, "Failed to allocate memory");
+        return NULL;
+    }
+    handle->session = session;
+    handle->pending = 0;
+    handle->closed = false;
+    
+    napi_value external;
+    if (napi_create_external(env, handle, FinalizeFrameSessionHandle, NULL, &external) != napi_ok) {
+        FreeFrameSessionHandle(handle);
+        napi_throw_error(env, NULL, "Failed to create frame session handle");
+        return NULL;
+    }
+    return external;
+}
+
+// Returns the open session handle behind a value, throwing once it has been closed
+static FrameSessionHandle* GetFrameSessionArgument(napi_env env, napi_value value) {
+    napi_valuetype type;
+    if (napi_typeof(env, value, &type) != napi_ok || type != napi_external) {
+        napi_throw_type_error(env, NULL, "First argument must be a frame session");
+        return NULL;
+    }
+    FrameSessionHandle* handle;
+    napi_get_value_external(env, value, (void**)&handle);
+    if (handle->closed) {
+        napi_throw_error(env, NULL, "Frame session is closed");
+        return NULL;
+    }
+    return handle;
+}
+
+void ExecuteFrameOCR(napi_env env, void* data) {
+    FrameWork* work = (FrameWork*)data;
+    
+    OCRErrorCode error = OCR_OK;
+    CGImageRef image = work->input.path ?
+        CreateCGImageFromPath(work->input.path, &error) :
+        CreateCGImageFromBuffer(work->input.buffer, work->input.length, &error);
+    if (!image) {
+        work->error_code = error != OCR_OK ? error : OCR_ERROR_DECODE_FAILED;
+        return;
+    }
+    
+    work->result = perform_frame_ocr(work->handle->session, image);
+    
+    CGImageRelease(image);
+}
+
+void CompleteFrameOCR(napi_env env, napi_status status, void* data) {
+    FrameWork* work = (FrameWork*)data;
+    
+    OCRErrorCode code = work->error_code != OCR_OK ? work->error_code :
+        work->result ? work->result->error_code : OCR_ERROR_OUT_OF_MEMORY;
+    if (code != OCR_OK) {
+        RejectWithCode(env, work->deferred, code);
+    } else {
+        napi_value obj = CreateResultObject(env, work->result);
+        napi_resolve_deferred(env, work->deferred, obj);
+    }
+    
+    FrameSessionHandle* handle = work->handle;
+    handle->pending--;
+    if (handle->closed && handle->pending == 0) {
+        free_ocr_frame_session(handle->session);
+        handle->session = NULL;
+    }
+    napi_delete_reference(env, work->handle_ref);
+    
+    free_ocr_result(work->result);
+    free((void*)work->input.path);
+    free((void*)work->input.buffer);
+    napi_delete_async_work(env, work->work);
+    free(work);
+}
+
+napi_value RecognizeFrame(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+    
+    if (argc < 2) {
+        napi_throw_error(env, NULL, "Wrong number of arguments");
+        return NULL;
+    }
+    
+    FrameSessionHandle* handle = GetFrameSessionArgument(env, args[0]);
+    if (!handle) {
+        return NULL;
+    }
+    
+    FrameWork* work = (FrameWork*)calloc(1, sizeof(FrameWork));
+    if (!work) {
+        napi_throw_error(env, NULL, "Failed to allocate memory");
+        return NULL;
+    }
+    
+    napi_valuetype type;
+    napi_typeof(env, args[1], &type);
+    if (type == napi_string) {
+        work->input.path = GetStringArgument(env, args[1], "Frame must be an image path or a Buffer");
+        if (!work->input.path) {
+            free(work);
+            return NULL;
+        }
+    } else {
+        void* buffer_data;
+        size_t buffer_length;
+        if (napi_get_buffer_info(env, args[1], &buffer_data, &buffer_length) != napi_ok) {
+            free(work);
+            napi_throw_type_error(env, NULL, "Frame must be an image path or a Buffer");
+            return NULL;
+        }
+        void* copy = malloc(buffer_length > 0 ? buffer_length : 1);
+        if (!copy) {
+            free(work);
+            napi_throw_error(env, NULL, "Failed to allocate memory for buffer");
+            return NULL;
+        }
+        memcpy(copy, buffer_data, buffer_length);
+        work->input.buffer = copy;
+        work->input.length = buffer_length;
+    }
+    work->handle = handle;
+    
+    napi_value promise;
+    napi_create_promise(env, &work->deferred, &promise);
+    
+    napi_value resource_name;
+    napi_create_string_utf8(env, "FrameOCR", NAPI_AUTO_LENGTH, &resource_name);
+    if (napi_create_async_work(env, NULL, resource_name, ExecuteFrameOCR, CompleteFrameOCR, work, &work->work) != napi_ok) {
+        free((void*)work->input.path);
+        free((void*)work->input.buffer);
+        free(work);
+        napi_throw_error(env, NULL, "Failed to create async work");
+        return NULL;
+    }
+    
+    // Keep the session alive until the frame completes
+    napi_create_reference(env, args[0], 1, &work->handle_ref);
+    handle->pending++;
+    napi_queue_async_work(env, work->work);
+    
+    return promise;
+}
+
+napi_value ResetFrameSession(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+    
+    FrameSessionHandle* handle = argc > 0 ? GetFrameSessionArgument(env, args[0]) : NULL;
+    if (!handle) {
+        if (argc == 0) napi_throw_error(env, NULL, "Wrong number of arguments");
+        return NULL;
+    }
+    reset_ocr_frame_session(handle->session);
+    return NULL;
+}
+
+napi_value CloseFrameSession(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+    
+    napi_valuetype type;
+    if (argc < 1 || napi_typeof(env, args[0], &type) != napi_ok || type != napi_external) {
+        napi_throw_type_error(env, NULL, "First argument must be a frame session");
+        return NULL;
+    }
+    
+    FrameSessionHandle* handle;
+    napi_get_value_external(env, args[0], (void**)&handle);
+    if (handle->closed) {
+        return NULL;
+    }
+    handle->closed = true;
+    if (handle->pending == 0) {
+        free_ocr_frame_session(handle->session);
+        handle->session = NULL;
+    }
+    return NULL;
+}
+
+napi_value CreateSpatialIndex(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+    
+    bool is_typedarray = false;
+    if (argc < 1 || napi_is_typedarray(env, args[0], &is_typedarray) != napi_ok || !is_typedarray) {
+        napi_throw_type_error(env, NULL, "First argument must be a Float64Array of boxes");
+        return NULL;
+    }
+    
+    napi_typedarray_type type;
+    size_t length;
+    void* data;
+    napi_get_typedarray_info(env, args[0], &type, &length, &data, NULL, NULL);
+    if (type != napi_float64_array || length % 4 != 0) {
+        napi_throw_type_error(env, NULL, "First argument must be a Float64Array of x, y, width, height quads");
+        return NULL;
+    }
+    
+    OCRSpatialIndex* index = ocr_spatial_index_create((const double*)data, length / 4);
+    if (!index) {
+        napi_throw_error(env, NULL, "Failed to allocate memory for spatial index");
+        return NULL;
+    }
+    
+    napi_value external;
+    if (napi_create_external(env, index, FinalizeSpatialIndex, NULL, &external) != napi_ok) {
+        ocr_spatial_index_free(index);
+        napi_throw_error(env, NULL, "Failed to create spatial index");
+        return NULL;
+    }
+    return external;
+}
+
+static bool GetSpatialIndexArgument(napi_env env, napi_value value, OCRSpatialIndex** out_index) {
+    napi_valuetype type;
+    if (napi_typeof(env, value, &type) != napi_ok || type != napi_external) {
+        napi_throw_type_error(env, NULL, "First argument must be a spatial index");
+        return false;
+    }
+    napi_get_value_external(env, value, (void**)out_index);
+    return true;
+}
+
+static napi_value CreateIdArray(napi_env env, const size_t* ids, size_t count) {
+    napi_value array;
+    napi_create_array_with_length(env, count, &array);
+    for (size_t i = 0; i < count; i++) {
+        napi_value id;
+        napi_create_uint32(env, (uint32_t)ids[i], &id);
+        napi_set_element(env, array, i, id);
+    }
+    return array;
+}
+
+napi_value QuerySpatialIndex(napi_env env, napi_callback_info info) {
+    size_t argc = 5;
+    napi_value args[5];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+    
+    if (argc < 5) {
+        napi_throw_error(env, NULL, "Wrong number of arguments");
+        return NULL;
+    }
+    
+    OCRSpatialIndex* index;
+    if (!GetSpatialIndexArgument(env, args[0], &index)) {
+        return NULL;
+    }
+    
+    double rect[4];
+    for (size_t i = 0; i < 4; i++) {
+        if (napi_get_value_double(env, args[i + 1], &rect[i]) != napi_ok) {
+            napi_throw_type_error(env, NULL, "Rectangle must be numbers");
+            return NULL;
+        }
+    }
+    
+    // The result count is bounded by the number of boxes, so one pass is enough
+    size_t capacity = ocr_spatial_index_count(index);
+    size_t* ids = (size_t*)malloc(sizeof(size_t) * (capacity + 1));
+    if (!ids) {
+        napi_throw_error(env, NULL, "Failed to allocate memory");
+        return NULL;
+    }
+    size_t found = ocr_spatial_index_query(index, rect[0], rect[1], rect[2], rect[3], ids, capacity);
+    napi_value result = CreateIdArray(env, ids, found);
+    free(ids);
+    return result;
+}
+
+napi_value NearestInSpatialIndex(napi_env env, napi_callback_info info) {
+    size_t argc = 4;
+    napi_value args[4];
+    napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+    
+    if (argc < 4) {
+        napi_throw_error(env, NULL, "Wrong number of arguments");
+        return NULL;
+    }
+    
+    OCRSpatialIndex* index;
+    if (!GetSpatialIndexArgument(env, args[0], &index)) {
+        return NULL;
+    }
+    
+    double x, y;
+    uint32_t k;
+    if (napi_get_value_double(env, args[1], &x) != napi_ok ||
+        napi_get_value_double(env, args[2], &y) != napi_ok ||
+        napi_get_value_uint32(env, args[3], &k) != napi_ok) {
+        napi_throw_type_error(env, NULL, "Point and count must be numbers");
+        return NULL;
+    }
+    
+    size_t count = ocr_spatial_index_count(index);
+    if (k > count) {
+        k = (uint32_t)count;
+    }
+    size_t* ids = (size_t*)malloc(sizeof(size_t) * (k + 1));
+    if (!ids) {
+        napi_throw_error(env, NULL, "Failed to allocate memory");
+        return NULL;
+    }
+    size_t found = ocr_spatial_index_nearest(index, x, y, k, ids);
+    napi_value result = CreateIdArray(env, ids, found);
+    free(ids);
+    return result;
+}
+
+napi_value Init(napi_env env, napi_value exports) {
+    napi_value recognize_fn;
+    napi_create_function(env, NULL, 0, Recognize, NULL, &recognize_fn);
+    napi_set_named_property(env, exports, "recognize", recognize_fn);
+    
+    napi_value recognize_buffer_fn;
+    napi_create_function(env, NULL, 0, RecognizeBuffer, NULL, &recognize_buffer_fn);
+    napi_set_named_property(env, exports, "recognizeBuffer", recognize_buffer_fn);
+    
+    napi_value recognize_batch_fn;
+    napi_create_function(env, NULL, 0, RecognizeBatch, NULL, &recognize_batch_fn);
+    napi_set_named_property(env, exports, "recognizeBatch", recognize_batch_fn);
+    
+    napi_value recognize_batch_buffer_fn;
+    napi_create_function(env, NULL, 0, RecognizeBatchFromBuffer, NULL, &recognize_batch_buffer_fn);
+    napi_set_named_property(env, exports, "recognizeBatchFromBuffer", recognize_batch_buffer_fn);
+    
+    napi_value find_text_fn;
+    napi_create_function(env, NULL, 0, FindText, NULL, &find_text_fn);
+    napi_set_named_property(env, exports, "findText", find_text_fn);
+    
+    napi_value create_spatial_index_fn;
+    napi_create_function(env, NULL, 0, CreateSpatialIndex, NULL, &create_spatial_index_fn);
+    napi_set_named_property(env, exports, "createSpatialIndex", create_spatial_index_fn);
+    
+    napi_value query_spatial_index_fn;
+    napi_create_function(env, NULL, 0, QuerySpatialIndex, NULL, &query_spatial_index_fn);
+    napi_set_named_property(env, exports, "querySpatialIndex", query_spatial_index_fn);
+    
+    napi_value nearest_spatial_index_fn;
+    napi_create_function(env, NULL, 0, NearestInSpatialIndex, NULL, &nearest_spatial_index_fn);
+    napi_set_named_property(env, exports, "nearestInSpatialIndex", nearest_spatial_index_fn);
+    
+    napi_value build_index_fn;
+    napi_create_function(env, NULL, 0, BuildIndex, NULL, &build_index_fn);
+    napi_set_named_property(env, exports, "buildIndex", build_index_fn);
+    
+    napi_value open_index_fn;
+    napi_create_function(env, NULL, 0, OpenIndex, NULL, &open_index_fn);
+    napi_set_named_property(env, exports, "openIndex", open_index_fn);
+    
+    napi_value lookup_index_fn;
+    napi_create_function(env, NULL, 0, LookupIndex, NULL, &lookup_index_fn);
+    napi_set_named_property(env, exports, "lookupIndex", lookup_index_fn);
+    
+    napi_value search_index_fn;
+    napi_create_function(env, NULL, 0, SearchIndex, NULL, &search_index_fn);
+    napi_set_named_property(env, exports, "searchIndex", search_index_fn);
+    
+    napi_value close_index_fn;
+    napi_create_function(env, NULL, 0, CloseIndex, NULL, &close_index_fn);
+    napi_set_named_property(env, exports, "closeIndex", close_index_fn);
+    
+    napi_value probe_fn;
+    napi_create_function(env, NULL, 0, Probe, NULL, &probe_fn);
+    napi_set_named_property(env, exports, "probe", probe_fn);
+    
+    napi_value get_hedge_stats_fn;
+    napi_create_function(env, NULL, 0, GetHedgeStats, NULL, &get_hedge_stats_fn);
+    napi_set_named_property(env, exports, "getHedgeStats", get_hedge_stats_fn);
+    
+    napi_value get_blank_stats_fn;
+    napi_create_function(env, NULL, 0, GetBlankStats, NULL, &get_blank_stats_fn);
+    napi_set_named_property(env, exports, "getBlankStats", get_blank_stats_fn);
+    
+    napi_value get_routing_stats_fn;
+    napi_create_function(env, NULL, 0, GetRoutingStats, NULL, &get_routing_stats_fn);
+    napi_set_named_property(env, exports, "getRoutingStats", get_routing_stats_fn);
+    
+    napi_value get_admission_stats_fn;
+    napi_create_function(env, NULL, 0, GetAdmissionStats, NULL, &get_admission_stats_fn);
+    napi_set_named_property(env, exports, "getAdmissionStats", get_admission_stats_fn);
+    
+    napi_value get_pixel_pool_stats_fn;
+    napi_create_function(env, NULL, 0, GetPixelPoolStats, NULL, &get_pixel_pool_stats_fn);
+    napi_set_named_property(env, exports, "getPixelPoolStats", get_pixel_pool_stats_fn);
+    
+    napi_value create_frame_session_fn;
+    napi_create_function(env, NULL, 0, CreateFrameSession, NULL, &create_frame_session_fn);
+    napi_set_named_property(env, exports, "createFrameSession", create_frame_session_fn);
+    
+    napi_value recognize_frame_fn;
+    napi_create_function(env, NULL, 0, RecognizeFrame, NULL, &recognize_frame_fn);
+    napi_set_named_property(env, exports, "recognizeFrame", recognize_frame_fn);
+    
+    napi_value reset_frame_session_fn;
+    napi_create_function(env, NULL, 0, ResetFrameSession, NULL, &reset_frame_session_fn);
+    napi_set_named_property(env, exports, "resetFrameSession", reset_frame_session_fn);
+    
+    napi_value close_frame_session_fn;
+    napi_create_function(env, NULL, 0, CloseFrameSession, NULL, &close_frame_session_fn);
+    napi_set_named_property(env, exports, "closeFrameSession", close_frame_session_fn);
+    
+    napi_value recognize_option_sets_fn;
+    napi_create_function(env, NULL, 0, RecognizeOptionSets, NULL, &recognize_option_sets_fn);
+    napi_set_named_property(env, exports, "recognizeOptionSets", recognize_option_sets_fn);
     
     return exports;
 }
@@ -0,0 +1,253 @@
+#include "byte_budget.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <vector>
+
+struct OCRByteBudget {
+    std::mutex mutex;
+    std::condition_variable released;
+    size_t capacity;
+    size_t held;
+    size_t peak;
+};
+
+struct OCRAdmission {
+    struct Waiting {
+        size_t index;
+        size_t bytes;
+    };
+
+    OCRByteBudget* budget;
+    size_t count;
+    size_t next;
+    OCRSizeEstimator estimate;
+    void* context;
+    std::deque<Waiting> waiting;
+    size_t bypassed;            // admissions that went ahead of the oldest set-aside input
+    size_t deferred;
+    double waited_ms;
+};
+
+namespace {
+
+// Inputs looked at past a set-aside one before waiting, and admissions allowed ahead of
+// the oldest set-aside input before it is waited for alone
+const size_t kMaxWaiting = 64;
+const size_t kMaxBypass = 64;
+
+size_t Clamp(const OCRByteBudget* budget, size_t bytes) {
+    return budget->capacity > 0 ? std::min(bytes, budget->capacity) : bytes;
+}
+
+bool Fits(const OCRByteBudget* budget, size_t bytes) {
+    return budget->capacity == 0 || bytes <= budget->capacity - budget->held;
+}
+
+void Take(OCRByteBudget* budget, size_t bytes) {
+    budget->held += bytes;
+    budget->peak = std::max(budget->peak, budget->held);
+}
+
+bool Admit(OCRAdmission* admission, size_t position, size_t* index, size_t* bytes) {
+    const OCRAdmission::Waiting& chosen = admission->waiting[position];
+    *index = chosen.index;
+    *bytes = chosen.bytes;
+    admission->bypassed = position == 0 ? 0 : admission->bypassed + 1;
+    admission->waiting.erase(admission->waiting.begin() + position);
+    return true;
+}
+
+} // namespace
+
+OCRByteBudget* ocr_byte_budget_create(size_t capacity) {
+    OCRByteBudget* budget = new (std::nothrow) OCRByteBudget();
+    if (!budget) {
+        return NULL;
+    }
+    budget->capacity = capacity;
+    budget->held = 0;
+    budget->peak = 0;
+    return budget;
+}
+
+bool ocr_byte_budget_try_acquire(OCRByteBudget* budget, size_t bytes) {
+    if (!budget) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(budget->mutex);
+    bytes = Clamp(budget, bytes);
+    if (!Fits(budget, bytes)) {
+        return false;
+    }
+    Take(budget, bytes);
+    return true;
+}
+
+double ocr_byte_budget_acquire(OCRByteBudget* budget, size_t bytes) {
+    if (!budget) {
+        return 0.0;
+    }
+    std::unique_lock<std::mutex> lock(budget->mutex);
+    bytes = Clamp(budget, bytes);
+    if (Fits(budget, bytes)) {
+        Take(budget, bytes);
+        return 0.0;
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    budget->released.wait(lock, [budget, bytes] { return Fits(budget, bytes); });
+    Take(budget, bytes);
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void ocr_byte_budget_release(OCRByteBudget* budget, size_t bytes) {
+    if (!budget) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(budget->mutex);
+        bytes = Clamp(budget, bytes);
+        budget->held -= std::min(bytes, budget->held);
+    }
+    budget->released.notify_all();
+}
+
+double ocr_byte_budget_acquire_any(OCRByteBudget* budget, const size_t* sizes, size_t count, size_t* chosen) {
+    if (!budget || !sizes || count == 0 || !chosen) {
+        return 0.0;
+    }
+    std::unique_lock<std::mutex> lock(budget->mutex);
+    size_t bytes = 0;
+    auto any_fits = [budget, sizes, count, chosen, &bytes] {
+        for (size_t i = 0; i < count; i++) {
+            if (Fits(budget, Clamp(budget, sizes[i]))) {
+                *chosen = i;
+                bytes = Clamp(budget, sizes[i]);
+                return true;
+            }
+        }
+        return false;
+    };
+    if (any_fits()) {
+        Take(budget, bytes);
+        return 0.0;
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    budget->released.wait(lock, any_fits);
+    Take(budget, bytes);
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+size_t ocr_byte_budget_peak(OCRByteBudget* budget) {
+    if (!budget) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(budget->mutex);
+    return budget->peak;
+}
+
+void ocr_byte_budget_free(OCRByteBudget* budget) {
+    delete budget;
+}
+
+OCRAdmission* ocr_admission_create(OCRByteBudget* budget, size_t count, OCRSizeEstimator estimate, void* context) {
+    if (!budget || !estimate) {
+        return NULL;
+    }
+    OCRAdmission* admission = new (std::nothrow) OCRAdmission();
+    if (!admission) {
+        return NULL;
+    }
+    admission->budget = budget;
+    admission->count = count;
+    admission->next = 0;
+    admission->estimate = estimate;
+    admission->context = context;
+    admission->bypassed = 0;
+    admission->deferred = 0;
+    admission->waited_ms = 0.0;
+    return admission;
+}
+
+bool ocr_admission_next(OCRAdmission* admission, size_t* index, size_t* bytes) {
+    if (!admission || !index || !bytes) {
+        return false;
+    }
+    // Nothing can be set aside under an unlimited budget, so inputs are not estimated
+    if (admission->budget->capacity == 0) {
+        if (admission->next == admission->count) {
+            return false;
+        }
+        *index = admission->next++;
+        *bytes = 0;
+        return true;
+    }
+    try {
+        bool starving = admission->bypassed >= kMaxBypass;
+        if (!starving) {
+            for (size_t i = 0; i < admission->waiting.size(); i++) {
+                if (ocr_byte_budget_try_acquire(admission->budget, admission->waiting[i].bytes)) {
+                    return Admit(admission, i, index, bytes);
+                }
+            }
+            while (admission->next < admission->count && admission->waiting.size() < kMaxWaiting) {
+                size_t candidate = admission->next;
+                size_t estimate = admission->estimate(admission->context, candidate);
+                if (ocr_byte_budget_try_acquire(admission->budget, estimate)) {
+                    if (!admission->waiting.empty()) {
+                        admission->bypassed++;
+                    }
+                    admission->next++;
+                    *index = candidate;
+                    *bytes = estimate;
+                    return true;
+                }
+                admission->waiting.push_back({candidate, estimate});
+                admission->next++;
+                admission->deferred++;
+            }
+        }
+        if (admission->waiting.empty()) {
+            return false;
+        }
+
+        size_t chosen = 0;
+        if (starving) {
+            admission->waited_ms += ocr_byte_budget_acquire(admission->budget, admission->waiting.front().bytes);
+        } else {
+            std::vector<size_t> sizes;
+            sizes.reserve(admission->waiting.size());
+            for (const OCRAdmission::Waiting& waiting : admission->waiting) {
+                sizes.push_back(waiting.bytes);
+            }
+            admission->waited_ms += ocr_byte_budget_acquire_any(admission->budget, sizes.data(), sizes.size(), &chosen);
+        }
+        return Admit(admission, chosen, index, bytes);
+    } catch (const std::bad_alloc&) {
+        // Without room to set more inputs aside, admit in order
+        if (!admission->waiting.empty()) {
+            admission->waited_ms += ocr_byte_budget_acquire(admission->budget, admission->waiting.front().bytes);
+            return Admit(admission, 0, index, bytes);
+        }
+        if (admission->next < admission->count) {
+            *index = admission->next++;
+            *bytes = admission->estimate(admission->context, *index);
+            admission->waited_ms += ocr_byte_budget_acquire(admission->budget, *bytes);
+            return true;
+        }
+        return false;
+    }
+}
+
+void ocr_admission_stats(const OCRAdmission* admission, size_t* deferred, double* waited_ms) {
+    if (deferred) *deferred = admission ? admission->deferred : 0;
+    if (waited_ms) *waited_ms = admission ? admission->waited_ms : 0.0;
+}
+
+void ocr_admission_free(OCRAdmission* admission) {
+    delete admission;
+}
@@ -0,0 +1,124 @@
+#ifndef MAC_OCR_BYTE_BUDGET_H
+#define MAC_OCR_BYTE_BUDGET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Counting semaphore over bytes, shared by the workers of one batch
+ */
+typedef struct OCRByteBudget OCRByteBudget;
+
+/**
+ * Create a byte budget
+ * @param capacity bytes that may be held at once, 0 for no limit (holdings are still tracked)
+ * @return budget, NULL if memory allocation fails
+ */
+OCRByteBudget* ocr_byte_budget_create(size_t capacity);
+
+/**
+ * Take bytes if they fit the remaining budget
+ * A request larger than the capacity is clamped to it, so it fits once nothing else is held
+ * @param budget byte budget
+ * @param bytes bytes to take
+ * @return true if the bytes were taken
+ */
+bool ocr_byte_budget_try_acquire(OCRByteBudget* budget, size_t bytes);
+
+/**
+ * Take bytes, waiting until enough are released
+ * Requests larger than the capacity are clamped as in ocr_byte_budget_try_acquire
+ * @param budget byte budget
+ * @param bytes bytes to take
+ * @return milliseconds spent waiting
+ */
+double ocr_byte_budget_acquire(OCRByteBudget* budget, size_t bytes);
+
+/**
+ * Return bytes taken by ocr_byte_budget_try_acquire or ocr_byte_budget_acquire
+ * @param budget byte budget
+ * @param bytes the same count that was taken
+ */
+void ocr_byte_budget_release(OCRByteBudget* budget, size_t bytes);
+
+/**
+ * Take the first of several byte counts that fits, waiting until one does
+ * @param budget byte budget
+ * @param sizes byte counts in order of preference
+ * @param count number of byte counts, at least 1
+ * @param chosen receives the index of the count taken
+ * @return milliseconds spent waiting
+ */
+double ocr_byte_budget_acquire_any(OCRByteBudget* budget, const size_t* sizes, size_t count, size_t* chosen);
+
+/**
+ * Most bytes held at once since the budget was created, after clamping
+ * @param budget byte budget
+ * @return peak holding
+ */
+size_t ocr_byte_budget_peak(OCRByteBudget* budget);
+
+/**
+ * Free a byte budget; nothing may be held or waiting
+ * @param budget byte budget, may be NULL
+ */
+void ocr_byte_budget_free(OCRByteBudget* budget);
+
+/**
+ * Estimated bytes an input will hold while it is processed
+ */
+typedef size_t (*OCRSizeEstimator)(void* context, size_t index);
+
+/**
+ * Hands out the inputs of a batch under a byte budget
+ * An input that does not fit the remaining budget is set aside and later inputs that fit
+ * go ahead of it, so large images wait while small ones keep flowing. Set-aside inputs
+ * are retried first, in order; once the oldest has been passed over 64 times, nothing
+ * else is admitted until it fits
+ */
+typedef struct OCRAdmission OCRAdmission;
+
+/**
+ * Create an admission queue over inputs 0..count-1
+ * @param budget byte budget the inputs are admitted against, owned by the caller
+ * @param count number of inputs
+ * @param estimate called for each input from the thread calling ocr_admission_next; not called
+ *        when the budget has no limit
+ * @param context passed to estimate
+ * @return admission queue, NULL if memory allocation fails
+ */
+OCRAdmission* ocr_admission_create(OCRByteBudget* budget, size_t count, OCRSizeEstimator estimate, void* context);
+
+/**
+ * Admit the next input, waiting for budget if nothing fits
+ * @param admission admission queue
+ * @param index receives the input index
+ * @param bytes receives the bytes taken, to release with ocr_byte_budget_release when the input is done;
+ *        0 when the budget has no limit
+ * @return false once every input has been admitted
+ */
+bool ocr_admission_next(OCRAdmission* admission, size_t* index, size_t* bytes);
+
+/**
+ * Admission counters
+ * @param admission admission queue
+ * @param deferred receives the number of inputs set aside because they did not fit, may be NULL
+ * @param waited_ms receives the total time ocr_admission_next waited for budget, may be NULL
+ */
+void ocr_admission_stats(const OCRAdmission* admission, size_t* deferred, double* waited_ms);
+
+/**
+ * Free an admission queue
+ * @param admission admission queue, may be NULL
+ */
+void ocr_admission_free(OCRAdmission* admission);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MAC_OCR_BYTE_BUDGET_H
@@ -0,0 +1,173 @@
+#include "cascade.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+#include "region_util.h"
+
+using ocr::FreeObservation;
+using ocr::MergeRegions;
+using ocr::Rect;
+
+namespace {
+
+// Margins are in multiples of the observation height, so a region keeps whole
+// glyphs and some context around a word whose box was cut short by the fast pass
+const double kHorizontalMarginRatio = 1.0;
+const double kVerticalMarginRatio = 0.5;
+const double kMaxEscalatedShare = 0.5;  // share of unsure fast observations that re-runs the whole image
+
+// Heights are fractions of the image height and widths of its width, so the horizontal
+// margin is divided by the aspect ratio to come out the same number of pixels
+Rect Grow(const TextObservation& obs, double aspect_ratio) {
+    double dx = obs.height * kHorizontalMarginRatio / aspect_ratio;
+    double dy = obs.height * kVerticalMarginRatio;
+    return {std::max(0.0, obs.x - dx), std::max(0.0, obs.y - dy),
+            std::min(1.0, obs.x + obs.width + dx), std::min(1.0, obs.y + obs.height + dy)};
+}
+
+bool Publish(const std::vector<TextObservation>& kept, TextObservation** observations, size_t* count) {
+    if (kept.empty()) {
+        return true;
+    }
+    *observations = static_cast<TextObservation*>(malloc(sizeof(TextObservation) * kept.size()));
+    if (!*observations) {
+        return false;
+    }
+    memcpy(*observations, kept.data(), sizeof(TextObservation) * kept.size());
+    *count = kept.size();
+    return true;
+}
+
+} // namespace
+
+bool ocr_cascade_recognize(double threshold, double aspect_ratio, OCRRecognizeFn recognize, void* context,
+                           TextObservation** observations, size_t* count, OCRCascadeStats* stats) {
+    if (!recognize || !observations || !count || !(aspect_ratio > 0.0)) {
+        return false;
+    }
+    *observations = NULL;
+    *count = 0;
+    OCRCascadeStats local = {0, 0, 0, false};
+
+    const OCRRegion full = {0.0, 0.0, 1.0, 1.0};
+    TextObservation* fast = NULL;
+    size_t fast_count = 0;
+    if (!recognize(context, OCR_RECOGNITION_LEVEL_FAST, &full, &fast, &fast_count)) {
+        return false;
+    }
+    local.fast_count = fast_count;
+
+    std::vector<size_t> escalated;
+    for (size_t i = 0; i < fast_count; i++) {
+        if (fast[i].confidence < threshold) {
+            escalated.push_back(i);
+        }
+    }
+    local.escalated_count = escalated.size();
+
+    if (escalated.empty() && fast_count > 0) {
+        *observations = fast;
+        *count = fast_count;
+        if (stats) *stats = local;
+        return true;
+    }
+
+    if (fast_count == 0 || escalated.size() > kMaxEscalatedShare * fast_count) {
+        ocr_observations_free(fast, fast_count);
+        local.image_escalated = true;
+        if (!recognize(context, OCR_RECOGNITION_LEVEL_ACCURATE, &full, observations, count)) {
+            return false;
+        }
+        if (stats) *stats = local;
+        return true;
+    }
+
+    std::vector<TextObservation> merged;
+    std::vector<bool> replaced(fast_count, false);
+    try {
+        std::vector<Rect> grown;
+        grown.reserve(escalated.size());
+        for (size_t index : escalated) {
+            grown.push_back(Grow(fast[index], aspect_ratio));
+        }
+        std::vector<Rect> regions = MergeRegions(grown);
+        local.region_count = regions.size();
+
+        for (const Rect& rect : regions) {
+            OCRRegion region = {rect.left, rect.bottom, rect.right - rect.left, rect.top - rect.bottom};
+            TextObservation* accurate = NULL;
+            size_t accurate_count = 0;
+            if (!recognize(context, OCR_RECOGNITION_LEVEL_ACCURATE, &region, &accurate, &accurate_count)) {
+                ocr_observations_free(fast, fast_count);
+                for (TextObservation& obs : merged) FreeObservation(obs);
+                return false;
+            }
+
+            // Reserve up front so ownership never splits between arrays on failure
+            try {
+                merged.reserve(merged.size() + accurate_count + fast_count);
+            } catch (const std::bad_alloc&) {
+                ocr_observations_free(accurate, accurate_count);
+                throw;
+            }
+
+            // Keep the accurate reading only where it found text; words cut by the
+            // region border belong to their neighbours and are dropped
+            bool found = false;
+            for (size_t i = 0; i < accurate_count; i++) {
+                if (rect.ContainsCenterOf(accurate[i])) {
+                    merged.push_back(accurate[i]);
+                    found = true;
+                } else {
+                    FreeObservation(accurate[i]);
+                }
+            }
+            free(accurate);
+
+            if (found) {
+                for (size_t i = 0; i < fast_count; i++) {
+                    if (!replaced[i] && rect.ContainsCenterOf(fast[i])) {
+                        replaced[i] = true;
+                    }
+                }
+            }
+        }
+
+        merged.reserve(merged.size() + fast_count);
+        for (size_t i = 0; i < fast_count; i++) {
+            if (replaced[i]) {
+                FreeObservation(fast[i]);
+            } else {
+                merged.push_back(fast[i]);
+            }
+        }
+        free(fast);
+        fast = NULL;
+    } catch (const std::bad_alloc&) {
+        if (fast) {
+            ocr_observations_free(fast, fast_count);
+        }
+        for (TextObservation& obs : merged) FreeObservation(obs);
+        return false;
+    }
+
+    if (!Publish(merged, observations, count)) {
+        for (TextObservation& obs : merged) FreeObservation(obs);
+        return false;
+    }
+    if (stats) *stats = local;
+    return true;
+}
+
+void ocr_observations_free(TextObservation* observations, size_t count) {
+    if (!observations) return;
+
+    for (size_t i = 0; i < count; i++) {
+        FreeObservation(observations[i]);
+    }
+    free(observations);
+}
@@ -0,0 +1,74 @@
+#ifndef MAC_OCR_CASCADE_H
+#define MAC_OCR_CASCADE_H
+
+#include <stdbool.h>
+#include "ocr_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Region of the image in normalized coordinates (bottom-left origin)
+ */
+typedef struct {
+    double x;
+    double y;
+    double width;
+    double height;
+} OCRRegion;
+
+/**
+ * What the cascade had to re-recognize in accurate mode
+ */
+typedef struct {
+    size_t fast_count;          // observations produced by the fast pass
+    size_t escalated_count;     // fast observations below the threshold
+    size_t region_count;        // regions re-recognized in accurate mode
+    bool image_escalated;       // whole image re-recognized in accurate mode
+} OCRCascadeStats;
+
+/**
+ * Recognizer used by the cascade
+ * @param context caller context
+ * @param level OCR_RECOGNITION_LEVEL_FAST or OCR_RECOGNITION_LEVEL_ACCURATE
+ * @param region region to recognize, {0, 0, 1, 1} for the whole image
+ * @param observations receives a malloc'd array in whole-image coordinates; texts
+ *        and candidates are malloc'd as well and owned by the caller afterwards
+ * @param count receives the number of observations
+ * @return false if recognition failed; the recognizer keeps its own error
+ */
+typedef bool (*OCRRecognizeFn)(void* context, OCRRecognitionLevel level, const OCRRegion* region,
+                               TextObservation** observations, size_t* count);
+
+/**
+ * Recognize in fast mode, then re-recognize what the fast pass was unsure of
+ * Observations below the threshold are grown by a margin, merged into regions and
+ * recognized again in accurate mode; the accurate observations centered in a region
+ * replace the fast ones there. When the fast pass finds nothing, or when more than
+ * half of its observations are below the threshold, the whole image is recognized
+ * again instead, since one full pass is cheaper than many region passes
+ * @param threshold confidence below which a fast observation is escalated
+ * @param aspect_ratio image width divided by height, so region margins are equal in pixels on both axes
+ * @param recognize recognizer
+ * @param context recognizer context
+ * @param observations receives the merged malloc'd observation array, NULL when empty
+ * @param count receives the number of observations
+ * @param stats receives what was escalated, can be NULL
+ * @return true on success, false if the recognizer failed or memory allocation failed
+ */
+bool ocr_cascade_recognize(double threshold, double aspect_ratio, OCRRecognizeFn recognize, void* context,
+                           TextObservation** observations, size_t* count, OCRCascadeStats* stats);
+
+/**
+ * Free an observation array together with its texts and candidates
+ * @param observations observation array, can be NULL
+ * @param count number of observations
+ */
+void ocr_observations_free(TextObservation* observations, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MAC_OCR_CASCADE_H
@@ -0,0 +1,148 @@
+#include "cost_model.h"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <new>
+
+namespace {
+
+const double kDecay = 0.9;              // weight kept by past samples at each new sample
+const double kMinShortSide = 512.0;     // smaller images lose small text
+const double kPriorSmallPixels = 0.5e6;
+const double kPriorLargePixels = 4.0e6;
+
+struct Prior {
+    double overhead_ms;
+    double ns_per_pixel;
+};
+
+// Rough Apple silicon figures; the first measurements take over quickly
+const Prior kPriors[2] = {
+    {15.0, 15.0},  // fast
+    {40.0, 80.0},  // accurate
+};
+
+struct Plan {
+    OCRRecognitionLevel level;
+    double scale;
+};
+
+// Best quality first
+const Plan kPlans[] = {
+    {OCR_RECOGNITION_LEVEL_ACCURATE, 1.0},
+    {OCR_RECOGNITION_LEVEL_ACCURATE, 0.75},
+    {OCR_RECOGNITION_LEVEL_FAST, 1.0},
+    {OCR_RECOGNITION_LEVEL_ACCURATE, 0.5},
+    {OCR_RECOGNITION_LEVEL_FAST, 0.75},
+    {OCR_RECOGNITION_LEVEL_FAST, 0.5},
+    {OCR_RECOGNITION_LEVEL_FAST, 0.35},
+};
+
+// Exponentially decayed sums for a least squares line fit; pixels are in megapixels
+struct Fit {
+    double w = 0.0;
+    double x = 0.0;
+    double y = 0.0;
+    double xx = 0.0;
+    double xy = 0.0;
+
+    void Add(double megapixels, double ms, double weight) {
+        w = w * kDecay + weight;
+        x = x * kDecay + weight * megapixels;
+        y = y * kDecay + weight * ms;
+        xx = xx * kDecay + weight * megapixels * megapixels;
+        xy = xy * kDecay + weight * megapixels * ms;
+    }
+
+    double Predict(double megapixels) const {
+        double variance = w * xx - x * x;
+        double slope;
+        double intercept;
+        if (variance > 1e-9 * w * w) {
+            slope = (w * xy - x * y) / variance;
+            intercept = (y - slope * x) / w;
+        } else {
+            // All samples at one size: attribute the whole latency to pixels
+            slope = x > 0.0 ? y / x : 0.0;
+            intercept = 0.0;
+        }
+        if (slope < 0.0) {
+            slope = x > 0.0 ? y / x : 0.0;
+            intercept = 0.0;
+        }
+        return std::max(0.0, intercept) + slope * megapixels;
+    }
+};
+
+size_t LevelIndex(OCRRecognitionLevel level) {
+    return level == OCR_RECOGNITION_LEVEL_FAST ? 0 : 1;
+}
+
+} // namespace
+
+struct OCRCostModel {
+    std::mutex mutex;
+    Fit fits[2];
+};
+
+OCRCostModel* ocr_cost_model_create(void) {
+    OCRCostModel* model = new (std::nothrow) OCRCostModel();
+    if (!model) {
+        return NULL;
+    }
+    for (size_t i = 0; i < 2; i++) {
+        const Prior& prior = kPriors[i];
+        for (double pixels : {kPriorSmallPixels, kPriorLargePixels}) {
+            model->fits[i].Add(pixels / 1e6, prior.overhead_ms + prior.ns_per_pixel * pixels / 1e6, 1.0);
+        }
+    }
+    return model;
+}
+
+double ocr_cost_model_estimate(OCRCostModel* model, OCRRecognitionLevel level, double pixels) {
+    if (!model) {
+        return 0.0;
+    }
+    std::lock_guard<std::mutex> guard(model->mutex);
+    return model->fits[LevelIndex(level)].Predict(pixels / 1e6);
+}
+
+OCRCostPlan ocr_cost_model_plan(OCRCostModel* model, double budget_ms, size_t width, size_t height) {
+    OCRCostPlan chosen = {OCR_RECOGNITION_LEVEL_ACCURATE, 1.0, 0.0, false};
+    if (!model) {
+        return chosen;
+    }
+
+    double pixels = (double)width * (double)height;
+    double short_side = (double)std::min(width, height);
+    std::lock_guard<std::mutex> guard(model->mutex);
+    bool have_fallback = false;
+    for (const Plan& plan : kPlans) {
+        if (plan.scale < 1.0 && short_side * plan.scale < kMinShortSide) {
+            continue;
+        }
+        double predicted = model->fits[LevelIndex(plan.level)].Predict(pixels * plan.scale * plan.scale / 1e6);
+        if (predicted <= budget_ms) {
+            return {plan.level, plan.scale, predicted, true};
+        }
+        // Plans are ordered by quality, not cost, so track the cheapest separately
+        if (!have_fallback || predicted < chosen.predicted_ms) {
+            chosen = {plan.level, plan.scale, predicted, false};
+            have_fallback = true;
+        }
+    }
+    return chosen;
+}
+
+void ocr_cost_model_record(OCRCostModel* model, OCRRecognitionLevel level, double pixels, double elapsed_ms) {
+    if (!model || pixels <= 0.0 || !(elapsed_ms >= 0.0) || std::isinf(elapsed_ms)) {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(model->mutex);
+    model->fits[LevelIndex(level)].Add(pixels / 1e6, elapsed_ms, 1.0);
+}
+
+void ocr_cost_model_free(OCRCostModel* model) {
+    delete model;
+}
@@ -0,0 +1,78 @@
+#ifndef MAC_OCR_COST_MODEL_H
+#define MAC_OCR_COST_MODEL_H
+
+#include <stdbool.h>
+#include "ocr_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Online model of recognition latency, one per process
+ * Each level is modelled as latency = overhead + cost_per_pixel * pixels and fitted
+ * by least squares over exponentially decayed samples, so it follows the machine
+ * it runs on and drifts with thermal state and load. Built-in priors are weighted
+ * like a couple of samples and fade after a few dozen recognitions
+ */
+typedef struct OCRCostModel OCRCostModel;
+
+/**
+ * Recognition level and downsampling chosen for a latency budget
+ */
+typedef struct {
+    OCRRecognitionLevel level;  // OCR_RECOGNITION_LEVEL_FAST or OCR_RECOGNITION_LEVEL_ACCURATE
+    double scale;               // downsampling factor applied to both sides, 1.0 keeps the full resolution
+    double predicted_ms;        // predicted recognition latency
+    bool within_budget;         // false if even the cheapest plan is predicted to exceed the budget
+} OCRCostPlan;
+
+/**
+ * Create a cost model initialized with the built-in priors
+ * @return model pointer, NULL if memory allocation fails
+ * @note The returned model must be freed using ocr_cost_model_free
+ */
+OCRCostModel* ocr_cost_model_create(void);
+
+/**
+ * Predict the recognition latency of an image
+ * @param model cost model
+ * @param level OCR_RECOGNITION_LEVEL_FAST or OCR_RECOGNITION_LEVEL_ACCURATE
+ * @param pixels number of pixels recognized
+ * @return predicted latency in milliseconds
+ */
+double ocr_cost_model_estimate(OCRCostModel* model, OCRRecognitionLevel level, double pixels);
+
+/**
+ * Choose the best quality plan predicted to fit a budget
+ * Plans are tried from best to worst quality: accurate at full and 3/4 resolution,
+ * fast at full resolution, then accurate and fast at lower resolutions. Scales that
+ * would bring the short side under 512 pixels are skipped to keep text legible
+ * @param model cost model
+ * @param budget_ms latency budget in milliseconds
+ * @param width image width in pixels
+ * @param height image height in pixels
+ * @return chosen plan; the cheapest plan when none fits
+ */
+OCRCostPlan ocr_cost_model_plan(OCRCostModel* model, double budget_ms, size_t width, size_t height);
+
+/**
+ * Add a measured recognition to the model, thread-safe
+ * @param model cost model
+ * @param level level the recognition ran at
+ * @param pixels number of pixels recognized
+ * @param elapsed_ms measured latency in milliseconds
+ */
+void ocr_cost_model_record(OCRCostModel* model, OCRRecognitionLevel level, double pixels, double elapsed_ms);
+
+/**
+ * Free a cost model
+ * @param model model to be freed, can be NULL
+ */
+void ocr_cost_model_free(OCRCostModel* model);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MAC_OCR_COST_MODEL_H
@@ -0,0 +1,442 @@
+#include "frame_diff.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+#include "region_util.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+struct OCRFrameDiff {
+    size_t tile_size;
+    size_t width;
+    size_t height;
+    bool has_frame;
+    std::vector<uint8_t> frame;  // previous frame, tightly packed rows
+};
+
+using ocr::BoxOf;
+using ocr::FreeObservation;
+using ocr::MergeRegions;
+using ocr::Rect;
+
+namespace {
+
+const size_t kDefaultTileSize = 64;
+const size_t kBytesPerPixel = 4;
+const double kMaxChangedShare = 0.5;  // share of changed tiles or area that re-recognizes the whole frame
+const size_t kMarginDivisor = 4;      // regions are padded by a quarter tile for context
+
+// Compare 64 bytes per iteration and only test the combined mask, then finish
+// the row in 16-byte blocks; the scalar tail is at most 15 bytes
+bool BytesEqual(const uint8_t* a, const uint8_t* b, size_t length) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 64 <= length; i += 64) {
+        __m128i eq0 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(a + i)), _mm_loadu_si128((const __m128i*)(b + i)));
+        __m128i eq1 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(a + i + 16)), _mm_loadu_si128((const __m128i*)(b + i + 16)));
+        __m128i eq2 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(a + i + 32)), _mm_loadu_si128((const __m128i*)(b + i + 32)));
+        __m128i eq3 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(a + i + 48)), _mm_loadu_si128((const __m128i*)(b + i + 48)));
+        __m128i eq = _mm_and_si128(_mm_and_si128(eq0, eq1), _mm_and_si128(eq2, eq3));
+        if (_mm_movemask_epi8(eq) != 0xFFFF) {
+            return false;
+        }
+    }
+    for (; i + 16 <= length; i += 16) {
+        __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(a + i)), _mm_loadu_si128((const __m128i*)(b + i)));
+        if (_mm_movemask_epi8(eq) != 0xFFFF) {
+            return false;
+        }
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 64 <= length; i += 64) {
+        uint8x16_t eq0 = vceqq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+        uint8x16_t eq1 = vceqq_u8(vld1q_u8(a + i + 16), vld1q_u8(b + i + 16));
+        uint8x16_t eq2 = vceqq_u8(vld1q_u8(a + i + 32), vld1q_u8(b + i + 32));
+        uint8x16_t eq3 = vceqq_u8(vld1q_u8(a + i + 48), vld1q_u8(b + i + 48));
+        if (vminvq_u8(vandq_u8(vandq_u8(eq0, eq1), vandq_u8(eq2, eq3))) != 0xFF) {
+            return false;
+        }
+    }
+    for (; i + 16 <= length; i += 16) {
+        if (vminvq_u8(vceqq_u8(vld1q_u8(a + i), vld1q_u8(b + i))) != 0xFF) {
+            return false;
+        }
+    }
+#endif
+    return memcmp(a + i, b + i, length - i) == 0;
+}
+
+bool PublishRegions(const std::vector<Rect>& rects, OCRFrameDelta* delta) {
+    free(delta->regions);
+    delta->regions = NULL;
+    delta->region_count = 0;
+    if (rects.empty()) {
+        return true;
+    }
+    delta->regions = static_cast<OCRRegion*>(malloc(sizeof(OCRRegion) * rects.size()));
+    if (!delta->regions) {
+        return false;
+    }
+    for (size_t i = 0; i < rects.size(); i++) {
+        delta->regions[i] = {rects[i].left, rects[i].bottom, rects[i].right - rects[i].left, rects[i].top - rects[i].bottom};
+    }
+    delta->region_count = rects.size();
+    return true;
+}
+
+// Group changed tiles into 8-connected components and return their pixel bounds,
+// padded and converted to normalized bottom-left coordinates
+std::vector<Rect> ChangedRegions(const std::vector<uint8_t>& changed, size_t columns, size_t rows,
+                                 size_t tile, size_t width, size_t height) {
+    std::vector<Rect> rects;
+    std::vector<uint8_t> seen(changed.size(), 0);
+    std::vector<size_t> stack;
+    double margin = (double)std::max((size_t)1, tile / kMarginDivisor);
+
+    for (size_t start = 0; start < changed.size(); start++) {
+        if (!changed[start] || seen[start]) {
+            continue;
+        }
+        size_t min_col = columns, min_row = rows, max_col = 0, max_row = 0;
+        seen[start] = 1;
+        stack.push_back(start);
+        while (!stack.empty()) {
+            size_t index = stack.back();
+            stack.pop_back();
+            size_t col = index % columns;
+            size_t row = index / columns;
+            min_col = std::min(min_col, col);
+            max_col = std::max(max_col, col);
+            min_row = std::min(min_row, row);
+            max_row = std::max(max_row, row);
+            for (size_t r = row > 0 ? row - 1 : 0; r <= std::min(row + 1, rows - 1); r++) {
+                for (size_t c = col > 0 ? col - 1 : 0; c <= std::min(col + 1, columns - 1); c++) {
+                    size_t next = r * columns + c;
+                    if (changed[next] && !seen[next]) {
+                        seen[next] = 1;
+                        stack.push_back(next);
+                    }
+                }
+            }
+        }
+
+        double left = std::max(0.0, (double)(min_col * tile) - margin);
+        double right = std::min((double)width, (double)((max_col + 1) * tile) + margin);
+        double top_row = std::max(0.0, (double)(min_row * tile) - margin);
+        double bottom_row = std::min((double)height, (double)((max_row + 1) * tile) + margin);
+        rects.push_back({left / width, 1.0 - bottom_row / height, right / width, 1.0 - top_row / height});
+    }
+    return MergeRegions(rects);
+}
+
+bool CopyObservation(const TextObservation& source, TextObservation* out) {
+    *out = source;
+    out->text = NULL;
+    out->candidates = NULL;
+    out->candidate_count = 0;
+
+    out->text = strdup(source.text ? source.text : "");
+    if (!out->text) {
+        return false;
+    }
+    if (source.candidate_count > 0) {
+        out->candidates = static_cast<TextCandidate*>(calloc(source.candidate_count, sizeof(TextCandidate)));
+        if (!out->candidates) {
+            return false;
+        }
+        out->candidate_count = source.candidate_count;
+        for (size_t c = 0; c < source.candidate_count; c++) {
+            out->candidates[c].confidence = source.candidates[c].confidence;
+            out->candidates[c].text = strdup(source.candidates[c].text ? source.candidates[c].text : "");
+            if (!out->candidates[c].text) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool Publish(const std::vector<TextObservation>& kept, TextObservation** observations, size_t* count) {
+    *observations = NULL;
+    *count = 0;
+    if (kept.empty()) {
+        return true;
+    }
+    *observations = static_cast<TextObservation*>(malloc(sizeof(TextObservation) * kept.size()));
+    if (!*observations) {
+        return false;
+    }
+    memcpy(*observations, kept.data(), sizeof(TextObservation) * kept.size());
+    *count = kept.size();
+    return true;
+}
+
+} // namespace
+
+OCRFrameDiff* ocr_frame_diff_create(size_t tile_size) {
+    OCRFrameDiff* diff = new (std::nothrow) OCRFrameDiff();
+    if (!diff) {
+        return NULL;
+    }
+    diff->tile_size = tile_size > 0 ? tile_size : kDefaultTileSize;
+    diff->width = 0;
+    diff->height = 0;
+    diff->has_frame = false;
+    return diff;
+}
+
+bool ocr_frame_diff_update(OCRFrameDiff* diff, const uint8_t* pixels, size_t width, size_t height,
+                           size_t bytes_per_row, OCRFrameDelta* delta) {
+    if (!diff || !pixels || !delta || width == 0 || height == 0 || bytes_per_row < width * kBytesPerPixel) {
+        return false;
+    }
+    free(delta->regions);
+    delta->regions = NULL;
+    delta->region_count = 0;
+    delta->full_frame = false;
+
+    const size_t tile = diff->tile_size;
+    const size_t columns = (width + tile - 1) / tile;
+    const size_t rows = (height + tile - 1) / tile;
+    const size_t row_bytes = width * kBytesPerPixel;
+    delta->tile_count = columns * rows;
+    delta->changed_tile_count = 0;
+
+    try {
+        if (!diff->has_frame || diff->width != width || diff->height != height) {
+            diff->has_frame = false;
+            diff->frame.resize(row_bytes * height);
+            for (size_t y = 0; y < height; y++) {
+                memcpy(&diff->frame[y * row_bytes], pixels + y * bytes_per_row, row_bytes);
+            }
+            diff->width = width;
+            diff->height = height;
+            diff->has_frame = true;
+            delta->changed_tile_count = delta->tile_count;
+            delta->full_frame = true;
+            return PublishRegions({{0.0, 0.0, 1.0, 1.0}}, delta);
+        }
+
+        std::vector<uint8_t> changed(columns * rows, 0);
+        size_t changed_count = 0;
+        for (size_t ty = 0; ty < rows; ty++) {
+            size_t y0 = ty * tile;
+            size_t y1 = std::min(height, y0 + tile);
+            for (size_t tx = 0; tx < columns; tx++) {
+                size_t offset = tx * tile * kBytesPerPixel;
+                size_t length = (std::min(width, (tx + 1) * tile) - tx * tile) * kBytesPerPixel;
+                size_t y = y0;
+                while (y < y1 && BytesEqual(&diff->frame[y * row_bytes + offset], pixels + y * bytes_per_row + offset, length)) {
+                    y++;
+                }
+                if (y == y1) {
+                    continue;
+                }
+                // Rows above the first difference are already equal
+                for (; y < y1; y++) {
+                    memcpy(&diff->frame[y * row_bytes + offset], pixels + y * bytes_per_row + offset, length);
+                }
+                changed[ty * columns + tx] = 1;
+                changed_count++;
+            }
+        }
+        delta->changed_tile_count = changed_count;
+
+        if (changed_count == 0) {
+            return true;
+        }
+        if (changed_count > kMaxChangedShare * delta->tile_count) {
+            delta->full_frame = true;
+            return PublishRegions({{0.0, 0.0, 1.0, 1.0}}, delta);
+        }
+        if (!PublishRegions(ChangedRegions(changed, columns, rows, tile, width, height), delta)) {
+            diff->has_frame = false;
+            return false;
+        }
+        return true;
+    } catch (const std::bad_alloc&) {
+        diff->has_frame = false;
+        return false;
+    }
+}
+
+void ocr_frame_diff_reset(OCRFrameDiff* diff) {
+    if (diff) {
+        diff->has_frame = false;
+    }
+}
+
+void ocr_frame_diff_free(OCRFrameDiff* diff) {
+    delete diff;
+}
+
+bool ocr_frame_merge(const TextObservation* previous, size_t previous_count, OCRRecognitionLevel level,
+                     OCRRecognizeFn recognize, void* context, OCRFrameDelta* delta,
+                     TextObservation** observations, size_t* count) {
+    if (!recognize || !delta || !observations || !count || (previous_count > 0 && !previous)) {
+        return false;
+    }
+    *observations = NULL;
+    *count = 0;
+    delta->removed = NULL;
+    delta->removed_count = 0;
+    delta->added = NULL;
+    delta->added_count = 0;
+    delta->carried_count = 0;
+
+    std::vector<TextObservation> kept;
+    std::vector<TextObservation> removed;
+    auto release = [&]() {
+        for (TextObservation& obs : kept) FreeObservation(obs);
+        for (TextObservation& obs : removed) FreeObservation(obs);
+    };
+
+    try {
+        std::vector<Rect> regions;
+        regions.reserve(delta->region_count);
+        for (size_t i = 0; i < delta->region_count; i++) {
+            const OCRRegion& region = delta->regions[i];
+            regions.push_back({region.x, region.y, region.x + region.width, region.y + region.height});
+        }
+
+        // Grow regions over every previous observation they cut, until none is cut
+        std::vector<bool> touched(previous_count, false);
+        bool grown = !regions.empty();
+        while (grown) {
+            grown = false;
+            for (size_t i = 0; i < previous_count; i++) {
+                if (touched[i]) {
+                    continue;
+                }
+                Rect box = BoxOf(previous[i]);
+                for (Rect& region : regions) {
+                    if (region.Intersects(box)) {
+                        region.Include(box);
+                        touched[i] = true;
+                        grown = true;
+                        break;
+                    }
+                }
+            }
+            if (grown) {
+                regions = MergeRegions(regions);
+            }
+        }
+
+        double area = 0.0;
+        for (const Rect& region : regions) {
+            area += (region.right - region.left) * (region.top - region.bottom);
+        }
+        if (area > kMaxChangedShare) {
+            regions.assign(1, {0.0, 0.0, 1.0, 1.0});
+            touched.assign(previous_count, true);
+            delta->full_frame = true;
+        }
+        if (!PublishRegions(regions, delta)) {
+            return false;
+        }
+
+        kept.reserve(previous_count);
+        removed.reserve(previous_count);
+        for (size_t i = 0; i < previous_count; i++) {
+            std::vector<TextObservation>& target = touched[i] ? removed : kept;
+            TextObservation copy;
+            bool copied = CopyObservation(previous[i], &copy);
+            target.push_back(copy);
+            if (!copied) {
+                release();
+                return false;
+            }
+        }
+        delta->carried_count = kept.size();
+
+        for (const Rect& rect : regions) {
+            OCRRegion region = {rect.left, rect.bottom, rect.right - rect.left, rect.top - rect.bottom};
+            TextObservation* found = NULL;
+            size_t found_count = 0;
+            if (!recognize(context, level, &region, &found, &found_count)) {
+                release();
+                return false;
+            }
+
+            // Reserve up front so ownership never splits between arrays on failure
+            try {
+                kept.reserve(kept.size() + found_count);
+            } catch (const std::bad_alloc&) {
+                ocr_observations_free(found, found_count);
+                throw;
+            }
+            for (size_t i = 0; i < found_count; i++) {
+                if (rect.ContainsCenterOf(found[i])) {
+                    kept.push_back(found[i]);
+                } else {
+                    FreeObservation(found[i]);
+                }
+            }
+            free(found);
+        }
+    } catch (const std::bad_alloc&) {
+        release();
+        return false;
+    }
+
+    TextObservation* removed_array = NULL;
+    size_t removed_count = 0;
+    if (!Publish(removed, &removed_array, &removed_count)) {
+        release();
+        return false;
+    }
+    if (!Publish(kept, observations, count)) {
+        free(removed_array);
+        release();
+        return false;
+    }
+    delta->removed = removed_array;
+    delta->removed_count = removed_count;
+    delta->added_count = *count - delta->carried_count;
+    return true;
+}
+
+bool ocr_observations_copy(const TextObservation* observations, size_t count, TextObservation** out) {
+    if (!out || (count > 0 && !observations)) {
+        return false;
+    }
+    *out = NULL;
+    if (count == 0) {
+        return true;
+    }
+    TextObservation* copy = static_cast<TextObservation*>(calloc(count, sizeof(TextObservation)));
+    if (!copy) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (!CopyObservation(observations[i], &copy[i])) {
+            ocr_observations_free(copy, i + 1);
+            return false;
+        }
+    }
+    *out = copy;
+    return true;
+}
+
+void ocr_frame_delta_free(OCRFrameDelta* delta) {
+    if (!delta) return;
+
+    free(delta->regions);
+    ocr_observations_free(delta->removed, delta->removed_count);
+    free(delta->added);
+    delta->regions = NULL;
+    delta->region_count = 0;
+    delta->removed = NULL;
+    delta->removed_count = 0;
+    delta->added = NULL;
+    delta->added_count = 0;
+}
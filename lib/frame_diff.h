@@ -0,0 +1,114 @@
+#ifndef MAC_OCR_FRAME_DIFF_H
+#define MAC_OCR_FRAME_DIFF_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ocr_types.h"
+#include "cascade.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Tile-level change detector over consecutive frames
+ * Keeps a copy of the last frame and compares each new frame against it tile by
+ * tile in SIMD blocks, stopping at the first differing block of a tile
+ */
+typedef struct OCRFrameDiff OCRFrameDiff;
+
+/**
+ * What changed between two frames and how the observations were updated
+ * Note: All arrays are dynamically allocated and need to be freed using ocr_frame_delta_free
+ */
+typedef struct {
+    OCRRegion* regions;          // regions re-recognized, grown over the previous observations they touched
+    size_t region_count;         // number of regions
+    TextObservation* removed;    // previous observations inside the regions, replaced by this frame
+    size_t removed_count;        // number of removed observations
+    size_t* added;               // indices of the observations recognized in this frame
+    size_t added_count;          // number of added observations
+    size_t carried_count;        // previous observations carried forward unchanged
+    size_t tile_count;           // number of tiles compared
+    size_t changed_tile_count;   // number of tiles that differed from the previous frame
+    bool full_frame;             // the whole frame was recognized again
+    bool duplicate;              // near-duplicate of the last recognized frame, its observations were reused
+} OCRFrameDelta;
+
+/**
+ * Create a change detector
+ * @param tile_size tile side in pixels, 0 uses 64
+ * @return detector pointer, NULL if memory allocation fails
+ * @note The returned detector must be freed using ocr_frame_diff_free
+ */
+OCRFrameDiff* ocr_frame_diff_create(size_t tile_size);
+
+/**
+ * Compare a frame against the previous one and keep it for the next comparison
+ * Changed tiles are grouped into connected regions with a small margin. The first
+ * frame, a frame of a different size, or a frame where more than half of the tiles
+ * changed yields a single region covering the whole frame
+ * @param diff change detector
+ * @param pixels 32-bit pixels, first row at the top of the image
+ * @param width frame width in pixels
+ * @param height frame height in pixels
+ * @param bytes_per_row distance between rows in bytes
+ * @param delta receives regions, tile_count, changed_tile_count and full_frame; other fields are left as is
+ * @return true on success, false if memory allocation fails; the next frame is then compared as a first frame
+ */
+bool ocr_frame_diff_update(OCRFrameDiff* diff, const uint8_t* pixels, size_t width, size_t height,
+                           size_t bytes_per_row, OCRFrameDelta* delta);
+
+/**
+ * Forget the previous frame, so the next one is recognized in full
+ * @param diff change detector
+ */
+void ocr_frame_diff_reset(OCRFrameDiff* diff);
+
+/**
+ * Free a change detector
+ * @param diff detector to be freed, can be NULL
+ */
+void ocr_frame_diff_free(OCRFrameDiff* diff);
+
+/**
+ * Re-recognize the changed regions and carry every other observation forward
+ * Regions are first grown to cover the previous observations they touch, so a word
+ * that changed in one tile is read again whole. Previous observations inside a region
+ * are removed; new observations centered in a region are appended after the carried ones.
+ * When the grown regions cover more than half of the frame, the whole frame is recognized
+ * @param previous observations of the previous frame
+ * @param previous_count number of previous observations
+ * @param level recognition level passed to the recognizer
+ * @param recognize recognizer
+ * @param context recognizer context
+ * @param delta regions from ocr_frame_diff_update; receives the grown regions, removed,
+ *        carried_count and added_count, with added left NULL; full_frame is set when regions were collapsed
+ * @param observations receives the carried observations followed by the added ones, NULL when empty
+ * @param count receives the number of observations
+ * @return true on success, false if the recognizer failed or memory allocation failed
+ */
+bool ocr_frame_merge(const TextObservation* previous, size_t previous_count, OCRRecognitionLevel level,
+                     OCRRecognizeFn recognize, void* context, OCRFrameDelta* delta,
+                     TextObservation** observations, size_t* count);
+
+/**
+ * Deep-copy an observation array together with its texts and candidates
+ * @param observations observation array
+ * @param count number of observations
+ * @param out receives the copy, NULL when count is 0
+ * @return true on success, false if memory allocation fails
+ */
+bool ocr_observations_copy(const TextObservation* observations, size_t count, TextObservation** out);
+
+/**
+ * Free the arrays of a frame delta
+ * @param delta delta to be freed, can be NULL; its fields are reset afterwards
+ */
+void ocr_frame_delta_free(OCRFrameDelta* delta);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MAC_OCR_FRAME_DIFF_H
@@ -0,0 +1,445 @@
+#include "image_probe.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+// Longest TIFF directory chain followed; real multi-page scans stay far below this,
+// and the limit also ends chains that loop back on themselves
+const size_t kMaxTiffDirectories = 65536;
+
+// Bounds-checked big- or little-endian reads over the input
+struct Reader {
+    const uint8_t* data;
+    size_t length;
+    bool little_endian;
+
+    bool Has(size_t offset, size_t count) const {
+        return offset <= length && count <= length - offset;
+    }
+
+    uint32_t U8(size_t offset) const {
+        return data[offset];
+    }
+
+    uint32_t U16(size_t offset) const {
+        return little_endian ? data[offset] | data[offset + 1] << 8 : data[offset] << 8 | data[offset + 1];
+    }
+
+    uint32_t U32(size_t offset) const {
+        uint32_t value = 0;
+        for (int i = 0; i < 4; i++) {
+            value |= (uint32_t)data[offset + i] << (little_endian ? 8 * i : 8 * (3 - i));
+        }
+        return value;
+    }
+};
+
+bool ProbePng(const Reader& r, OCRImageInfo* info) {
+    static const uint8_t kSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    if (!r.Has(0, 33) || memcmp(r.data, kSignature, 8) != 0 || r.U32(8) != 13 || memcmp(r.data + 12, "IHDR", 4) != 0) {
+        return false;
+    }
+    static const int kComponents[7] = {1, 0, 3, 1, 2, 0, 4};  // by color type
+    uint32_t depth = r.U8(24);
+    uint32_t color_type = r.U8(25);
+    if (color_type > 6 || kComponents[color_type] == 0 || depth == 0 || depth > 16 || (depth & (depth - 1)) != 0) {
+        return false;
+    }
+    info->format = OCR_IMAGE_FORMAT_PNG;
+    info->width = r.U32(16);
+    info->height = r.U32(20);
+    info->bits_per_component = (int)depth;
+    info->components = kComponents[color_type];
+    info->frame_count = 1;
+
+    // An animation control chunk, if any, comes before the first image data
+    size_t offset = 33;
+    while (r.Has(offset, 8)) {
+        uint32_t chunk_length = r.U32(offset);
+        const uint8_t* type = r.data + offset + 4;
+        if (memcmp(type, "IDAT", 4) == 0 || memcmp(type, "IEND", 4) == 0) {
+            break;
+        }
+        if (memcmp(type, "acTL", 4) == 0 && chunk_length >= 8 && r.Has(offset + 8, 4)) {
+            uint32_t frames = r.U32(offset + 8);
+            info->frame_count = frames > 0 ? frames : 1;
+            break;
+        }
+        if (!r.Has(offset + 8, (size_t)chunk_length + 4)) {
+            break;
+        }
+        offset += 12 + (size_t)chunk_length;
+    }
+    return true;
+}
+
+bool ProbeJpeg(const Reader& r, OCRImageInfo* info) {
+    if (!r.Has(0, 3) || r.U8(0) != 0xFF || r.U8(1) != 0xD8 || r.U8(2) != 0xFF) {
+        return false;
+    }
+    size_t offset = 2;
+    while (r.Has(offset, 2)) {
+        if (r.U8(offset) != 0xFF) {
+            return false;
+        }
+        uint32_t marker = r.U8(offset + 1);
+        if (marker == 0xFF) {
+            offset++;  // fill byte
+            continue;
+        }
+        offset += 2;
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8)) {
+            continue;  // standalone markers
+        }
+        if (marker == 0xD9 || marker == 0xDA || !r.Has(offset, 2)) {
+            return false;  // image data or end of image before a frame header
+        }
+        uint32_t segment_length = r.U16(offset);
+        if (segment_length < 2) {
+            return false;
+        }
+        bool frame_header = marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+        if (frame_header) {
+            if (segment_length < 8 || !r.Has(offset, 8)) {
+                return false;
+            }
+            info->format = OCR_IMAGE_FORMAT_JPEG;
+            info->bits_per_component = (int)r.U8(offset + 2);
+            info->height = r.U16(offset + 3);
+            info->width = r.U16(offset + 5);
+            info->components = (int)r.U8(offset + 7);
+            info->frame_count = 1;
+            return info->bits_per_component > 0 && info->components > 0;
+        }
+        offset += segment_length;
+    }
+    return false;
+}
+
+// First value of a SHORT or LONG directory entry; values of up to four bytes are
+// stored inline, longer arrays at an offset
+bool TiffValue(const Reader& r, size_t entry, uint32_t* value) {
+    uint32_t type = r.U16(entry + 2);
+    uint32_t count = r.U32(entry + 4);
+    if (count == 0 || (type != 3 && type != 4)) {
+        return false;
+    }
+    size_t size = type == 3 ? 2 : 4;
+    size_t offset = entry + 8;
+    if ((uint64_t)count * size > 4) {
+        offset = r.U32(entry + 8);
+        if (!r.Has(offset, size)) {
+            return false;
+        }
+    }
+    *value = type == 3 ? r.U16(offset) : r.U32(offset);
+    return true;
+}
+
+bool ProbeTiff(Reader r, OCRImageInfo* info) {
+    if (!r.Has(0, 8)) {
+        return false;
+    }
+    if (memcmp(r.data, "II*\0", 4) == 0) {
+        r.little_endian = true;
+    } else if (memcmp(r.data, "MM\0*", 4) == 0) {
+        r.little_endian = false;
+    } else {
+        return false;
+    }
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t bits = 1;
+    uint32_t samples = 1;
+    size_t directories = 0;
+    size_t offset = r.U32(4);
+    while (offset != 0 && directories < kMaxTiffDirectories && r.Has(offset, 2)) {
+        uint32_t entries = r.U16(offset);
+        if (!r.Has(offset + 2, (size_t)entries * 12 + 4)) {
+            break;
+        }
+        if (directories == 0) {
+            for (uint32_t i = 0; i < entries; i++) {
+                size_t entry = offset + 2 + (size_t)i * 12;
+                uint32_t value;
+                if (!TiffValue(r, entry, &value)) {
+                    continue;
+                }
+                switch (r.U16(entry)) {
+                    case 256: width = value; break;
+                    case 257: height = value; break;
+                    case 258: bits = value; break;
+                    case 277: samples = value; break;
+                }
+            }
+        }
+        directories++;
+        size_t next = r.U32(offset + 2 + (size_t)entries * 12);
+        // Directories only chain forwards in practice; requiring it ends every cycle
+        if (next != 0 && next <= offset) {
+            break;
+        }
+        offset = next;
+    }
+    if (directories == 0 || bits == 0 || bits > 64 || samples == 0 || samples > 16) {
+        return false;
+    }
+    info->format = OCR_IMAGE_FORMAT_TIFF;
+    info->width = width;
+    info->height = height;
+    info->bits_per_component = (int)bits;
+    info->components = (int)samples;
+    info->frame_count = directories;
+    return true;
+}
+
+// Skip a run of data sub-blocks; returns the offset after the terminator, or 0 if truncated
+size_t SkipSubBlocks(const Reader& r, size_t offset) {
+    while (r.Has(offset, 1)) {
+        uint32_t size = r.U8(offset);
+        offset += 1 + size;
+        if (size == 0) {
+            return offset;
+        }
+    }
+    return 0;
+}
+
+bool ProbeGif(Reader r, OCRImageInfo* info) {
+    r.little_endian = true;
+    if (!r.Has(0, 13) || (memcmp(r.data, "GIF87a", 6) != 0 && memcmp(r.data, "GIF89a", 6) != 0)) {
+        return false;
+    }
+    info->format = OCR_IMAGE_FORMAT_GIF;
+    info->width = r.U16(6);
+    info->height = r.U16(8);
+    info->bits_per_component = 8;
+    info->components = 1;
+    info->frame_count = 0;
+
+    uint32_t flags = r.U8(10);
+    size_t offset = 13 + (flags & 0x80 ? 3u << ((flags & 7) + 1) : 0);
+    // A truncated file still reports the frames seen so far
+    while (r.Has(offset, 1)) {
+        uint32_t block = r.U8(offset);
+        if (block == 0x3B) {
+            break;
+        } else if (block == 0x21) {
+            offset = r.Has(offset, 2) ? SkipSubBlocks(r, offset + 2) : 0;
+        } else if (block == 0x2C) {
+            if (!r.Has(offset, 11)) {
+                break;
+            }
+            uint32_t local = r.U8(offset + 9);
+            info->frame_count++;
+            // Descriptor, local color table and LZW minimum code size precede the data
+            offset = SkipSubBlocks(r, offset + 11 + (local & 0x80 ? 3u << ((local & 7) + 1) : 0));
+        } else {
+            break;
+        }
+        if (offset == 0) {
+            break;
+        }
+    }
+    return true;
+}
+
+bool StartsWith(const uint8_t* data, size_t length, size_t offset, const char* signature, size_t count) {
+    return offset <= length && count <= length - offset && memcmp(data + offset, signature, count) == 0;
+}
+
+// ISO base media brands of still HEIF and AVIF images
+bool IsHeifBrand(const uint8_t* brand) {
+    static const char* const kBrands[] = {"heic", "heix", "heim", "heis", "hevc", "hevx", "mif1", "msf1", "avif", "avis"};
+    for (const char* known : kBrands) {
+        if (memcmp(brand, known, 4) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// read() until count bytes arrive, the file ends or an error other than EINTR occurs
+ssize_t ReadFully(int fd, uint8_t* buffer, size_t count) {
+    size_t total = 0;
+    while (total < count) {
+        ssize_t n = read(fd, buffer + total, count - total);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return -1;
+        }
+        if (n == 0) {
+            break;
+        }
+        total += (size_t)n;
+    }
+    return (ssize_t)total;
+}
+
+} // namespace
+
+OCRImageFormat ocr_image_sniff(const void* data, size_t length) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    if (!bytes) {
+        return OCR_IMAGE_FORMAT_UNKNOWN;
+    }
+    if (StartsWith(bytes, length, 0, "\x89PNG\r\n\x1a\n", 8)) {
+        return OCR_IMAGE_FORMAT_PNG;
+    }
+    if (StartsWith(bytes, length, 0, "\xff\xd8\xff", 3)) {
+        return OCR_IMAGE_FORMAT_JPEG;
+    }
+    if (StartsWith(bytes, length, 0, "II*\0", 4) || StartsWith(bytes, length, 0, "MM\0*", 4)) {
+        return OCR_IMAGE_FORMAT_TIFF;
+    }
+    if (StartsWith(bytes, length, 0, "GIF87a", 6) || StartsWith(bytes, length, 0, "GIF89a", 6)) {
+        return OCR_IMAGE_FORMAT_GIF;
+    }
+    if (StartsWith(bytes, length, 0, "RIFF", 4) && StartsWith(bytes, length, 8, "WEBP", 4)) {
+        return OCR_IMAGE_FORMAT_WEBP;
+    }
+    if (StartsWith(bytes, length, 4, "ftyp", 4) && length >= 12 && IsHeifBrand(bytes + 8)) {
+        return OCR_IMAGE_FORMAT_HEIF;
+    }
+    // Two letters alone match plenty of text; the reserved header field must also be zero
+    if (StartsWith(bytes, length, 0, "BM", 2) && StartsWith(bytes, length, 6, "\0\0\0\0", 4)) {
+        return OCR_IMAGE_FORMAT_BMP;
+    }
+    return OCR_IMAGE_FORMAT_UNKNOWN;
+}
+
+OCRErrorCode ocr_image_read_file(const char* path, void** data, size_t* length, OCRImageFormat* format) {
+    if (!path || !data || !length) {
+        return OCR_ERROR_INVALID_ARGUMENT;
+    }
+    *data = NULL;
+    *length = 0;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return ocr_error_from_errno(errno);
+    }
+    struct stat stat_info;
+    if (fstat(fd, &stat_info) != 0) {
+        OCRErrorCode code = ocr_error_from_errno(errno);
+        close(fd);
+        return code;
+    }
+    // A directory or device at the path is no image file
+    if (!S_ISREG(stat_info.st_mode)) {
+        close(fd);
+        return OCR_ERROR_FILE_NOT_FOUND;
+    }
+
+    uint8_t signature[OCR_IMAGE_SIGNATURE_BYTES];
+    ssize_t head = ReadFully(fd, signature, sizeof(signature));
+    if (head < 0) {
+        OCRErrorCode code = ocr_error_from_errno(errno);
+        close(fd);
+        return code;
+    }
+    OCRImageFormat sniffed = ocr_image_sniff(signature, (size_t)head);
+    if (sniffed == OCR_IMAGE_FORMAT_UNKNOWN) {
+        close(fd);
+        return OCR_ERROR_UNSUPPORTED_FORMAT;
+    }
+
+    size_t size = (size_t)stat_info.st_size;
+    uint8_t* contents = static_cast<uint8_t*>(size >= (size_t)head ? malloc(size) : NULL);
+    if (!contents) {
+        close(fd);
+        return size >= (size_t)head ? OCR_ERROR_OUT_OF_MEMORY : OCR_ERROR_FILE_READ;
+    }
+    memcpy(contents, signature, (size_t)head);
+    ssize_t rest = ReadFully(fd, contents + head, size - (size_t)head);
+    // One extra byte tells a file that grew since fstat from one read to its end
+    uint8_t extra;
+    bool complete = rest >= 0 && (size_t)rest == size - (size_t)head && ReadFully(fd, &extra, 1) == 0;
+    int read_errno = errno;
+    close(fd);
+    if (!complete) {
+        free(contents);
+        return rest < 0 ? ocr_error_from_errno(read_errno) : OCR_ERROR_FILE_READ;
+    }
+
+    *data = contents;
+    *length = size;
+    if (format) *format = sniffed;
+    return OCR_OK;
+}
+
+bool ocr_image_probe(const void* data, size_t length, OCRImageInfo* info) {
+    if (!data || !info) {
+        return false;
+    }
+    memset(info, 0, sizeof(*info));
+    Reader reader = {static_cast<const uint8_t*>(data), length, false};
+    bool probed = ProbePng(reader, info) || ProbeJpeg(reader, info) || ProbeTiff(reader, info) ||
+                  ProbeGif(reader, info);
+    if (!probed || info->width == 0 || info->height == 0) {
+        memset(info, 0, sizeof(*info));
+        return false;
+    }
+    return true;
+}
+
+bool ocr_image_probe_file(const char* path, OCRImageInfo* info, OCRErrorCode* error) {
+    if (error) *error = OCR_OK;
+    if (!path || !info) {
+        if (error) *error = OCR_ERROR_INVALID_ARGUMENT;
+        return false;
+    }
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (error) *error = ocr_error_from_errno(errno);
+        return false;
+    }
+    struct stat stat_info;
+    if (fstat(fd, &stat_info) != 0) {
+        if (error) *error = ocr_error_from_errno(errno);
+        close(fd);
+        return false;
+    }
+    // Like ocr_image_read_file, a directory at the path is no image file and an empty file no image
+    if (!S_ISREG(stat_info.st_mode) || stat_info.st_size <= 0) {
+        close(fd);
+        if (error) *error = S_ISREG(stat_info.st_mode) ? OCR_ERROR_UNSUPPORTED_FORMAT : OCR_ERROR_FILE_NOT_FOUND;
+        return false;
+    }
+    size_t size = (size_t)stat_info.st_size;
+    void* mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        if (error) *error = OCR_ERROR_FILE_READ;
+        return false;
+    }
+    bool probed = ocr_image_probe(mapping, size, info);
+    munmap(mapping, size);
+    if (!probed && error) {
+        *error = OCR_ERROR_UNSUPPORTED_FORMAT;
+    }
+    return probed;
+}
+
+size_t ocr_image_decoded_bytes(const OCRImageInfo* info) {
+    if (!info || info->width == 0 || info->height == 0) {
+        return 0;
+    }
+    size_t pixel_bytes = info->bits_per_component > 8 ? 8 : 4;
+    if (info->width > SIZE_MAX / info->height || info->width * info->height > SIZE_MAX / pixel_bytes) {
+        return SIZE_MAX;
+    }
+    return info->width * info->height * pixel_bytes;
+}
@@ -0,0 +1,101 @@
+#ifndef MAC_OCR_IMAGE_PROBE_H
+#define MAC_OCR_IMAGE_PROBE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "ocr_error.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Container formats recognized by their signature
+ * The probe reads headers of the first four; the rest are left to the decoder
+ */
+typedef enum {
+    OCR_IMAGE_FORMAT_UNKNOWN = 0,
+    OCR_IMAGE_FORMAT_PNG,
+    OCR_IMAGE_FORMAT_JPEG,
+    OCR_IMAGE_FORMAT_TIFF,
+    OCR_IMAGE_FORMAT_GIF,
+    OCR_IMAGE_FORMAT_BMP,
+    OCR_IMAGE_FORMAT_WEBP,
+    OCR_IMAGE_FORMAT_HEIF
+} OCRImageFormat;
+
+/**
+ * Leading bytes that identify every format above
+ */
+#define OCR_IMAGE_SIGNATURE_BYTES 12
+
+/**
+ * What an image header says about the pixels, read without decoding them
+ */
+typedef struct {
+    OCRImageFormat format;
+    size_t width;               // pixels as stored, before any EXIF orientation
+    size_t height;
+    int bits_per_component;     // PNG bit depth, JPEG precision, TIFF BitsPerSample; 8 for GIF palettes
+    int components;             // samples per pixel as stored; 1 for palette images
+    size_t frame_count;         // APNG frames, TIFF directories or GIF images; 1 for JPEG and plain PNG
+} OCRImageInfo;
+
+/**
+ * Identify an image format from its leading bytes, whatever the file is named
+ * @param data encoded image bytes
+ * @param length number of bytes; OCR_IMAGE_SIGNATURE_BYTES are enough for any format
+ * @return the format, OCR_IMAGE_FORMAT_UNKNOWN if no supported signature matches
+ */
+OCRImageFormat ocr_image_sniff(const void* data, size_t length);
+
+/**
+ * Read an image file whose signature names a supported format
+ * The file is opened once; its signature is read first, so files in other formats are
+ * refused without reading the rest
+ * @param path image file path
+ * @param data receives the file contents on success
+ * @param length receives the number of bytes
+ * @param format receives the sniffed format; may be NULL
+ * @return OCR_OK, OCR_ERROR_FILE_NOT_FOUND for a missing path or one that is not a regular
+ *         file, OCR_ERROR_ACCESS_DENIED, OCR_ERROR_UNSUPPORTED_FORMAT, OCR_ERROR_OUT_OF_MEMORY,
+ *         or OCR_ERROR_FILE_READ for I/O errors and files that change size while read
+ * @note The data must be freed with free()
+ */
+OCRErrorCode ocr_image_read_file(const char* path, void** data, size_t* length, OCRImageFormat* format);
+
+/**
+ * Read the header of an in-memory image
+ * Only headers and chunk or block framing are read; every offset is bounds-checked,
+ * so any input, including truncated or hostile data, is safe to pass
+ * @param data encoded image bytes
+ * @param length number of bytes
+ * @param info receives the header fields
+ * @return true if the data starts with a PNG, JPEG, TIFF or GIF header holding non-zero dimensions
+ */
+bool ocr_image_probe(const void* data, size_t length, OCRImageInfo* info);
+
+/**
+ * Read the header of an image file
+ * The file is memory-mapped, so only the pages the parser touches are read
+ * @param path image file path
+ * @param info receives the header fields
+ * @param error receives OCR_OK, or why the file could not be read or is not a known format
+ *        (OCR_ERROR_UNSUPPORTED_FORMAT); may be NULL
+ * @return true on success
+ */
+bool ocr_image_probe_file(const char* path, OCRImageInfo* info, OCRErrorCode* error);
+
+/**
+ * Bytes a decoder needs for the first frame as RGBA, 8 or 16 bits per component
+ * @param info probed header
+ * @return estimated decoded size, SIZE_MAX if it overflows
+ */
+size_t ocr_image_decoded_bytes(const OCRImageInfo* info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MAC_OCR_IMAGE_PROBE_H
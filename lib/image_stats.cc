@@ -0,0 +1,131 @@
+#include "image_stats.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+// Smallest neighbour step, in luminance levels, that counts as an edge
+const uint8_t kEdgeStep = 24;
+
+// 16-pixel blocks between flushes of the 32-bit square sums; each lane gains at
+// most 4 * 255^2 per block, so this stays far below overflow
+const size_t kFlushBlocks = 4096;
+
+inline int AbsDiff(uint8_t a, uint8_t b) {
+    return a > b ? a - b : b - a;
+}
+
+// Add the sum and the sum of squares of one row
+void AccumulateRow(const uint8_t* row, size_t width, uint64_t* sum, uint64_t* squares) {
+    size_t x = 0;
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    while (x + 16 <= width) {
+        __m128i sums = zero;
+        __m128i acc = zero;
+        for (size_t blocks = 0; blocks < kFlushBlocks && x + 16 <= width; blocks++, x += 16) {
+            __m128i px = _mm_loadu_si128((const __m128i*)(row + x));
+            sums = _mm_add_epi64(sums, _mm_sad_epu8(px, zero));
+            __m128i lo = _mm_unpacklo_epi8(px, zero);
+            __m128i hi = _mm_unpackhi_epi8(px, zero);
+            acc = _mm_add_epi32(acc, _mm_add_epi32(_mm_madd_epi16(lo, lo), _mm_madd_epi16(hi, hi)));
+        }
+        uint64_t s[2];
+        uint32_t q[4];
+        _mm_storeu_si128((__m128i*)s, sums);
+        _mm_storeu_si128((__m128i*)q, acc);
+        *sum += s[0] + s[1];
+        *squares += (uint64_t)q[0] + q[1] + q[2] + q[3];
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    while (x + 16 <= width) {
+        uint32x4_t acc = vdupq_n_u32(0);
+        uint64_t sums = 0;
+        for (size_t blocks = 0; blocks < kFlushBlocks && x + 16 <= width; blocks++, x += 16) {
+            uint8x16_t px = vld1q_u8(row + x);
+            sums += vaddlvq_u8(px);
+            acc = vpadalq_u16(acc, vmull_u8(vget_low_u8(px), vget_low_u8(px)));
+            acc = vpadalq_u16(acc, vmull_u8(vget_high_u8(px), vget_high_u8(px)));
+        }
+        *sum += sums;
+        *squares += vaddlvq_u32(acc);
+    }
+#endif
+    for (; x < width; x++) {
+        *sum += row[x];
+        *squares += (uint64_t)row[x] * row[x];
+    }
+}
+
+// Count the pixels of a row, all but the last, that step by more than kEdgeStep
+// to their right or lower neighbour
+size_t CountRowEdges(const uint8_t* row, const uint8_t* below, size_t width) {
+    size_t count = 0;
+    size_t x = 0;
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i step = _mm_set1_epi8((char)kEdgeStep);
+    for (; x + 17 <= width; x += 16) {
+        __m128i px = _mm_loadu_si128((const __m128i*)(row + x));
+        __m128i right = _mm_loadu_si128((const __m128i*)(row + x + 1));
+        __m128i down = _mm_loadu_si128((const __m128i*)(below + x));
+        __m128i dx = _mm_or_si128(_mm_subs_epu8(px, right), _mm_subs_epu8(right, px));
+        __m128i dy = _mm_or_si128(_mm_subs_epu8(px, down), _mm_subs_epu8(down, px));
+        // Saturating subtraction leaves zero exactly where the step is not an edge
+        __m128i flat = _mm_cmpeq_epi8(_mm_subs_epu8(_mm_max_epu8(dx, dy), step), zero);
+        count += 16 - __builtin_popcount((unsigned)_mm_movemask_epi8(flat));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint8x16_t step = vdupq_n_u8(kEdgeStep);
+    for (; x + 17 <= width; x += 16) {
+        uint8x16_t px = vld1q_u8(row + x);
+        uint8x16_t diff = vmaxq_u8(vabdq_u8(px, vld1q_u8(row + x + 1)), vabdq_u8(px, vld1q_u8(below + x)));
+        count += vaddvq_u8(vshrq_n_u8(vcgtq_u8(diff, step), 7));
+    }
+#endif
+    for (; x + 1 < width; x++) {
+        if (AbsDiff(row[x], row[x + 1]) > kEdgeStep || AbsDiff(row[x], below[x]) > kEdgeStep) {
+            count++;
+        }
+    }
+    return count;
+}
+
+} // namespace
+
+bool ocr_image_stats(const uint8_t* gray, size_t width, size_t height, size_t bytes_per_row, OCRImageStats* stats) {
+    if (!gray || !stats || width == 0 || height == 0 || bytes_per_row < width) {
+        return false;
+    }
+    uint64_t sum = 0;
+    uint64_t squares = 0;
+    size_t edges = 0;
+    for (size_t y = 0; y < height; y++) {
+        const uint8_t* row = gray + y * bytes_per_row;
+        AccumulateRow(row, width, &sum, &squares);
+        if (y + 1 < height) {
+            edges += CountRowEdges(row, row + bytes_per_row, width);
+        }
+    }
+
+    double pixels = (double)width * height;
+    stats->mean = sum / pixels;
+    stats->stddev = std::sqrt(std::max(0.0, squares / pixels - stats->mean * stats->mean));
+    size_t edge_pixels = (width - 1) * (height - 1);
+    stats->edge_density = edge_pixels > 0 ? (double)edges / edge_pixels : 0.0;
+    return true;
+}
+
+bool ocr_image_is_blank(const OCRImageStats* stats, double min_stddev, double min_edge_density) {
+    if (!stats) {
+        return false;
+    }
+    return stats->stddev < min_stddev || stats->edge_density < min_edge_density;
+}
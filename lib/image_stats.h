@@ -0,0 +1,48 @@
+#ifndef MAC_OCR_IMAGE_STATS_H
+#define MAC_OCR_IMAGE_STATS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Luminance statistics used to recognize blank pages without running Vision
+ */
+typedef struct {
+    double mean;               // mean luminance 0-255
+    double stddev;             // standard deviation of luminance in levels
+    double edge_density;       // share of pixels that differ from a right or lower neighbour by more than the edge step
+} OCRImageStats;
+
+/**
+ * Compute the luminance statistics of an 8-bit gray image
+ * Sums and edge counts run over 16-pixel SIMD blocks. An edge is a step of more than
+ * 24 levels between neighbours, well above scanner noise and paper texture but below
+ * the contrast of text, even when the image was downsampled before the check
+ * @param gray 8-bit luminance pixels
+ * @param width image width in pixels
+ * @param height image height in pixels
+ * @param bytes_per_row distance between rows in bytes
+ * @param stats receives the statistics
+ * @return true on success, false if the image is empty
+ */
+bool ocr_image_stats(const uint8_t* gray, size_t width, size_t height, size_t bytes_per_row, OCRImageStats* stats);
+
+/**
+ * Decide whether an image carries too little information to hold text
+ * @param stats statistics from ocr_image_stats
+ * @param min_stddev images with a luminance standard deviation below this are uniform
+ * @param min_edge_density images with an edge density below this hold no legible text
+ * @return true if the image should be treated as blank
+ */
+bool ocr_image_is_blank(const OCRImageStats* stats, double min_stddev, double min_edge_density);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MAC_OCR_IMAGE_STATS_H
@@ -0,0 +1,424 @@
+#include "inverted_index.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+const char kMagic[8] = {'O', 'C', 'R', 'I', 'D', 'X', '0', '1'};
+const uint32_t kVersion = 1;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t term_count;
+    uint64_t posting_count;
+    uint64_t terms_offset;
+    uint64_t postings_offset;
+    uint64_t strings_offset;
+    uint64_t strings_size;
+};
+
+struct FileTerm {
+    uint32_t string_offset;
+    uint32_t string_length;
+    uint64_t first_posting;
+    uint32_t posting_count;
+    uint32_t reserved;
+};
+
+// Decode one UTF-8 sequence; returns its length, or 0 for a malformed byte
+size_t DecodeUtf8(const unsigned char* s, uint32_t* code_point) {
+    if (s[0] < 0x80) {
+        *code_point = s[0];
+        return 1;
+    }
+    size_t length = (s[0] & 0xE0) == 0xC0 ? 2 : (s[0] & 0xF0) == 0xE0 ? 3 : (s[0] & 0xF8) == 0xF0 ? 4 : 0;
+    if (length == 0) {
+        return 0;
+    }
+    uint32_t value = s[0] & (0x7F >> length);
+    for (size_t i = 1; i < length; i++) {
+        if ((s[i] & 0xC0) != 0x80) {
+            return 0;
+        }
+        value = (value << 6) | (s[i] & 0x3F);
+    }
+    *code_point = value;
+    return length;
+}
+
+bool IsSingleCharacterToken(uint32_t c) {
+    return (c >= 0x3040 && c <= 0x30FF) ||   // hiragana, katakana
+           (c >= 0x3400 && c <= 0x4DBF) ||   // CJK extension A
+           (c >= 0x4E00 && c <= 0x9FFF) ||   // CJK unified ideographs
+           (c >= 0xAC00 && c <= 0xD7AF) ||   // hangul syllables
+           (c >= 0xF900 && c <= 0xFAFF) ||   // CJK compatibility ideographs
+           (c >= 0x20000 && c <= 0x2FFFF);   // CJK extensions B-F
+}
+
+bool IsWordCharacter(uint32_t c) {
+    if (c < 0x80) {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    }
+    return !(c <= 0xBF ||                    // Latin-1 punctuation and symbols
+             c == 0xD7 || c == 0xF7 ||       // multiplication and division signs
+             (c >= 0x2000 && c <= 0x2BFF) || // punctuation, symbols, arrows, box drawing
+             (c >= 0x3000 && c <= 0x303F) || // CJK symbols and punctuation
+             (c >= 0xFF00 && c <= 0xFF0F) || // fullwidth punctuation
+             (c >= 0xFF1A && c <= 0xFF20));
+}
+
+void Tokenize(const char* text, std::vector<std::string>* tokens) {
+    const unsigned char* s = reinterpret_cast<const unsigned char*>(text);
+    std::string current;
+    while (*s) {
+        uint32_t c = 0;
+        size_t length = DecodeUtf8(s, &c);
+        if (length == 0) {
+            length = 1;
+            c = ' ';
+        }
+
+        if (IsSingleCharacterToken(c) || !IsWordCharacter(c)) {
+            if (!current.empty()) {
+                tokens->push_back(current);
+                current.clear();
+            }
+            if (IsSingleCharacterToken(c)) {
+                tokens->push_back(std::string(reinterpret_cast<const char*>(s), length));
+            }
+        } else if (c < 0x80) {
+            current.push_back((char)(c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c));
+        } else {
+            current.append(reinterpret_cast<const char*>(s), length);
+        }
+        s += length;
+    }
+    if (!current.empty()) {
+        tokens->push_back(current);
+    }
+}
+
+bool PostingLess(const OCRPosting& a, const OCRPosting& b) {
+    if (a.image != b.image) return a.image < b.image;
+    if (a.observation != b.observation) return a.observation < b.observation;
+    return a.position < b.position;
+}
+
+} // namespace
+
+struct OCRIndexBuilder {
+    std::mutex mutex;
+    std::unordered_map<std::string, std::vector<OCRPosting>> postings;
+    size_t posting_count = 0;
+};
+
+struct OCRIndex {
+    void* mapping;
+    size_t size;
+    const FileHeader* header;
+    const FileTerm* terms;
+    const OCRPosting* postings;
+    const char* strings;
+};
+
+OCRIndexBuilder* ocr_index_builder_create(void) {
+    return new (std::nothrow) OCRIndexBuilder();
+}
+
+bool ocr_index_builder_add(OCRIndexBuilder* builder, uint32_t image, const TextObservation* observations, size_t count) {
+    if (!builder || (!observations && count > 0)) {
+        return false;
+    }
+
+    try {
+        // Tokenize outside the lock so concurrent workers only serialize on the merge
+        std::vector<std::pair<std::string, OCRPosting>> local;
+        std::vector<std::string> tokens;
+        for (size_t i = 0; i < count; i++) {
+            if (!observations[i].text) {
+                continue;
+            }
+            tokens.clear();
+            Tokenize(observations[i].text, &tokens);
+            for (size_t t = 0; t < tokens.size(); t++) {
+                OCRPosting posting = {image, (uint32_t)i, (uint32_t)t};
+                local.push_back({std::move(tokens[t]), posting});
+            }
+        }
+
+        std::lock_guard<std::mutex> guard(builder->mutex);
+        for (std::pair<std::string, OCRPosting>& entry : local) {
+            builder->postings[std::move(entry.first)].push_back(entry.second);
+        }
+        builder->posting_count += local.size();
+        return true;
+    } catch (const std::bad_alloc&) {
+        return false;
+    }
+}
+
+void ocr_index_builder_stats(OCRIndexBuilder* builder, size_t* term_count, size_t* posting_count) {
+    if (!builder) return;
+
+    std::lock_guard<std::mutex> guard(builder->mutex);
+    if (term_count) *term_count = builder->postings.size();
+    if (posting_count) *posting_count = builder->posting_count;
+}
+
+bool ocr_index_builder_write(OCRIndexBuilder* builder, const char* path, OCRErrorCode* error) {
+    if (!builder || !path || !error) {
+        if (error) *error = OCR_ERROR_INVALID_ARGUMENT;
+        return false;
+    }
+    *error = OCR_OK;
+
+    try {
+        std::lock_guard<std::mutex> guard(builder->mutex);
+
+        std::vector<const std::string*> terms;
+        terms.reserve(builder->postings.size());
+        for (const auto& entry : builder->postings) {
+            terms.push_back(&entry.first);
+        }
+        std::sort(terms.begin(), terms.end(), [](const std::string* a, const std::string* b) {
+            return *a < *b;
+        });
+
+        FileHeader header;
+        memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        header.term_count = (uint32_t)terms.size();
+        header.posting_count = builder->posting_count;
+        header.terms_offset = sizeof(FileHeader);
+        header.postings_offset = header.terms_offset + sizeof(FileTerm) * terms.size();
+        header.strings_offset = header.postings_offset + sizeof(OCRPosting) * builder->posting_count;
+        header.strings_size = 0;
+
+        std::vector<FileTerm> table(terms.size());
+        uint64_t first_posting = 0;
+        for (size_t i = 0; i < terms.size(); i++) {
+            table[i].string_offset = (uint32_t)header.strings_size;
+            table[i].string_length = (uint32_t)terms[i]->size();
+            table[i].first_posting = first_posting;
+            table[i].posting_count = (uint32_t)builder->postings[*terms[i]].size();
+            table[i].reserved = 0;
+            header.strings_size += terms[i]->size();
+            first_posting += table[i].posting_count;
+        }
+
+        FILE* file = fopen(path, "wb");
+        if (!file) {
+            *error = OCR_ERROR_INDEX_WRITE;
+            return false;
+        }
+
+        bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+        if (ok && !table.empty()) {
+            ok = fwrite(table.data(), sizeof(FileTerm), table.size(), file) == table.size();
+        }
+        for (size_t i = 0; ok && i < terms.size(); i++) {
+            std::vector<OCRPosting>& postings = builder->postings[*terms[i]];
+            std::sort(postings.begin(), postings.end(), PostingLess);
+            ok = fwrite(postings.data(), sizeof(OCRPosting), postings.size(), file) == postings.size();
+        }
+        for (size_t i = 0; ok && i < terms.size(); i++) {
+            ok = fwrite(terms[i]->data(), 1, terms[i]->size(), file) == terms[i]->size();
+        }
+        if (fclose(file) != 0) {
+            ok = false;
+        }
+
+        if (!ok) {
+            *error = OCR_ERROR_INDEX_WRITE;
+            return false;
+        }
+        return true;
+    } catch (const std::bad_alloc&) {
+        *error = OCR_ERROR_OUT_OF_MEMORY;
+        return false;
+    }
+}
+
+void ocr_index_builder_free(OCRIndexBuilder* builder) {
+    delete builder;
+}
+
+OCRIndex* ocr_index_open(const char* path, OCRErrorCode* error) {
+    if (!path || !error) {
+        if (error) *error = OCR_ERROR_INVALID_ARGUMENT;
+        return NULL;
+    }
+
+    *error = OCR_OK;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        *error = ocr_error_from_errno(errno);
+        return NULL;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(FileHeader)) {
+        close(fd);
+        *error = OCR_ERROR_INDEX_CORRUPT;
+        return NULL;
+    }
+
+    size_t size = (size_t)info.st_size;
+    void* mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        *error = OCR_ERROR_FILE_READ;
+        return NULL;
+    }
+
+    // Each section is compared against the bytes left after it before any product or sum is
+    // formed, so counts in a crafted header cannot wrap around to a valid-looking layout
+    const FileHeader* header = static_cast<const FileHeader*>(mapping);
+    bool valid = memcmp(header->magic, kMagic, sizeof(kMagic)) == 0 && header->version == kVersion &&
+                 header->terms_offset == sizeof(FileHeader) &&
+                 header->term_count <= (size - header->terms_offset) / sizeof(FileTerm) &&
+                 header->postings_offset == header->terms_offset + sizeof(FileTerm) * (uint64_t)header->term_count &&
+                 header->posting_count <= (size - header->postings_offset) / sizeof(OCRPosting) &&
+                 header->strings_offset == header->postings_offset + sizeof(OCRPosting) * header->posting_count &&
+                 header->strings_size == size - header->strings_offset;
+    if (!valid) {
+        munmap(mapping, size);
+        *error = OCR_ERROR_INDEX_CORRUPT;
+        return NULL;
+    }
+
+    OCRIndex* index = new (std::nothrow) OCRIndex();
+    if (!index) {
+        munmap(mapping, size);
+        *error = OCR_ERROR_OUT_OF_MEMORY;
+        return NULL;
+    }
+
+    const char* base = static_cast<const char*>(mapping);
+    index->mapping = mapping;
+    index->size = size;
+    index->header = header;
+    index->terms = reinterpret_cast<const FileTerm*>(base + header->terms_offset);
+    index->postings = reinterpret_cast<const OCRPosting*>(base + header->postings_offset);
+    index->strings = base + header->strings_offset;
+
+    // Reject tables pointing outside the mapping once, so lookups need no checks
+    for (uint32_t i = 0; i < header->term_count; i++) {
+        const FileTerm& term = index->terms[i];
+        if ((uint64_t)term.string_offset + term.string_length > header->strings_size ||
+            term.first_posting > header->posting_count ||
+            term.posting_count > header->posting_count - term.first_posting) {
+            ocr_index_close(index);
+            *error = OCR_ERROR_INDEX_CORRUPT;
+            return NULL;
+        }
+    }
+    return index;
+}
+
+size_t ocr_index_term_count(const OCRIndex* index) {
+    return index ? index->header->term_count : 0;
+}
+
+const OCRPosting* ocr_index_lookup(const OCRIndex* index, const char* term, size_t* count) {
+    if (count) *count = 0;
+    if (!index || !term) {
+        return NULL;
+    }
+
+    std::vector<std::string> tokens;
+    try {
+        Tokenize(term, &tokens);
+    } catch (const std::bad_alloc&) {
+        return NULL;
+    }
+    if (tokens.size() != 1) {
+        return NULL;
+    }
+
+    const std::string& key = tokens[0];
+    const FileTerm* begin = index->terms;
+    const FileTerm* end = index->terms + index->header->term_count;
+    const FileTerm* it = std::lower_bound(begin, end, key, [index](const FileTerm& entry, const std::string& value) {
+        return value.compare(0, std::string::npos, index->strings + entry.string_offset, entry.string_length) > 0;
+    });
+    if (it == end || key.compare(0, std::string::npos, index->strings + it->string_offset, it->string_length) != 0) {
+        return NULL;
+    }
+
+    if (count) *count = it->posting_count;
+    return index->postings + it->first_posting;
+}
+
+size_t ocr_index_search(const OCRIndex* index, const char* query, uint32_t* images, size_t capacity) {
+    if (!index || !query) {
+        return 0;
+    }
+
+    try {
+        std::vector<std::string> tokens;
+        Tokenize(query, &tokens);
+        if (tokens.empty()) {
+            return 0;
+        }
+
+        std::vector<uint32_t> matches;
+        for (size_t t = 0; t < tokens.size(); t++) {
+            size_t count = 0;
+            const OCRPosting* postings = ocr_index_lookup(index, tokens[t].c_str(), &count);
+            if (!postings) {
+                return 0;
+            }
+
+            // Postings are sorted by image, so distinct images come out sorted too
+            std::vector<uint32_t> term_images;
+            for (size_t i = 0; i < count; i++) {
+                if (term_images.empty() || term_images.back() != postings[i].image) {
+                    term_images.push_back(postings[i].image);
+                }
+            }
+
+            if (t == 0) {
+                matches.swap(term_images);
+            } else {
+                std::vector<uint32_t> intersection;
+                std::set_intersection(matches.begin(), matches.end(), term_images.begin(), term_images.end(),
+                                      std::back_inserter(intersection));
+                matches.swap(intersection);
+            }
+            if (matches.empty()) {
+                return 0;
+            }
+        }
+
+        if (images) {
+            std::copy(matches.begin(), matches.begin() + std::min(capacity, matches.size()), images);
+        }
+        return matches.size();
+    } catch (const std::bad_alloc&) {
+        return 0;
+    }
+}
+
+void ocr_index_close(OCRIndex* index) {
+    if (!index) return;
+
+    munmap(index->mapping, index->size);
+    delete index;
+}
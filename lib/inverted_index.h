@@ -0,0 +1,129 @@
+#ifndef MAC_OCR_INVERTED_INDEX_H
+#define MAC_OCR_INVERTED_INDEX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ocr_types.h"
+#include "ocr_error.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Occurrence of a term
+ */
+typedef struct {
+    uint32_t image;         // index of the image in the indexed inputs
+    uint32_t observation;   // index of the observation in reading order
+    uint32_t position;      // index of the token inside the observation
+} OCRPosting;
+
+/**
+ * Thread-safe builder collecting postings while results are produced
+ */
+typedef struct OCRIndexBuilder OCRIndexBuilder;
+
+/**
+ * Read-only index mapped from disk
+ *
+ * File layout (host byte order, little-endian on all supported Macs):
+ *   header    "OCRIDX01", uint32 version, uint32 term_count, uint64 posting_count,
+ *             uint64 terms_offset, uint64 postings_offset, uint64 strings_offset, uint64 strings_size
+ *   terms     term_count x {uint32 string_offset, uint32 string_length, uint64 first_posting,
+ *             uint32 posting_count, uint32 reserved}, sorted by term bytes
+ *   postings  posting_count x OCRPosting, grouped by term and sorted by image, observation, position
+ *   strings   term bytes, not NUL-terminated
+ * Lookups binary search the terms table and return pointers straight into the mapping.
+ */
+typedef struct OCRIndex OCRIndex;
+
+/**
+ * Create an empty index builder
+ * @return builder pointer, NULL if memory allocation fails
+ * @note The returned builder must be freed using ocr_index_builder_free
+ */
+OCRIndexBuilder* ocr_index_builder_create(void);
+
+/**
+ * Tokenize the observations of one image and add their postings
+ * Tokens are runs of letters and digits lowercased in ASCII; CJK ideographs,
+ * kana and hangul syllables are indexed one character per token
+ * @param builder index builder, may be shared between threads
+ * @param image index of the image
+ * @param observations observation array in reading order
+ * @param count number of observations
+ * @return true on success, false if memory allocation fails
+ */
+bool ocr_index_builder_add(OCRIndexBuilder* builder, uint32_t image, const TextObservation* observations, size_t count);
+
+/**
+ * Number of distinct terms and postings collected so far
+ * @param builder index builder
+ * @param term_count receives the number of distinct terms, can be NULL
+ * @param posting_count receives the number of postings, can be NULL
+ */
+void ocr_index_builder_stats(OCRIndexBuilder* builder, size_t* term_count, size_t* posting_count);
+
+/**
+ * Write the collected postings to an index file
+ * @param builder index builder
+ * @param path output file path
+ * @param error receives OCR_OK, OCR_ERROR_INDEX_WRITE or OCR_ERROR_OUT_OF_MEMORY
+ * @return true on success
+ */
+bool ocr_index_builder_write(OCRIndexBuilder* builder, const char* path, OCRErrorCode* error);
+
+/**
+ * Free an index builder
+ * @param builder builder to be freed, can be NULL
+ */
+void ocr_index_builder_free(OCRIndexBuilder* builder);
+
+/**
+ * Map an index file into memory
+ * @param path index file path
+ * @param error receives OCR_OK, a file error such as OCR_ERROR_FILE_NOT_FOUND, or
+ *        OCR_ERROR_INDEX_CORRUPT if the header does not describe the file
+ * @return index pointer, NULL if failed
+ * @note The returned index must be closed using ocr_index_close
+ */
+OCRIndex* ocr_index_open(const char* path, OCRErrorCode* error);
+
+/**
+ * Number of distinct terms in the index
+ * @param index index, can be NULL
+ * @return number of terms, 0 for NULL
+ */
+size_t ocr_index_term_count(const OCRIndex* index);
+
+/**
+ * Find the postings of a term
+ * @param index index
+ * @param term term to look up, normalized the same way as indexed text
+ * @param count receives the number of postings
+ * @return postings inside the mapping, valid until ocr_index_close; NULL if the term is absent
+ */
+const OCRPosting* ocr_index_lookup(const OCRIndex* index, const char* term, size_t* count);
+
+/**
+ * Find the images containing every token of a query
+ * @param index index
+ * @param query text to tokenize
+ * @param images array receiving matching image indices in ascending order, can be NULL
+ * @param capacity number of entries available in images
+ * @return total number of matching images, which may exceed capacity
+ */
+size_t ocr_index_search(const OCRIndex* index, const char* query, uint32_t* images, size_t capacity);
+
+/**
+ * Unmap an index
+ * @param index index to be closed, can be NULL
+ */
+void ocr_index_close(OCRIndex* index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MAC_OCR_INVERTED_INDEX_H
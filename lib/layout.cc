@@ -0,0 +1,371 @@
+#include "layout.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+namespace {
+
+// All thresholds are expressed in multiples of the median observation height,
+// so the same constants work for screenshots and for dense scanned pages.
+const double kLineOverlapRatio = 0.5;    // vertical overlap needed to share a line
+const double kParagraphGapRatio = 0.75;  // vertical whitespace that starts a new paragraph
+const double kColumnGapRatio = 1.5;      // horizontal whitespace that starts a new column
+const int kMaxCutDepth = 32;             // bounds the recursion on pathological layouts
+
+struct Box {
+    double left;
+    double right;
+    double bottom;
+    double top;
+};
+
+struct Range {
+    size_t begin;
+    size_t end;
+};
+
+struct Leaf {
+    Range range;
+    size_t column;
+};
+
+class LayoutBuilder {
+public:
+    LayoutBuilder(const TextObservation* observations, size_t count)
+        : boxes_(count), items_(count) {
+        std::vector<double> heights(count);
+        for (size_t i = 0; i < count; i++) {
+            const TextObservation& obs = observations[i];
+            boxes_[i] = {obs.x, obs.x + obs.width, obs.y, obs.y + obs.height};
+            items_[i] = i;
+            heights[i] = obs.height;
+        }
+
+        unit_ = 0.0;
+        if (count > 0) {
+            std::nth_element(heights.begin(), heights.begin() + count / 2, heights.end());
+            unit_ = heights[count / 2];
+        }
+        if (unit_ <= 0.0) {
+            unit_ = 1e-3;
+        }
+    }
+
+    void Build() {
+        Cut({0, items_.size()}, 0, 0);
+    }
+
+    const std::vector<Box>& boxes() const { return boxes_; }
+    const std::vector<size_t>& items() const { return items_; }
+    const std::vector<Leaf>& leaves() const { return leaves_; }
+
+    // Split a leaf into lines, reordering its items top to bottom, left to right
+    std::vector<Range> SplitLines(Range range) {
+        std::sort(items_.begin() + range.begin, items_.begin() + range.end,
+                  [this](size_t a, size_t b) {
+                      return Center(boxes_[a]) > Center(boxes_[b]);
+                  });
+
+        std::vector<Range> lines;
+        size_t line_begin = range.begin;
+        double line_bottom = 0.0;
+        double line_top = 0.0;
+        for (size_t i = range.begin; i < range.end; i++) {
+            const Box& box = boxes_[items_[i]];
+            if (i > line_begin) {
+                double overlap = std::min(line_top, box.top) - std::max(line_bottom, box.bottom);
+                double shortest = std::min(line_top - line_bottom, box.top - box.bottom);
+                if (overlap >= kLineOverlapRatio * shortest && overlap > 0.0) {
+                    line_bottom = std::min(line_bottom, box.bottom);
+                    line_top = std::max(line_top, box.top);
+                    continue;
+                }
+                lines.push_back({line_begin, i});
+                line_begin = i;
+            }
+            line_bottom = box.bottom;
+            line_top = box.top;
+        }
+        if (range.end > line_begin) {
+            lines.push_back({line_begin, range.end});
+        }
+
+        for (const Range& line : lines) {
+            std::sort(items_.begin() + line.begin, items_.begin() + line.end,
+                      [this](size_t a, size_t b) {
+                          return boxes_[a].left < boxes_[b].left;
+                      });
+        }
+        return lines;
+    }
+
+private:
+    static double Center(const Box& box) {
+        return (box.bottom + box.top) * 0.5;
+    }
+
+    // Recursive XY-cut: a gutter running the full height of the region splits
+    // it into columns first, otherwise it is split into paragraph bands
+    void Cut(Range range, int depth, size_t column) {
+        if (range.end - range.begin > 1 && depth < kMaxCutDepth) {
+            std::vector<Range> columns = SplitColumns(range);
+            if (columns.size() > 1) {
+                for (const Range& part : columns) {
+                    Cut(part, depth + 1, ++column_ids_);
+                }
+                return;
+            }
+
+            std::vector<Range> rows = SplitRows(range);
+            if (rows.size() > 1) {
+                for (const Range& row : rows) {
+                    Cut(row, depth + 1, column);
+                }
+                return;
+            }
+        }
+        leaves_.push_back({range, column});
+    }
+
+    std::vector<Range> SplitRows(Range range) {
+        std::sort(items_.begin() + range.begin, items_.begin() + range.end,
+                  [this](size_t a, size_t b) {
+                      return boxes_[a].top > boxes_[b].top;
+                  });
+
+        std::vector<Range> rows;
+        double gap = kParagraphGapRatio * unit_;
+        size_t row_begin = range.begin;
+        double row_bottom = boxes_[items_[range.begin]].bottom;
+        for (size_t i = range.begin + 1; i < range.end; i++) {
+            const Box& box = boxes_[items_[i]];
+            if (box.top < row_bottom - gap) {
+                rows.push_back({row_begin, i});
+                row_begin = i;
+                row_bottom = box.bottom;
+            } else {
+                row_bottom = std::min(row_bottom, box.bottom);
+            }
+        }
+        rows.push_back({row_begin, range.end});
+        return rows;
+    }
+
+    std::vector<Range> SplitColumns(Range range) {
+        std::sort(items_.begin() + range.begin, items_.begin() + range.end,
+                  [this](size_t a, size_t b) {
+                      return boxes_[a].left < boxes_[b].left;
+                  });
+
+        std::vector<Range> columns;
+        double gap = kColumnGapRatio * unit_;
+        size_t column_begin = range.begin;
+        double column_right = boxes_[items_[range.begin]].right;
+        for (size_t i = range.begin + 1; i < range.end; i++) {
+            const Box& box = boxes_[items_[i]];
+            if (box.left > column_right + gap) {
+                columns.push_back({column_begin, i});
+                column_begin = i;
+                column_right = box.right;
+            } else {
+                column_right = std::max(column_right, box.right);
+            }
+        }
+        columns.push_back({column_begin, range.end});
+        return columns;
+    }
+
+    std::vector<Box> boxes_;
+    std::vector<size_t> items_;
+    std::vector<Leaf> leaves_;
+    size_t column_ids_ = 0;
+    double unit_;
+};
+
+struct Bounds {
+    double left = 0.0;
+    double right = 0.0;
+    double bottom = 0.0;
+    double top = 0.0;
+    bool empty = true;
+
+    void Add(double l, double r, double b, double t) {
+        if (empty) {
+            left = l; right = r; bottom = b; top = t;
+            empty = false;
+            return;
+        }
+        left = std::min(left, l);
+        right = std::max(right, r);
+        bottom = std::min(bottom, b);
+        top = std::max(top, t);
+    }
+
+    void Add(const OCRLayoutNode& node) {
+        Add(node.x, node.x + node.width, node.y, node.y + node.height);
+    }
+
+    OCRLayoutNode ToNode(size_t first, size_t count) const {
+        OCRLayoutNode node;
+        node.x = left;
+        node.y = bottom;
+        node.width = right - left;
+        node.height = top - bottom;
+        node.first = first;
+        node.count = count;
+        return node;
+    }
+};
+
+template <typename T>
+T* CopyToMalloc(const std::vector<T>& items) {
+    if (items.empty()) {
+        return NULL;
+    }
+    T* copy = static_cast<T*>(malloc(sizeof(T) * items.size()));
+    if (copy) {
+        memcpy(copy, items.data(), sizeof(T) * items.size());
+    }
+    return copy;
+}
+
+} // namespace
+
+bool ocr_layout_build(TextObservation* observations, size_t count, OCRLayout* out) {
+    if (!out) {
+        return false;
+    }
+    memset(out, 0, sizeof(OCRLayout));
+    if (!observations || count == 0) {
+        return true;
+    }
+
+    try {
+        LayoutBuilder builder(observations, count);
+        builder.Build();
+
+        std::vector<size_t> order;
+        std::vector<OCRLayoutNode> lines;
+        std::vector<OCRLayoutNode> paragraphs;
+        std::vector<OCRLayoutNode> columns;
+        order.reserve(count);
+
+        const std::vector<Box>& boxes = builder.boxes();
+        size_t current_column = 0;
+        for (size_t l = 0; l < builder.leaves().size(); l++) {
+            Leaf leaf = builder.leaves()[l];
+
+            if (l == 0 || leaf.column != current_column) {
+                columns.push_back(Bounds().ToNode(paragraphs.size(), 0));
+                current_column = leaf.column;
+            }
+
+            Bounds paragraph_bounds;
+            size_t first_line = lines.size();
+            for (const Range& line : builder.SplitLines(leaf.range)) {
+                Bounds line_bounds;
+                size_t first_observation = order.size();
+                for (size_t i = line.begin; i < line.end; i++) {
+                    size_t index = builder.items()[i];
+                    const Box& box = boxes[index];
+                    line_bounds.Add(box.left, box.right, box.bottom, box.top);
+                    order.push_back(index);
+                }
+                lines.push_back(line_bounds.ToNode(first_observation, order.size() - first_observation));
+                paragraph_bounds.Add(lines.back());
+            }
+            paragraphs.push_back(paragraph_bounds.ToNode(first_line, lines.size() - first_line));
+
+            OCRLayoutNode& column = columns.back();
+            Bounds column_bounds;
+            if (column.count > 0) {
+                column_bounds.Add(column);
+            }
+            column_bounds.Add(paragraphs.back());
+            column = column_bounds.ToNode(column.first, column.count + 1);
+        }
+
+        // Move observations into reading order so every line owns a contiguous range
+        std::vector<TextObservation> sorted(count);
+        for (size_t i = 0; i < count; i++) {
+            sorted[i] = observations[order[i]];
+        }
+        std::copy(sorted.begin(), sorted.end(), observations);
+
+        out->lines = CopyToMalloc(lines);
+        out->paragraphs = CopyToMalloc(paragraphs);
+        out->columns = CopyToMalloc(columns);
+        if (!out->lines || !out->paragraphs || !out->columns) {
+            ocr_layout_free(out);
+            return false;
+        }
+        out->line_count = lines.size();
+        out->paragraph_count = paragraphs.size();
+        out->column_count = columns.size();
+        return true;
+    } catch (const std::bad_alloc&) {
+        ocr_layout_free(out);
+        return false;
+    }
+}
+
+char* ocr_layout_join_text(const TextObservation* observations, const OCRLayout* layout) {
+    if (!observations || !layout) {
+        return NULL;
+    }
+
+    size_t length = 0;
+    for (size_t p = 0; p < layout->paragraph_count; p++) {
+        const OCRLayoutNode& paragraph = layout->paragraphs[p];
+        for (size_t l = paragraph.first; l < paragraph.first + paragraph.count; l++) {
+            const OCRLayoutNode& line = layout->lines[l];
+            for (size_t o = line.first; o < line.first + line.count; o++) {
+                length += strlen(observations[o].text) + 1;
+            }
+            length += 1;
+        }
+        length += 2;
+    }
+
+    char* text = static_cast<char*>(malloc(length + 1));
+    if (!text) {
+        return NULL;
+    }
+
+    char* cursor = text;
+    for (size_t p = 0; p < layout->paragraph_count; p++) {
+        const OCRLayoutNode& paragraph = layout->paragraphs[p];
+        if (p > 0) {
+            *cursor++ = '\n';
+            *cursor++ = '\n';
+        }
+        for (size_t l = paragraph.first; l < paragraph.first + paragraph.count; l++) {
+            const OCRLayoutNode& line = layout->lines[l];
+            if (l > paragraph.first) {
+                *cursor++ = '\n';
+            }
+            for (size_t o = line.first; o < line.first + line.count; o++) {
+                if (o > line.first) {
+                    *cursor++ = ' ';
+                }
+                size_t size = strlen(observations[o].text);
+                memcpy(cursor, observations[o].text, size);
+                cursor += size;
+            }
+        }
+    }
+    *cursor = '\0';
+    return text;
+}
+
+void ocr_layout_free(OCRLayout* layout) {
+    if (!layout) return;
+
+    free(layout->lines);
+    free(layout->paragraphs);
+    free(layout->columns);
+    memset(layout, 0, sizeof(OCRLayout));
+}
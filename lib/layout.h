@@ -0,0 +1,68 @@
+#ifndef MAC_OCR_LAYOUT_H
+#define MAC_OCR_LAYOUT_H
+
+#include <stdbool.h>
+#include "ocr_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Layout node: a bounding box plus a contiguous range of children
+ * Lines own observations, paragraphs own lines and columns own paragraphs
+ * Coordinates use the same normalized bottom-left origin as TextObservation
+ */
+typedef struct {
+    double x;             // x coordinate of the union of the children (0.0-1.0)
+    double y;             // y coordinate of the union of the children (0.0-1.0, bottom-left origin)
+    double width;         // width of the union of the children (0.0-1.0)
+    double height;        // height of the union of the children (0.0-1.0)
+    size_t first;         // index of the first child
+    size_t count;         // number of children
+} OCRLayoutNode;
+
+/**
+ * Reading-order layout hierarchy built from text observations
+ * Note: All arrays are dynamically allocated and need to be freed using ocr_layout_free
+ */
+typedef struct {
+    OCRLayoutNode* lines;       // lines in reading order, children index observations
+    size_t line_count;          // number of lines
+    OCRLayoutNode* paragraphs;  // paragraphs in reading order, children index lines
+    size_t paragraph_count;     // number of paragraphs
+    OCRLayoutNode* columns;     // columns in reading order, children index paragraphs
+    size_t column_count;        // number of columns
+} OCRLayout;
+
+/**
+ * Cluster observations into columns, paragraphs and lines by geometry
+ * Regions are split recursively at whitespace gaps (XY-cut), so the cost is
+ * O(n log n) per cut level with the depth bounded by a small constant
+ * @param observations observation array, reordered in place into reading order
+ * @param count number of observations
+ * @param out layout to fill, must be freed with ocr_layout_free even on failure
+ * @return true on success, false if memory allocation fails
+ */
+bool ocr_layout_build(TextObservation* observations, size_t count, OCRLayout* out);
+
+/**
+ * Join observation text in reading order
+ * Words on a line are separated by a space, lines by "\n" and paragraphs by "\n\n"
+ * @param observations observation array already ordered by ocr_layout_build
+ * @param layout layout produced by ocr_layout_build for the same observations
+ * @return dynamically allocated string, NULL if memory allocation fails
+ */
+char* ocr_layout_join_text(const TextObservation* observations, const OCRLayout* layout);
+
+/**
+ * Free layout arrays
+ * @param layout layout to be freed, can be NULL; its fields are reset afterwards
+ */
+void ocr_layout_free(OCRLayout* layout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MAC_OCR_LAYOUT_H
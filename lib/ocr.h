@@ -6,59 +6,173 @@ extern "C" {
 #endif
 
 #include <CoreGraphics/CoreGraphics.h>
+#include "ocr_types.h"
+#include "layout.h"
+#include "spatial_index.h"
+#include "table.h"
+#include "cascade.h"
+#include "cost_model.h"
+#include "frame_diff.h"
+#include "inverted_index.h"
+#include "perceptual_hash.h"
+#include "image_stats.h"
+#include "preprocess.h"
+#include "pyramid.h"
+#include "script_detect.h"
+#include "image_probe.h"
+#include "byte_budget.h"
+#include "pixel_pool.h"
+#include "ocr_error.h"
 
 /**
- * OCR recognition level
+ * Recognition plan chosen for OCROptions.latency_budget_ms
  */
-typedef enum {
-    OCR_RECOGNITION_LEVEL_FAST = 0,    // fast mode
-    OCR_RECOGNITION_LEVEL_ACCURATE = 1  // accurate mode
-} OCRRecognitionLevel;
+typedef struct {
+    bool applied;               // false unless a latency budget was given
+    OCRRecognitionLevel level;  // level used for recognition
+    double scale;               // downsampling factor applied to both sides
+    double predicted_ms;        // latency predicted by the cost model
+    double elapsed_ms;          // measured latency of downsampling and recognition
+    bool within_budget;         // false if even the cheapest plan was predicted to exceed the budget
+} OCRBudgetReport;
+
+/**
+ * What happened to a recognition run with OCROptions.hedge_after_ms
+ */
+typedef struct {
+    bool launched;              // a duplicate attempt was started because the first one ran late
+    bool won;                   // the returned result came from the duplicate attempt
+} OCRHedgeReport;
+
+/**
+ * Process-wide hedging counters, hedged / calls is the share of extra attempts
+ */
+typedef struct {
+    size_t calls;               // recognitions run with hedge_after_ms
+    size_t hedged;              // recognitions that launched a duplicate attempt
+    size_t hedge_wins;          // recognitions answered by the duplicate attempt
+} OCRHedgeStats;
+
+/**
+ * Blank page counters accumulated since the process started
+ */
+typedef struct {
+    size_t checked;             // recognitions run with reject_blank
+    size_t rejected;            // recognitions answered with an empty result without running Vision
+} OCRBlankStats;
+
+/**
+ * Language routing decision for OCROptions.route_languages
+ */
+typedef struct {
+    bool applied;               // a script pass chose the languages, false for a single language or the fast level
+    unsigned scripts;           // mask of OCRScript values found by the script pass
+    const char* languages;      // languages the image was recognized with, NULL unless applied
+    double probe_ms;            // latency of the script pass
+    double recognize_ms;        // latency of the recognition that followed
+} OCRRoutingReport;
+
+/**
+ * Language routing counters accumulated since the process started
+ * Accurate recognitions with more than one language are timed whether routed or not
+ */
+typedef struct {
+    size_t routed;              // recognitions that ran a script pass
+    size_t narrowed;            // routed recognitions that kept fewer languages than configured
+    double probe_ms;            // total time of the script passes
+    double narrowed_ms;         // total recognition time with a narrowed list
+    double narrowed_megapixels; // total image size recognized with a narrowed list
+    double full_ms;             // total recognition time with a full list of more than one language
+    double full_megapixels;     // total image size recognized with a full list
+    double saved_ms;            // estimated time saved, script passes included; 0 until both lists were timed
+} OCRRoutingStats;
 
 /**
- * Text observation structure containing text and native macOS coordinates
- * Coordinates are exactly as returned by Vision Framework without any conversion
- * Uses bottom-left origin coordinate system (native macOS/Quartz)
+ * Batch admission counters accumulated since the process started
  */
 typedef struct {
-    const char* text;     // recognized text
-    double confidence;    // confidence for this text
-    double x;             // x coordinate from Vision Framework (0.0-1.0)
-    double y;             // y coordinate from Vision Framework (0.0-1.0, bottom-left origin)
-    double width;         // width from Vision Framework (0.0-1.0)
-    double height;        // height from Vision Framework (0.0-1.0)
-} TextObservation;
+    size_t batches;             // batches run, with or without max_in_flight_bytes
+    size_t admitted;            // images handed to a worker
+    size_t deferred;            // images set aside because their decoded size did not fit the budget
+    double wait_ms;             // total time batches waited for budget before dispatching
+    size_t peak_in_flight_bytes; // most decoded bytes in flight at once in any batch, estimated under a budget
+} OCRAdmissionStats;
 
 /**
  * OCR result structure with detailed observations
- * Note: All string fields are dynamically allocated and need to be freed using free_ocr_result
+ * Note: All string fields except error are dynamically allocated and need to be freed using free_ocr_result
  */
 typedef struct {
-    const char* error;    // error message, NULL if no error
+    const char* error;    // constant error message, NULL if no error
+    OCRErrorCode error_code; // why recognition failed, OCR_OK if no error
     const char* text;     // recognized text, NULL if an error occurred
     double confidence;    // recognition confidence 0.0-1.0
-    TextObservation* observations;  // array of text observations (native macOS coordinates)
+    TextObservation* observations;  // array of text observations in reading order (native macOS coordinates)
     size_t observation_count;       // number of observations
+    OCRLayout layout;               // lines, paragraphs and columns over the observations
+    OCRSpatialIndex* spatial_index; // R-tree over observation boxes, NULL unless requested in OCROptions
+    OCRTable table;                 // cell grid over the observations, empty unless requested in OCROptions
+    size_t dropped_count;           // observations discarded by min_observation_confidence or min_box_size
+    OCRCascadeStats cascade;        // what was re-recognized, zero unless the level is OCR_RECOGNITION_LEVEL_CASCADE
+    OCRBudgetReport budget;         // plan chosen for latency_budget_ms
+    OCRPyramidStats pyramid;        // what the pyramid detected and recognized, zero unless requested
+    OCRHedgeReport hedge;           // duplicate attempt made for hedge_after_ms
+    OCRFrameDelta frame;            // changes since the previous frame, zero outside frame sessions
+    bool duplicate;                 // batch input skipped as a near-duplicate of another input
+    size_t duplicate_of;            // index of the input whose result was reused, valid if duplicate
+    bool blank;                     // rejected as blank by reject_blank, text is empty
+    int rotation;                   // clockwise degrees (0, 90, 180, 270) auto_rotate turned the image before recognition
+    OCRRoutingReport routing;       // languages chosen by route_languages
+    int attempts;                   // times a batch input was decoded, more than 1 after retries; 0 outside batches
 } OCRResult;
 
+/**
+ * Default OCROptions.duplicate_distance; 0 is a valid distance, so callers set this explicitly
+ */
+#define OCR_DEFAULT_DUPLICATE_DISTANCE 3
+
 /**
  * OCR options structure
  * All fields are optional, and if NULL or 0, the default value will be used
  */
 typedef struct {
     const char* languages;     // recognition languages, e.g. "zh-Hans,en-US", NULL uses default language
-    OCRRecognitionLevel recognition_level;     // recognition level: OCR_RECOGNITION_LEVEL_FAST or OCR_RECOGNITION_LEVEL_ACCURATE
+    OCRRecognitionLevel recognition_level;     // recognition level: OCR_RECOGNITION_LEVEL_FAST, _ACCURATE or _CASCADE
     double min_confidence;     // minimum confidence threshold 0.0-1.0, default is 0.0
+    double min_observation_confidence; // drop observations whose best candidate is below this confidence, default is 0.0
+    double min_box_size;       // drop observations narrower or shorter than this (0.0-1.0), default is 0.0
+    int candidates;            // number of readings to keep per observation (0-10), default is 0
+    double cascade_threshold;  // cascade level: re-recognize fast observations below this confidence, 0 uses 0.5
+    double latency_budget_ms;  // choose level and downsampling to fit this latency, overrides recognition_level, 0 disables
+    double hedge_after_ms;     // start a duplicate attempt if no result arrived after this long, 0 disables
+    bool hedge_fast;           // run the duplicate attempt at OCR_RECOGNITION_LEVEL_FAST, default is false
+    bool spatial_index;        // build a spatial index over the observations, default is false
+    bool detect_table;         // align the observations into a table cell grid, default is false
+    bool skip_duplicates;      // batches and frame sessions reuse the result of a near-duplicate image, default is false
+    int duplicate_distance;    // largest perceptual hash distance (0-64) counted as a duplicate, default is OCR_DEFAULT_DUPLICATE_DISTANCE
+    bool reject_blank;         // return an empty result for blank or near-uniform images without running Vision, default is false
+    double blank_min_stddev;   // reject_blank: luminance standard deviation below which an image is blank, 0 uses 1.0
+    double blank_min_edge_density; // reject_blank: share of edge pixels below which an image is blank, 0 uses 0.0002
+    bool grayscale;            // convert to gray with the native kernels before recognition, default is false
+    bool normalize_contrast;   // stretch gray levels to the full range before recognition, implies grayscale, default is false
+    double preprocess_scale;   // downscale by this factor (0.0-1.0) with area averaging, implies grayscale, 0 or 1 keeps the size
+    bool auto_rotate;          // retry other orientations when the first pass has low confidence, default is false
+    double auto_rotate_threshold; // auto_rotate: mean confidence below which other orientations are tried, 0 uses 0.5
+    bool pyramid;              // detect text on a downscaled copy, recognize only those crops at full resolution, default is false
+    double pyramid_scale;      // pyramid: scale (0.0-1.0) of the detection copy, 0 uses 0.25
+    bool detect_only;          // return text boxes with empty text without recognizing them, default is false
+    bool route_languages;      // read a downscaled copy first and recognize with only the languages of the scripts found, default is false
 } OCROptions;
 
 /**
  * Batch OCR result structure
  */
 typedef struct {
-    const char* error;         // overall error message, NULL if no error
+    const char* error;         // constant overall error message, NULL if no error
+    OCRErrorCode error_code;   // why the batch failed as a whole, OCR_OK if no error
     OCRResult** results;       // OCR results array
     size_t count;             // number of results
-    size_t failed_count;      // number of failed results
+    size_t failed_count;      // number of failed results; each names its cause in error_code, a NULL result could not be allocated
 } OCRBatchResult;
 
 /**
@@ -68,16 +182,91 @@ typedef struct {
     OCROptions ocr_options;    // OCR basic options
     int max_threads;           // maximum number of threads, default is the number of system CPU cores
     int batch_size;           // batch size, default is 1
+    size_t max_in_flight_bytes; // estimated decoded bytes allowed in flight at once, 0 means no limit
+    int max_retries;           // extra decode attempts for an input failing with a transient I/O error, default 0
+    double retry_backoff_ms;   // wait before the first retry, doubled before each next one, 0 uses 50
 } OCRBatchOptions;
 
+/**
+ * Image input given either as a file path or as an encoded buffer
+ */
+typedef struct {
+    const char* path;          // image file path, NULL when buffer is used
+    const void* buffer;        // encoded image data, used when path is NULL
+    size_t length;             // length of buffer
+} OCRInput;
+
+/**
+ * Text search options
+ */
+typedef struct {
+    const char* pattern;       // literal text, or an ICU regular expression when regex is set
+    bool regex;                // treat pattern as a regular expression, default is false
+    bool case_insensitive;     // ignore case when matching, default is false
+    size_t stop_after;         // stop once this many matches are found, 0 means no limit
+} OCRFindOptions;
+
+/**
+ * Text match inside a single observation
+ * Match offsets are in UTF-16 code units, the same as JavaScript string indices
+ */
+typedef struct {
+    size_t input_index;        // index of the image in the inputs array
+    size_t observation_index;  // index of the observation in reading order
+    const char* text;          // full text of the observation
+    size_t match_start;        // offset of the match in text
+    size_t match_length;       // length of the match
+    double confidence;         // confidence of the observation
+    double x;                  // x coordinate of the observation (0.0-1.0)
+    double y;                  // y coordinate of the observation (0.0-1.0, bottom-left origin)
+    double width;              // width of the observation (0.0-1.0)
+    double height;             // height of the observation (0.0-1.0)
+} OCRTextMatch;
+
+/**
+ * Text search result
+ * Note: All string fields except error are dynamically allocated and need to be freed using free_ocr_find_result
+ */
+typedef struct {
+    const char* error;         // constant overall error message, NULL if no error
+    OCRErrorCode error_code;   // why the search failed, OCR_OK if no error
+    OCRTextMatch* matches;     // matches ordered by input, observation and offset
+    size_t match_count;        // number of matches
+    size_t processed_count;    // number of images recognized
+    size_t failed_count;       // number of images that failed to decode or recognize
+    size_t skipped_count;      // number of images not recognized, or cut short, because stop_after was reached
+} OCRFindResult;
+
+/**
+ * Index build result
+ * Note: the result needs to be freed using free_ocr_index_build_result
+ */
+typedef struct {
+    const char* error;         // constant overall error message, NULL if no error
+    OCRErrorCode error_code;   // why the build failed, OCR_OK if no error
+    size_t document_count;     // number of images indexed
+    size_t failed_count;       // number of images that failed to decode or recognize
+    size_t term_count;         // number of distinct terms written
+    size_t posting_count;      // number of postings written
+} OCRIndexBuildResult;
+
+/**
+ * Stateful recognizer for a sequence of frames, such as periodic screen captures
+ * Each frame is diffed against the previous one and only the changed regions are recognized
+ */
+typedef struct OCRFrameSession OCRFrameSession;
+
 /**
  * Create CGImage from buffer data
  * @param buffer pointer to the image data buffer
  * @param length length of the buffer
- * @param error pointer to store error message, NULL if no error
+ * @param error pointer to store the error code, OCR_OK if no error
  * @return CGImageRef if successful, NULL if failed
+ * @note EXIF/TIFF orientation metadata is applied, so the returned image is upright
+ * @note The header is probed first; an image whose decoded pixels would take more than half of
+ *       physical memory fails without being decoded
  */
-CGImageRef CreateCGImageFromBuffer(const void* buffer, size_t length, char** error);
+CGImageRef CreateCGImageFromBuffer(const void* buffer, size_t length, OCRErrorCode* error);
 
 /**
  * Perform OCR recognition
@@ -85,6 +274,18 @@ CGImageRef CreateCGImageFromBuffer(const void* buffer, size_t length, char** err
  * @param options OCR options, can be NULL to use default values
  * @return OCRResult structure pointer, NULL if memory allocation fails
  * @note The returned structure must be freed using free_ocr_result
+ * @note With hedge_after_ms, the first attempt without error wins and the other is cancelled
+ * @note With reject_blank, a blank image returns an empty result with blank set before any recognition
+ * @note grayscale, normalize_contrast and preprocess_scale run on the calling thread before recognition
+ * @note With detect_only, text rectangles are detected without recognition; observations and layout are
+ *       filled in, texts are empty, and the level, cascade, budget and pyramid settings do not apply
+ * @note With pyramid, text is detected in fast mode on a downscaled copy and the crops around it are
+ *       recognized in parallel at full resolution; latency_budget_ms takes precedence
+ * @note With auto_rotate, a low-confidence result triggers parallel attempts in the other three orientations
+ *       on a downscaled copy; if one reads better, the full image is recognized turned that way and the
+ *       observations are relative to the turned image
+ * @note With route_languages and more than one language, a downscaled copy is read accurately first and
+ *       the image is recognized with only the languages whose script was found; ignored at the fast level
  * 
  * Supported image formats:
  * - JPEG (.jpg, .jpeg)
@@ -94,6 +295,83 @@ CGImageRef CreateCGImageFromBuffer(const void* buffer, size_t length, char** err
  */
 OCRResult* perform_ocr(CGImageRef image, const OCROptions* options);
 
+/**
+ * Recognize one image under several option sets concurrently
+ * @param image CoreGraphics image, shared read-only by every recognition
+ * @param option_sets options of each recognition
+ * @param count number of option sets
+ * @return batch result with one result per option set in order, NULL if memory allocation fails
+ * @note The returned structure must be freed using free_ocr_batch_result
+ */
+OCRBatchResult* perform_ocr_option_sets(CGImageRef image, const OCROptions* option_sets, size_t count);
+
+/**
+ * Read the hedging counters accumulated since the process started
+ * @param stats pointer to receive the counters
+ */
+void get_ocr_hedge_stats(OCRHedgeStats* stats);
+
+/**
+ * Read the blank page counters accumulated since the process started
+ * @param stats pointer to receive the counters
+ */
+void get_ocr_blank_stats(OCRBlankStats* stats);
+
+/**
+ * Read the language routing counters accumulated since the process started
+ * @param stats pointer to receive the counters
+ */
+void get_ocr_routing_stats(OCRRoutingStats* stats);
+
+/**
+ * Read the batch admission counters accumulated since the process started
+ * @param stats pointer to receive the counters
+ */
+void get_ocr_admission_stats(OCRAdmissionStats* stats);
+
+/**
+ * Read the counters of the pixel buffer pool shared by decode and preprocessing
+ * @param stats pointer to receive the counters
+ */
+void get_ocr_pixel_pool_stats(OCRPixelPoolStats* stats);
+
+/**
+ * Create a frame session
+ * @param options OCR options applied to every frame, can be NULL to use default values;
+ *        latency_budget_ms and hedge_after_ms are ignored, the cascade level reads regions accurately,
+ *        and detect_only finds boxes in the changed regions without reading them. Blank rejection,
+ *        preprocessing, pyramid, auto-rotation and language routing work on whole images and are
+ *        not applied to frames
+ * @param tile_size side of the tiles compared between frames in pixels, 0 uses 64
+ * @return session pointer, NULL if memory allocation fails
+ * @note The returned session must be freed using free_ocr_frame_session
+ */
+OCRFrameSession* create_ocr_frame_session(const OCROptions* options, size_t tile_size);
+
+/**
+ * Recognize the next frame of a session
+ * Unchanged observations are carried forward from the previous frame and the changed
+ * regions are recognized again; result->frame describes what changed
+ * @param session frame session
+ * @param frame CoreGraphics Image Reference
+ * @return OCRResult structure pointer for the whole frame, NULL if memory allocation fails
+ * @note Frames of one session are processed one at a time; after an error the next frame is recognized in full
+ * @note The returned structure must be freed using free_ocr_result
+ */
+OCRResult* perform_frame_ocr(OCRFrameSession* session, CGImageRef frame);
+
+/**
+ * Forget the previous frame, so the next one is recognized in full
+ * @param session frame session
+ */
+void reset_ocr_frame_session(OCRFrameSession* session);
+
+/**
+ * Free a frame session
+ * @param session session to be freed, can be NULL; no frame may be in progress
+ */
+void free_ocr_frame_session(OCRFrameSession* session);
+
 /**
  * Perform batch OCR recognition
  * @param image_paths image file path array
@@ -115,6 +393,31 @@ OCRBatchResult* perform_batch_ocr(const char** image_paths, size_t count, const
  */
 OCRBatchResult* perform_batch_ocr_from_buffers(const void** buffers, const size_t* lengths, size_t count, const OCRBatchOptions* options);
 
+/**
+ * Search for text across images, matching each result as soon as it is produced
+ * @param inputs image inputs
+ * @param count number of inputs
+ * @param options batch processing options, can be NULL to use default values
+ * @param find search options, pattern is required
+ * @return OCRFindResult structure pointer, NULL if memory allocation fails
+ * @note Once stop_after matches are found, queued images are skipped without being decoded
+ * @note The returned structure must be freed using free_ocr_find_result
+ */
+OCRFindResult* perform_batch_find_text(const OCRInput* inputs, size_t count, const OCRBatchOptions* options, const OCRFindOptions* find);
+
+/**
+ * Recognize images and write an inverted index of their text
+ * Each worker tokenizes its result right after recognition, so indexing overlaps
+ * with the recognition of the remaining images
+ * @param inputs image inputs, their positions are the image indices stored in the index
+ * @param count number of inputs
+ * @param options batch processing options, can be NULL to use default values
+ * @param index_path output index file path
+ * @return OCRIndexBuildResult structure pointer, NULL if memory allocation fails
+ * @note The returned structure must be freed using free_ocr_index_build_result
+ */
+OCRIndexBuildResult* perform_batch_index(const OCRInput* inputs, size_t count, const OCRBatchOptions* options, const char* index_path);
+
 /**
  * Free OCR result
  * @param result pointer to the OCR result to be freed, can be NULL
@@ -128,6 +431,18 @@ void free_ocr_result(OCRResult* result);
  */
 void free_ocr_batch_result(OCRBatchResult* result);
 
+/**
+ * Free text search result
+ * @param result pointer to the search result to be freed, can be NULL
+ */
+void free_ocr_find_result(OCRFindResult* result);
+
+/**
+ * Free index build result
+ * @param result pointer to the index build result to be freed, can be NULL
+ */
+void free_ocr_index_build_result(OCRIndexBuildResult* result);
+
 #ifdef __cplusplus
 }
 #endif
@@ -2,7 +2,16 @@
 #import <Vision/Vision.h>
 #import <AppKit/AppKit.h>
 #import "ocr.h"
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <sys/stat.h>
+#include <unordered_map>
+#include <vector>
 
 
 static const OCROptions DEFAULT_OPTIONS = {
@@ -11,6 +20,21 @@ static const OCROptions DEFAULT_OPTIONS = {
     .min_confidence = 0.0
 };
 
+static const double DEFAULT_CASCADE_THRESHOLD = 0.5;
+static const double DEFAULT_BLANK_MIN_STDDEV = 1.0;
+static const double DEFAULT_BLANK_MIN_EDGE_DENSITY = 0.0002;
+static const double CONTRAST_CLIP = 0.005;
+static const double DEFAULT_AUTO_ROTATE_THRESHOLD = 0.5;
+static const double AUTO_ROTATE_MAX_SIDE = 1024.0;
+static const double DEFAULT_PYRAMID_SCALE = 0.25;
+static const double ROUTE_PROBE_MAX_SIDE = 768.0;
+static const double ROUTE_MIN_SCRIPT_SHARE = 0.05;
+static const double MAX_DECODE_MEMORY_SHARE = 0.5;
+static const size_t UNPROBED_DECODE_RATIO = 10;
+static const double PIXEL_POOL_MEMORY_SHARE = 0.125;
+static const double DEFAULT_RETRY_BACKOFF_MS = 50.0;
+static const double MAX_RETRY_BACKOFF_MS = 2000.0;
+
 static const OCRBatchOptions DEFAULT_BATCH_OPTIONS = {
     .ocr_options = {
         .languages = "en-US",
@@ -21,60 +45,296 @@ static const OCRBatchOptions DEFAULT_BATCH_OPTIONS = {
     .batch_size = 1
 };
 
-static BOOL isValidImageExtension(NSString* extension) {
-    static NSSet* validExtensions = nil;
+// Results point at the constant message of their code, so a failure never allocates
+template <typename Result>
+static void SetError(Result* result, OCRErrorCode code) {
+    result->error_code = code;
+    result->error = ocr_error_message(code);
+}
+
+// Latency model shared by every recognition in the process
+static OCRCostModel* SharedCostModel(void) {
+    static OCRCostModel* model = NULL;
     static dispatch_once_t onceToken;
     dispatch_once(&onceToken, ^{
-        validExtensions = [NSSet setWithArray:@[@"jpg", @"jpeg", @"png", @"tiff", @"gif"]];
+        model = ocr_cost_model_create();
     });
-    return [validExtensions containsObject:extension.lowercaseString];
+    return model;
 }
 
-static int getSystemThreadCount(void) {
-    return (int)[[NSProcessInfo processInfo] processorCount];
+// Pixel buffers shared by decode and preprocessing. Released buffers are kept for reuse up
+// to a share of physical memory; a memory pressure warning halves the cache and critical
+// pressure empties it
+static OCRPixelPool* SharedPixelPool(void) {
+    static OCRPixelPool* pool = NULL;
+    static dispatch_source_t pressureSource = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        pool = ocr_pixel_pool_create((size_t)([[NSProcessInfo processInfo] physicalMemory] * PIXEL_POOL_MEMORY_SHARE));
+        pressureSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_MEMORYPRESSURE, 0,
+                                                DISPATCH_MEMORYPRESSURE_WARN | DISPATCH_MEMORYPRESSURE_CRITICAL,
+                                                dispatch_get_global_queue(QOS_CLASS_UTILITY, 0));
+        dispatch_source_set_event_handler(pressureSource, ^{
+            OCRPixelPoolStats stats;
+            ocr_pixel_pool_stats(pool, &stats);
+            bool critical = dispatch_source_get_data(pressureSource) & DISPATCH_MEMORYPRESSURE_CRITICAL;
+            ocr_pixel_pool_trim(pool, critical ? 0 : stats.cached_bytes / 2);
+        });
+        dispatch_resume(pressureSource);
+    });
+    return pool;
 }
 
-CGImageRef CreateCGImageFromPath(const char* path, char** error) {
-    if (!path || !error) {
-        if (error) *error = strdup("Invalid parameters");
+// Scratch pixels taken from the shared pool for the length of a scope
+struct PooledPixels {
+    uint8_t* data;
+
+    explicit PooledPixels(size_t bytes)
+        : data(bytes > 0 ? static_cast<uint8_t*>(ocr_pixel_pool_acquire(SharedPixelPool(), bytes)) : NULL) {}
+    ~PooledPixels() { ocr_pixel_pool_release(SharedPixelPool(), data); }
+    PooledPixels(const PooledPixels&) = delete;
+    PooledPixels& operator=(const PooledPixels&) = delete;
+};
+
+static void ReleasePooledPixels(void* info, const void* data, size_t size) {
+    ocr_pixel_pool_release(SharedPixelPool(), (void*)data);
+}
+
+// Wrap pooled pixels in an image that gives them back to the pool once it is released.
+// The image takes the pixels even when it cannot be created
+static CGImageRef CreateImageFromPooledPixels(void* pixels, size_t width, size_t height, size_t bytesPerRow, bool gray) {
+    CGDataProviderRef provider = CGDataProviderCreateWithData(NULL, pixels, bytesPerRow * height, ReleasePooledPixels);
+    if (!provider) {
+        ocr_pixel_pool_release(SharedPixelPool(), pixels);
         return NULL;
     }
-    
-    @autoreleasepool {
-        NSString* imagePath = [NSString stringWithUTF8String:path];
-        if (!imagePath) {
-            *error = strdup("Failed to create NSString from path");
-            return NULL;
+    CGColorSpaceRef colorSpace = gray ? CGColorSpaceCreateDeviceGray() : CGColorSpaceCreateDeviceRGB();
+    CGImageRef image = CGImageCreate(width, height, 8, gray ? 8 : 32, bytesPerRow, colorSpace,
+                                     gray ? kCGImageAlphaNone : kCGImageAlphaPremultipliedLast,
+                                     provider, NULL, false, kCGRenderingIntentDefault);
+    CGColorSpaceRelease(colorSpace);
+    CGDataProviderRelease(provider);
+    return image;
+}
+
+// Draw into a pooled bitmap, RGBA or 8-bit gray. RGBA starts transparent and gray starts
+// white, as if CoreGraphics had allocated the bitmap and the transparent areas were paper
+static CGImageRef CreatePooledImage(size_t width, size_t height, bool gray, void (^draw)(CGContextRef context)) {
+    size_t pixelBytes = gray ? 1 : 4;
+    if (width == 0 || height == 0 || width > SIZE_MAX / pixelBytes / height) {
+        return NULL;
+    }
+    size_t bytesPerRow = width * pixelBytes;
+    void* pixels = ocr_pixel_pool_acquire(SharedPixelPool(), bytesPerRow * height);
+    if (!pixels) {
+        return NULL;
+    }
+    CGColorSpaceRef colorSpace = gray ? CGColorSpaceCreateDeviceGray() : CGColorSpaceCreateDeviceRGB();
+    CGContextRef context = CGBitmapContextCreate(pixels, width, height, 8, bytesPerRow, colorSpace,
+                                                 gray ? kCGImageAlphaNone : kCGImageAlphaPremultipliedLast);
+    CGColorSpaceRelease(colorSpace);
+    if (!context) {
+        ocr_pixel_pool_release(SharedPixelPool(), pixels);
+        return NULL;
+    }
+    if (gray) {
+        CGContextSetGrayFillColor(context, 1.0, 1.0);
+        CGContextFillRect(context, CGRectMake(0, 0, width, height));
+    } else {
+        CGContextClearRect(context, CGRectMake(0, 0, width, height));
+    }
+    draw(context);
+    CGContextRelease(context);
+    return CreateImageFromPooledPixels(pixels, width, height, bytesPerRow, gray);
+}
+
+static CGImageRef CreateScaledImage(CGImageRef image, double scale) {
+    size_t width = std::max((size_t)1, (size_t)llround(CGImageGetWidth(image) * scale));
+    size_t height = std::max((size_t)1, (size_t)llround(CGImageGetHeight(image) * scale));
+    return CreatePooledImage(width, height, false, ^(CGContextRef context) {
+        CGContextSetInterpolationQuality(context, kCGInterpolationMedium);
+        CGContextDrawImage(context, CGRectMake(0, 0, width, height), image);
+    });
+}
+
+// Lets one thread cancel a recognition running on another. Vision checks the
+// request between stages, so a cancelled attempt gives its CPU back quickly. An
+// attempt may run several requests at once, as pyramid crops do, so every request
+// in flight is tracked and cancelled
+struct AttemptCancellation {
+    std::mutex mutex;
+    bool cancelled = false;
+    std::vector<VNRequest*> requests;
+    AttemptCancellation* parent = NULL;     // also sees these requests until Detach, so cancelling it stops them
+
+    bool Begin(VNRequest* current) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (cancelled || (parent && !parent->Begin(current))) {
+            return false;
         }
-        
-        if (![[NSFileManager defaultManager] fileExistsAtPath:imagePath]) {
-            *error = strdup("File does not exist");
-            return NULL;
+        requests.push_back(current);
+        return true;
+    }
+
+    void End(VNRequest* current) {
+        std::lock_guard<std::mutex> lock(mutex);
+        requests.erase(std::remove(requests.begin(), requests.end(), current), requests.end());
+        if (parent) {
+            parent->End(current);
         }
+    }
 
-        NSString* extension = [imagePath pathExtension].lowercaseString;
-        if (!isValidImageExtension(extension)) {
-            *error = strdup("Invalid image file extension");
-            return NULL;
+    // Called before the parent may go away; requests still running stay cancellable here only
+    void Detach() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (parent) {
+            for (VNRequest* request : requests) {
+                parent->End(request);
+            }
+            parent = NULL;
+        }
+    }
+
+    void Cancel() {
+        std::lock_guard<std::mutex> lock(mutex);
+        cancelled = true;
+        for (VNRequest* request : requests) {
+            [request cancel];
         }
+    }
+};
+
+static std::atomic<size_t> g_hedge_calls(0);
+static std::atomic<size_t> g_hedge_launched(0);
+static std::atomic<size_t> g_hedge_wins(0);
+
+static std::atomic<size_t> g_blank_checked(0);
+static std::atomic<size_t> g_blank_rejected(0);
+
+static std::atomic<size_t> g_route_routed(0);
+static std::atomic<size_t> g_route_narrowed(0);
+static std::atomic<size_t> g_route_probe_us(0);
+static std::atomic<size_t> g_route_narrowed_us(0);
+static std::atomic<size_t> g_route_narrowed_kilopixels(0);
+static std::atomic<size_t> g_route_full_us(0);
+static std::atomic<size_t> g_route_full_kilopixels(0);
+
+static std::atomic<size_t> g_admission_batches(0);
+static std::atomic<size_t> g_admission_admitted(0);
+static std::atomic<size_t> g_admission_deferred(0);
+static std::atomic<size_t> g_admission_wait_us(0);
+static std::atomic<size_t> g_admission_peak_bytes(0);
+
+static int getSystemThreadCount(void) {
+    return (int)[[NSProcessInfo processInfo] processorCount];
+}
+
+// Headers that claim more pixels than the machine can hold are refused before decode,
+// where ImageIO would otherwise allocate until the process is killed. Formats the
+// probe does not know are left to ImageIO
+static bool AdmitDecode(const OCRImageInfo* info, bool probed, OCRErrorCode* error) {
+    static size_t max_bytes = 0;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        max_bytes = (size_t)([[NSProcessInfo processInfo] physicalMemory] * MAX_DECODE_MEMORY_SHARE);
+    });
+    if (probed && ocr_image_decoded_bytes(info) > max_bytes) {
+        *error = OCR_ERROR_IMAGE_TOO_LARGE;
+        return false;
+    }
+    return true;
+}
+
+// Decode by drawing a lazily read, uncached image once into pooled pixels, so decoded
+// images reuse the buffers of earlier ones. Opaque gray images stay one byte per pixel
+static CGImageRef CreatePooledDecode(CGImageSourceRef imageSource) {
+    NSDictionary* lazyOptions = @{(__bridge NSString*)kCGImageSourceShouldCache: @NO};
+    CGImageRef lazy = CGImageSourceCreateImageAtIndex(imageSource, 0, (__bridge CFDictionaryRef)lazyOptions);
+    if (!lazy) {
+        return NULL;
+    }
+    size_t width = CGImageGetWidth(lazy);
+    size_t height = CGImageGetHeight(lazy);
+    CGImageAlphaInfo alpha = CGImageGetAlphaInfo(lazy);
+    bool gray = CGColorSpaceGetModel(CGImageGetColorSpace(lazy)) == kCGColorSpaceModelMonochrome &&
+        (alpha == kCGImageAlphaNone || alpha == kCGImageAlphaNoneSkipFirst || alpha == kCGImageAlphaNoneSkipLast);
+    CGImageRef decoded = CreatePooledImage(width, height, gray, ^(CGContextRef context) {
+        CGContextDrawImage(context, CGRectMake(0, 0, width, height), lazy);
+    });
+    CGImageRelease(lazy);
+    return decoded;
+}
+
+// CGImage carries no orientation, so EXIF/TIFF orientation is applied to the pixels
+// once at decode and every later stage sees the image upright. Pixels are decoded
+// here rather than on first draw, so recognitions sharing the image never decode twice
+static CGImageRef CreateUprightImage(CGImageSourceRef imageSource) {
+    NSDictionary* decodeOptions = @{(__bridge NSString*)kCGImageSourceShouldCacheImmediately: @YES};
+    NSDictionary* properties = (__bridge_transfer NSDictionary*)CGImageSourceCopyPropertiesAtIndex(imageSource, 0, NULL);
+    NSNumber* orientation = properties[(__bridge NSString*)kCGImagePropertyOrientation];
+    if (!orientation || orientation.intValue <= kCGImagePropertyOrientationUp ||
+        orientation.intValue > kCGImagePropertyOrientationLeft) {
+        CGImageRef pooled = CreatePooledDecode(imageSource);
+        return pooled ? pooled : CGImageSourceCreateImageAtIndex(imageSource, 0, (__bridge CFDictionaryRef)decodeOptions);
+    }
+    
+    NSMutableDictionary* options = [@{
+        (__bridge NSString*)kCGImageSourceCreateThumbnailFromImageAlways: @YES,
+        (__bridge NSString*)kCGImageSourceCreateThumbnailWithTransform: @YES,
+        (__bridge NSString*)kCGImageSourceShouldCacheImmediately: @YES
+    } mutableCopy];
+    // Without a size limit the thumbnail would be capped; keep every pixel
+    NSNumber* width = properties[(__bridge NSString*)kCGImagePropertyPixelWidth];
+    NSNumber* height = properties[(__bridge NSString*)kCGImagePropertyPixelHeight];
+    if (width && height) {
+        options[(__bridge NSString*)kCGImageSourceThumbnailMaxPixelSize] = @(std::max(width.unsignedLongValue, height.unsignedLongValue));
+    }
+    CGImageRef upright = CGImageSourceCreateThumbnailAtIndex(imageSource, 0, (__bridge CFDictionaryRef)options);
+    return upright ? upright : CGImageSourceCreateImageAtIndex(imageSource, 0, (__bridge CFDictionaryRef)decodeOptions);
+}
+
+CGImageRef CreateCGImageFromPath(const char* path, OCRErrorCode* error) {
+    if (!path || !error) {
+        if (error) *error = OCR_ERROR_INVALID_ARGUMENT;
+        return NULL;
+    }
+    *error = OCR_OK;
+    
+    // The format comes from the file's signature, not its name, and the file is opened and
+    // read once: a missing file, a foreign format and the bytes to decode all come from that read
+    void* contents = NULL;
+    size_t length = 0;
+    OCRErrorCode readError = ocr_image_read_file(path, &contents, &length, NULL);
+    if (readError != OCR_OK) {
+        *error = readError;
+        return NULL;
+    }
 
-        NSData* imageData = [NSData dataWithContentsOfFile:imagePath];
+    OCRImageInfo info;
+    if (!AdmitDecode(&info, ocr_image_probe(contents, length, &info), error)) {
+        free(contents);
+        return NULL;
+    }
+    
+    @autoreleasepool {
+        NSData* imageData = [NSData dataWithBytesNoCopy:contents length:length freeWhenDone:YES];
         if (!imageData) {
-            *error = strdup("Failed to read image data");
+            free(contents);
+            *error = OCR_ERROR_OUT_OF_MEMORY;
             return NULL;
         }
 
         CGImageSourceRef imageSource = CGImageSourceCreateWithData((__bridge CFDataRef)imageData, NULL);
         if (!imageSource) {
-            *error = strdup("Failed to create image source");
+            *error = OCR_ERROR_DECODE_FAILED;
             return NULL;
         }
         
-        CGImageRef cgImage = CGImageSourceCreateImageAtIndex(imageSource, 0, NULL);
+        CGImageRef cgImage = CreateUprightImage(imageSource);
         CFRelease(imageSource);
         
         if (!cgImage) {
-            *error = strdup("Failed to create CGImage from source");
+            *error = OCR_ERROR_DECODE_FAILED;
             return NULL;
         }
         
@@ -82,30 +342,36 @@ CGImageRef CreateCGImageFromPath(const char* path, char** error) {
     }
 }
 
-CGImageRef CreateCGImageFromBuffer(const void* buffer, size_t length, char** error) {
+CGImageRef CreateCGImageFromBuffer(const void* buffer, size_t length, OCRErrorCode* error) {
     if (!buffer || length == 0 || !error) {
-        if (error) *error = strdup("Invalid parameters");
+        if (error) *error = OCR_ERROR_INVALID_ARGUMENT;
+        return NULL;
+    }
+    *error = OCR_OK;
+    
+    OCRImageInfo info;
+    if (!AdmitDecode(&info, ocr_image_probe(buffer, length, &info), error)) {
         return NULL;
     }
     
     @autoreleasepool {
         NSData* imageData = [NSData dataWithBytes:buffer length:length];
         if (!imageData) {
-            *error = strdup("Failed to create NSData from buffer");
+            *error = OCR_ERROR_OUT_OF_MEMORY;
             return NULL;
         }
 
         CGImageSourceRef imageSource = CGImageSourceCreateWithData((__bridge CFDataRef)imageData, NULL);
         if (!imageSource) {
-            *error = strdup("Failed to create image source from buffer");
+            *error = OCR_ERROR_DECODE_FAILED;
             return NULL;
         }
         
-        CGImageRef cgImage = CGImageSourceCreateImageAtIndex(imageSource, 0, NULL);
+        CGImageRef cgImage = CreateUprightImage(imageSource);
         CFRelease(imageSource);
         
         if (!cgImage) {
-            *error = strdup("Failed to create CGImage from buffer source");
+            *error = OCR_ERROR_DECODE_FAILED;
             return NULL;
         }
         
@@ -113,30 +379,27 @@ CGImageRef CreateCGImageFromBuffer(const void* buffer, size_t length, char** err
     }
 }
 
-OCRResult* perform_ocr(CGImageRef image, const OCROptions* options) {
+static CGImageRef CreateCGImageFromInput(const OCRInput* input, OCRErrorCode* error) {
+    if (input && input->path) {
+        return CreateCGImageFromPath(input->path, error);
+    }
+    return CreateCGImageFromBuffer(input ? input->buffer : NULL, input ? input->length : 0, error);
+}
+
+// Run one Vision request over a region of the image; observations are returned
+// in whole-image coordinates, ROI-relative boxes are mapped back here
+static bool RecognizeRegion(CGImageRef image, const OCROptions* opts, OCRRecognitionLevel level, CGRect region,
+                            AttemptCancellation* cancellation, TextObservation** out_observations, size_t* out_count,
+                            size_t* out_dropped, OCRErrorCode* out_error) {
     @autoreleasepool {
-        OCRResult* result = (OCRResult*)malloc(sizeof(OCRResult));
-        if (!result) {
-            return NULL;
-        }
-        result->error = NULL;
-        result->text = NULL;
-        result->confidence = 0.0;
-        result->observations = NULL;
-        result->observation_count = 0;
-        
-        const OCROptions* opts = options ? options : &DEFAULT_OPTIONS;
-        
-        if (!image) {
-            result->error = strdup("CGImage is required and cannot be NULL");
-            return result;
-        }
+        *out_observations = NULL;
+        *out_count = 0;
         
-        __block NSMutableString* recognizedText = [NSMutableString string];
         __block NSMutableArray* textObservations = [NSMutableArray array];
-        __block double totalConfidence = 0.0;
-        __block int observationCount = 0;
+        __block size_t droppedCount = 0;
         __block NSLock* resultLock = [[NSLock alloc] init];
+        // Vision returns at most 10 candidates; 5 are enough to apply min_confidence
+        NSUInteger candidateLimit = (NSUInteger)std::min(std::max(opts->candidates, 5), 10);
         
         VNRecognizeTextRequest* request = [[VNRecognizeTextRequest alloc] 
             initWithCompletionHandler:^(VNRequest* request, NSError* error) {
@@ -147,7 +410,18 @@ OCRResult* perform_ocr(CGImageRef image, const OCROptions* options) {
                 NSArray<VNRecognizedTextObservation*>* observations = request.results;
                 [resultLock lock];
                 for (VNRecognizedTextObservation* observation in observations) {
-                    NSArray<VNRecognizedText*>* candidates = [observation topCandidates:5];
+                    // Filters run before any candidate string is copied or boxed
+                    CGRect roiBox = observation.boundingBox;
+                    CGRect boundingBox = CGRectMake(region.origin.x + roiBox.origin.x * region.size.width,
+                                                    region.origin.y + roiBox.origin.y * region.size.height,
+                                                    roiBox.size.width * region.size.width,
+                                                    roiBox.size.height * region.size.height);
+                    if (boundingBox.size.width < opts->min_box_size || boundingBox.size.height < opts->min_box_size) {
+                        droppedCount++;
+                        continue;
+                    }
+                    
+                    NSArray<VNRecognizedText*>* candidates = [observation topCandidates:candidateLimit];
                     
                     VNRecognizedText* bestCandidate = nil;
                     for (VNRecognizedText* candidate in candidates) {
@@ -157,40 +431,35 @@ OCRResult* perform_ocr(CGImageRef image, const OCROptions* options) {
                         }
                     }
                     
-                    if (bestCandidate) {
-                        NSString* text = bestCandidate.string;
-                        if (text.length > 0) {
-                            // Store observation data (native macOS coordinates, no conversion)
-                            CGRect boundingBox = observation.boundingBox;
-                            NSDictionary* obsData = @{
-                                @"text": text,
-                                @"confidence": @(bestCandidate.confidence),
-                                @"x": @(boundingBox.origin.x),
-                                @"y": @(boundingBox.origin.y),
-                                @"width": @(boundingBox.size.width),
-                                @"height": @(boundingBox.size.height)
-                            };
-                            [textObservations addObject:obsData];
-                            
-                            if (recognizedText.length > 0) {
-                                if (boundingBox.origin.y < 0.1) {
-                                    [recognizedText appendString:@"\n"];
-                                } else {
-                                    [recognizedText appendString:@" "];
-                                }
-                            }
-                            [recognizedText appendString:text];
+                    if (bestCandidate && bestCandidate.confidence < opts->min_observation_confidence) {
+                        droppedCount++;
+                        continue;
+                    }
+                    
+                    if (bestCandidate && bestCandidate.string.length > 0) {
+                        // Store observation data (native macOS coordinates, no conversion)
+                        NSMutableDictionary* obsData = [@{
+                            @"text": bestCandidate.string,
+                            @"confidence": @(bestCandidate.confidence),
+                            @"x": @(boundingBox.origin.x),
+                            @"y": @(boundingBox.origin.y),
+                            @"width": @(boundingBox.size.width),
+                            @"height": @(boundingBox.size.height)
+                        } mutableCopy];
+                        if (opts->candidates > 0) {
+                            NSUInteger keep = std::min((NSUInteger)opts->candidates, candidates.count);
+                            obsData[@"candidates"] = [candidates subarrayWithRange:NSMakeRange(0, keep)];
                         }
-                        totalConfidence += bestCandidate.confidence;
-                        observationCount++;
+                        [textObservations addObject:obsData];
                     }
                 }
                 [resultLock unlock];
             }];
         
-        request.recognitionLevel = opts->recognition_level == OCR_RECOGNITION_LEVEL_FAST ? 
+        request.recognitionLevel = level == OCR_RECOGNITION_LEVEL_FAST ? 
             VNRequestTextRecognitionLevelFast : 
             VNRequestTextRecognitionLevelAccurate;
+        request.regionOfInterest = region;
         
         if (opts->languages) {
             NSString* langs = [NSString stringWithUTF8String:opts->languages];
@@ -220,205 +489,1405 @@ OCRResult* perform_ocr(CGImageRef image, const OCROptions* options) {
                                         orientation:kCGImagePropertyOrientationUp
                                         options:options];
         
-        if (![handler performRequests:@[request] error:&error]) {
-            const char* errorStr = error.localizedDescription.UTF8String;
-            result->error = errorStr ? strdup(errorStr) : strdup("Unknown error occurred during OCR");
-            return result;
+        if (cancellation && !cancellation->Begin(request)) {
+            *out_error = OCR_ERROR_CANCELLED;
+            return false;
+        }
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        BOOL performed = [handler performRequests:@[request] error:&error];
+        if (cancellation) {
+            cancellation->End(request);
         }
+        if (!performed) {
+            *out_error = OCR_ERROR_RECOGNITION_FAILED;
+            return false;
+        }
+        double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        double pixels = (double)CGImageGetWidth(image) * CGImageGetHeight(image) * region.size.width * region.size.height;
+        ocr_cost_model_record(SharedCostModel(), level, pixels, elapsed);
         
-        if (observationCount > 0) {
-            const char* textStr = [recognizedText UTF8String];
-            if (textStr) {
-                result->text = strdup(textStr);
-                if (!result->text) {
-                    result->error = strdup("Memory allocation failed for OCR text");
-                    return result;
-                }
-            } else {
-                result->text = strdup("");
+        *out_dropped = droppedCount;
+        
+        size_t count = textObservations.count;
+        if (count == 0) {
+            return true;
+        }
+        
+        // Allocate and populate observations array (native macOS coordinates)
+        TextObservation* observations = (TextObservation*)calloc(count, sizeof(TextObservation));
+        if (!observations) {
+            *out_error = OCR_ERROR_OUT_OF_MEMORY;
+            return false;
+        }
+        for (size_t i = 0; i < count; i++) {
+            NSDictionary* obsData = textObservations[i];
+            TextObservation* obs = &observations[i];
+            
+            NSString* text = obsData[@"text"];
+            obs->text = strdup([text UTF8String]);
+            obs->confidence = [obsData[@"confidence"] doubleValue];
+            obs->x = [obsData[@"x"] doubleValue];
+            obs->y = [obsData[@"y"] doubleValue];
+            obs->width = [obsData[@"width"] doubleValue];
+            obs->height = [obsData[@"height"] doubleValue];
+            if (!obs->text) {
+                ocr_observations_free(observations, count);
+                *out_error = OCR_ERROR_OUT_OF_MEMORY;
+                return false;
             }
-            result->confidence = totalConfidence / observationCount;
             
-            // Allocate and populate observations array (native macOS coordinates)
-            result->observation_count = textObservations.count;
-            if (result->observation_count > 0) {
-                result->observations = (TextObservation*)malloc(sizeof(TextObservation) * result->observation_count);
-                if (result->observations) {
-                    for (size_t i = 0; i < result->observation_count; i++) {
-                        NSDictionary* obsData = textObservations[i];
-                        TextObservation* obs = &result->observations[i];
-                        
-                        NSString* text = obsData[@"text"];
-                        obs->text = strdup([text UTF8String]);
-                        obs->confidence = [obsData[@"confidence"] doubleValue];
-                        obs->x = [obsData[@"x"] doubleValue];
-                        obs->y = [obsData[@"y"] doubleValue];
-                        obs->width = [obsData[@"width"] doubleValue];
-                        obs->height = [obsData[@"height"] doubleValue];
+            NSArray<VNRecognizedText*>* alternatives = obsData[@"candidates"];
+            if (alternatives.count > 0) {
+                obs->candidates = (TextCandidate*)calloc(alternatives.count, sizeof(TextCandidate));
+                if (!obs->candidates) {
+                    ocr_observations_free(observations, count);
+                    *out_error = OCR_ERROR_OUT_OF_MEMORY;
+                    return false;
+                }
+                obs->candidate_count = alternatives.count;
+                for (NSUInteger c = 0; c < alternatives.count; c++) {
+                    obs->candidates[c].text = strdup(alternatives[c].string.UTF8String);
+                    obs->candidates[c].confidence = alternatives[c].confidence;
+                    if (!obs->candidates[c].text) {
+                        ocr_observations_free(observations, count);
+                        *out_error = OCR_ERROR_OUT_OF_MEMORY;
+                        return false;
                     }
                 }
             }
-        } else {
-            result->text = strdup("");
-            if (!result->text) {
-                result->error = strdup("Memory allocation failed for empty text");
-                return result;
-            }
-            result->confidence = 0.0;
         }
         
-        return result;
+        *out_observations = observations;
+        *out_count = count;
+        return true;
     }
 }
 
-void free_ocr_result(OCRResult* result) {
-    if (!result) return;
-    
-    if (result->error) {
-        free((void*)result->error);
-        result->error = NULL;
+// Find where text is without reading it. Text rectangle detection skips the
+// recognition network, so observations have empty text and no candidates
+static bool DetectTextBoxes(CGImageRef image, const OCROptions* opts, CGRect region,
+                            AttemptCancellation* cancellation, TextObservation** out_observations,
+                            size_t* out_count, size_t* out_dropped, OCRErrorCode* out_error) {
+    @autoreleasepool {
+        *out_observations = NULL;
+        *out_count = 0;
+        *out_dropped = 0;
+        
+        VNDetectTextRectanglesRequest* request = [[VNDetectTextRectanglesRequest alloc] init];
+        request.reportCharacterBoxes = NO;
+        request.regionOfInterest = region;
+        if (@available(macOS 13.0, *)) {
+            request.preferBackgroundProcessing = YES;
+        }
+        VNImageRequestHandler* handler = [[VNImageRequestHandler alloc]
+                                        initWithCGImage:image
+                                        orientation:kCGImagePropertyOrientationUp
+                                        options:@{}];
+        
+        if (cancellation && !cancellation->Begin(request)) {
+            *out_error = OCR_ERROR_CANCELLED;
+            return false;
+        }
+        NSError* error = nil;
+        BOOL performed = [handler performRequests:@[request] error:&error];
+        if (cancellation) {
+            cancellation->End(request);
+        }
+        if (!performed) {
+            *out_error = OCR_ERROR_RECOGNITION_FAILED;
+            return false;
+        }
+        
+        NSArray<VNTextObservation*>* boxes = request.results;
+        if (boxes.count == 0) {
+            return true;
+        }
+        TextObservation* observations = (TextObservation*)calloc(boxes.count, sizeof(TextObservation));
+        if (!observations) {
+            *out_error = OCR_ERROR_OUT_OF_MEMORY;
+            return false;
+        }
+        size_t count = 0;
+        for (VNTextObservation* box in boxes) {
+            CGRect roiBox = box.boundingBox;
+            CGRect boundingBox = CGRectMake(region.origin.x + roiBox.origin.x * region.size.width,
+                                            region.origin.y + roiBox.origin.y * region.size.height,
+                                            roiBox.size.width * region.size.width,
+                                            roiBox.size.height * region.size.height);
+            if (boundingBox.size.width < opts->min_box_size || boundingBox.size.height < opts->min_box_size ||
+                box.confidence < opts->min_observation_confidence) {
+                (*out_dropped)++;
+                continue;
+            }
+            TextObservation* obs = &observations[count++];
+            obs->text = strdup("");
+            obs->confidence = box.confidence;
+            obs->x = boundingBox.origin.x;
+            obs->y = boundingBox.origin.y;
+            obs->width = boundingBox.size.width;
+            obs->height = boundingBox.size.height;
+            if (!obs->text) {
+                ocr_observations_free(observations, count);
+                *out_error = OCR_ERROR_OUT_OF_MEMORY;
+                return false;
+            }
+        }
+        if (count == 0) {
+            free(observations);
+            return true;
+        }
+        *out_observations = observations;
+        *out_count = count;
+        return true;
     }
-    
-    if (result->text) {
-        free((void*)result->text);
-        result->text = NULL;
+}
+
+typedef struct {
+    CGImageRef image;
+    const OCROptions* options;
+    AttemptCancellation* cancellation;
+    size_t dropped_count;
+    OCRErrorCode error;
+} RegionContext;
+
+static bool RecognizeContextRegion(void* context, OCRRecognitionLevel level, const OCRRegion* region,
+                                   TextObservation** observations, size_t* count) {
+    RegionContext* ctx = (RegionContext*)context;
+    CGRect rect = CGRectMake(region->x, region->y, region->width, region->height);
+    size_t dropped = 0;
+    // In detect mode a region is searched for boxes and never read
+    bool found = ctx->options->detect_only ?
+        DetectTextBoxes(ctx->image, ctx->options, rect, ctx->cancellation, observations, count, &dropped, &ctx->error) :
+        RecognizeRegion(ctx->image, ctx->options, level, rect, ctx->cancellation,
+                        observations, count, &dropped, &ctx->error);
+    if (!found) {
+        return false;
     }
-    
-    if (result->observations) {
+    // Region passes re-read part of the image; only whole-image passes define what was dropped
+    if (region->width >= 1.0 && region->height >= 1.0) {
+        ctx->dropped_count = dropped;
+    }
+    return true;
+}
+
+// Confidence, reading order, text and the optional structures derived from the observations
+static void FinishResult(OCRResult* result, const OCROptions* opts) {
+    if (result->observation_count > 0) {
+        double totalConfidence = 0.0;
         for (size_t i = 0; i < result->observation_count; i++) {
-            if (result->observations[i].text) {
-                free((void*)result->observations[i].text);
+            totalConfidence += result->observations[i].confidence;
+        }
+        result->confidence = totalConfidence / result->observation_count;
+        
+        // Group observations into lines, paragraphs and columns and join in reading order
+        if (!ocr_layout_build(result->observations, result->observation_count, &result->layout)) {
+            SetError(result, OCR_ERROR_OUT_OF_MEMORY);
+            return;
+        }
+        // Detected boxes carry no text; the layout still describes where it is
+        result->text = opts->detect_only ? strdup("") : ocr_layout_join_text(result->observations, &result->layout);
+        if (!result->text) {
+            SetError(result, OCR_ERROR_OUT_OF_MEMORY);
+            return;
+        }
+        
+        if (opts->spatial_index) {
+            double* boxes = (double*)malloc(sizeof(double) * 4 * (result->observation_count + 1));
+            if (boxes) {
+                for (size_t i = 0; i < result->observation_count; i++) {
+                    const TextObservation* obs = &result->observations[i];
+                    boxes[i * 4] = obs->x;
+                    boxes[i * 4 + 1] = obs->y;
+                    boxes[i * 4 + 2] = obs->width;
+                    boxes[i * 4 + 3] = obs->height;
+                }
+                result->spatial_index = ocr_spatial_index_create(boxes, result->observation_count);
+                free(boxes);
+            }
+            if (!result->spatial_index) {
+                SetError(result, OCR_ERROR_OUT_OF_MEMORY);
+                return;
             }
         }
-        free(result->observations);
-        result->observations = NULL;
+        
+        if (opts->detect_table && !ocr_table_build(result->observations, result->observation_count, &result->table)) {
+            SetError(result, OCR_ERROR_OUT_OF_MEMORY);
+            return;
+        }
+    } else {
+        result->text = strdup("");
+        if (!result->text) {
+            SetError(result, OCR_ERROR_OUT_OF_MEMORY);
+            return;
+        }
+        result->confidence = 0.0;
     }
-    
-    free(result);
 }
 
-void free_ocr_batch_result(OCRBatchResult* result) {
-    if (!result) return;
+// Find text on a downscaled copy, then recognize the planned crops of the full image
+// in parallel. Crops share the decoded pixels; their observations are mapped back
+static bool RecognizePyramid(CGImageRef image, const OCROptions* opts, AttemptCancellation* cancellation,
+                             OCRResult* result, OCRErrorCode* error) {
+    size_t width = CGImageGetWidth(image);
+    size_t height = CGImageGetHeight(image);
+    double scale = opts->pyramid_scale > 0.0 && opts->pyramid_scale < 1.0 ? opts->pyramid_scale : DEFAULT_PYRAMID_SCALE;
+    CGImageRef small = CreateScaledImage(image, scale);
+    if (!small) {
+        *error = OCR_ERROR_PREPROCESS_FAILED;
+        return false;
+    }
+    // Detection only needs boxes, so nothing is filtered out yet
+    OCROptions detect = *opts;
+    detect.min_confidence = 0.0;
+    detect.min_observation_confidence = 0.0;
+    detect.min_box_size = 0.0;
+    detect.candidates = 0;
+    TextObservation* detected = NULL;
+    size_t detected_count = 0;
+    size_t detect_dropped = 0;
+    bool found = RecognizeRegion(small, &detect, OCR_RECOGNITION_LEVEL_FAST, CGRectMake(0, 0, 1, 1), cancellation,
+                                 &detected, &detected_count, &detect_dropped, error);
+    CGImageRelease(small);
+    if (!found) {
+        return false;
+    }
     
-    if (result->error) {
-        free((void*)result->error);
+    OCRRegion* regions = NULL;
+    size_t region_count = 0;
+    double covered = 0.0;
+    bool planned = ocr_pyramid_plan(detected, detected_count, width, height, &regions, &region_count, &covered);
+    ocr_observations_free(detected, detected_count);
+    if (!planned) {
+        *error = OCR_ERROR_OUT_OF_MEMORY;
+        return false;
+    }
+    result->pyramid.applied = true;
+    result->pyramid.detected_count = detected_count;
+    result->pyramid.region_count = region_count;
+    result->pyramid.covered_area = covered;
+    if (region_count == 0) {
+        return true;
     }
     
-    if (result->results) {
-        for (size_t i = 0; i < result->count; i++) {
-            if (result->results[i]) {
-                free_ocr_result(result->results[i]);
-            }
-        }
-        free(result->results);
+    // Box size is judged on whole-image coordinates once the crops are mapped back
+    OCROptions crop = *opts;
+    crop.min_box_size = 0.0;
+    if (crop.recognition_level == OCR_RECOGNITION_LEVEL_CASCADE) {
+        crop.recognition_level = OCR_RECOGNITION_LEVEL_ACCURATE;
     }
+    std::vector<TextObservation*> observations;
+    std::vector<size_t> counts;
+    std::vector<size_t> dropped;
+    std::vector<OCRErrorCode> errors;
+    try {
+        observations.assign(region_count, NULL);
+        counts.assign(region_count, 0);
+        dropped.assign(region_count, 0);
+        errors.assign(region_count, OCR_OK);
+    } catch (const std::bad_alloc&) {
+        free(regions);
+        *error = OCR_ERROR_OUT_OF_MEMORY;
+        return false;
+    }
+    TextObservation** cropObservations = observations.data();
+    size_t* cropCounts = counts.data();
+    size_t* cropDropped = dropped.data();
+    OCRErrorCode* cropErrors = errors.data();
+    const OCROptions* cropOptions = &crop;
+    const OCRRegion* cropRegions = regions;
+    dispatch_apply(region_count, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t i) {
+        const OCRRegion* region = &cropRegions[i];
+        // Regions are whole pixels of the full image; CGImage rects have a top-left origin
+        CGRect rect = CGRectMake(llround(region->x * width), llround((1.0 - region->y - region->height) * height),
+                                 llround(region->width * width), llround(region->height * height));
+        CGImageRef cropped = CGImageCreateWithImageInRect(image, rect);
+        if (!cropped) {
+            cropErrors[i] = OCR_ERROR_PREPROCESS_FAILED;
+            return;
+        }
+        // Sets the crop's error on failure
+        RecognizeRegion(cropped, cropOptions, cropOptions->recognition_level, CGRectMake(0, 0, 1, 1), cancellation,
+                        &cropObservations[i], &cropCounts[i], &cropDropped[i], &cropErrors[i]);
+        CGImageRelease(cropped);
+    });
     
-    free(result);
+    for (size_t i = 0; i < region_count; i++) {
+        result->dropped_count += dropped[i];
+        if (errors[i] != OCR_OK && *error == OCR_OK) {
+            *error = errors[i];
+        }
+    }
+    if (*error != OCR_OK) {
+        for (size_t i = 0; i < region_count; i++) {
+            ocr_observations_free(observations[i], counts[i]);
+        }
+        free(regions);
+        return false;
+    }
+    size_t small_boxes = 0;
+    bool merged = ocr_pyramid_merge(regions, region_count, observations.data(), counts.data(), opts->min_box_size,
+                                    &result->observations, &result->observation_count, &small_boxes);
+    free(regions);
+    if (!merged) {
+        *error = OCR_ERROR_OUT_OF_MEMORY;
+        return false;
+    }
+    result->dropped_count += small_boxes;
+    return true;
 }
 
-OCRBatchResult* perform_batch_ocr(const char** image_paths, size_t count, const OCRBatchOptions* options) {
+static OCRResult* PerformOCR(CGImageRef image, const OCROptions* options, AttemptCancellation* cancellation) {
     @autoreleasepool {
-        // 分配批处理结果结构体
-        OCRBatchResult* batch_result = (OCRBatchResult*)malloc(sizeof(OCRBatchResult));
-        if (!batch_result) {
+        OCRResult* result = (OCRResult*)calloc(1, sizeof(OCRResult));
+        if (!result) {
             return NULL;
         }
-
-        batch_result->error = NULL;
-        batch_result->results = NULL;
-        batch_result->count = count;
-        batch_result->failed_count = 0;
-
-        if (!image_paths || count == 0) {
-            batch_result->error = strdup("No image paths provided");
-            return batch_result;
-        }
-
-        const OCRBatchOptions* opts = options ? options : &DEFAULT_BATCH_OPTIONS;
         
-        int thread_count = opts->max_threads > 0 ? 
-            opts->max_threads : getSystemThreadCount();
+        const OCROptions* opts = options ? options : &DEFAULT_OPTIONS;
         
-        batch_result->results = (OCRResult**)calloc(count, sizeof(OCRResult*));
-        if (!batch_result->results) {
-            batch_result->error = strdup("Memory allocation failed for results array");
-            return batch_result;
+        if (!image) {
+            SetError(result, OCR_ERROR_INVALID_ARGUMENT);
+            return result;
         }
-
-        dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
-        dispatch_group_t group = dispatch_group_create();
         
-        dispatch_semaphore_t sema = dispatch_semaphore_create(thread_count);
-
-        std::atomic<int64_t>* atomic_failed_count = reinterpret_cast<std::atomic<int64_t>*>(&batch_result->failed_count);
-
-        for (size_t i = 0; i < count; i++) {
-            const char* current_path = image_paths[i];
-            size_t current_index = i;
+        OCRErrorCode error = OCR_OK;
+        bool recognized;
+        if (opts->detect_only) {
+            recognized = DetectTextBoxes(image, opts, CGRectMake(0, 0, 1, 1), cancellation, &result->observations,
+                                         &result->observation_count, &result->dropped_count, &error);
+        } else if (opts->latency_budget_ms > 0.0) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            OCRCostPlan plan = ocr_cost_model_plan(SharedCostModel(), opts->latency_budget_ms,
+                                                   CGImageGetWidth(image), CGImageGetHeight(image));
+            CGImageRef source = plan.scale < 1.0 ? CreateScaledImage(image, plan.scale) : CGImageRetain(image);
+            if (!source) {
+                // Downsampling is an optimization; fall back to the full image
+                plan.scale = 1.0;
+                source = CGImageRetain(image);
+            }
+            recognized = RecognizeRegion(source, opts, plan.level, CGRectMake(0, 0, 1, 1), cancellation,
+                                         &result->observations, &result->observation_count,
+                                         &result->dropped_count, &error);
+            CGImageRelease(source);
             
-            dispatch_semaphore_wait(sema, DISPATCH_TIME_FOREVER);
-            dispatch_group_async(group, queue, ^{
-                @autoreleasepool {
-                    char* error = NULL;
-                    CGImageRef image = CreateCGImageFromPath(current_path, &error);
-                    
-                    if (!image) {
-                        OCRResult* result = (OCRResult*)malloc(sizeof(OCRResult));
-                        result->error = error ? error : strdup("Failed to create image");
-                        result->text = NULL;
-                        result->confidence = 0.0;
-                        batch_result->results[current_index] = result;
-                        atomic_failed_count->fetch_add(1, std::memory_order_relaxed);
-                        return;
-                    }
-
-                    OCRResult* result = perform_ocr(image, &opts->ocr_options);
-
-                    CGImageRelease(image);
-
-                    batch_result->results[current_index] = result;
-
-                    if (result && result->error) {
-                        atomic_failed_count->fetch_add(1, std::memory_order_relaxed);
-                    }
-                    
-                    dispatch_semaphore_signal(sema);
-                }
-            });
+            result->budget.applied = true;
+            result->budget.level = plan.level;
+            result->budget.scale = plan.scale;
+            result->budget.predicted_ms = plan.predicted_ms;
+            result->budget.within_budget = plan.within_budget;
+            result->budget.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        } else if (opts->pyramid) {
+            recognized = RecognizePyramid(image, opts, cancellation, result, &error);
+        } else if (opts->recognition_level == OCR_RECOGNITION_LEVEL_CASCADE) {
+            RegionContext context = {image, opts, cancellation, 0, OCR_OK};
+            double threshold = opts->cascade_threshold > 0.0 ? opts->cascade_threshold : DEFAULT_CASCADE_THRESHOLD;
+            double aspect_ratio = (double)CGImageGetWidth(image) / (double)CGImageGetHeight(image);
+            recognized = ocr_cascade_recognize(threshold, aspect_ratio, RecognizeContextRegion, &context,
+                                               &result->observations, &result->observation_count, &result->cascade);
+            result->dropped_count = context.dropped_count;
+            error = context.error;
+        } else {
+            recognized = RecognizeRegion(image, opts, opts->recognition_level, CGRectMake(0, 0, 1, 1), cancellation,
+                                         &result->observations, &result->observation_count,
+                                         &result->dropped_count, &error);
+        }
+        if (!recognized) {
+            SetError(result, error != OCR_OK ? error : OCR_ERROR_OUT_OF_MEMORY);
+            return result;
         }
-
-        dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
         
-        return batch_result;
+        FinishResult(result, opts);
+        return result;
     }
 }
 
-OCRBatchResult* perform_batch_ocr_from_buffers(const void** buffers, const size_t* lengths, size_t count, const OCRBatchOptions* options) {
-    @autoreleasepool {
-        // 分配批处理结果结构体
-        OCRBatchResult* batch_result = (OCRBatchResult*)malloc(sizeof(OCRBatchResult));
-        if (!batch_result) {
-            return NULL;
-        }
-
-        batch_result->error = NULL;
-        batch_result->results = NULL;
-        batch_result->count = count;
-        batch_result->failed_count = 0;
+// Both attempts of a hedged recognition share this; the late one may still be
+// running after perform_ocr returns, so it owns copies of the image and options
+struct HedgeState {
+    CGImageRef image;
+    std::string languages;
+    OCROptions options[2];
+    AttemptCancellation cancellations[2];
+    dispatch_semaphore_t done;
+    std::mutex mutex;
+    int launched = 0;
+    int finished = 0;
+    bool signaled = false;
+    OCRResult* winner = NULL;
+    OCRResult* failure = NULL;
 
-        if (!buffers || !lengths || count == 0) {
-            batch_result->error = strdup("No image buffers provided");
-            return batch_result;
-        }
+    ~HedgeState() {
+        CGImageRelease(image);
+        free_ocr_result(failure);
+    }
+};
 
-        const OCRBatchOptions* opts = options ? options : &DEFAULT_BATCH_OPTIONS;
+static void LaunchAttempt(const std::shared_ptr<HedgeState>& state, int attempt) {
+    std::shared_ptr<HedgeState> shared = state;
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        OCRResult* result = PerformOCR(shared->image, &shared->options[attempt], &shared->cancellations[attempt]);
+        
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        shared->finished++;
+        if (!shared->winner && result && !result->error) {
+            result->hedge.won = attempt == 1;
+            shared->winner = result;
+            shared->cancellations[1 - attempt].Cancel();
+        } else if (!shared->winner && !shared->failure) {
+            shared->failure = result;
+        } else {
+            free_ocr_result(result);
+        }
+        if (!shared->signaled && (shared->winner || shared->finished == shared->launched)) {
+            shared->signaled = true;
+            dispatch_semaphore_signal(shared->done);
+        }
+    });
+}
+
+static OCRResult* PerformHedgedOCR(CGImageRef image, const OCROptions* opts, AttemptCancellation* cancellation) {
+    std::shared_ptr<HedgeState> state;
+    try {
+        state = std::make_shared<HedgeState>();
+        state->languages = opts->languages ? opts->languages : "";
+    } catch (const std::bad_alloc&) {
+        return NULL;
+    }
+    state->image = CGImageRetain(image);
+    state->done = dispatch_semaphore_create(0);
+    state->cancellations[0].parent = cancellation;
+    state->cancellations[1].parent = cancellation;
+    state->options[0] = *opts;
+    state->options[0].languages = opts->languages ? state->languages.c_str() : NULL;
+    state->options[0].hedge_after_ms = 0.0;
+    state->options[1] = state->options[0];
+    if (opts->hedge_fast) {
+        // A fast duplicate only makes sense as a single plain pass
+        state->options[1].recognition_level = OCR_RECOGNITION_LEVEL_FAST;
+        state->options[1].latency_budget_ms = 0.0;
+    }
+    g_hedge_calls++;
+    
+    state->launched = 1;
+    LaunchAttempt(state, 0);
+    
+    dispatch_time_t deadline = dispatch_time(DISPATCH_TIME_NOW, (int64_t)(opts->hedge_after_ms * NSEC_PER_MSEC));
+    bool hedged = false;
+    if (dispatch_semaphore_wait(state->done, deadline) != 0) {
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            // The first attempt may have finished between the timeout and taking the lock
+            if (!state->signaled) {
+                state->launched = 2;
+                hedged = true;
+                LaunchAttempt(state, 1);
+            }
+        }
+        dispatch_semaphore_wait(state->done, DISPATCH_TIME_FOREVER);
+    }
+    // A late attempt may outlive the caller's cancellation; it was cancelled when the other won
+    state->cancellations[0].Detach();
+    state->cancellations[1].Detach();
+    
+    std::lock_guard<std::mutex> lock(state->mutex);
+    OCRResult* result = state->winner;
+    if (!result) {
+        result = state->failure;
+        state->failure = NULL;
+    }
+    if (hedged) {
+        g_hedge_launched++;
+        if (result && result->hedge.won) {
+            g_hedge_wins++;
+        }
+    }
+    if (result) {
+        result->hedge.launched = hedged;
+    }
+    return result;
+}
+
+// Draw the image in gray at most 512 pixels on a side and test it against the blank
+// thresholds. Averaging during the downscale also smooths scanner noise and paper texture
+static bool IsBlankImage(CGImageRef image, const OCROptions* opts) {
+    size_t width = CGImageGetWidth(image);
+    size_t height = CGImageGetHeight(image);
+    if (width == 0 || height == 0) {
+        return false;
+    }
+    double scale = std::min(1.0, 512.0 / std::max(width, height));
+    width = std::max((size_t)1, (size_t)llround(width * scale));
+    height = std::max((size_t)1, (size_t)llround(height * scale));
+    PooledPixels gray(width * height);
+    if (!gray.data) {
+        return false;
+    }
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceGray();
+    CGContextRef context = CGBitmapContextCreate(gray.data, width, height, 8, width, colorSpace, kCGImageAlphaNone);
+    CGColorSpaceRelease(colorSpace);
+    if (!context) {
+        return false;
+    }
+    // Transparent areas are read as white paper rather than black
+    CGContextSetGrayFillColor(context, 1.0, 1.0);
+    CGContextFillRect(context, CGRectMake(0, 0, width, height));
+    CGContextSetInterpolationQuality(context, kCGInterpolationMedium);
+    CGContextDrawImage(context, CGRectMake(0, 0, width, height), image);
+    CGContextRelease(context);
+    
+    OCRImageStats stats;
+    if (!ocr_image_stats(gray.data, width, height, width, &stats)) {
+        return false;
+    }
+    double min_stddev = opts->blank_min_stddev > 0.0 ? opts->blank_min_stddev : DEFAULT_BLANK_MIN_STDDEV;
+    double min_edge_density = opts->blank_min_edge_density > 0.0 ? opts->blank_min_edge_density : DEFAULT_BLANK_MIN_EDGE_DENSITY;
+    return ocr_image_is_blank(&stats, min_stddev, min_edge_density);
+}
+
+static bool NeedsPreprocessing(const OCROptions* opts) {
+    return opts->grayscale || opts->normalize_contrast ||
+        (opts->preprocess_scale > 0.0 && opts->preprocess_scale < 1.0);
+}
+
+// Decode to RGBA once, then convert, downscale and stretch with the native kernels.
+// Runs on the calling worker thread; the returned gray image owns its pixels
+static CGImageRef CreatePreprocessedImage(CGImageRef image, const OCROptions* opts) {
+    size_t width = CGImageGetWidth(image);
+    size_t height = CGImageGetHeight(image);
+    if (width == 0 || height == 0) {
+        return NULL;
+    }
+    double scale = opts->preprocess_scale > 0.0 && opts->preprocess_scale < 1.0 ? opts->preprocess_scale : 1.0;
+    size_t outWidth = std::max((size_t)1, (size_t)llround(width * scale));
+    size_t outHeight = std::max((size_t)1, (size_t)llround(height * scale));
+    
+    bool downscale = outWidth < width || outHeight < height;
+    PooledPixels rgba(width * height * 4);
+    PooledPixels full(downscale ? width * height : 0);
+    if (!rgba.data || (downscale && !full.data)) {
+        return NULL;
+    }
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+    CGContextRef context = CGBitmapContextCreate(rgba.data, width, height, 8, width * 4, colorSpace,
+                                                 kCGImageAlphaPremultipliedLast);
+    CGColorSpaceRelease(colorSpace);
+    if (!context) {
+        return NULL;
+    }
+    // Transparent areas are read as white paper rather than black
+    CGContextSetRGBFillColor(context, 1.0, 1.0, 1.0, 1.0);
+    CGContextFillRect(context, CGRectMake(0, 0, width, height));
+    CGContextDrawImage(context, CGRectMake(0, 0, width, height), image);
+    CGContextRelease(context);
+    
+    // Handed to the image, which returns it to the pool when released
+    uint8_t* gray = (uint8_t*)ocr_pixel_pool_acquire(SharedPixelPool(), outWidth * outHeight);
+    if (!gray) {
+        return NULL;
+    }
+    if (downscale) {
+        ocr_rgba_to_gray(rgba.data, width, height, width * 4, full.data, width);
+        if (!ocr_resize_area(full.data, width, height, width, gray, outWidth, outHeight, outWidth)) {
+            ocr_pixel_pool_release(SharedPixelPool(), gray);
+            return NULL;
+        }
+    } else {
+        ocr_rgba_to_gray(rgba.data, width, height, width * 4, gray, width);
+    }
+    if (opts->normalize_contrast) {
+        ocr_normalize_contrast(gray, outWidth, outHeight, outWidth, CONTRAST_CLIP);
+    }
+    return CreateImageFromPooledPixels(gray, outWidth, outHeight, outWidth, true);
+}
+
+static OCRResult* RecognizeImage(CGImageRef image, const OCROptions* options, AttemptCancellation* cancellation) {
+    if (image && options && options->hedge_after_ms > 0.0) {
+        return PerformHedgedOCR(image, options, cancellation);
+    }
+    return PerformOCR(image, options, cancellation);
+}
+
+// Draw the image turned clockwise by quarter_turns and scaled, on white
+static CGImageRef CreateRotatedImage(CGImageRef image, int quarter_turns, double scale) {
+    double width = std::max(1.0, (double)llround(CGImageGetWidth(image) * scale));
+    double height = std::max(1.0, (double)llround(CGImageGetHeight(image) * scale));
+    bool sideways = quarter_turns % 2 == 1;
+    size_t outWidth = (size_t)(sideways ? height : width);
+    size_t outHeight = (size_t)(sideways ? width : height);
+    return CreatePooledImage(outWidth, outHeight, false, ^(CGContextRef context) {
+        CGContextSetRGBFillColor(context, 1.0, 1.0, 1.0, 1.0);
+        CGContextFillRect(context, CGRectMake(0, 0, outWidth, outHeight));
+        // Bottom-left origin: a clockwise quarter turn maps (x, y) to (y, width - x)
+        static const CGFloat turns[4][4] = {{1, 0, 0, 1}, {0, -1, 1, 0}, {-1, 0, 0, -1}, {0, 1, -1, 0}};
+        const CGFloat* t = turns[quarter_turns & 3];
+        CGFloat tx = quarter_turns == 2 ? width : (quarter_turns == 3 ? height : 0);
+        CGFloat ty = quarter_turns == 1 ? width : (quarter_turns == 2 ? height : 0);
+        CGContextConcatCTM(context, CGAffineTransformMake(t[0], t[1], t[2], t[3], tx, ty));
+        CGContextSetInterpolationQuality(context, kCGInterpolationMedium);
+        CGContextDrawImage(context, CGRectMake(0, 0, width, height), image);
+    });
+}
+
+// Confidence-weighted character count; unlike mean confidence it does not reward
+// an orientation that reads a few short fragments with certainty
+static double TextScore(const OCRResult* result) {
+    double score = 0.0;
+    for (size_t i = 0; i < result->observation_count; i++) {
+        score += result->observations[i].confidence * strlen(result->observations[i].text);
+    }
+    return score;
+}
+
+// Read a downscaled copy in all four orientations in parallel. If a turned one reads
+// better than the copy as given, recognize the full image turned that way and keep
+// whichever full result scores higher
+static OCRResult* AutoRotate(CGImageRef image, const OCROptions* options, OCRResult* first,
+                             AttemptCancellation* cancellation) {
+    size_t longest = std::max(CGImageGetWidth(image), CGImageGetHeight(image));
+    double scale = longest > 0 ? std::min(1.0, AUTO_ROTATE_MAX_SIDE / longest) : 1.0;
+    // A single plain pass per orientation; the caller's level is kept so scores are comparable
+    OCROptions probe = *options;
+    if (probe.recognition_level == OCR_RECOGNITION_LEVEL_CASCADE) {
+        probe.recognition_level = OCR_RECOGNITION_LEVEL_ACCURATE;
+    }
+    probe.latency_budget_ms = 0.0;
+    probe.hedge_after_ms = 0.0;
+    probe.candidates = 0;
+    probe.spatial_index = false;
+    probe.detect_table = false;
+    
+    __block double scores[4] = {0.0, 0.0, 0.0, 0.0};
+    const OCROptions* probeOptions = &probe;
+    dispatch_apply(4, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t turn) {
+        CGImageRef copy = CreateRotatedImage(image, (int)turn, scale);
+        if (!copy) {
+            return;
+        }
+        OCRResult* attempt = PerformOCR(copy, probeOptions, cancellation);
+        CGImageRelease(copy);
+        if (attempt && !attempt->error) {
+            scores[turn] = TextScore(attempt);
+        }
+        free_ocr_result(attempt);
+    });
+    
+    int best = 0;
+    for (int turn = 1; turn < 4; turn++) {
+        if (scores[turn] > scores[best]) {
+            best = turn;
+        }
+    }
+    if (best == 0) {
+        return first;
+    }
+    CGImageRef turned = CreateRotatedImage(image, best, 1.0);
+    if (!turned) {
+        return first;
+    }
+    OCRResult* result = RecognizeImage(turned, options, cancellation);
+    CGImageRelease(turned);
+    if (!result || result->error || TextScore(result) <= TextScore(first)) {
+        free_ocr_result(result);
+        return first;
+    }
+    free_ocr_result(first);
+    result->rotation = best * 90;
+    return result;
+}
+
+static OCRResult* RecognizeOriented(CGImageRef image, const OCROptions* options, AttemptCancellation* cancellation) {
+    OCRResult* result = RecognizeImage(image, options, cancellation);
+    // Detected boxes carry no text to compare orientations by
+    if (image && options && options->auto_rotate && !options->detect_only && result && !result->error) {
+        double threshold = options->auto_rotate_threshold > 0.0 ? options->auto_rotate_threshold : DEFAULT_AUTO_ROTATE_THRESHOLD;
+        if (result->confidence < threshold) {
+            return AutoRotate(image, options, result, cancellation);
+        }
+    }
+    return result;
+}
+
+static size_t CountLanguages(const char* languages) {
+    size_t count = 0;
+    bool in_language = false;
+    for (const char* c = languages; *c; c++) {
+        if (*c == ',') {
+            in_language = false;
+        } else if (*c != ' ' && !in_language) {
+            in_language = true;
+            count++;
+        }
+    }
+    return count;
+}
+
+// Read a downscaled copy accurately with every configured language and return the
+// scripts of the letters found. Small text is lost, but the script of a page is
+// decided by its body text
+static unsigned DetectScripts(CGImageRef image, const OCROptions* options, AttemptCancellation* cancellation) {
+    size_t longest = std::max(CGImageGetWidth(image), CGImageGetHeight(image));
+    double scale = longest > 0 ? std::min(1.0, ROUTE_PROBE_MAX_SIDE / longest) : 1.0;
+    OCROptions probe = {};
+    probe.languages = options->languages;
+    probe.recognition_level = OCR_RECOGNITION_LEVEL_ACCURATE;
+    CGImageRef copy = scale < 1.0 ? CreateScaledImage(image, scale) : CGImageRetain(image);
+    if (!copy) {
+        return 0;
+    }
+    OCRResult* attempt = PerformOCR(copy, &probe, cancellation);
+    CGImageRelease(copy);
+    OCRScriptHistogram histogram = {};
+    if (attempt && !attempt->error) {
+        for (size_t i = 0; i < attempt->observation_count; i++) {
+            ocr_script_count(attempt->observations[i].text, &histogram);
+        }
+    }
+    free_ocr_result(attempt);
+    return ocr_script_detect(&histogram, ROUTE_MIN_SCRIPT_SHARE);
+}
+
+// With route_languages, recognize with only the configured languages whose script the
+// script pass found. Every accurate recognition with more than one language is timed
+// per megapixel, so the stats can estimate what narrowing saved
+static OCRResult* RecognizeRouted(CGImageRef image, const OCROptions* options, AttemptCancellation* cancellation) {
+    size_t language_count = image && options && options->languages ? CountLanguages(options->languages) : 0;
+    // Fast recognition reads Latin scripts only, and detected boxes carry no text
+    if (language_count < 2 || options->recognition_level == OCR_RECOGNITION_LEVEL_FAST || options->detect_only) {
+        return RecognizeOriented(image, options, cancellation);
+    }
+    
+    OCROptions routed = *options;
+    OCRRoutingReport report = {};
+    char* languages = NULL;
+    if (options->route_languages) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        report.scripts = DetectScripts(image, options, cancellation);
+        if (!ocr_route_languages(options->languages, report.scripts, &languages)) {
+            OCRResult* result = (OCRResult*)calloc(1, sizeof(OCRResult));
+            if (result) {
+                SetError(result, OCR_ERROR_OUT_OF_MEMORY);
+            }
+            return result;
+        }
+        report.applied = true;
+        report.probe_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        routed.languages = languages;
+        g_route_routed++;
+        g_route_probe_us += (size_t)llround(report.probe_ms * 1000.0);
+    }
+    
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    OCRResult* result = RecognizeOriented(image, &routed, cancellation);
+    double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (result && !result->error) {
+        size_t elapsed_us = (size_t)llround(elapsed_ms * 1000.0);
+        size_t kilopixels = (size_t)llround(CGImageGetWidth(image) * (double)CGImageGetHeight(image) / 1000.0);
+        if (languages && CountLanguages(languages) < language_count) {
+            g_route_narrowed++;
+            g_route_narrowed_us += elapsed_us;
+            g_route_narrowed_kilopixels += kilopixels;
+        } else {
+            g_route_full_us += elapsed_us;
+            g_route_full_kilopixels += kilopixels;
+        }
+    }
+    if (result && report.applied) {
+        report.languages = languages;
+        report.recognize_ms = elapsed_ms;
+        result->routing = report;
+        languages = NULL;
+    }
+    free(languages);
+    return result;
+}
+
+// perform_ocr, with every Vision request it makes registered with cancellation when one is given
+static OCRResult* PerformCancellableOCR(CGImageRef image, const OCROptions* options, AttemptCancellation* cancellation) {
+    if (image && options && options->reject_blank) {
+        g_blank_checked++;
+        if (IsBlankImage(image, options)) {
+            g_blank_rejected++;
+            OCRResult* result = (OCRResult*)calloc(1, sizeof(OCRResult));
+            if (!result) {
+                return NULL;
+            }
+            result->blank = true;
+            result->text = strdup("");
+            if (!result->text) {
+                SetError(result, OCR_ERROR_OUT_OF_MEMORY);
+            }
+            return result;
+        }
+    }
+    if (image && options && NeedsPreprocessing(options)) {
+        // Both attempts of a hedged recognition share the preprocessed image
+        CGImageRef prepared = CreatePreprocessedImage(image, options);
+        if (!prepared) {
+            OCRResult* result = (OCRResult*)calloc(1, sizeof(OCRResult));
+            if (result) {
+                SetError(result, OCR_ERROR_PREPROCESS_FAILED);
+            }
+            return result;
+        }
+        OCRResult* result = RecognizeRouted(prepared, options, cancellation);
+        CGImageRelease(prepared);
+        return result;
+    }
+    return RecognizeRouted(image, options, cancellation);
+}
+
+OCRResult* perform_ocr(CGImageRef image, const OCROptions* options) {
+    return PerformCancellableOCR(image, options, NULL);
+}
+
+OCRBatchResult* perform_ocr_option_sets(CGImageRef image, const OCROptions* option_sets, size_t count) {
+    OCRBatchResult* batch_result = (OCRBatchResult*)calloc(1, sizeof(OCRBatchResult));
+    if (!batch_result) {
+        return NULL;
+    }
+    if (!image || !option_sets || count == 0) {
+        SetError(batch_result, OCR_ERROR_INVALID_ARGUMENT);
+        return batch_result;
+    }
+    batch_result->results = (OCRResult**)calloc(count, sizeof(OCRResult*));
+    if (!batch_result->results) {
+        SetError(batch_result, OCR_ERROR_OUT_OF_MEMORY);
+        return batch_result;
+    }
+    batch_result->count = count;
+    
+    // CGImage is immutable, so every option set reads the same decoded pixels
+    OCRResult** results = batch_result->results;
+    dispatch_apply(count, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t i) {
+        results[i] = perform_ocr(image, &option_sets[i]);
+    });
+    for (size_t i = 0; i < count; i++) {
+        if (!results[i] || results[i]->error) {
+            batch_result->failed_count++;
+        }
+    }
+    return batch_result;
+}
+
+void get_ocr_blank_stats(OCRBlankStats* stats) {
+    if (!stats) return;
+    
+    stats->checked = g_blank_checked.load();
+    stats->rejected = g_blank_rejected.load();
+}
+
+void get_ocr_routing_stats(OCRRoutingStats* stats) {
+    if (!stats) return;
+    
+    stats->routed = g_route_routed.load();
+    stats->narrowed = g_route_narrowed.load();
+    stats->probe_ms = g_route_probe_us.load() / 1000.0;
+    stats->narrowed_ms = g_route_narrowed_us.load() / 1000.0;
+    stats->narrowed_megapixels = g_route_narrowed_kilopixels.load() / 1000.0;
+    stats->full_ms = g_route_full_us.load() / 1000.0;
+    stats->full_megapixels = g_route_full_kilopixels.load() / 1000.0;
+    // Narrowed images priced at the full-list cost per megapixel, less what they took
+    // and what every script pass took
+    stats->saved_ms = 0.0;
+    if (stats->narrowed_megapixels > 0.0 && stats->full_megapixels > 0.0) {
+        double full_rate = stats->full_ms / stats->full_megapixels;
+        stats->saved_ms = stats->narrowed_megapixels * full_rate - stats->narrowed_ms - stats->probe_ms;
+    }
+}
+
+void get_ocr_admission_stats(OCRAdmissionStats* stats) {
+    if (!stats) return;
+    
+    stats->batches = g_admission_batches.load();
+    stats->admitted = g_admission_admitted.load();
+    stats->deferred = g_admission_deferred.load();
+    stats->wait_ms = g_admission_wait_us.load() / 1000.0;
+    stats->peak_in_flight_bytes = g_admission_peak_bytes.load();
+}
+
+void get_ocr_pixel_pool_stats(OCRPixelPoolStats* stats) {
+    ocr_pixel_pool_stats(SharedPixelPool(), stats);
+}
+
+void get_ocr_hedge_stats(OCRHedgeStats* stats) {
+    if (!stats) return;
+    
+    stats->calls = g_hedge_calls.load();
+    stats->hedged = g_hedge_launched.load();
+    stats->hedge_wins = g_hedge_wins.load();
+}
+
+// Frames are processed one at a time; the session keeps its own copy of the last
+// frame's observations so results can be freed independently
+struct OCRFrameSession {
+    std::mutex mutex;
+    std::string languages;
+    OCROptions options;
+    OCRFrameDiff* diff;
+    TextObservation* observations;
+    size_t observation_count;
+    std::vector<uint8_t> pixels;
+    uint64_t last_hash;        // perceptual hash of the last recognized frame
+    bool has_hash;
+};
+
+OCRFrameSession* create_ocr_frame_session(const OCROptions* options, size_t tile_size) {
+    const OCROptions* opts = options ? options : &DEFAULT_OPTIONS;
+    OCRFrameSession* session = new (std::nothrow) OCRFrameSession();
+    if (!session) {
+        return NULL;
+    }
+    try {
+        session->languages = opts->languages ? opts->languages : "";
+    } catch (const std::bad_alloc&) {
+        delete session;
+        return NULL;
+    }
+    session->options = *opts;
+    session->options.languages = opts->languages ? session->languages.c_str() : NULL;
+    // Regions are recognized in a single pass, the planner and hedging work on whole images
+    session->options.latency_budget_ms = 0.0;
+    session->options.hedge_after_ms = 0.0;
+    session->observations = NULL;
+    session->observation_count = 0;
+    session->last_hash = 0;
+    session->has_hash = false;
+    session->diff = ocr_frame_diff_create(tile_size);
+    if (!session->diff) {
+        delete session;
+        return NULL;
+    }
+    return session;
+}
+
+static void ForgetFrame(OCRFrameSession* session) {
+    ocr_frame_diff_reset(session->diff);
+    ocr_observations_free(session->observations, session->observation_count);
+    session->observations = NULL;
+    session->observation_count = 0;
+    session->has_hash = false;
+}
+
+OCRResult* perform_frame_ocr(OCRFrameSession* session, CGImageRef frame) {
+    @autoreleasepool {
+        OCRResult* result = (OCRResult*)calloc(1, sizeof(OCRResult));
+        if (!result) {
+            return NULL;
+        }
+        if (!session || !frame) {
+            SetError(result, OCR_ERROR_INVALID_ARGUMENT);
+            return result;
+        }
+        std::lock_guard<std::mutex> lock(session->mutex);
+        const OCROptions* opts = &session->options;
+        
+        // Render into a fixed RGBA layout so frames from any source compare byte for byte
+        size_t width = CGImageGetWidth(frame);
+        size_t height = CGImageGetHeight(frame);
+        size_t bytesPerRow = width * 4;
+        try {
+            session->pixels.resize(bytesPerRow * height);
+        } catch (const std::bad_alloc&) {
+            SetError(result, OCR_ERROR_OUT_OF_MEMORY);
+            return result;
+        }
+        CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+        CGContextRef context = CGBitmapContextCreate(session->pixels.data(), width, height, 8, bytesPerRow,
+                                                     colorSpace, kCGImageAlphaPremultipliedLast);
+        CGColorSpaceRelease(colorSpace);
+        if (!context) {
+            SetError(result, OCR_ERROR_OUT_OF_MEMORY);
+            return result;
+        }
+        CGContextDrawImage(context, CGRectMake(0, 0, width, height), frame);
+        CGContextRelease(context);
+        
+        // A near-duplicate reuses the last recognized frame's observations. Neither the hash
+        // nor the stored frame moves forward, so slow drift still adds up to a change
+        uint64_t hash = 0;
+        if (opts->skip_duplicates) {
+            hash = ocr_perceptual_hash(session->pixels.data(), width, height, bytesPerRow);
+            if (session->has_hash && ocr_hash_distance(hash, session->last_hash) <= opts->duplicate_distance) {
+                if (!ocr_observations_copy(session->observations, session->observation_count, &result->observations)) {
+                    SetError(result, OCR_ERROR_OUT_OF_MEMORY);
+                    return result;
+                }
+                result->observation_count = session->observation_count;
+                result->frame.carried_count = session->observation_count;
+                result->frame.duplicate = true;
+                FinishResult(result, opts);
+                return result;
+            }
+        }
+        
+        if (!ocr_frame_diff_update(session->diff, session->pixels.data(), width, height, bytesPerRow, &result->frame)) {
+            ForgetFrame(session);
+            SetError(result, OCR_ERROR_OUT_OF_MEMORY);
+            return result;
+        }
+        
+        // Cascade is not applied per region; regions are small enough to read accurately
+        OCRRecognitionLevel level = opts->recognition_level == OCR_RECOGNITION_LEVEL_FAST ?
+            OCR_RECOGNITION_LEVEL_FAST : OCR_RECOGNITION_LEVEL_ACCURATE;
+        RegionContext regionContext = {frame, opts, NULL, 0, OCR_OK};
+        if (!ocr_frame_merge(session->observations, session->observation_count, level, RecognizeContextRegion,
+                             &regionContext, &result->frame, &result->observations, &result->observation_count)) {
+            ForgetFrame(session);
+            SetError(result, regionContext.error != OCR_OK ? regionContext.error : OCR_ERROR_OUT_OF_MEMORY);
+            return result;
+        }
+        result->dropped_count = regionContext.dropped_count;
+        
+        // Added observations sit after the carried ones until the layout reorders them
+        std::unordered_map<const char*, size_t> added;
+        try {
+            for (size_t i = result->frame.carried_count; i < result->observation_count; i++) {
+                added[result->observations[i].text] = i;
+            }
+        } catch (const std::bad_alloc&) {
+            ForgetFrame(session);
+            SetError(result, OCR_ERROR_OUT_OF_MEMORY);
+            return result;
+        }
+        
+        FinishResult(result, opts);
+        if (result->error) {
+            ForgetFrame(session);
+            return result;
+        }
+        
+        if (!added.empty()) {
+            result->frame.added = (size_t*)malloc(sizeof(size_t) * added.size());
+            if (!result->frame.added) {
+                ForgetFrame(session);
+                SetError(result, OCR_ERROR_OUT_OF_MEMORY);
+                return result;
+            }
+            size_t next = 0;
+            for (size_t i = 0; i < result->observation_count; i++) {
+                if (added.count(result->observations[i].text)) {
+                    result->frame.added[next++] = i;
+                }
+            }
+        }
+        
+        TextObservation* kept = NULL;
+        if (!ocr_observations_copy(result->observations, result->observation_count, &kept)) {
+            ForgetFrame(session);
+            SetError(result, OCR_ERROR_OUT_OF_MEMORY);
+            return result;
+        }
+        ocr_observations_free(session->observations, session->observation_count);
+        session->observations = kept;
+        session->observation_count = result->observation_count;
+        session->last_hash = hash;
+        session->has_hash = opts->skip_duplicates;
+        return result;
+    }
+}
+
+void reset_ocr_frame_session(OCRFrameSession* session) {
+    if (!session) return;
+    
+    std::lock_guard<std::mutex> lock(session->mutex);
+    ForgetFrame(session);
+}
+
+void free_ocr_frame_session(OCRFrameSession* session) {
+    if (!session) return;
+    
+    ocr_observations_free(session->observations, session->observation_count);
+    ocr_frame_diff_free(session->diff);
+    delete session;
+}
+
+void free_ocr_result(OCRResult* result) {
+    if (!result) return;
+    
+    if (result->text) {
+        free((void*)result->text);
+        result->text = NULL;
+    }
+    
+    ocr_observations_free(result->observations, result->observation_count);
+    result->observations = NULL;
+    
+    ocr_layout_free(&result->layout);
+    ocr_spatial_index_free(result->spatial_index);
+    ocr_table_free(&result->table);
+    ocr_frame_delta_free(&result->frame);
+    free((void*)result->routing.languages);
+    
+    free(result);
+}
+
+void free_ocr_batch_result(OCRBatchResult* result) {
+    if (!result) return;
+    
+    if (result->results) {
+        for (size_t i = 0; i < result->count; i++) {
+            if (result->results[i]) {
+                free_ocr_result(result->results[i]);
+            }
+        }
+        free(result->results);
+    }
+    
+    free(result);
+}
+
+// Perceptual hash of an image drawn at most 256 pixels on a side; the hash only
+// looks at a 9x8 grid, so decoding to full size would be wasted work
+static bool HashImage(CGImageRef image, uint64_t* hash) {
+    size_t width = CGImageGetWidth(image);
+    size_t height = CGImageGetHeight(image);
+    if (width == 0 || height == 0) {
+        return false;
+    }
+    double scale = std::min(1.0, 256.0 / std::max(width, height));
+    width = std::max((size_t)1, (size_t)llround(width * scale));
+    height = std::max((size_t)1, (size_t)llround(height * scale));
+    PooledPixels pixels(width * height * 4);
+    if (!pixels.data) {
+        return false;
+    }
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+    CGContextRef context = CGBitmapContextCreate(pixels.data, width, height, 8, width * 4, colorSpace,
+                                                 kCGImageAlphaPremultipliedLast);
+    CGColorSpaceRelease(colorSpace);
+    if (!context) {
+        return false;
+    }
+    CGContextSetInterpolationQuality(context, kCGInterpolationLow);
+    CGContextDrawImage(context, CGRectMake(0, 0, width, height), image);
+    CGContextRelease(context);
+    *hash = ocr_perceptual_hash(pixels.data, width, height, width * 4);
+    return true;
+}
+
+// True if the image is a near-duplicate of another batch input. The first input of a
+// group to be hashed is registered and recognized; the others wait for its result
+static bool MatchDuplicate(OCRDuplicateIndex* duplicates, CGImageRef image, size_t index, size_t* original) {
+    uint64_t hash;
+    return duplicates && HashImage(image, &hash) && ocr_duplicate_index_match(duplicates, hash, index, original);
+}
+
+static OCRResult* CopyDuplicateResult(const OCRResult* original, size_t original_index, const OCROptions* opts) {
+    OCRResult* result = (OCRResult*)calloc(1, sizeof(OCRResult));
+    if (!result) {
+        return NULL;
+    }
+    result->duplicate = true;
+    result->duplicate_of = original_index;
+    if (!original || original->error) {
+        SetError(result, original ? original->error_code : OCR_ERROR_DUPLICATE_FAILED);
+        return result;
+    }
+    if (!ocr_observations_copy(original->observations, original->observation_count, &result->observations)) {
+        SetError(result, OCR_ERROR_OUT_OF_MEMORY);
+        return result;
+    }
+    result->observation_count = original->observation_count;
+    result->dropped_count = original->dropped_count;
+    result->cascade = original->cascade;
+    result->budget = original->budget;
+    result->pyramid = original->pyramid;
+    result->rotation = original->rotation;
+    result->routing = original->routing;
+    result->routing.languages = NULL;
+    if (original->routing.languages && !(result->routing.languages = strdup(original->routing.languages))) {
+        SetError(result, OCR_ERROR_OUT_OF_MEMORY);
+        return result;
+    }
+    FinishResult(result, opts);
+    return result;
+}
+
+// Fill in the results of inputs skipped as near-duplicates once every original is done
+static void ResolveDuplicates(OCRBatchResult* batch_result, const size_t* originals, const OCROptions* opts) {
+    for (size_t i = 0; i < batch_result->count; i++) {
+        if (originals[i] == SIZE_MAX) {
+            continue;
+        }
+        OCRResult* result = CopyDuplicateResult(batch_result->results[originals[i]], originals[i], opts);
+        batch_result->results[i] = result;
+        if (!result || result->error) {
+            batch_result->failed_count++;
+        }
+    }
+}
+
+// Decoded size of a batch input read from its header, so admission never decodes. Formats
+// the probe does not read are charged a typical compression ratio over their encoded size
+static size_t EstimateDecodedBytes(const OCRInput* input) {
+    OCRImageInfo info;
+    size_t encoded = 0;
+    if (input->path) {
+        if (ocr_image_probe_file(input->path, &info, NULL)) {
+            return ocr_image_decoded_bytes(&info);
+        }
+        struct stat file_info;
+        if (stat(input->path, &file_info) == 0 && file_info.st_size > 0) {
+            encoded = (size_t)file_info.st_size;
+        }
+    } else if (input->buffer) {
+        if (ocr_image_probe(input->buffer, input->length, &info)) {
+            return ocr_image_decoded_bytes(&info);
+        }
+        encoded = input->length;
+    }
+    return encoded > SIZE_MAX / UNPROBED_DECODE_RATIO ? SIZE_MAX : encoded * UNPROBED_DECODE_RATIO;
+}
+
+static size_t EstimatePathBytes(void* context, size_t index) {
+    OCRInput input = {static_cast<const char**>(context)[index], NULL, 0};
+    return EstimateDecodedBytes(&input);
+}
+
+struct BufferList {
+    const void** buffers;
+    const size_t* lengths;
+};
+
+static size_t EstimateBufferBytes(void* context, size_t index) {
+    const BufferList* list = static_cast<const BufferList*>(context);
+    OCRInput input = {NULL, list->buffers[index], list->lengths[index]};
+    return EstimateDecodedBytes(&input);
+}
+
+static size_t EstimateInputBytes(void* context, size_t index) {
+    return EstimateDecodedBytes(&static_cast<const OCRInput*>(context)[index]);
+}
+
+// Fold a finished batch into the admission counters and free its queue and budget
+static void FinishAdmission(OCRAdmission* admission, OCRByteBudget* budget, size_t admitted) {
+    size_t deferred;
+    double waited_ms;
+    ocr_admission_stats(admission, &deferred, &waited_ms);
+    g_admission_batches.fetch_add(1, std::memory_order_relaxed);
+    g_admission_admitted.fetch_add(admitted, std::memory_order_relaxed);
+    g_admission_deferred.fetch_add(deferred, std::memory_order_relaxed);
+    g_admission_wait_us.fetch_add((size_t)(waited_ms * 1000.0), std::memory_order_relaxed);
+    size_t peak = ocr_byte_budget_peak(budget);
+    size_t seen = g_admission_peak_bytes.load(std::memory_order_relaxed);
+    while (peak > seen && !g_admission_peak_bytes.compare_exchange_weak(seen, peak, std::memory_order_relaxed)) {
+    }
+    ocr_admission_free(admission);
+    ocr_byte_budget_free(budget);
+}
+
+// What a batch worker holds while it runs: one concurrency slot and its input's estimated
+// bytes, or its decoded bytes once decoded under an unlimited budget
+struct BatchSlot {
+    dispatch_semaphore_t sema;
+    OCRByteBudget* budget;
+    size_t bytes;
+};
+
+// Decode a batch input, retrying transient I/O errors up to max_retries times with doubling
+// backoff. The concurrency slot is handed back while backing off; the bytes stay reserved, since
+// taking them back outside the admission queue would jump ahead of inputs it set aside
+static CGImageRef DecodeBatchInput(const OCRInput* input, const OCRBatchOptions* opts, BatchSlot* slot,
+                                   OCRErrorCode* error, int* attempts) {
+    double backoff_ms = opts->retry_backoff_ms > 0.0 ? opts->retry_backoff_ms : DEFAULT_RETRY_BACKOFF_MS;
+    for (*attempts = 1;; (*attempts)++) {
+        CGImageRef image = CreateCGImageFromInput(input, error);
+        if (image && opts->max_in_flight_bytes == 0) {
+            // Unlimited budgets admit without estimating, so the decoded size is charged
+            // here to keep the peak meaningful
+            slot->bytes = CGImageGetBytesPerRow(image) * CGImageGetHeight(image);
+            ocr_byte_budget_acquire(slot->budget, slot->bytes);
+        }
+        if (image || !ocr_error_is_transient(*error) || *attempts > opts->max_retries) {
+            return image;
+        }
+        dispatch_semaphore_signal(slot->sema);
+        [NSThread sleepForTimeInterval:backoff_ms / 1000.0];
+        backoff_ms = std::min(backoff_ms * 2.0, MAX_RETRY_BACKOFF_MS);
+        dispatch_semaphore_wait(slot->sema, DISPATCH_TIME_FOREVER);
+    }
+}
+
+// Decode and recognize one batch input into its results slot. Every outcome, failures
+// included, returns here, so the worker gives back its slot on a single path
+static void RecognizeBatchInput(const OCRInput* input, size_t index, const OCRBatchOptions* opts,
+                                BatchSlot* slot, OCRBatchResult* batch_result,
+                                OCRDuplicateIndex* duplicates, size_t* duplicate_of) {
+    OCRErrorCode error = OCR_OK;
+    int attempts = 0;
+    CGImageRef image = DecodeBatchInput(input, opts, slot, &error, &attempts);
+    if (!image) {
+        // Left NULL if even the failure cannot be allocated; NULL counts as failed
+        OCRResult* result = (OCRResult*)calloc(1, sizeof(OCRResult));
+        if (result) {
+            SetError(result, error != OCR_OK ? error : OCR_ERROR_DECODE_FAILED);
+            result->attempts = attempts;
+        }
+        batch_result->results[index] = result;
+        return;
+    }
+
+    size_t original;
+    if (MatchDuplicate(duplicates, image, index, &original)) {
+        duplicate_of[index] = original;
+        CGImageRelease(image);
+        return;
+    }
+
+    OCRResult* result = perform_ocr(image, &opts->ocr_options);
+    CGImageRelease(image);
+    if (result) {
+        result->attempts = attempts;
+    }
+    batch_result->results[index] = result;
+}
+
+// Count failed inputs once every worker is done; near-duplicates are counted as they are resolved
+static size_t CountFailedInputs(const OCRBatchResult* batch_result, const size_t* duplicate_of) {
+    size_t failed = 0;
+    for (size_t i = 0; i < batch_result->count; i++) {
+        if (duplicate_of && duplicate_of[i] != SIZE_MAX) {
+            continue;
+        }
+        if (!batch_result->results[i] || batch_result->results[i]->error) {
+            failed++;
+        }
+    }
+    return failed;
+}
+
+OCRBatchResult* perform_batch_ocr(const char** image_paths, size_t count, const OCRBatchOptions* options) {
+    @autoreleasepool {
+        // 分配批处理结果结构体
+        OCRBatchResult* batch_result = (OCRBatchResult*)calloc(1, sizeof(OCRBatchResult));
+        if (!batch_result) {
+            return NULL;
+        }
+        batch_result->count = count;
+
+        if (!image_paths || count == 0) {
+            SetError(batch_result, OCR_ERROR_NO_INPUT);
+            return batch_result;
+        }
+
+        const OCRBatchOptions* opts = options ? options : &DEFAULT_BATCH_OPTIONS;
         
         int thread_count = opts->max_threads > 0 ? 
             opts->max_threads : getSystemThreadCount();
         
         batch_result->results = (OCRResult**)calloc(count, sizeof(OCRResult*));
         if (!batch_result->results) {
-            batch_result->error = strdup("Memory allocation failed for results array");
+            SetError(batch_result, OCR_ERROR_OUT_OF_MEMORY);
+            return batch_result;
+        }
+
+        // Images are handed out by estimated decoded size; one that does not fit the budget
+        // waits while smaller ones behind it keep flowing
+        OCRByteBudget* budget = ocr_byte_budget_create(opts->max_in_flight_bytes);
+        OCRAdmission* admission = ocr_admission_create(budget, count, EstimatePathBytes, (void*)image_paths);
+        if (!admission) {
+            ocr_byte_budget_free(budget);
+            SetError(batch_result, OCR_ERROR_OUT_OF_MEMORY);
             return batch_result;
         }
 
@@ -427,47 +1896,493 @@ OCRBatchResult* perform_batch_ocr_from_buffers(const void** buffers, const size_
         
         dispatch_semaphore_t sema = dispatch_semaphore_create(thread_count);
 
-        std::atomic<int64_t>* atomic_failed_count = reinterpret_cast<std::atomic<int64_t>*>(&batch_result->failed_count);
+        // Index of the input whose result each duplicate reuses, SIZE_MAX for originals;
+        // duplicate skipping is an optimization and is dropped if this cannot be allocated
+        std::vector<size_t> originals;
+        OCRDuplicateIndex* duplicates = NULL;
+        if (opts->ocr_options.skip_duplicates) {
+            try {
+                originals.assign(count, SIZE_MAX);
+                duplicates = ocr_duplicate_index_create(opts->ocr_options.duplicate_distance);
+            } catch (const std::bad_alloc&) {
+            }
+        }
+        size_t* duplicate_of = originals.data();
 
-        for (size_t i = 0; i < count; i++) {
-            const void* current_buffer = buffers[i];
-            size_t current_length = lengths[i];
-            size_t current_index = i;
+        while (true) {
+            dispatch_semaphore_wait(sema, DISPATCH_TIME_FOREVER);
+            size_t current_index;
+            size_t current_bytes;
+            if (!ocr_admission_next(admission, &current_index, &current_bytes)) {
+                dispatch_semaphore_signal(sema);
+                break;
+            }
+            OCRInput current_input = {image_paths[current_index], NULL, 0};
+
+            dispatch_group_async(group, queue, ^{
+                BatchSlot slot = {sema, budget, current_bytes};
+                @autoreleasepool {
+                    RecognizeBatchInput(&current_input, current_index, opts, &slot, batch_result, duplicates, duplicate_of);
+                }
+                ocr_byte_budget_release(budget, slot.bytes);
+                dispatch_semaphore_signal(sema);
+            });
+        }
+
+        dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+        FinishAdmission(admission, budget, count);
+        batch_result->failed_count = CountFailedInputs(batch_result, duplicate_of);
+        
+        if (duplicates) {
+            ResolveDuplicates(batch_result, duplicate_of, &opts->ocr_options);
+            ocr_duplicate_index_free(duplicates);
+        }
+        
+        return batch_result;
+    }
+}
+
+OCRBatchResult* perform_batch_ocr_from_buffers(const void** buffers, const size_t* lengths, size_t count, const OCRBatchOptions* options) {
+    @autoreleasepool {
+        // 分配批处理结果结构体
+        OCRBatchResult* batch_result = (OCRBatchResult*)calloc(1, sizeof(OCRBatchResult));
+        if (!batch_result) {
+            return NULL;
+        }
+        batch_result->count = count;
+
+        if (!buffers || !lengths || count == 0) {
+            SetError(batch_result, OCR_ERROR_NO_INPUT);
+            return batch_result;
+        }
+
+        const OCRBatchOptions* opts = options ? options : &DEFAULT_BATCH_OPTIONS;
+        
+        int thread_count = opts->max_threads > 0 ? 
+            opts->max_threads : getSystemThreadCount();
+        
+        batch_result->results = (OCRResult**)calloc(count, sizeof(OCRResult*));
+        if (!batch_result->results) {
+            SetError(batch_result, OCR_ERROR_OUT_OF_MEMORY);
+            return batch_result;
+        }
+
+        // Images are handed out by estimated decoded size; one that does not fit the budget
+        // waits while smaller ones behind it keep flowing
+        BufferList buffer_list = {buffers, lengths};
+        OCRByteBudget* budget = ocr_byte_budget_create(opts->max_in_flight_bytes);
+        OCRAdmission* admission = ocr_admission_create(budget, count, EstimateBufferBytes, &buffer_list);
+        if (!admission) {
+            ocr_byte_budget_free(budget);
+            SetError(batch_result, OCR_ERROR_OUT_OF_MEMORY);
+            return batch_result;
+        }
+
+        dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+        dispatch_group_t group = dispatch_group_create();
+        
+        dispatch_semaphore_t sema = dispatch_semaphore_create(thread_count);
+
+        // Index of the input whose result each duplicate reuses, SIZE_MAX for originals;
+        // duplicate skipping is an optimization and is dropped if this cannot be allocated
+        std::vector<size_t> originals;
+        OCRDuplicateIndex* duplicates = NULL;
+        if (opts->ocr_options.skip_duplicates) {
+            try {
+                originals.assign(count, SIZE_MAX);
+                duplicates = ocr_duplicate_index_create(opts->ocr_options.duplicate_distance);
+            } catch (const std::bad_alloc&) {
+            }
+        }
+        size_t* duplicate_of = originals.data();
+
+        while (true) {
+            dispatch_semaphore_wait(sema, DISPATCH_TIME_FOREVER);
+            size_t current_index;
+            size_t current_bytes;
+            if (!ocr_admission_next(admission, &current_index, &current_bytes)) {
+                dispatch_semaphore_signal(sema);
+                break;
+            }
+            OCRInput current_input = {NULL, buffers[current_index], lengths[current_index]};
+
+            dispatch_group_async(group, queue, ^{
+                BatchSlot slot = {sema, budget, current_bytes};
+                @autoreleasepool {
+                    RecognizeBatchInput(&current_input, current_index, opts, &slot, batch_result, duplicates, duplicate_of);
+                }
+                ocr_byte_budget_release(budget, slot.bytes);
+                dispatch_semaphore_signal(sema);
+            });
+        }
+
+        dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+        FinishAdmission(admission, budget, count);
+        batch_result->failed_count = CountFailedInputs(batch_result, duplicate_of);
+        
+        if (duplicates) {
+            ResolveDuplicates(batch_result, duplicate_of, &opts->ocr_options);
+            ocr_duplicate_index_free(duplicates);
+        }
+        
+        return batch_result;
+    }
+} 
+
+OCRFindResult* perform_batch_find_text(const OCRInput* inputs, size_t count, const OCRBatchOptions* options, const OCRFindOptions* find) {
+    @autoreleasepool {
+        OCRFindResult* find_result = (OCRFindResult*)calloc(1, sizeof(OCRFindResult));
+        if (!find_result) {
+            return NULL;
+        }
+
+        if (!inputs || count == 0) {
+            SetError(find_result, OCR_ERROR_NO_INPUT);
+            return find_result;
+        }
+
+        if (!find || !find->pattern || find->pattern[0] == '\0') {
+            SetError(find_result, OCR_ERROR_INVALID_PATTERN);
+            return find_result;
+        }
+
+        NSString* pattern = [NSString stringWithUTF8String:find->pattern];
+        if (!pattern) {
+            SetError(find_result, OCR_ERROR_INVALID_PATTERN);
+            return find_result;
+        }
+
+        // Literal searches use the same matcher with metacharacters disabled
+        NSRegularExpressionOptions regexOptions = find->regex ? 0 : NSRegularExpressionIgnoreMetacharacters;
+        if (find->case_insensitive) {
+            regexOptions |= NSRegularExpressionCaseInsensitive;
+        }
+        NSRegularExpression* expression = [NSRegularExpression regularExpressionWithPattern:pattern
+                                                                                    options:regexOptions
+                                                                                      error:nil];
+        if (!expression) {
+            SetError(find_result, OCR_ERROR_INVALID_PATTERN);
+            return find_result;
+        }
+
+        const OCRBatchOptions* opts = options ? options : &DEFAULT_BATCH_OPTIONS;
+        
+        int thread_count = opts->max_threads > 0 ? 
+            opts->max_threads : getSystemThreadCount();
+
+        // Images are handed out by estimated decoded size; one that does not fit the budget
+        // waits while smaller ones behind it keep flowing
+        OCRByteBudget* budget = ocr_byte_budget_create(opts->max_in_flight_bytes);
+        OCRAdmission* admission = ocr_admission_create(budget, count, EstimateInputBytes, (void*)inputs);
+        if (!admission) {
+            ocr_byte_budget_free(budget);
+            SetError(find_result, OCR_ERROR_OUT_OF_MEMORY);
+            return find_result;
+        }
+
+        dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+        dispatch_group_t group = dispatch_group_create();
+        
+        dispatch_semaphore_t sema = dispatch_semaphore_create(thread_count);
+
+        std::vector<OCRTextMatch> found_matches;
+        std::mutex match_mutex;
+        std::atomic<size_t> match_count(0);
+        std::atomic<size_t> processed_count(0);
+        std::atomic<size_t> failed_count(0);
+        std::atomic<size_t> skipped_count(0);
+        std::atomic<bool> cancelled(false);
+        // Reaching stop_after cancels the recognitions already running as well
+        AttemptCancellation stop_requests;
+
+        std::vector<OCRTextMatch>* matches = &found_matches;
+        std::mutex* matches_lock = &match_mutex;
+        std::atomic<size_t>* atomic_match_count = &match_count;
+        std::atomic<size_t>* atomic_processed_count = &processed_count;
+        std::atomic<size_t>* atomic_failed_count = &failed_count;
+        std::atomic<size_t>* atomic_skipped_count = &skipped_count;
+        std::atomic<bool>* atomic_cancelled = &cancelled;
+        AttemptCancellation* running_requests = &stop_requests;
+        size_t stop_after = find->stop_after;
+
+        size_t dispatched = 0;
+        while (true) {
+            dispatch_semaphore_wait(sema, DISPATCH_TIME_FOREVER);
+            size_t current_index;
+            size_t current_bytes;
+            if (atomic_cancelled->load(std::memory_order_acquire) ||
+                !ocr_admission_next(admission, &current_index, &current_bytes)) {
+                dispatch_semaphore_signal(sema);
+                break;
+            }
+
+            const OCRInput* current_input = &inputs[current_index];
+            dispatched++;
             
+            dispatch_group_async(group, queue, ^{
+                @autoreleasepool {
+                    // Work queued before the limit was reached is dropped before decoding
+                    if (atomic_cancelled->load(std::memory_order_acquire)) {
+                        atomic_skipped_count->fetch_add(1, std::memory_order_relaxed);
+                        ocr_byte_budget_release(budget, current_bytes);
+                        dispatch_semaphore_signal(sema);
+                        return;
+                    }
+
+                    BatchSlot slot = {sema, budget, current_bytes};
+                    OCRErrorCode error = OCR_OK;
+                    int attempts = 0;
+                    CGImageRef image = DecodeBatchInput(current_input, opts, &slot, &error, &attempts);
+                    if (!image) {
+                        atomic_failed_count->fetch_add(1, std::memory_order_relaxed);
+                        ocr_byte_budget_release(budget, slot.bytes);
+                        dispatch_semaphore_signal(sema);
+                        return;
+                    }
+
+                    OCRResult* result = PerformCancellableOCR(image, &opts->ocr_options, running_requests);
+                    CGImageRelease(image);
+
+                    if (!result || result->error) {
+                        // A recognition cut short by the limit was skipped, not failed
+                        bool stopped = result && atomic_cancelled->load(std::memory_order_acquire);
+                        free_ocr_result(result);
+                        (stopped ? atomic_skipped_count : atomic_failed_count)->fetch_add(1, std::memory_order_relaxed);
+                        ocr_byte_budget_release(budget, slot.bytes);
+                        dispatch_semaphore_signal(sema);
+                        return;
+                    }
+                    atomic_processed_count->fetch_add(1, std::memory_order_relaxed);
+
+                    for (size_t j = 0; j < result->observation_count; j++) {
+                        const TextObservation* obs = &result->observations[j];
+                        NSString* text = [NSString stringWithUTF8String:obs->text];
+                        if (!text) {
+                            continue;
+                        }
+
+                        NSArray<NSTextCheckingResult*>* hits = [expression matchesInString:text
+                                                                                   options:0
+                                                                                     range:NSMakeRange(0, text.length)];
+                        if (hits.count == 0) {
+                            continue;
+                        }
+
+                        std::lock_guard<std::mutex> guard(*matches_lock);
+                        size_t added = 0;
+                        for (NSTextCheckingResult* hit in hits) {
+                            OCRTextMatch match;
+                            match.input_index = current_index;
+                            match.observation_index = j;
+                            match.text = strdup(obs->text);
+                            match.match_start = hit.range.location;
+                            match.match_length = hit.range.length;
+                            match.confidence = obs->confidence;
+                            match.x = obs->x;
+                            match.y = obs->y;
+                            match.width = obs->width;
+                            match.height = obs->height;
+                            if (!match.text) {
+                                continue;
+                            }
+                            matches->push_back(match);
+                            added++;
+                        }
+                        size_t total = atomic_match_count->fetch_add(added, std::memory_order_relaxed) + added;
+                        if (stop_after > 0 && total >= stop_after &&
+                            !atomic_cancelled->exchange(true, std::memory_order_acq_rel)) {
+                            running_requests->Cancel();
+                        }
+                    }
+
+                    free_ocr_result(result);
+                    ocr_byte_budget_release(budget, slot.bytes);
+                    dispatch_semaphore_signal(sema);
+                }
+            });
+        }
+
+        dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+        FinishAdmission(admission, budget, dispatched);
+
+        // Images running concurrently may overshoot the limit; keep the earliest inputs
+        std::sort(found_matches.begin(), found_matches.end(), [](const OCRTextMatch& a, const OCRTextMatch& b) {
+            if (a.input_index != b.input_index) return a.input_index < b.input_index;
+            if (a.observation_index != b.observation_index) return a.observation_index < b.observation_index;
+            return a.match_start < b.match_start;
+        });
+        if (stop_after > 0 && found_matches.size() > stop_after) {
+            for (size_t i = stop_after; i < found_matches.size(); i++) {
+                free((void*)found_matches[i].text);
+            }
+            found_matches.resize(stop_after);
+        }
+
+        find_result->processed_count = processed_count.load();
+        find_result->failed_count = failed_count.load();
+        find_result->skipped_count = skipped_count.load() + (count - dispatched);
+
+        if (!found_matches.empty()) {
+            find_result->matches = (OCRTextMatch*)malloc(sizeof(OCRTextMatch) * found_matches.size());
+            if (!find_result->matches) {
+                for (const OCRTextMatch& match : found_matches) {
+                    free((void*)match.text);
+                }
+                SetError(find_result, OCR_ERROR_OUT_OF_MEMORY);
+                return find_result;
+            }
+            std::copy(found_matches.begin(), found_matches.end(), find_result->matches);
+            find_result->match_count = found_matches.size();
+        }
+
+        return find_result;
+    }
+}
+
+void free_ocr_find_result(OCRFindResult* result) {
+    if (!result) return;
+    
+    if (result->matches) {
+        for (size_t i = 0; i < result->match_count; i++) {
+            free((void*)result->matches[i].text);
+        }
+        free(result->matches);
+    }
+    
+    free(result);
+}
+
+OCRIndexBuildResult* perform_batch_index(const OCRInput* inputs, size_t count, const OCRBatchOptions* options, const char* index_path) {
+    @autoreleasepool {
+        OCRIndexBuildResult* build_result = (OCRIndexBuildResult*)calloc(1, sizeof(OCRIndexBuildResult));
+        if (!build_result) {
+            return NULL;
+        }
+
+        if (!inputs || count == 0) {
+            SetError(build_result, OCR_ERROR_NO_INPUT);
+            return build_result;
+        }
+
+        if (!index_path || index_path[0] == '\0') {
+            SetError(build_result, OCR_ERROR_INVALID_ARGUMENT);
+            return build_result;
+        }
+
+        if (count > UINT32_MAX) {
+            SetError(build_result, OCR_ERROR_TOO_MANY_IMAGES);
+            return build_result;
+        }
+
+        OCRIndexBuilder* builder = ocr_index_builder_create();
+        if (!builder) {
+            SetError(build_result, OCR_ERROR_OUT_OF_MEMORY);
+            return build_result;
+        }
+
+        const OCRBatchOptions* opts = options ? options : &DEFAULT_BATCH_OPTIONS;
+        
+        int thread_count = opts->max_threads > 0 ? 
+            opts->max_threads : getSystemThreadCount();
+
+        // Images are handed out by estimated decoded size; one that does not fit the budget
+        // waits while smaller ones behind it keep flowing
+        OCRByteBudget* budget = ocr_byte_budget_create(opts->max_in_flight_bytes);
+        OCRAdmission* admission = ocr_admission_create(budget, count, EstimateInputBytes, (void*)inputs);
+        if (!admission) {
+            ocr_byte_budget_free(budget);
+            ocr_index_builder_free(builder);
+            SetError(build_result, OCR_ERROR_OUT_OF_MEMORY);
+            return build_result;
+        }
+
+        dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+        dispatch_group_t group = dispatch_group_create();
+        
+        dispatch_semaphore_t sema = dispatch_semaphore_create(thread_count);
+
+        std::atomic<size_t> document_count(0);
+        std::atomic<size_t> failed_count(0);
+        std::atomic<bool> out_of_memory(false);
+
+        std::atomic<size_t>* atomic_document_count = &document_count;
+        std::atomic<size_t>* atomic_failed_count = &failed_count;
+        std::atomic<bool>* atomic_out_of_memory = &out_of_memory;
+
+        while (true) {
             dispatch_semaphore_wait(sema, DISPATCH_TIME_FOREVER);
+            size_t index;
+            size_t current_bytes;
+            if (!ocr_admission_next(admission, &index, &current_bytes)) {
+                dispatch_semaphore_signal(sema);
+                break;
+            }
+            const OCRInput* current_input = &inputs[index];
+            uint32_t current_index = (uint32_t)index;
+
             dispatch_group_async(group, queue, ^{
                 @autoreleasepool {
-                    char* error = NULL;
-                    CGImageRef image = CreateCGImageFromBuffer(current_buffer, current_length, &error);
-                    
+                    BatchSlot slot = {sema, budget, current_bytes};
+                    OCRErrorCode error = OCR_OK;
+                    int attempts = 0;
+                    CGImageRef image = DecodeBatchInput(current_input, opts, &slot, &error, &attempts);
                     if (!image) {
-                        OCRResult* result = (OCRResult*)malloc(sizeof(OCRResult));
-                        result->error = error ? error : strdup("Failed to create image from buffer");
-                        result->text = NULL;
-                        result->confidence = 0.0;
-                        batch_result->results[current_index] = result;
                         atomic_failed_count->fetch_add(1, std::memory_order_relaxed);
+                        ocr_byte_budget_release(budget, slot.bytes);
                         dispatch_semaphore_signal(sema);
                         return;
                     }
 
                     OCRResult* result = perform_ocr(image, &opts->ocr_options);
-
                     CGImageRelease(image);
 
-                    batch_result->results[current_index] = result;
-
-                    if (result && result->error) {
+                    if (!result || result->error) {
+                        free_ocr_result(result);
                         atomic_failed_count->fetch_add(1, std::memory_order_relaxed);
+                        ocr_byte_budget_release(budget, slot.bytes);
+                        dispatch_semaphore_signal(sema);
+                        return;
                     }
-                    
+
+                    // Tokenize while the other workers are still recognizing
+                    if (ocr_index_builder_add(builder, current_index, result->observations, result->observation_count)) {
+                        atomic_document_count->fetch_add(1, std::memory_order_relaxed);
+                    } else {
+                        atomic_out_of_memory->store(true, std::memory_order_relaxed);
+                    }
+
+                    free_ocr_result(result);
+                    ocr_byte_budget_release(budget, slot.bytes);
                     dispatch_semaphore_signal(sema);
                 }
             });
         }
 
         dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
-        
-        return batch_result;
+        FinishAdmission(admission, budget, count);
+
+        build_result->document_count = document_count.load();
+        build_result->failed_count = failed_count.load();
+
+        if (out_of_memory.load()) {
+            SetError(build_result, OCR_ERROR_OUT_OF_MEMORY);
+            ocr_index_builder_free(builder);
+            return build_result;
+        }
+
+        OCRErrorCode error = OCR_OK;
+        if (!ocr_index_builder_write(builder, index_path, &error)) {
+            SetError(build_result, error);
+            ocr_index_builder_free(builder);
+            return build_result;
+        }
+
+        ocr_index_builder_stats(builder, &build_result->term_count, &build_result->posting_count);
+        ocr_index_builder_free(builder);
+        return build_result;
     }
-} 
\ No newline at end of file
+}
+
+void free_ocr_index_build_result(OCRIndexBuildResult* result) {
+    free(result);
+}
@@ -0,0 +1,73 @@
+#include "ocr_error.h"
+
+#include <errno.h>
+
+namespace {
+
+struct ErrorInfo {
+    const char* name;
+    const char* message;
+};
+
+// Indexed by OCRErrorCode
+const ErrorInfo kErrors[] = {
+    {"OK", "No error"},
+    {"ERR_OCR_UNKNOWN", "Unknown error occurred"},
+    {"ERR_OCR_INVALID_ARGUMENT", "Invalid parameters"},
+    {"ERR_OCR_OUT_OF_MEMORY", "Memory allocation failed"},
+    {"ERR_OCR_FILE_NOT_FOUND", "Image file does not exist"},
+    {"ERR_OCR_FILE_READ", "Failed to read image data"},
+    {"ERR_OCR_ACCESS_DENIED", "Permission denied reading image file"},
+    {"ERR_OCR_UNSUPPORTED_FORMAT", "Unsupported image format"},
+    {"ERR_OCR_DECODE_FAILED", "Failed to decode image"},
+    {"ERR_OCR_IMAGE_TOO_LARGE", "Image too large to decode"},
+    {"ERR_OCR_PREPROCESS_FAILED", "Image preprocessing failed"},
+    {"ERR_OCR_RECOGNITION_FAILED", "Text recognition failed"},
+    {"ERR_OCR_CANCELLED", "Recognition cancelled"},
+    {"ERR_OCR_DUPLICATE_FAILED", "Near-duplicate image failed to recognize"},
+    {"ERR_OCR_NO_INPUT", "No images provided"},
+    {"ERR_OCR_INVALID_PATTERN", "Invalid search pattern"},
+    {"ERR_OCR_TOO_MANY_IMAGES", "Too many images for one index"},
+    {"ERR_OCR_INDEX_WRITE", "Failed to write index file"},
+    {"ERR_OCR_INDEX_CORRUPT", "Invalid index file"},
+};
+
+static_assert(sizeof(kErrors) / sizeof(kErrors[0]) == OCR_ERROR_COUNT, "every error code needs a name and message");
+
+const ErrorInfo& Lookup(OCRErrorCode code) {
+    if ((int)code < 0 || code >= OCR_ERROR_COUNT) {
+        return kErrors[OCR_ERROR_UNKNOWN];
+    }
+    return kErrors[code];
+}
+
+} // namespace
+
+const char* ocr_error_message(OCRErrorCode code) {
+    return Lookup(code).message;
+}
+
+const char* ocr_error_name(OCRErrorCode code) {
+    return Lookup(code).name;
+}
+
+OCRErrorCode ocr_error_from_errno(int errnum) {
+    switch (errnum) {
+        case ENOENT:
+        case ENOTDIR:
+        case ENAMETOOLONG:
+        case ELOOP:
+            return OCR_ERROR_FILE_NOT_FOUND;
+        case EACCES:
+        case EPERM:
+            return OCR_ERROR_ACCESS_DENIED;
+        case ENOMEM:
+            return OCR_ERROR_OUT_OF_MEMORY;
+        default:
+            return OCR_ERROR_FILE_READ;
+    }
+}
+
+bool ocr_error_is_transient(OCRErrorCode code) {
+    return code == OCR_ERROR_FILE_READ;
+}
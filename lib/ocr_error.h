@@ -0,0 +1,71 @@
+#ifndef MAC_OCR_ERROR_H
+#define MAC_OCR_ERROR_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Why an operation failed
+ * Each code has a constant message and a name, so reporting a failure never allocates
+ */
+typedef enum {
+    OCR_OK = 0,                         // no error
+    OCR_ERROR_UNKNOWN,                  // failure without a more specific cause
+    OCR_ERROR_INVALID_ARGUMENT,         // missing or out-of-range parameter
+    OCR_ERROR_OUT_OF_MEMORY,            // memory allocation failed
+    OCR_ERROR_FILE_NOT_FOUND,           // image file does not exist
+    OCR_ERROR_FILE_READ,                // image file exists but could not be read
+    OCR_ERROR_ACCESS_DENIED,            // image file exists but may not be opened
+    OCR_ERROR_UNSUPPORTED_FORMAT,       // input is not in a supported image format
+    OCR_ERROR_DECODE_FAILED,            // image data could not be decoded
+    OCR_ERROR_IMAGE_TOO_LARGE,          // decoded pixels would exceed the memory limit
+    OCR_ERROR_PREPROCESS_FAILED,        // grayscale, contrast or scaling step failed
+    OCR_ERROR_RECOGNITION_FAILED,       // Vision request failed
+    OCR_ERROR_CANCELLED,                // recognition was cancelled
+    OCR_ERROR_DUPLICATE_FAILED,         // the image this near-duplicate reuses failed
+    OCR_ERROR_NO_INPUT,                 // no images were given
+    OCR_ERROR_INVALID_PATTERN,          // search pattern is empty, not UTF-8 or not a valid regular expression
+    OCR_ERROR_TOO_MANY_IMAGES,          // more images than an index can address
+    OCR_ERROR_INDEX_WRITE,              // index file could not be written
+    OCR_ERROR_INDEX_CORRUPT,            // index file is truncated or its header does not match its contents
+    OCR_ERROR_COUNT
+} OCRErrorCode;
+
+/**
+ * Message for an error code
+ * @param code error code
+ * @return constant message, never NULL; unknown codes map to the OCR_ERROR_UNKNOWN message
+ */
+const char* ocr_error_message(OCRErrorCode code);
+
+/**
+ * Name for an error code, in the style of Node.js error codes
+ * @param code error code
+ * @return constant name such as "ERR_OCR_DECODE_FAILED", never NULL
+ */
+const char* ocr_error_name(OCRErrorCode code);
+
+/**
+ * Error code for a failed file system call
+ * @param errnum errno value
+ * @return OCR_ERROR_FILE_NOT_FOUND for missing paths, OCR_ERROR_ACCESS_DENIED for permission
+ *         errors, OCR_ERROR_OUT_OF_MEMORY for ENOMEM, OCR_ERROR_FILE_READ otherwise
+ */
+OCRErrorCode ocr_error_from_errno(int errnum);
+
+/**
+ * Whether the same operation may succeed if tried again, as when a read fails while the
+ * file is being replaced or the process is briefly out of file descriptors
+ * @param code error code
+ * @return true for OCR_ERROR_FILE_READ
+ */
+bool ocr_error_is_transient(OCRErrorCode code);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MAC_OCR_ERROR_H
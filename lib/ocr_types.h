@@ -0,0 +1,47 @@
+#ifndef MAC_OCR_TYPES_H
+#define MAC_OCR_TYPES_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * OCR recognition level
+ */
+typedef enum {
+    OCR_RECOGNITION_LEVEL_FAST = 0,    // fast mode
+    OCR_RECOGNITION_LEVEL_ACCURATE = 1, // accurate mode
+    OCR_RECOGNITION_LEVEL_CASCADE = 2  // fast mode, low-confidence regions re-recognized in accurate mode
+} OCRRecognitionLevel;
+
+/**
+ * Alternative reading of an observation
+ */
+typedef struct {
+    const char* text;     // candidate text
+    double confidence;    // confidence for this candidate
+} TextCandidate;
+
+/**
+ * Text observation structure containing text and native macOS coordinates
+ * Coordinates are exactly as returned by Vision Framework without any conversion
+ * Uses bottom-left origin coordinate system (native macOS/Quartz)
+ */
+typedef struct {
+    const char* text;     // recognized text
+    double confidence;    // confidence for this text
+    double x;             // x coordinate from Vision Framework (0.0-1.0)
+    double y;             // y coordinate from Vision Framework (0.0-1.0, bottom-left origin)
+    double width;         // width from Vision Framework (0.0-1.0)
+    double height;        // height from Vision Framework (0.0-1.0)
+    TextCandidate* candidates;  // best readings in descending confidence, NULL unless requested
+    size_t candidate_count;     // number of candidates
+} TextObservation;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MAC_OCR_TYPES_H
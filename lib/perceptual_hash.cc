@@ -0,0 +1,160 @@
+#include "perceptual_hash.h"
+
+#include <algorithm>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+struct OCRDuplicateIndex {
+    int max_distance;
+    std::mutex mutex;
+    std::vector<uint64_t> hashes;  // originals in registration order
+    std::vector<size_t> ids;
+};
+
+namespace {
+
+const size_t kGridColumns = 9;
+const size_t kGridRows = 8;
+
+// Integer BT.601 luma weights scaled by 256
+const uint32_t kRedWeight = 77;
+const uint32_t kGreenWeight = 150;
+const uint32_t kBlueWeight = 29;
+
+// Cells must differ by more than this many luma levels to set a bit. Flat areas such
+// as slide backgrounds would otherwise set bits by noise alone
+const double kDeadZone = 2.0 * 256;
+
+// Add the luma of one row to a per-column accumulator
+void AccumulateLuma(const uint8_t* row, size_t width, uint32_t* sums) {
+    size_t x = 0;
+#if defined(__SSE2__)
+    // One pixel per 32-bit lane; each channel is masked into the low half of the
+    // lane so madd multiplies it by its weight without crossing into the next pixel
+    const __m128i byte_mask = _mm_set1_epi32(0xFF);
+    const __m128i red = _mm_set1_epi32(kRedWeight);
+    const __m128i green = _mm_set1_epi32(kGreenWeight);
+    const __m128i blue = _mm_set1_epi32(kBlueWeight);
+    for (; x + 4 <= width; x += 4) {
+        __m128i px = _mm_loadu_si128((const __m128i*)(row + x * 4));
+        __m128i r = _mm_and_si128(px, byte_mask);
+        __m128i g = _mm_and_si128(_mm_srli_epi32(px, 8), byte_mask);
+        __m128i b = _mm_and_si128(_mm_srli_epi32(px, 16), byte_mask);
+        __m128i luma = _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(r, red), _mm_madd_epi16(g, green)),
+                                     _mm_madd_epi16(b, blue));
+        __m128i acc = _mm_loadu_si128((const __m128i*)(sums + x));
+        _mm_storeu_si128((__m128i*)(sums + x), _mm_add_epi32(acc, luma));
+    }
+#elif defined(__ARM_NEON)
+    const uint8x8_t red = vdup_n_u8((uint8_t)kRedWeight);
+    const uint8x8_t green = vdup_n_u8((uint8_t)kGreenWeight);
+    const uint8x8_t blue = vdup_n_u8((uint8_t)kBlueWeight);
+    for (; x + 8 <= width; x += 8) {
+        uint8x8x4_t px = vld4_u8(row + x * 4);
+        uint16x8_t luma = vmull_u8(px.val[0], red);
+        luma = vmlal_u8(luma, px.val[1], green);
+        luma = vmlal_u8(luma, px.val[2], blue);
+        vst1q_u32(sums + x, vaddw_u16(vld1q_u32(sums + x), vget_low_u16(luma)));
+        vst1q_u32(sums + x + 4, vaddw_u16(vld1q_u32(sums + x + 4), vget_high_u16(luma)));
+    }
+#endif
+    for (; x < width; x++) {
+        const uint8_t* p = row + x * 4;
+        sums[x] += kRedWeight * p[0] + kGreenWeight * p[1] + kBlueWeight * p[2];
+    }
+}
+
+// Bounds of cell i when n cells cover length pixels; every cell is at least one pixel
+void CellBounds(size_t i, size_t n, size_t length, size_t* start, size_t* end) {
+    *start = std::min(i * length / n, length - 1);
+    *end = std::max(*start + 1, std::min((i + 1) * length / n, length));
+}
+
+} // namespace
+
+uint64_t ocr_perceptual_hash(const uint8_t* pixels, size_t width, size_t height, size_t bytes_per_row) {
+    if (!pixels || width == 0 || height == 0 || bytes_per_row < width * 4) {
+        return 0;
+    }
+    std::vector<uint32_t> sums;
+    try {
+        sums.resize(width);
+    } catch (const std::bad_alloc&) {
+        return 0;
+    }
+
+    uint64_t hash = 0;
+    for (size_t r = 0; r < kGridRows; r++) {
+        size_t y0, y1;
+        CellBounds(r, kGridRows, height, &y0, &y1);
+        // Column sums stay in 32 bits: 65280 per pixel times at most 65k rows per band
+        std::fill(sums.begin(), sums.end(), 0);
+        for (size_t y = y0; y < y1; y++) {
+            AccumulateLuma(pixels + y * bytes_per_row, width, sums.data());
+        }
+
+        double means[kGridColumns];
+        for (size_t c = 0; c < kGridColumns; c++) {
+            size_t x0, x1;
+            CellBounds(c, kGridColumns, width, &x0, &x1);
+            uint64_t total = 0;
+            for (size_t x = x0; x < x1; x++) {
+                total += sums[x];
+            }
+            means[c] = (double)total / ((x1 - x0) * (y1 - y0));
+        }
+        for (size_t c = 0; c + 1 < kGridColumns; c++) {
+            hash = (hash << 1) | (means[c] > means[c + 1] + kDeadZone ? 1 : 0);
+        }
+    }
+    return hash;
+}
+
+int ocr_hash_distance(uint64_t a, uint64_t b) {
+    return __builtin_popcountll(a ^ b);
+}
+
+OCRDuplicateIndex* ocr_duplicate_index_create(int max_distance) {
+    OCRDuplicateIndex* index = new (std::nothrow) OCRDuplicateIndex();
+    if (!index) {
+        return NULL;
+    }
+    index->max_distance = std::max(0, max_distance);
+    return index;
+}
+
+bool ocr_duplicate_index_match(OCRDuplicateIndex* index, uint64_t hash, size_t id, size_t* original) {
+    if (!index) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(index->mutex);
+    // A linear scan of XOR + popcount checks about a million hashes per millisecond,
+    // which is far below the cost of recognizing a single image
+    for (size_t i = 0; i < index->hashes.size(); i++) {
+        if (ocr_hash_distance(index->hashes[i], hash) <= index->max_distance) {
+            if (original) *original = index->ids[i];
+            return true;
+        }
+    }
+    try {
+        index->hashes.push_back(hash);
+        index->ids.push_back(id);
+    } catch (const std::bad_alloc&) {
+        // Unregistered originals are still recognized; later duplicates just miss them
+        if (index->ids.size() < index->hashes.size()) {
+            index->hashes.pop_back();
+        }
+    }
+    return false;
+}
+
+void ocr_duplicate_index_free(OCRDuplicateIndex* index) {
+    delete index;
+}
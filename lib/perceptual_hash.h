@@ -0,0 +1,66 @@
+#ifndef MAC_OCR_PERCEPTUAL_HASH_H
+#define MAC_OCR_PERCEPTUAL_HASH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Registry of image hashes for near-duplicate detection, thread-safe
+ */
+typedef struct OCRDuplicateIndex OCRDuplicateIndex;
+
+/**
+ * Compute the 64-bit difference hash (dHash) of an image
+ * The image is reduced to a 9x8 grid of mean luminance; each bit records whether a
+ * cell is clearly brighter than its right neighbour. Compression noise moves cell means
+ * by far less than text does, so re-encoded copies of a frame stay a few bits apart
+ * @param pixels 32-bit RGBA or RGBX pixels
+ * @param width image width in pixels
+ * @param height image height in pixels
+ * @param bytes_per_row distance between rows in bytes
+ * @return hash, 0 for an empty image
+ */
+uint64_t ocr_perceptual_hash(const uint8_t* pixels, size_t width, size_t height, size_t bytes_per_row);
+
+/**
+ * Number of differing bits between two hashes
+ * @param a first hash
+ * @param b second hash
+ * @return Hamming distance 0-64
+ */
+int ocr_hash_distance(uint64_t a, uint64_t b);
+
+/**
+ * Create a duplicate registry
+ * @param max_distance largest Hamming distance at which two images count as duplicates
+ * @return registry pointer, NULL if memory allocation fails
+ * @note The returned registry must be freed using ocr_duplicate_index_free
+ */
+OCRDuplicateIndex* ocr_duplicate_index_create(int max_distance);
+
+/**
+ * Look for a registered near-duplicate of an image, registering the image if there is none
+ * @param index duplicate registry
+ * @param hash hash of the image
+ * @param id caller's identifier of the image
+ * @param original receives the identifier of the earliest registered duplicate
+ * @return true if a duplicate was found, false if the image was registered as an original
+ */
+bool ocr_duplicate_index_match(OCRDuplicateIndex* index, uint64_t hash, size_t id, size_t* original);
+
+/**
+ * Free a duplicate registry
+ * @param index registry to be freed, can be NULL
+ */
+void ocr_duplicate_index_free(OCRDuplicateIndex* index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MAC_OCR_PERCEPTUAL_HASH_H
@@ -0,0 +1,261 @@
+#include "pixel_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace {
+
+// Classes run from 16 KiB to 4 GiB in four steps per power of two
+const size_t kMinClassShift = 14;
+const size_t kMaxClassShift = 32;
+const size_t kStepsPerDoubling = 4;
+const size_t kClassCount = (kMaxClassShift - kMinClassShift) * kStepsPerDoubling + 1;
+const uint32_t kOversized = UINT32_MAX;
+
+// Threads are spread over the shards in the order they first touch a pool; with no
+// more workers than shards, each thread caches into a shard of its own
+const size_t kShards = 16;
+
+// The header sits in front of each buffer so release needs only the pointer, as a
+// CoreGraphics data provider callback has; its size keeps the buffer 64-byte aligned
+const size_t kHeaderBytes = 64;
+const uint32_t kMagic = 0x4F435250;
+
+struct Header {
+    uint32_t magic;
+    uint32_t size_class;
+    size_t capacity;
+};
+
+static_assert(sizeof(Header) <= kHeaderBytes, "header must fit in front of the buffer");
+
+size_t ClassCapacity(size_t size_class) {
+    size_t base = (size_t)1 << (kMinClassShift + size_class / kStepsPerDoubling);
+    return base + size_class % kStepsPerDoubling * (base / kStepsPerDoubling);
+}
+
+// Smallest class holding bytes, which must not exceed the largest class
+size_t ClassFor(size_t bytes) {
+    if (bytes <= (size_t)1 << kMinClassShift) {
+        return 0;
+    }
+    size_t shift = 63 - (size_t)__builtin_clzll((unsigned long long)(bytes - 1));
+    size_t base = (size_t)1 << shift;
+    size_t step = base / kStepsPerDoubling;
+    size_t steps = (bytes - base + step - 1) / step;
+    return (shift - kMinClassShift) * kStepsPerDoubling + steps;
+}
+
+std::atomic<size_t> g_next_shard(0);
+
+size_t ThreadShard() {
+    thread_local size_t shard = g_next_shard.fetch_add(1, std::memory_order_relaxed) % kShards;
+    return shard;
+}
+
+Header* HeaderOf(void* buffer) {
+    return reinterpret_cast<Header*>(static_cast<uint8_t*>(buffer) - kHeaderBytes);
+}
+
+} // namespace
+
+struct OCRPixelPool {
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::vector<void*> free[kClassCount];
+    };
+
+    Shard shards[kShards];
+    size_t max_cached_bytes;
+    std::atomic<size_t> acquired;
+    std::atomic<size_t> reused;
+    std::atomic<size_t> oversized;
+    std::atomic<size_t> in_use_bytes;
+    std::atomic<size_t> cached_bytes;
+    std::atomic<size_t> footprint_bytes;
+    std::atomic<size_t> high_water_bytes;
+    std::atomic<size_t> trimmed_bytes;
+};
+
+namespace {
+
+void* Allocate(OCRPixelPool* pool, uint32_t size_class, size_t capacity) {
+    if (capacity > SIZE_MAX - kHeaderBytes) {
+        return NULL;
+    }
+    void* raw = NULL;
+    if (posix_memalign(&raw, kHeaderBytes, kHeaderBytes + capacity) != 0) {
+        return NULL;
+    }
+    Header* header = static_cast<Header*>(raw);
+    header->magic = kMagic;
+    header->size_class = size_class;
+    header->capacity = capacity;
+    size_t footprint = pool->footprint_bytes.fetch_add(capacity, std::memory_order_relaxed) + capacity;
+    size_t high_water = pool->high_water_bytes.load(std::memory_order_relaxed);
+    while (footprint > high_water &&
+           !pool->high_water_bytes.compare_exchange_weak(high_water, footprint, std::memory_order_relaxed)) {
+    }
+    return static_cast<uint8_t*>(raw) + kHeaderBytes;
+}
+
+void Deallocate(OCRPixelPool* pool, void* buffer) {
+    pool->footprint_bytes.fetch_sub(HeaderOf(buffer)->capacity, std::memory_order_relaxed);
+    free(HeaderOf(buffer));
+}
+
+void* Pop(OCRPixelPool::Shard& shard, size_t size_class) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    std::vector<void*>& list = shard.free[size_class];
+    if (list.empty()) {
+        return NULL;
+    }
+    void* buffer = list.back();
+    list.pop_back();
+    return buffer;
+}
+
+} // namespace
+
+OCRPixelPool* ocr_pixel_pool_create(size_t max_cached_bytes) {
+    OCRPixelPool* pool = new (std::nothrow) OCRPixelPool();
+    if (!pool) {
+        return NULL;
+    }
+    pool->max_cached_bytes = max_cached_bytes;
+    pool->acquired = 0;
+    pool->reused = 0;
+    pool->oversized = 0;
+    pool->in_use_bytes = 0;
+    pool->cached_bytes = 0;
+    pool->footprint_bytes = 0;
+    pool->high_water_bytes = 0;
+    pool->trimmed_bytes = 0;
+    return pool;
+}
+
+void* ocr_pixel_pool_acquire(OCRPixelPool* pool, size_t bytes) {
+    if (!pool) {
+        return NULL;
+    }
+    bytes = std::max(bytes, (size_t)1);
+    void* buffer = NULL;
+    if (bytes > ClassCapacity(kClassCount - 1)) {
+        buffer = Allocate(pool, kOversized, bytes);
+        if (buffer) {
+            pool->oversized.fetch_add(1, std::memory_order_relaxed);
+        }
+    } else {
+        size_t size_class = ClassFor(bytes);
+        size_t own = ThreadShard();
+        for (size_t i = 0; i < kShards && !buffer; i++) {
+            buffer = Pop(pool->shards[(own + i) % kShards], size_class);
+        }
+        if (buffer) {
+            pool->reused.fetch_add(1, std::memory_order_relaxed);
+            pool->cached_bytes.fetch_sub(HeaderOf(buffer)->capacity, std::memory_order_relaxed);
+        } else {
+            buffer = Allocate(pool, (uint32_t)size_class, ClassCapacity(size_class));
+        }
+    }
+    if (!buffer) {
+        return NULL;
+    }
+    pool->acquired.fetch_add(1, std::memory_order_relaxed);
+    pool->in_use_bytes.fetch_add(HeaderOf(buffer)->capacity, std::memory_order_relaxed);
+    return buffer;
+}
+
+void ocr_pixel_pool_release(OCRPixelPool* pool, void* buffer) {
+    if (!pool || !buffer) {
+        return;
+    }
+    Header* header = HeaderOf(buffer);
+    if (header->magic != kMagic) {
+        return;
+    }
+    size_t capacity = header->capacity;
+    pool->in_use_bytes.fetch_sub(capacity, std::memory_order_relaxed);
+    if (header->size_class == kOversized) {
+        Deallocate(pool, buffer);
+        return;
+    }
+
+    // Reserve room in the cache first, so concurrent releases cannot overshoot the limit
+    size_t cached = pool->cached_bytes.load(std::memory_order_relaxed);
+    do {
+        if (capacity > pool->max_cached_bytes || cached > pool->max_cached_bytes - capacity) {
+            Deallocate(pool, buffer);
+            return;
+        }
+    } while (!pool->cached_bytes.compare_exchange_weak(cached, cached + capacity, std::memory_order_relaxed));
+
+    OCRPixelPool::Shard& shard = pool->shards[ThreadShard()];
+    try {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.free[header->size_class].push_back(buffer);
+    } catch (const std::bad_alloc&) {
+        pool->cached_bytes.fetch_sub(capacity, std::memory_order_relaxed);
+        Deallocate(pool, buffer);
+    }
+}
+
+size_t ocr_pixel_pool_trim(OCRPixelPool* pool, size_t keep_bytes) {
+    if (!pool) {
+        return 0;
+    }
+    size_t freed = 0;
+    for (size_t size_class = kClassCount; size_class-- > 0;) {
+        for (OCRPixelPool::Shard& shard : pool->shards) {
+            if (pool->cached_bytes.load(std::memory_order_relaxed) <= keep_bytes) {
+                pool->trimmed_bytes.fetch_add(freed, std::memory_order_relaxed);
+                return freed;
+            }
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            std::vector<void*>& list = shard.free[size_class];
+            while (!list.empty() && pool->cached_bytes.load(std::memory_order_relaxed) > keep_bytes) {
+                void* buffer = list.back();
+                list.pop_back();
+                size_t capacity = HeaderOf(buffer)->capacity;
+                pool->cached_bytes.fetch_sub(capacity, std::memory_order_relaxed);
+                Deallocate(pool, buffer);
+                freed += capacity;
+            }
+            if (list.empty()) {
+                std::vector<void*>().swap(list);
+            }
+        }
+    }
+    pool->trimmed_bytes.fetch_add(freed, std::memory_order_relaxed);
+    return freed;
+}
+
+void ocr_pixel_pool_stats(OCRPixelPool* pool, OCRPixelPoolStats* stats) {
+    if (!stats) {
+        return;
+    }
+    if (!pool) {
+        *stats = OCRPixelPoolStats();
+        return;
+    }
+    stats->acquired = pool->acquired.load(std::memory_order_relaxed);
+    stats->reused = pool->reused.load(std::memory_order_relaxed);
+    stats->oversized = pool->oversized.load(std::memory_order_relaxed);
+    stats->in_use_bytes = pool->in_use_bytes.load(std::memory_order_relaxed);
+    stats->cached_bytes = pool->cached_bytes.load(std::memory_order_relaxed);
+    stats->high_water_bytes = pool->high_water_bytes.load(std::memory_order_relaxed);
+    stats->trimmed_bytes = pool->trimmed_bytes.load(std::memory_order_relaxed);
+}
+
+void ocr_pixel_pool_free(OCRPixelPool* pool) {
+    if (!pool) {
+        return;
+    }
+    ocr_pixel_pool_trim(pool, 0);
+    delete pool;
+}
@@ -0,0 +1,79 @@
+#ifndef MAC_OCR_PIXEL_POOL_H
+#define MAC_OCR_PIXEL_POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Pool of pixel buffers kept in size classes four to a power of two, so a buffer is at
+ * most 25% larger than requested. Released buffers are cached in the releasing thread's
+ * shard and handed back to the next request of the same class, first from the caller's
+ * shard, then from the others
+ */
+typedef struct OCRPixelPool OCRPixelPool;
+
+/**
+ * Pixel pool counters
+ */
+typedef struct {
+    size_t acquired;            // buffers handed out
+    size_t reused;              // buffers handed out from the cache instead of allocated
+    size_t oversized;           // requests above the largest class, allocated and freed directly
+    size_t in_use_bytes;        // bytes of buffers handed out and not yet released
+    size_t cached_bytes;        // bytes of released buffers kept for reuse
+    size_t high_water_bytes;    // most in-use and cached bytes at once
+    size_t trimmed_bytes;       // cached bytes freed by ocr_pixel_pool_trim
+} OCRPixelPoolStats;
+
+/**
+ * Create a pixel pool
+ * @param max_cached_bytes most bytes kept for reuse; released buffers beyond it are freed
+ * @return pool, NULL if memory allocation fails
+ */
+OCRPixelPool* ocr_pixel_pool_create(size_t max_cached_bytes);
+
+/**
+ * Take a buffer of at least bytes, aligned to 64 bytes
+ * @param pool pixel pool
+ * @param bytes bytes needed
+ * @return buffer with undefined contents, NULL if memory allocation fails
+ */
+void* ocr_pixel_pool_acquire(OCRPixelPool* pool, size_t bytes);
+
+/**
+ * Return a buffer taken by ocr_pixel_pool_acquire; may be called from any thread
+ * @param pool the pool the buffer was taken from
+ * @param buffer buffer, may be NULL
+ */
+void ocr_pixel_pool_release(OCRPixelPool* pool, void* buffer);
+
+/**
+ * Free cached buffers, largest first, until at most keep_bytes stay cached
+ * @param pool pixel pool
+ * @param keep_bytes cached bytes to keep, 0 to free every cached buffer
+ * @return bytes freed
+ */
+size_t ocr_pixel_pool_trim(OCRPixelPool* pool, size_t keep_bytes);
+
+/**
+ * Read the pool counters
+ * @param pool pixel pool
+ * @param stats pointer to receive the counters
+ */
+void ocr_pixel_pool_stats(OCRPixelPool* pool, OCRPixelPoolStats* stats);
+
+/**
+ * Free a pixel pool and its cached buffers; every buffer must have been released
+ * @param pool pixel pool, may be NULL
+ */
+void ocr_pixel_pool_free(OCRPixelPool* pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MAC_OCR_PIXEL_POOL_H
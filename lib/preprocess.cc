@@ -0,0 +1,294 @@
+#include "preprocess.h"
+
+#include <algorithm>
+#include <new>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+// Integer BT.601 luma weights scaled by 256, the same as the perceptual hash
+const uint32_t kRedWeight = 77;
+const uint32_t kGreenWeight = 150;
+const uint32_t kBlueWeight = 29;
+
+// Resize weights are coverage fractions in 8.8 fixed point
+const uint32_t kWeightOne = 256;
+
+inline uint8_t Luma(const uint8_t* p) {
+    return (uint8_t)((kRedWeight * p[0] + kGreenWeight * p[1] + kBlueWeight * p[2] + 128) >> 8);
+}
+
+#if defined(__AVX2__) || defined(__SSE2__)
+// Luma of 4 pixels, one per 32-bit lane; each channel is masked into the low half of
+// its lane so madd multiplies it by its weight without crossing into the next pixel
+inline __m128i Luma4(__m128i px) {
+    const __m128i byte_mask = _mm_set1_epi32(0xFF);
+    __m128i r = _mm_and_si128(px, byte_mask);
+    __m128i g = _mm_and_si128(_mm_srli_epi32(px, 8), byte_mask);
+    __m128i b = _mm_and_si128(_mm_srli_epi32(px, 16), byte_mask);
+    __m128i luma = _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(r, _mm_set1_epi32(kRedWeight)),
+                                               _mm_madd_epi16(g, _mm_set1_epi32(kGreenWeight))),
+                                 _mm_add_epi32(_mm_madd_epi16(b, _mm_set1_epi32(kBlueWeight)), _mm_set1_epi32(128)));
+    return _mm_srli_epi32(luma, 8);
+}
+#endif
+
+#if defined(__AVX2__)
+inline __m256i Luma8(__m256i px) {
+    const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+    __m256i r = _mm256_and_si256(px, byte_mask);
+    __m256i g = _mm256_and_si256(_mm256_srli_epi32(px, 8), byte_mask);
+    __m256i b = _mm256_and_si256(_mm256_srli_epi32(px, 16), byte_mask);
+    __m256i luma = _mm256_add_epi32(_mm256_add_epi32(_mm256_madd_epi16(r, _mm256_set1_epi32(kRedWeight)),
+                                                     _mm256_madd_epi16(g, _mm256_set1_epi32(kGreenWeight))),
+                                    _mm256_add_epi32(_mm256_madd_epi16(b, _mm256_set1_epi32(kBlueWeight)),
+                                                     _mm256_set1_epi32(128)));
+    return _mm256_srli_epi32(luma, 8);
+}
+#endif
+
+void GrayRow(const uint8_t* rgba, uint8_t* gray, size_t width) {
+    size_t x = 0;
+#if defined(__AVX2__)
+    // Packing works within 128-bit lanes; the permute puts the 4-pixel groups back in order
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    for (; x + 32 <= width; x += 32) {
+        __m256i l0 = Luma8(_mm256_loadu_si256((const __m256i*)(rgba + x * 4)));
+        __m256i l1 = Luma8(_mm256_loadu_si256((const __m256i*)(rgba + x * 4 + 32)));
+        __m256i l2 = Luma8(_mm256_loadu_si256((const __m256i*)(rgba + x * 4 + 64)));
+        __m256i l3 = Luma8(_mm256_loadu_si256((const __m256i*)(rgba + x * 4 + 96)));
+        __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(l0, l1), _mm256_packs_epi32(l2, l3));
+        _mm256_storeu_si256((__m256i*)(gray + x), _mm256_permutevar8x32_epi32(packed, order));
+    }
+#endif
+#if defined(__AVX2__) || defined(__SSE2__)
+    for (; x + 16 <= width; x += 16) {
+        __m128i l0 = Luma4(_mm_loadu_si128((const __m128i*)(rgba + x * 4)));
+        __m128i l1 = Luma4(_mm_loadu_si128((const __m128i*)(rgba + x * 4 + 16)));
+        __m128i l2 = Luma4(_mm_loadu_si128((const __m128i*)(rgba + x * 4 + 32)));
+        __m128i l3 = Luma4(_mm_loadu_si128((const __m128i*)(rgba + x * 4 + 48)));
+        __m128i packed = _mm_packus_epi16(_mm_packs_epi32(l0, l1), _mm_packs_epi32(l2, l3));
+        _mm_storeu_si128((__m128i*)(gray + x), packed);
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint8x8_t red = vdup_n_u8((uint8_t)kRedWeight);
+    const uint8x8_t green = vdup_n_u8((uint8_t)kGreenWeight);
+    const uint8x8_t blue = vdup_n_u8((uint8_t)kBlueWeight);
+    for (; x + 16 <= width; x += 16) {
+        uint8x16x4_t px = vld4q_u8(rgba + x * 4);
+        uint16x8_t lo = vmull_u8(vget_low_u8(px.val[0]), red);
+        lo = vmlal_u8(lo, vget_low_u8(px.val[1]), green);
+        lo = vmlal_u8(lo, vget_low_u8(px.val[2]), blue);
+        uint16x8_t hi = vmull_u8(vget_high_u8(px.val[0]), red);
+        hi = vmlal_u8(hi, vget_high_u8(px.val[1]), green);
+        hi = vmlal_u8(hi, vget_high_u8(px.val[2]), blue);
+        vst1q_u8(gray + x, vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8)));
+    }
+#endif
+    for (; x < width; x++) {
+        gray[x] = Luma(rgba + x * 4);
+    }
+}
+
+// Source pixels covered by each destination pixel along one axis
+struct Spans {
+    std::vector<size_t> first;      // first covered source pixel
+    std::vector<size_t> offset;     // start of the pixel's weights, count is offset[i + 1] - offset[i]
+    std::vector<uint16_t> weights;  // covered fraction of each source pixel in 8.8 fixed point
+    std::vector<uint32_t> total;    // sum of the pixel's weights
+};
+
+// Destination pixel i covers [i * src, (i + 1) * src) and source pixel k covers
+// [k * dst, (k + 1) * dst), in units of 1 / (src * dst) of the axis, so overlaps are exact
+void BuildSpans(size_t src, size_t dst, Spans* spans) {
+    spans->first.resize(dst);
+    spans->offset.resize(dst + 1);
+    spans->total.resize(dst);
+    spans->weights.clear();
+    spans->weights.reserve(dst * (src / dst + 2));
+    for (size_t i = 0; i < dst; i++) {
+        size_t begin = i * src;
+        size_t end = begin + src;
+        spans->first[i] = begin / dst;
+        spans->offset[i] = spans->weights.size();
+        uint32_t total = 0;
+        for (size_t k = begin / dst; k * dst < end; k++) {
+            size_t overlap = std::min(end, (k + 1) * dst) - std::max(begin, k * dst);
+            uint16_t weight = (uint16_t)((overlap * kWeightOne + dst / 2) / dst);
+            spans->weights.push_back(weight);
+            total += weight;
+        }
+        spans->total[i] = std::max(total, 1u);
+    }
+    spans->offset[dst] = spans->weights.size();
+}
+
+// acc[x] += row[x] * weight, with weight at most kWeightOne
+void AccumulateWeightedRow(const uint8_t* row, uint16_t weight, uint32_t* acc, size_t width) {
+    size_t x = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i w = _mm_set1_epi16((short)weight);
+    for (; x + 16 <= width; x += 16) {
+        __m128i px = _mm_loadu_si128((const __m128i*)(row + x));
+        // 255 * 256 still fits an unsigned 16-bit product
+        __m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(px, zero), w);
+        __m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(px, zero), w);
+        __m128i* out = (__m128i*)(acc + x);
+        _mm_storeu_si128(out, _mm_add_epi32(_mm_loadu_si128(out), _mm_unpacklo_epi16(lo, zero)));
+        _mm_storeu_si128(out + 1, _mm_add_epi32(_mm_loadu_si128(out + 1), _mm_unpackhi_epi16(lo, zero)));
+        _mm_storeu_si128(out + 2, _mm_add_epi32(_mm_loadu_si128(out + 2), _mm_unpacklo_epi16(hi, zero)));
+        _mm_storeu_si128(out + 3, _mm_add_epi32(_mm_loadu_si128(out + 3), _mm_unpackhi_epi16(hi, zero)));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; x + 16 <= width; x += 16) {
+        uint8x16_t px = vld1q_u8(row + x);
+        uint16x8_t lo = vmovl_u8(vget_low_u8(px));
+        uint16x8_t hi = vmovl_u8(vget_high_u8(px));
+        vst1q_u32(acc + x, vmlal_n_u16(vld1q_u32(acc + x), vget_low_u16(lo), weight));
+        vst1q_u32(acc + x + 4, vmlal_n_u16(vld1q_u32(acc + x + 4), vget_high_u16(lo), weight));
+        vst1q_u32(acc + x + 8, vmlal_n_u16(vld1q_u32(acc + x + 8), vget_low_u16(hi), weight));
+        vst1q_u32(acc + x + 12, vmlal_n_u16(vld1q_u32(acc + x + 12), vget_high_u16(hi), weight));
+    }
+#endif
+    for (; x < width; x++) {
+        acc[x] += (uint32_t)row[x] * weight;
+    }
+}
+
+// out = saturate((sat_sub(p, low) * scale) >> 8), scale in 8.8 fixed point
+void StretchRow(uint8_t* row, size_t width, uint8_t low, uint16_t scale) {
+    size_t x = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lo_level = _mm_set1_epi8((char)low);
+    const __m128i s = _mm_set1_epi16((short)scale);
+    const __m128i max_level = _mm_set1_epi16(255);
+    for (; x + 16 <= width; x += 16) {
+        __m128i px = _mm_subs_epu8(_mm_loadu_si128((const __m128i*)(row + x)), lo_level);
+        // Unpacking under zero shifts each level left by 8, so the high half of the
+        // 16x16 product is (level * scale) >> 8
+        __m128i lo = _mm_mulhi_epu16(_mm_unpacklo_epi8(zero, px), s);
+        __m128i hi = _mm_mulhi_epu16(_mm_unpackhi_epi8(zero, px), s);
+        // packus saturates signed words, so products above 32767 would pack to 0; clamp
+        // unsigned to 255 first, as min(x, 255) = x - sat_sub(x, 255)
+        lo = _mm_sub_epi16(lo, _mm_subs_epu16(lo, max_level));
+        hi = _mm_sub_epi16(hi, _mm_subs_epu16(hi, max_level));
+        _mm_storeu_si128((__m128i*)(row + x), _mm_packus_epi16(lo, hi));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint8x16_t lo_level = vdupq_n_u8(low);
+    for (; x + 16 <= width; x += 16) {
+        uint8x16_t px = vqsubq_u8(vld1q_u8(row + x), lo_level);
+        uint16x8_t lo = vmovl_u8(vget_low_u8(px));
+        uint16x8_t hi = vmovl_u8(vget_high_u8(px));
+        uint16x8_t slo = vcombine_u16(vshrn_n_u32(vmull_n_u16(vget_low_u16(lo), scale), 8),
+                                      vshrn_n_u32(vmull_n_u16(vget_high_u16(lo), scale), 8));
+        uint16x8_t shi = vcombine_u16(vshrn_n_u32(vmull_n_u16(vget_low_u16(hi), scale), 8),
+                                      vshrn_n_u32(vmull_n_u16(vget_high_u16(hi), scale), 8));
+        vst1q_u8(row + x, vcombine_u8(vqmovn_u16(slo), vqmovn_u16(shi)));
+    }
+#endif
+    for (; x < width; x++) {
+        uint32_t level = row[x] > low ? row[x] - low : 0;
+        row[x] = (uint8_t)std::min(255u, (level * scale) >> 8);
+    }
+}
+
+} // namespace
+
+void ocr_rgba_to_gray(const uint8_t* rgba, size_t width, size_t height, size_t src_bytes_per_row,
+                      uint8_t* gray, size_t dst_bytes_per_row) {
+    if (!rgba || !gray) {
+        return;
+    }
+    for (size_t y = 0; y < height; y++) {
+        GrayRow(rgba + y * src_bytes_per_row, gray + y * dst_bytes_per_row, width);
+    }
+}
+
+bool ocr_resize_area(const uint8_t* src, size_t src_width, size_t src_height, size_t src_bytes_per_row,
+                     uint8_t* dst, size_t dst_width, size_t dst_height, size_t dst_bytes_per_row) {
+    if (!src || !dst || dst_width == 0 || dst_height == 0 || dst_width > src_width || dst_height > src_height) {
+        return false;
+    }
+    Spans columns, rows;
+    std::vector<uint32_t> acc;
+    try {
+        BuildSpans(src_width, dst_width, &columns);
+        BuildSpans(src_height, dst_height, &rows);
+        acc.resize(src_width);
+    } catch (const std::bad_alloc&) {
+        return false;
+    }
+
+    for (size_t i = 0; i < dst_height; i++) {
+        // Weighted sum of the covered source rows, then of the covered columns
+        std::fill(acc.begin(), acc.end(), 0);
+        for (size_t k = 0; k < rows.offset[i + 1] - rows.offset[i]; k++) {
+            const uint8_t* row = src + (rows.first[i] + k) * src_bytes_per_row;
+            AccumulateWeightedRow(row, rows.weights[rows.offset[i] + k], acc.data(), src_width);
+        }
+        uint8_t* out = dst + i * dst_bytes_per_row;
+        for (size_t j = 0; j < dst_width; j++) {
+            uint64_t sum = 0;
+            const uint32_t* column = acc.data() + columns.first[j];
+            const uint16_t* weights = columns.weights.data() + columns.offset[j];
+            for (size_t k = 0; k < columns.offset[j + 1] - columns.offset[j]; k++) {
+                sum += (uint64_t)column[k] * weights[k];
+            }
+            uint64_t total = (uint64_t)rows.total[i] * columns.total[j];
+            out[j] = (uint8_t)std::min<uint64_t>(255, (sum + total / 2) / total);
+        }
+    }
+    return true;
+}
+
+bool ocr_normalize_contrast(uint8_t* gray, size_t width, size_t height, size_t bytes_per_row, double clip) {
+    if (!gray || width == 0 || height == 0) {
+        return false;
+    }
+    // Four interleaved histograms avoid stalls when neighbouring pixels share a level
+    uint32_t histograms[4][256] = {};
+    for (size_t y = 0; y < height; y++) {
+        const uint8_t* row = gray + y * bytes_per_row;
+        size_t x = 0;
+        for (; x + 4 <= width; x += 4) {
+            histograms[0][row[x]]++;
+            histograms[1][row[x + 1]]++;
+            histograms[2][row[x + 2]]++;
+            histograms[3][row[x + 3]]++;
+        }
+        for (; x < width; x++) {
+            histograms[0][row[x]]++;
+        }
+    }
+    uint64_t histogram[256];
+    for (int level = 0; level < 256; level++) {
+        histogram[level] = (uint64_t)histograms[0][level] + histograms[1][level] + histograms[2][level] + histograms[3][level];
+    }
+
+    uint64_t clipped = (uint64_t)(std::clamp(clip, 0.0, 0.5) * width * height);
+    int low = 0;
+    for (uint64_t below = histogram[0]; low < 255 && below <= clipped; below += histogram[++low]) {
+    }
+    int high = 255;
+    for (uint64_t above = histogram[255]; high > 0 && above <= clipped; above += histogram[--high]) {
+    }
+    if (high <= low) {
+        return false;
+    }
+    uint16_t scale = (uint16_t)((255 * 256 + (high - low) / 2) / (high - low));
+    for (size_t y = 0; y < height; y++) {
+        StretchRow(gray + y * bytes_per_row, width, (uint8_t)low, scale);
+    }
+    return true;
+}
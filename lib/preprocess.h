@@ -0,0 +1,61 @@
+#ifndef MAC_OCR_PREPROCESS_H
+#define MAC_OCR_PREPROCESS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Convert 32-bit RGBA or RGBX pixels to 8-bit luminance
+ * Uses integer BT.601 weights (77, 150, 29) / 256 with rounding, 16 pixels per SSE2/NEON
+ * step or 32 per AVX2 step, and gives the same result on every path
+ * @param rgba source pixels
+ * @param width image width in pixels
+ * @param height image height in pixels
+ * @param src_bytes_per_row distance between source rows in bytes
+ * @param gray destination pixels
+ * @param dst_bytes_per_row distance between destination rows in bytes
+ */
+void ocr_rgba_to_gray(const uint8_t* rgba, size_t width, size_t height, size_t src_bytes_per_row,
+                      uint8_t* gray, size_t dst_bytes_per_row);
+
+/**
+ * Downscale an 8-bit image by area averaging
+ * Every destination pixel is the mean of the source area it covers, weighted by the
+ * covered fraction of each source pixel. Rows are accumulated in SIMD, columns are
+ * reduced with precomputed spans
+ * @param src source pixels
+ * @param src_width source width in pixels
+ * @param src_height source height in pixels
+ * @param src_bytes_per_row distance between source rows in bytes
+ * @param dst destination pixels
+ * @param dst_width destination width, 1 to src_width
+ * @param dst_height destination height, 1 to src_height
+ * @param dst_bytes_per_row distance between destination rows in bytes
+ * @return true on success, false on invalid sizes or if memory allocation fails
+ */
+bool ocr_resize_area(const uint8_t* src, size_t src_width, size_t src_height, size_t src_bytes_per_row,
+                     uint8_t* dst, size_t dst_width, size_t dst_height, size_t dst_bytes_per_row);
+
+/**
+ * Stretch the contrast of an 8-bit image in place
+ * The levels below which and above which clip of the pixels lie are mapped to 0 and
+ * 255, so faded scans and low-contrast screenshots use the full range
+ * @param gray pixels
+ * @param width image width in pixels
+ * @param height image height in pixels
+ * @param bytes_per_row distance between rows in bytes
+ * @param clip share of pixels clipped at each end, 0.0-0.5
+ * @return true if the image was stretched, false if it is uniform and was left as is
+ */
+bool ocr_normalize_contrast(uint8_t* gray, size_t width, size_t height, size_t bytes_per_row, double clip);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MAC_OCR_PREPROCESS_H
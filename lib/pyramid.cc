@@ -0,0 +1,151 @@
+#include "pyramid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+#include "region_util.h"
+
+using ocr::FreeObservation;
+using ocr::MergeRegions;
+using ocr::Rect;
+
+namespace {
+
+// Boxes found on a downscaled copy are loose, so margins are in multiples of the
+// observation height with a floor in full-resolution pixels
+const double kHorizontalMarginRatio = 1.0;
+const double kVerticalMarginRatio = 0.5;
+const double kMinMarginPixels = 16.0;
+const double kMaxCoveredShare = 0.6;  // image share covered by crops that recognizes the whole image instead
+const size_t kMaxRegions = 48;         // each crop pays Vision's fixed per-request cost
+
+void FreeRegionObservations(TextObservation** region_observations, const size_t* region_counts, size_t from,
+                            size_t region_count) {
+    for (size_t r = from; r < region_count; r++) {
+        ocr_observations_free(region_observations[r], region_counts[r]);
+        region_observations[r] = NULL;
+    }
+}
+
+} // namespace
+
+bool ocr_pyramid_plan(const TextObservation* detected, size_t detected_count, size_t image_width,
+                      size_t image_height, OCRRegion** regions, size_t* region_count, double* covered_area) {
+    if ((!detected && detected_count > 0) || image_width == 0 || image_height == 0 || !regions || !region_count) {
+        return false;
+    }
+    *regions = NULL;
+    *region_count = 0;
+    if (covered_area) *covered_area = 0.0;
+    if (detected_count == 0) {
+        return true;
+    }
+
+    const double width = (double)image_width;
+    const double height = (double)image_height;
+    std::vector<Rect> planned;
+    try {
+        std::vector<Rect> grown;
+        grown.reserve(detected_count);
+        for (size_t i = 0; i < detected_count; i++) {
+            const TextObservation& obs = detected[i];
+            // The height is a fraction of the image height; scaled to a fraction of its width,
+            // the side margin is as many pixels as the ratio says on any aspect ratio
+            double dx = std::max(obs.height * height / width * kHorizontalMarginRatio, kMinMarginPixels / width);
+            double dy = std::max(obs.height * kVerticalMarginRatio, kMinMarginPixels / height);
+            // Snapped outwards to whole pixels, so crops map back without rounding error
+            Rect rect = {std::floor(std::max(0.0, obs.x - dx) * width) / width,
+                         std::floor(std::max(0.0, obs.y - dy) * height) / height,
+                         std::ceil(std::min(1.0, obs.x + obs.width + dx) * width) / width,
+                         std::ceil(std::min(1.0, obs.y + obs.height + dy) * height) / height};
+            if (rect.right > rect.left && rect.top > rect.bottom) {
+                grown.push_back(rect);
+            }
+        }
+        planned = MergeRegions(grown);
+    } catch (const std::bad_alloc&) {
+        return false;
+    }
+    if (planned.empty()) {
+        return true;
+    }
+
+    double area = 0.0;
+    for (const Rect& rect : planned) {
+        area += (rect.right - rect.left) * (rect.top - rect.bottom);
+    }
+    if (area > kMaxCoveredShare || planned.size() > kMaxRegions) {
+        planned.assign(1, Rect{0.0, 0.0, 1.0, 1.0});
+        area = 1.0;
+    }
+
+    *regions = static_cast<OCRRegion*>(malloc(sizeof(OCRRegion) * planned.size()));
+    if (!*regions) {
+        return false;
+    }
+    for (size_t i = 0; i < planned.size(); i++) {
+        const Rect& rect = planned[i];
+        (*regions)[i] = {rect.left, rect.bottom, rect.right - rect.left, rect.top - rect.bottom};
+    }
+    *region_count = planned.size();
+    if (covered_area) *covered_area = area;
+    return true;
+}
+
+bool ocr_pyramid_merge(const OCRRegion* regions, size_t region_count, TextObservation** region_observations,
+                       const size_t* region_counts, double min_box_size, TextObservation** observations,
+                       size_t* count, size_t* dropped_count) {
+    if (!observations || !count || (region_count > 0 && (!regions || !region_observations || !region_counts))) {
+        return false;
+    }
+    *observations = NULL;
+    *count = 0;
+    size_t total = 0;
+    for (size_t r = 0; r < region_count; r++) {
+        total += region_observations[r] ? region_counts[r] : 0;
+    }
+    if (total > 0) {
+        *observations = static_cast<TextObservation*>(malloc(sizeof(TextObservation) * total));
+        if (!*observations) {
+            FreeRegionObservations(region_observations, region_counts, 0, region_count);
+            return false;
+        }
+    }
+
+    size_t kept = 0;
+    size_t dropped = 0;
+    for (size_t r = 0; r < region_count; r++) {
+        TextObservation* crop = region_observations[r];
+        if (!crop) {
+            continue;
+        }
+        const OCRRegion& region = regions[r];
+        for (size_t i = 0; i < region_counts[r]; i++) {
+            TextObservation obs = crop[i];
+            obs.x = region.x + obs.x * region.width;
+            obs.y = region.y + obs.y * region.height;
+            obs.width *= region.width;
+            obs.height *= region.height;
+            if (obs.width < min_box_size || obs.height < min_box_size) {
+                FreeObservation(obs);
+                dropped++;
+                continue;
+            }
+            (*observations)[kept++] = obs;
+        }
+        free(crop);
+        region_observations[r] = NULL;
+    }
+
+    if (kept == 0) {
+        free(*observations);
+        *observations = NULL;
+    }
+    *count = kept;
+    if (dropped_count) *dropped_count = dropped;
+    return true;
+}
@@ -0,0 +1,63 @@
+#ifndef MAC_OCR_PYRAMID_H
+#define MAC_OCR_PYRAMID_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "ocr_types.h"
+#include "cascade.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * What a pyramid recognition detected and recognized
+ */
+typedef struct {
+    bool applied;               // the image was recognized as a pyramid
+    size_t detected_count;      // observations found on the downscaled image
+    size_t region_count;        // crops recognized at full resolution
+    double covered_area;        // share of the image area recognized at full resolution
+} OCRPyramidStats;
+
+/**
+ * Plan the full-resolution crops for observations detected on a downscaled copy
+ * Each observation is grown by a margin, overlapping boxes are merged and the
+ * result is snapped outwards to whole pixels of the full image, so a crop maps
+ * back exactly. When the crops would cover most of the image, or there would be
+ * many of them, a single whole-image region is returned instead, since one
+ * full pass is then cheaper
+ * @param detected observations in normalized whole-image coordinates
+ * @param detected_count number of observations
+ * @param image_width full image width in pixels
+ * @param image_height full image height in pixels
+ * @param regions receives a malloc'd region array, NULL when nothing was detected
+ * @param region_count receives the number of regions
+ * @param covered_area receives the share of the image covered by the regions, can be NULL
+ * @return true on success, false on invalid parameters or if memory allocation fails
+ */
+bool ocr_pyramid_plan(const TextObservation* detected, size_t detected_count, size_t image_width,
+                      size_t image_height, OCRRegion** regions, size_t* region_count, double* covered_area);
+
+/**
+ * Map the observations of each crop back to whole-image coordinates and join them
+ * Takes ownership of every per-region array, including on failure
+ * @param regions regions from ocr_pyramid_plan
+ * @param region_count number of regions
+ * @param region_observations per-region malloc'd arrays in crop-relative coordinates, entries can be NULL
+ * @param region_counts per-region observation counts
+ * @param min_box_size drop mapped observations narrower or shorter than this, 0.0 keeps all
+ * @param observations receives the joined malloc'd array, NULL when empty
+ * @param count receives the number of observations
+ * @param dropped_count receives the number of observations dropped by min_box_size, can be NULL
+ * @return true on success, false if memory allocation fails
+ */
+bool ocr_pyramid_merge(const OCRRegion* regions, size_t region_count, TextObservation** region_observations,
+                       const size_t* region_counts, double min_box_size, TextObservation** observations,
+                       size_t* count, size_t* dropped_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MAC_OCR_PYRAMID_H
@@ -0,0 +1,42 @@
+#include "region_util.h"
+
+#include <cstdlib>
+
+namespace ocr {
+
+Rect BoxOf(const TextObservation& obs) {
+    return {obs.x, obs.y, obs.x + obs.width, obs.y + obs.height};
+}
+
+std::vector<Rect> MergeRegions(std::vector<Rect> rects) {
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        std::vector<Rect> out;
+        for (const Rect& rect : rects) {
+            Rect current = rect;
+            for (size_t i = 0; i < out.size();) {
+                if (out[i].Overlaps(current)) {
+                    current.Include(out[i]);
+                    out.erase(out.begin() + i);
+                    merged = true;
+                } else {
+                    i++;
+                }
+            }
+            out.push_back(current);
+        }
+        rects.swap(out);
+    }
+    return rects;
+}
+
+void FreeObservation(TextObservation& obs) {
+    free((void*)obs.text);
+    for (size_t c = 0; c < obs.candidate_count; c++) {
+        free((void*)obs.candidates[c].text);
+    }
+    free(obs.candidates);
+}
+
+} // namespace ocr
@@ -0,0 +1,67 @@
+#ifndef MAC_OCR_REGION_UTIL_H
+#define MAC_OCR_REGION_UTIL_H
+
+// Rectangle helpers shared by the cascade, frame diff and pyramid planners; C++ only
+
+#include <algorithm>
+#include <vector>
+
+#include "ocr_types.h"
+
+namespace ocr {
+
+/**
+ * Rectangle in normalized coordinates (bottom-left origin)
+ */
+struct Rect {
+    double left;
+    double bottom;
+    double right;
+    double top;
+
+    // Touching edges count, so adjacent regions merge into one
+    bool Overlaps(const Rect& other) const {
+        return left <= other.right && other.left <= right && bottom <= other.top && other.bottom <= top;
+    }
+
+    // Touching edges do not count, so a word next to a region is carried forward
+    bool Intersects(const Rect& other) const {
+        return left < other.right && other.left < right && bottom < other.top && other.bottom < top;
+    }
+
+    bool ContainsCenterOf(const TextObservation& obs) const {
+        double cx = obs.x + obs.width * 0.5;
+        double cy = obs.y + obs.height * 0.5;
+        return cx >= left && cx <= right && cy >= bottom && cy <= top;
+    }
+
+    void Include(const Rect& other) {
+        left = std::min(left, other.left);
+        bottom = std::min(bottom, other.bottom);
+        right = std::max(right, other.right);
+        top = std::max(top, other.top);
+    }
+};
+
+/**
+ * Bounding box of an observation
+ */
+Rect BoxOf(const TextObservation& obs);
+
+/**
+ * Merge overlapping rectangles until none overlap
+ * Quadratic in the number of rectangles; callers pass tens, not thousands
+ * @param rects rectangles to merge
+ * @return disjoint rectangles covering the input
+ * @throws std::bad_alloc
+ */
+std::vector<Rect> MergeRegions(std::vector<Rect> rects);
+
+/**
+ * Free the text and candidates of one observation, not the observation itself
+ */
+void FreeObservation(TextObservation& obs);
+
+} // namespace ocr
+
+#endif // MAC_OCR_REGION_UTIL_H
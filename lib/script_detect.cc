@@ -0,0 +1,182 @@
+#include "script_detect.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+
+namespace {
+
+struct Range {
+    uint32_t first;
+    uint32_t last;
+    unsigned script;
+};
+
+// Letter blocks per script, sorted by first code point
+const Range kRanges[] = {
+    {0x0041, 0x005A, OCR_SCRIPT_LATIN},    {0x0061, 0x007A, OCR_SCRIPT_LATIN},
+    {0x00C0, 0x00D6, OCR_SCRIPT_LATIN},    {0x00D8, 0x00F6, OCR_SCRIPT_LATIN},
+    {0x00F8, 0x024F, OCR_SCRIPT_LATIN},    {0x0400, 0x052F, OCR_SCRIPT_CYRILLIC},
+    {0x0600, 0x06FF, OCR_SCRIPT_ARABIC},   {0x0750, 0x077F, OCR_SCRIPT_ARABIC},
+    {0x0E00, 0x0E7F, OCR_SCRIPT_THAI},     {0x1100, 0x11FF, OCR_SCRIPT_HANGUL},
+    {0x1E00, 0x1EFF, OCR_SCRIPT_LATIN},    {0x3040, 0x30FF, OCR_SCRIPT_KANA},
+    {0x3130, 0x318F, OCR_SCRIPT_HANGUL},   {0x31F0, 0x31FF, OCR_SCRIPT_KANA},
+    {0x3400, 0x4DBF, OCR_SCRIPT_HAN},      {0x4E00, 0x9FFF, OCR_SCRIPT_HAN},
+    {0xAC00, 0xD7AF, OCR_SCRIPT_HANGUL},   {0xF900, 0xFAFF, OCR_SCRIPT_HAN},
+    {0xFB50, 0xFDFF, OCR_SCRIPT_ARABIC},   {0xFE70, 0xFEFF, OCR_SCRIPT_ARABIC},
+    {0xFF21, 0xFF3A, OCR_SCRIPT_LATIN},    {0xFF41, 0xFF5A, OCR_SCRIPT_LATIN},
+    {0xFF66, 0xFF9F, OCR_SCRIPT_KANA},     {0x20000, 0x2FA1F, OCR_SCRIPT_HAN},
+};
+
+unsigned ScriptOf(uint32_t code_point) {
+    // Most recognized text is ASCII
+    if (code_point < 0x80) {
+        return (code_point | 0x20) - 'a' < 26 ? OCR_SCRIPT_LATIN : 0;
+    }
+    size_t low = 0;
+    size_t high = sizeof(kRanges) / sizeof(kRanges[0]);
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        if (code_point > kRanges[mid].last) {
+            low = mid + 1;
+        } else if (code_point < kRanges[mid].first) {
+            high = mid;
+        } else {
+            return kRanges[mid].script;
+        }
+    }
+    return 0;
+}
+
+int BitIndex(unsigned script) {
+    int index = 0;
+    while (script > 1) {
+        script >>= 1;
+        index++;
+    }
+    return index;
+}
+
+// Decode one UTF-8 sequence; returns the number of bytes consumed, with
+// *code_point set to UINT32_MAX for a malformed sequence
+size_t Decode(const unsigned char* s, uint32_t* code_point) {
+    unsigned char lead = s[0];
+    size_t length;
+    uint32_t value;
+    if (lead < 0x80) {
+        *code_point = lead;
+        return 1;
+    } else if ((lead & 0xE0) == 0xC0) {
+        length = 2;
+        value = lead & 0x1F;
+    } else if ((lead & 0xF0) == 0xE0) {
+        length = 3;
+        value = lead & 0x0F;
+    } else if ((lead & 0xF8) == 0xF0) {
+        length = 4;
+        value = lead & 0x07;
+    } else {
+        *code_point = UINT32_MAX;
+        return 1;
+    }
+    for (size_t i = 1; i < length; i++) {
+        if ((s[i] & 0xC0) != 0x80) {
+            *code_point = UINT32_MAX;
+            return i;
+        }
+        value = (value << 6) | (s[i] & 0x3F);
+    }
+    *code_point = value;
+    return length;
+}
+
+} // namespace
+
+void ocr_script_count(const char* utf8, OCRScriptHistogram* histogram) {
+    if (!utf8 || !histogram) {
+        return;
+    }
+    const unsigned char* s = reinterpret_cast<const unsigned char*>(utf8);
+    while (*s) {
+        uint32_t code_point;
+        s += Decode(s, &code_point);
+        unsigned script = code_point == UINT32_MAX ? 0 : ScriptOf(code_point);
+        if (script) {
+            histogram->counts[BitIndex(script)]++;
+            histogram->total++;
+        }
+    }
+}
+
+unsigned ocr_script_detect(const OCRScriptHistogram* histogram, double min_share) {
+    if (!histogram || histogram->total == 0) {
+        return 0;
+    }
+    unsigned scripts = 0;
+    for (int i = 0; i < OCR_SCRIPT_COUNT; i++) {
+        size_t count = histogram->counts[i];
+        if (count > 0 && count >= min_share * histogram->total) {
+            scripts |= 1u << i;
+        }
+    }
+    return scripts;
+}
+
+unsigned ocr_language_script(const char* language) {
+    if (!language) {
+        return OCR_SCRIPT_LATIN;
+    }
+    size_t length = strcspn(language, "-_");
+    struct Prefix {
+        const char* tag;
+        unsigned script;
+    };
+    static const Prefix kPrefixes[] = {
+        {"zh", OCR_SCRIPT_HAN},      {"yue", OCR_SCRIPT_HAN},     {"ja", OCR_SCRIPT_KANA},
+        {"ko", OCR_SCRIPT_HANGUL},   {"ru", OCR_SCRIPT_CYRILLIC}, {"uk", OCR_SCRIPT_CYRILLIC},
+        {"be", OCR_SCRIPT_CYRILLIC}, {"bg", OCR_SCRIPT_CYRILLIC}, {"ar", OCR_SCRIPT_ARABIC},
+        {"ars", OCR_SCRIPT_ARABIC},  {"th", OCR_SCRIPT_THAI},
+    };
+    for (const Prefix& prefix : kPrefixes) {
+        if (strlen(prefix.tag) == length && strncmp(language, prefix.tag, length) == 0) {
+            return prefix.script;
+        }
+    }
+    return OCR_SCRIPT_LATIN;
+}
+
+bool ocr_route_languages(const char* languages, unsigned scripts, char** routed) {
+    if (!languages || !routed) {
+        return false;
+    }
+    *routed = NULL;
+    // Kanji in Japanese text is not evidence of Chinese
+    unsigned han_scripts = scripts & OCR_SCRIPT_KANA ? 0 : scripts & OCR_SCRIPT_HAN;
+    std::string kept;
+    try {
+        const char* cursor = languages;
+        while (*cursor) {
+            size_t length = strcspn(cursor, ",");
+            std::string language(cursor, length);
+            size_t begin = language.find_first_not_of(" \t");
+            size_t end = language.find_last_not_of(" \t");
+            if (begin != std::string::npos) {
+                language = language.substr(begin, end - begin + 1);
+                unsigned script = ocr_language_script(language.c_str());
+                bool match = script == OCR_SCRIPT_HAN ? han_scripts != 0 : (scripts & script) != 0;
+                if (match) {
+                    if (!kept.empty()) kept += ',';
+                    kept += language;
+                }
+            }
+            cursor += length;
+            if (*cursor == ',') cursor++;
+        }
+    } catch (const std::bad_alloc&) {
+        return false;
+    }
+    *routed = strdup(kept.empty() ? languages : kept.c_str());
+    return *routed != NULL;
+}
@@ -0,0 +1,72 @@
+#ifndef MAC_OCR_SCRIPT_DETECT_H
+#define MAC_OCR_SCRIPT_DETECT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Writing systems that decide which recognition languages an image needs
+ */
+typedef enum {
+    OCR_SCRIPT_LATIN = 1 << 0,
+    OCR_SCRIPT_HAN = 1 << 1,
+    OCR_SCRIPT_KANA = 1 << 2,
+    OCR_SCRIPT_HANGUL = 1 << 3,
+    OCR_SCRIPT_CYRILLIC = 1 << 4,
+    OCR_SCRIPT_ARABIC = 1 << 5,
+    OCR_SCRIPT_THAI = 1 << 6
+} OCRScript;
+
+#define OCR_SCRIPT_COUNT 7
+
+/**
+ * Letters counted per script; digits, punctuation and symbols are not counted
+ */
+typedef struct {
+    size_t counts[OCR_SCRIPT_COUNT];  // indexed by the bit position of the OCRScript
+    size_t total;                     // letters of any counted script
+} OCRScriptHistogram;
+
+/**
+ * Add the letters of a UTF-8 string to a histogram
+ * Malformed sequences are skipped
+ * @param utf8 NUL-terminated text
+ * @param histogram histogram to add to, zero-initialized by the caller
+ */
+void ocr_script_count(const char* utf8, OCRScriptHistogram* histogram);
+
+/**
+ * Scripts that hold at least min_share of the counted letters
+ * @param histogram letter counts
+ * @param min_share share of the letters a script needs, 0.0-1.0
+ * @return mask of OCRScript values, 0 if no letters were counted
+ */
+unsigned ocr_script_detect(const OCRScriptHistogram* histogram, double min_share);
+
+/**
+ * Script a recognition language reads, from its language subtag
+ * @param language BCP 47 tag such as "zh-Hans" or "en-US"
+ * @return a single OCRScript value; unknown languages read Latin
+ */
+unsigned ocr_language_script(const char* language);
+
+/**
+ * Narrow a comma-separated language list to the languages whose script was detected
+ * Chinese needs Han without kana, since Japanese text mixes kanji with kana; Japanese
+ * needs kana. Order is kept. If no configured language matches, the whole list is kept
+ * @param languages comma-separated language list, e.g. "en-US,zh-Hans,ja-JP"
+ * @param scripts mask from ocr_script_detect
+ * @param routed receives the malloc'd narrowed list, free with free()
+ * @return true on success, false on invalid parameters or if memory allocation fails
+ */
+bool ocr_route_languages(const char* languages, unsigned scripts, char** routed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MAC_OCR_SCRIPT_DETECT_H
@@ -0,0 +1,208 @@
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <new>
+#include <queue>
+#include <vector>
+
+namespace {
+
+const size_t kNodeSize = 16;
+
+struct Rect {
+    double min_x;
+    double min_y;
+    double max_x;
+    double max_y;
+
+    bool Intersects(const Rect& other) const {
+        return min_x <= other.max_x && other.min_x <= max_x &&
+               min_y <= other.max_y && other.min_y <= max_y;
+    }
+
+    double DistanceSquared(double x, double y) const {
+        double dx = std::max(std::max(min_x - x, 0.0), x - max_x);
+        double dy = std::max(std::max(min_y - y, 0.0), y - max_y);
+        return dx * dx + dy * dy;
+    }
+
+    void Expand(const Rect& other) {
+        min_x = std::min(min_x, other.min_x);
+        min_y = std::min(min_y, other.min_y);
+        max_x = std::max(max_x, other.max_x);
+        max_y = std::max(max_y, other.max_y);
+    }
+};
+
+struct Candidate {
+    double distance;
+    size_t position;
+    size_t level;
+
+    bool operator>(const Candidate& other) const {
+        return distance > other.distance;
+    }
+};
+
+} // namespace
+
+// Leaves occupy positions [0, count), each following level is appended after
+// the previous one and the root is the last position. For a leaf, `ids` holds
+// the original box id; for a node, the position of its first child.
+struct OCRSpatialIndex {
+    size_t count;
+    std::vector<Rect> rects;
+    std::vector<size_t> ids;
+    std::vector<size_t> level_ends;
+
+    size_t ChildEnd(size_t position, size_t level) const {
+        return std::min(ids[position] + kNodeSize, level_ends[level - 1]);
+    }
+};
+
+OCRSpatialIndex* ocr_spatial_index_create(const double* boxes, size_t count) {
+    if (!boxes && count > 0) {
+        return NULL;
+    }
+
+    try {
+        OCRSpatialIndex* index = new OCRSpatialIndex();
+        index->count = count;
+        if (count == 0) {
+            return index;
+        }
+
+        std::vector<Rect> input(count);
+        std::vector<size_t> order(count);
+        for (size_t i = 0; i < count; i++) {
+            const double* box = boxes + i * 4;
+            input[i] = {box[0], box[1], box[0] + box[2], box[1] + box[3]};
+            order[i] = i;
+        }
+
+        // Sort-Tile-Recursive: vertical slabs by center x, each slab sorted by center y
+        std::sort(order.begin(), order.end(), [&input](size_t a, size_t b) {
+            return input[a].min_x + input[a].max_x < input[b].min_x + input[b].max_x;
+        });
+        size_t leaf_nodes = (count + kNodeSize - 1) / kNodeSize;
+        size_t slab_size = kNodeSize * (size_t)std::ceil(std::sqrt((double)leaf_nodes));
+        for (size_t begin = 0; begin < count; begin += slab_size) {
+            size_t end = std::min(begin + slab_size, count);
+            std::sort(order.begin() + begin, order.begin() + end, [&input](size_t a, size_t b) {
+                return input[a].min_y + input[a].max_y < input[b].min_y + input[b].max_y;
+            });
+        }
+
+        index->rects.reserve(count + count / (kNodeSize - 1) + 2);
+        index->ids.reserve(index->rects.capacity());
+        for (size_t i = 0; i < count; i++) {
+            index->rects.push_back(input[order[i]]);
+            index->ids.push_back(order[i]);
+        }
+        index->level_ends.push_back(count);
+
+        // Pack each level into parents until a single root remains
+        size_t level_begin = 0;
+        do {
+            size_t level_end = index->rects.size();
+            for (size_t child = level_begin; child < level_end; child += kNodeSize) {
+                Rect bounds = index->rects[child];
+                size_t child_end = std::min(child + kNodeSize, level_end);
+                for (size_t i = child + 1; i < child_end; i++) {
+                    bounds.Expand(index->rects[i]);
+                }
+                index->rects.push_back(bounds);
+                index->ids.push_back(child);
+            }
+            index->level_ends.push_back(index->rects.size());
+            level_begin = level_end;
+        } while (index->rects.size() - level_begin > 1);
+
+        return index;
+    } catch (const std::bad_alloc&) {
+        return NULL;
+    }
+}
+
+size_t ocr_spatial_index_count(const OCRSpatialIndex* index) {
+    return index ? index->count : 0;
+}
+
+size_t ocr_spatial_index_query(const OCRSpatialIndex* index, double x, double y, double width, double height,
+                               size_t* out, size_t capacity) {
+    if (!index || index->count == 0) {
+        return 0;
+    }
+
+    Rect query = {x, y, x + width, y + height};
+    size_t found = 0;
+    std::vector<std::pair<size_t, size_t>> stack;
+    try {
+        stack.reserve(index->level_ends.size() * kNodeSize);
+    } catch (const std::bad_alloc&) {
+        return 0;
+    }
+    stack.push_back({index->rects.size() - 1, index->level_ends.size() - 1});
+
+    while (!stack.empty()) {
+        std::pair<size_t, size_t> node = stack.back();
+        stack.pop_back();
+
+        size_t end = index->ChildEnd(node.first, node.second);
+        for (size_t child = index->ids[node.first]; child < end; child++) {
+            if (!query.Intersects(index->rects[child])) {
+                continue;
+            }
+            if (node.second > 1) {
+                stack.push_back({child, node.second - 1});
+            } else {
+                if (out && found < capacity) {
+                    out[found] = index->ids[child];
+                }
+                found++;
+            }
+        }
+    }
+
+    if (out) {
+        std::sort(out, out + std::min(found, capacity));
+    }
+    return found;
+}
+
+size_t ocr_spatial_index_nearest(const OCRSpatialIndex* index, double x, double y, size_t k, size_t* out) {
+    if (!index || index->count == 0 || k == 0 || !out) {
+        return 0;
+    }
+
+    // Best-first search: nodes and leaves share one queue ordered by distance
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> queue;
+    size_t root = index->rects.size() - 1;
+    size_t found = 0;
+    try {
+        queue.push({index->rects[root].DistanceSquared(x, y), root, index->level_ends.size() - 1});
+
+        while (!queue.empty() && found < k) {
+            Candidate candidate = queue.top();
+            queue.pop();
+
+            if (candidate.level == 0) {
+                out[found++] = index->ids[candidate.position];
+                continue;
+            }
+
+            size_t end = index->ChildEnd(candidate.position, candidate.level);
+            for (size_t child = index->ids[candidate.position]; child < end; child++) {
+                queue.push({index->rects[child].DistanceSquared(x, y), child, candidate.level - 1});
+            }
+        }
+    } catch (const std::bad_alloc&) {
+        return found;
+    }
+    return found;
+}
+
+void ocr_spatial_index_free(OCRSpatialIndex* index) {
+    delete index;
+}
@@ -0,0 +1,64 @@
+#ifndef MAC_OCR_SPATIAL_INDEX_H
+#define MAC_OCR_SPATIAL_INDEX_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Static packed R-tree over observation bounding boxes
+ * Built once (Sort-Tile-Recursive bulk load) and immutable afterwards, so it
+ * can be queried concurrently from any thread
+ */
+typedef struct OCRSpatialIndex OCRSpatialIndex;
+
+/**
+ * Build a spatial index
+ * @param boxes array of 4 * count doubles laid out as x, y, width, height per box
+ * @param count number of boxes
+ * @return index pointer, NULL if memory allocation fails
+ * @note The returned index must be freed using ocr_spatial_index_free
+ */
+OCRSpatialIndex* ocr_spatial_index_create(const double* boxes, size_t count);
+
+/**
+ * Number of boxes in the index
+ * @param index spatial index, can be NULL
+ * @return number of boxes, 0 for NULL
+ */
+size_t ocr_spatial_index_count(const OCRSpatialIndex* index);
+
+/**
+ * Find the boxes intersecting a rectangle (edges touching count as intersecting)
+ * @param index spatial index
+ * @param x, y, width, height query rectangle in the same coordinates as the boxes
+ * @param out array receiving matching box ids in ascending order, can be NULL
+ * @param capacity number of entries available in out
+ * @return total number of matches, which may exceed capacity
+ */
+size_t ocr_spatial_index_query(const OCRSpatialIndex* index, double x, double y, double width, double height,
+                               size_t* out, size_t capacity);
+
+/**
+ * Find the k boxes closest to a point (distance to the box edge, 0 inside)
+ * @param index spatial index
+ * @param x, y query point
+ * @param k maximum number of results
+ * @param out array of at least k entries receiving box ids, closest first
+ * @return number of ids written, min(k, count)
+ */
+size_t ocr_spatial_index_nearest(const OCRSpatialIndex* index, double x, double y, size_t k, size_t* out);
+
+/**
+ * Free a spatial index
+ * @param index spatial index to be freed, can be NULL
+ */
+void ocr_spatial_index_free(OCRSpatialIndex* index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MAC_OCR_SPATIAL_INDEX_H
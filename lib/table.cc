@@ -0,0 +1,249 @@
+#include "table.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Thresholds are in multiples of the median observation height
+const double kRowCoreRatio = 0.25;      // half-height of the band around the center used to merge rows
+const double kMinGutterRatio = 0.5;     // narrower whitespace is spacing inside a cell
+const size_t kSpanningRowsPerGutter = 10;  // one spanning cell per this many rows may cross a gutter
+const double kColumnOverlapRatio = 0.5; // share of a column a cell must cover to span it
+
+struct Placement {
+    size_t row;
+    size_t column;
+    size_t span;
+    size_t index;
+};
+
+template <typename T>
+T* CopyToMalloc(const std::vector<T>& items) {
+    if (items.empty()) {
+        return NULL;
+    }
+    T* copy = static_cast<T*>(malloc(sizeof(T) * items.size()));
+    if (copy) {
+        memcpy(copy, items.data(), sizeof(T) * items.size());
+    }
+    return copy;
+}
+
+double MedianHeight(const TextObservation* observations, size_t count) {
+    std::vector<double> heights(count);
+    for (size_t i = 0; i < count; i++) {
+        heights[i] = observations[i].height;
+    }
+    std::nth_element(heights.begin(), heights.begin() + count / 2, heights.end());
+    double median = heights[count / 2];
+    return median > 0.0 ? median : 1e-3;
+}
+
+// Merge the cores of the vertical extents; rows are returned top to bottom
+std::vector<OCRTableBand> FindRows(const TextObservation* observations, size_t count, double unit) {
+    std::vector<OCRTableBand> cores(count);
+    for (size_t i = 0; i < count; i++) {
+        double center = observations[i].y + observations[i].height * 0.5;
+        double half = std::min(observations[i].height * 0.5, unit * kRowCoreRatio);
+        cores[i] = {center - half, center + half};
+    }
+    std::sort(cores.begin(), cores.end(), [](const OCRTableBand& a, const OCRTableBand& b) {
+        return a.start > b.start;
+    });
+
+    std::vector<OCRTableBand> rows;
+    for (const OCRTableBand& core : cores) {
+        if (!rows.empty() && core.end >= rows.back().start) {
+            rows.back().start = std::min(rows.back().start, core.start);
+            rows.back().end = std::max(rows.back().end, core.end);
+        } else {
+            rows.push_back(core);
+        }
+    }
+    return rows;
+}
+
+// Sweep the horizontal projection profile; columns are returned left to right
+std::vector<OCRTableBand> FindColumns(const TextObservation* observations, size_t count,
+                                      size_t row_count, double unit) {
+    std::vector<std::pair<double, int>> events;
+    events.reserve(count * 2);
+    for (size_t i = 0; i < count; i++) {
+        events.push_back({observations[i].x, 1});
+        events.push_back({observations[i].x + observations[i].width, -1});
+    }
+    // Openings sort before closings at the same x so touching boxes stay together
+    std::sort(events.begin(), events.end(), [](const std::pair<double, int>& a, const std::pair<double, int>& b) {
+        return a.first < b.first || (a.first == b.first && a.second > b.second);
+    });
+
+    int threshold = 1 + (int)(row_count / kSpanningRowsPerGutter);
+    double min_gutter = unit * kMinGutterRatio;
+    std::vector<OCRTableBand> columns;
+    int coverage = 0;
+    double run_start = 0.0;
+    for (const std::pair<double, int>& event : events) {
+        int previous = coverage;
+        coverage += event.second;
+        if (previous < threshold && coverage >= threshold) {
+            run_start = event.first;
+        } else if (previous >= threshold && coverage < threshold) {
+            if (!columns.empty() && run_start - columns.back().end < min_gutter) {
+                columns.back().end = event.first;
+            } else {
+                columns.push_back({run_start, event.first});
+            }
+        }
+    }
+    return columns;
+}
+
+// Index of the band containing value, or the closest one when value falls in a gap
+size_t NearestBand(const std::vector<OCRTableBand>& bands, double value) {
+    std::vector<OCRTableBand>::const_iterator it = std::lower_bound(
+        bands.begin(), bands.end(), value,
+        [](const OCRTableBand& band, double v) { return band.end < v; });
+    if (it == bands.end()) {
+        return bands.size() - 1;
+    }
+    size_t index = it - bands.begin();
+    if (value < it->start && index > 0 && value - bands[index - 1].end < it->start - value) {
+        return index - 1;
+    }
+    return index;
+}
+
+} // namespace
+
+bool ocr_table_build(const TextObservation* observations, size_t count, OCRTable* out) {
+    if (!out) {
+        return false;
+    }
+    memset(out, 0, sizeof(OCRTable));
+    if (!observations || count == 0) {
+        return true;
+    }
+
+    try {
+        double unit = MedianHeight(observations, count);
+        std::vector<OCRTableBand> rows = FindRows(observations, count, unit);
+        std::vector<OCRTableBand> columns = FindColumns(observations, count, rows.size(), unit);
+        if (columns.empty()) {
+            // Every position is crossed by fewer boxes than the threshold: one column
+            double left = observations[0].x;
+            double right = observations[0].x + observations[0].width;
+            for (size_t i = 1; i < count; i++) {
+                left = std::min(left, observations[i].x);
+                right = std::max(right, observations[i].x + observations[i].width);
+            }
+            columns.push_back({left, right});
+        }
+
+        // Rows are ordered top to bottom, so search them with negated coordinates
+        std::vector<OCRTableBand> flipped(rows.size());
+        for (size_t r = 0; r < rows.size(); r++) {
+            flipped[r] = {-rows[r].end, -rows[r].start};
+        }
+
+        std::vector<Placement> placements(count);
+        for (size_t i = 0; i < count; i++) {
+            const TextObservation& obs = observations[i];
+            double left = obs.x;
+            double right = obs.x + obs.width;
+            Placement& placement = placements[i];
+            placement.index = i;
+            placement.row = NearestBand(flipped, -(obs.y + obs.height * 0.5));
+
+            size_t first = NearestBand(columns, left);
+            size_t last = NearestBand(columns, right);
+            size_t covered_first = last + 1;
+            size_t covered_last = first;
+            for (size_t c = first; c <= last; c++) {
+                double overlap = std::min(right, columns[c].end) - std::max(left, columns[c].start);
+                if (overlap >= kColumnOverlapRatio * (columns[c].end - columns[c].start)) {
+                    covered_first = std::min(covered_first, c);
+                    covered_last = std::max(covered_last, c);
+                }
+            }
+            if (covered_first > covered_last) {
+                placement.column = NearestBand(columns, (left + right) * 0.5);
+                placement.span = 1;
+            } else {
+                placement.column = covered_first;
+                placement.span = covered_last - covered_first + 1;
+            }
+        }
+
+        std::sort(placements.begin(), placements.end(), [observations](const Placement& a, const Placement& b) {
+            if (a.row != b.row) return a.row < b.row;
+            if (a.column != b.column) return a.column < b.column;
+            return observations[a.index].x < observations[b.index].x;
+        });
+
+        std::vector<OCRTableCell> cells;
+        std::vector<size_t> ids(count);
+        for (size_t i = 0; i < count; i++) {
+            const Placement& placement = placements[i];
+            const TextObservation& obs = observations[placement.index];
+            ids[i] = placement.index;
+
+            if (!cells.empty() && cells.back().row == placement.row && cells.back().column == placement.column) {
+                OCRTableCell& cell = cells.back();
+                double left = std::min(cell.x, obs.x);
+                double bottom = std::min(cell.y, obs.y);
+                double right = std::max(cell.x + cell.width, obs.x + obs.width);
+                double top = std::max(cell.y + cell.height, obs.y + obs.height);
+                cell.x = left;
+                cell.y = bottom;
+                cell.width = right - left;
+                cell.height = top - bottom;
+                cell.column_span = std::max(cell.column_span, placement.span);
+                cell.count++;
+                continue;
+            }
+
+            OCRTableCell cell;
+            cell.row = placement.row;
+            cell.column = placement.column;
+            cell.column_span = placement.span;
+            cell.x = obs.x;
+            cell.y = obs.y;
+            cell.width = obs.width;
+            cell.height = obs.height;
+            cell.first = i;
+            cell.count = 1;
+            cells.push_back(cell);
+        }
+
+        out->rows = CopyToMalloc(rows);
+        out->columns = CopyToMalloc(columns);
+        out->cells = CopyToMalloc(cells);
+        out->observation_ids = CopyToMalloc(ids);
+        if (!out->rows || !out->columns || !out->cells || !out->observation_ids) {
+            ocr_table_free(out);
+            return false;
+        }
+        out->row_count = rows.size();
+        out->column_count = columns.size();
+        out->cell_count = cells.size();
+        return true;
+    } catch (const std::bad_alloc&) {
+        ocr_table_free(out);
+        return false;
+    }
+}
+
+void ocr_table_free(OCRTable* table) {
+    if (!table) return;
+
+    free(table->rows);
+    free(table->columns);
+    free(table->cells);
+    free(table->observation_ids);
+    memset(table, 0, sizeof(OCRTable));
+}
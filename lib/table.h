@@ -0,0 +1,72 @@
+#ifndef MAC_OCR_TABLE_H
+#define MAC_OCR_TABLE_H
+
+#include <stdbool.h>
+#include "ocr_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Extent of a table row (bottom to top) or column (left to right)
+ * Coordinates use the same normalized bottom-left origin as TextObservation
+ */
+typedef struct {
+    double start;         // bottom of a row, left edge of a column (0.0-1.0)
+    double end;           // top of a row, right edge of a column (0.0-1.0)
+} OCRTableBand;
+
+/**
+ * Non-empty table cell and the observations it contains
+ */
+typedef struct {
+    size_t row;           // row index, 0 is the top row
+    size_t column;        // column index, 0 is the leftmost column
+    size_t column_span;   // number of columns covered by the cell contents, at least 1
+    double x;             // x coordinate of the union of the observations (0.0-1.0)
+    double y;             // y coordinate of the union of the observations (0.0-1.0, bottom-left origin)
+    double width;         // width of the union of the observations (0.0-1.0)
+    double height;        // height of the union of the observations (0.0-1.0)
+    size_t first;         // index of the first entry in OCRTable.observation_ids
+    size_t count;         // number of observations in the cell
+} OCRTableCell;
+
+/**
+ * Cell grid reconstructed from observation geometry
+ * Note: All arrays are dynamically allocated and need to be freed using ocr_table_free
+ */
+typedef struct {
+    OCRTableBand* rows;         // rows from top to bottom
+    size_t row_count;           // number of rows
+    OCRTableBand* columns;      // columns from left to right
+    size_t column_count;        // number of columns
+    OCRTableCell* cells;        // non-empty cells in row-major order
+    size_t cell_count;          // number of cells
+    size_t* observation_ids;    // observation indices grouped by cell, left to right within a cell
+} OCRTable;
+
+/**
+ * Align observations into a grid of rows and columns
+ * Rows come from merging the vertical extents of the observations and columns
+ * from the horizontal projection profile, where a cell spanning several columns
+ * is tolerated as long as most rows leave the gutter empty. Each stage is a sort
+ * followed by a sweep or a binary search, so the cost is O(n log n)
+ * @param observations observation array
+ * @param count number of observations
+ * @param out table to fill, must be freed with ocr_table_free even on failure
+ * @return true on success, false if memory allocation fails
+ */
+bool ocr_table_build(const TextObservation* observations, size_t count, OCRTable* out);
+
+/**
+ * Free table arrays
+ * @param table table to be freed, can be NULL; its fields are reset afterwards
+ */
+void ocr_table_free(OCRTable* table);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MAC_OCR_TABLE_H
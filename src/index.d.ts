@@ -2,14 +2,222 @@ interface RecognizeOptions {
   languages?: string;
   recognitionLevel?:
     | typeof MacOCR.RECOGNITION_LEVEL_FAST
-    | typeof MacOCR.RECOGNITION_LEVEL_ACCURATE;
+    | typeof MacOCR.RECOGNITION_LEVEL_ACCURATE
+    | typeof MacOCR.RECOGNITION_LEVEL_CASCADE;
+  /** With RECOGNITION_LEVEL_CASCADE, fast observations below this confidence are re-recognized (default: 0.5) */
+  cascadeThreshold?: number;
+  /** Pick recognition level and downsampling so the call fits this latency; overrides recognitionLevel */
+  latencyBudgetMs?: number;
+  /** Single-image calls: start a duplicate attempt if no result arrived after this long; the first to succeed wins */
+  hedgeAfterMs?: number;
+  /** Run the duplicate attempt at RECOGNITION_LEVEL_FAST */
+  hedgeFast?: boolean;
   minConfidence?: number;
+  /** Drop observations whose confidence is below this value before they are copied out of Vision */
+  minObservationConfidence?: number;
+  /** Drop observations narrower or shorter than this size (0.0-1.0) */
+  minBoxSize?: number;
+  /** Return up to this many readings (0-10) per observation in TextObservation.candidates */
+  candidates?: number;
+  /** Build the spatial index used by OCRResult.query()/nearest() during recognition */
+  spatialIndex?: boolean;
+  /** Reconstruct a table cell grid into OCRResult.table */
+  detectTable?: boolean;
+  /** Return an empty result with OCRResult.blank set for blank or near-uniform images, without running Vision */
+  rejectBlank?: boolean;
+  /** With rejectBlank, luminance standard deviation below which an image is blank (default: 1.0) */
+  blankMinStdDev?: number;
+  /** With rejectBlank, share of edge pixels below which an image is blank (default: 0.0002) */
+  blankMinEdgeDensity?: number;
+  /** Convert to gray with the native SIMD kernels before recognition */
+  grayscale?: boolean;
+  /** Stretch gray levels to the full range before recognition; implies grayscale */
+  normalizeContrast?: boolean;
+  /** Downscale by this factor (0-1] with area averaging before recognition; implies grayscale (default: 1.0) */
+  preprocessScale?: number;
+  /** When mean confidence is below autoRotateThreshold, try the other 90° orientations and keep the best reading */
+  autoRotate?: boolean;
+  /** With autoRotate, mean confidence below which other orientations are tried (default: 0.5) */
+  autoRotateThreshold?: number;
+  /** Detect text on a downscaled copy, then recognize only those regions at full resolution, in parallel */
+  pyramid?: boolean;
+  /** With pyramid, scale (0-1) of the copy text is detected on (default: 0.25) */
+  pyramidScale?: number;
+  /** 'detect' returns text boxes with empty text without recognizing them; ignored by findText() and buildIndex() (default: 'recognize') */
+  mode?: 'recognize' | 'detect';
+  /** With more than one language, read a downscaled copy first and recognize with only the languages of the scripts found; ignored at the fast level */
+  routeLanguages?: boolean;
+}
+
+interface RecognizeOptionSetsOptions extends RecognizeOptions {
+  /** Recognize once per set, each layered over the other options; the image is read and decoded once */
+  optionSets: RecognizeOptions[];
+}
+
+interface FrameSessionOptions
+  extends Omit<
+    RecognizeOptions,
+    'cascadeThreshold' | 'latencyBudgetMs' | 'hedgeAfterMs' | 'hedgeFast' | 'rejectBlank' | 'blankMinStdDev' | 'blankMinEdgeDensity'
+    | 'grayscale' | 'normalizeContrast' | 'preprocessScale' | 'autoRotate' | 'autoRotateThreshold'
+    | 'pyramid' | 'pyramidScale' | 'routeLanguages'
+  > {
+  /** Reuse the last result for near-duplicates of the last recognized frame, counted in FrameSession.skippedFrames */
+  skipDuplicates?: boolean;
+  /** Largest perceptual hash distance (0-64) counted as a near-duplicate (default: 3) */
+  duplicateDistance?: number;
+  /** Side of the tiles compared between frames, in pixels (default: 64) */
+  tileSize?: number;
 }
 
 interface RecognizeBatchOptions {
   ocrOptions?: RecognizeOptions;
   maxThreads?: number;
+  /** Estimated decoded bytes of images in flight at once; larger images wait while smaller ones proceed (default: 0, no limit) */
+  maxInFlightBytes?: number;
+  /** Extra decode attempts (0-10) for an image failing with a transient read error (default: 0) */
+  maxRetries?: number;
+  /** Wait before the first retry in milliseconds, doubled before each next one (default: 50) */
+  retryBackoffMs?: number;
   batchSize?: number;
+  /** Reuse the result of a near-duplicate image instead of recognizing it again (recognizeBatch* only) */
+  skipDuplicates?: boolean;
+  /** Largest perceptual hash distance (0-64) counted as a near-duplicate (default: 3) */
+  duplicateDistance?: number;
+}
+
+interface CascadeStats {
+  fastObservations: number;       // observations from the fast pass
+  escalatedObservations: number;  // fast observations below cascadeThreshold
+  regions: number;                // regions re-recognized in accurate mode
+  imageEscalated: boolean;        // whole image re-recognized in accurate mode
+}
+
+interface BudgetReport {
+  recognitionLevel: typeof MacOCR.RECOGNITION_LEVEL_FAST | typeof MacOCR.RECOGNITION_LEVEL_ACCURATE;
+  scale: number;          // downsampling factor applied to both sides
+  predictedMs: number;    // latency predicted by the cost model
+  elapsedMs: number;      // measured latency of downsampling and recognition
+  withinBudget: boolean;  // false if even the cheapest plan was predicted to exceed the budget
+}
+
+interface PyramidReport {
+  detectedObservations: number;  // observations found on the downscaled copy
+  regions: number;               // crops recognized at full resolution
+  coveredArea: number;           // share of the image recognized at full resolution
+}
+
+interface RoutingReport {
+  scripts: Array<'latin' | 'han' | 'kana' | 'hangul' | 'cyrillic' | 'arabic' | 'thai'>;  // scripts the script pass found
+  languages: string;    // languages the image was recognized with, comma-separated
+  probeMs: number;      // latency of the script pass
+  recognizeMs: number;  // latency of the recognition that followed
+}
+
+interface HedgeReport {
+  launched: boolean;  // a duplicate attempt was started
+  won: boolean;       // the result came from the duplicate attempt
+}
+
+interface HedgeStats {
+  calls: number;      // recognitions run with hedgeAfterMs
+  hedged: number;     // recognitions that launched a duplicate attempt
+  hedgeWins: number;  // recognitions answered by the duplicate attempt
+  hedgeRate: number;  // hedged / calls
+}
+
+interface BlankStats {
+  checked: number;    // recognitions run with rejectBlank
+  rejected: number;   // recognitions answered as blank without running Vision
+  rejectRate: number; // rejected / checked
+}
+
+interface RoutingStats {
+  routed: number;             // recognitions that ran a script pass
+  narrowed: number;           // routed recognitions that kept fewer languages than configured
+  probeMs: number;            // total time of the script passes
+  narrowedMs: number;         // total recognition time with a narrowed list
+  narrowedMegapixels: number; // total image size recognized with a narrowed list
+  fullMs: number;             // total accurate recognition time with a full list of more than one language
+  fullMegapixels: number;     // total image size recognized with a full list
+  savedMs: number;            // estimated time saved, script passes included; 0 until both lists were timed
+  narrowRate: number;         // narrowed / routed
+}
+
+interface AdmissionStats {
+  batches: number;            // batches run, with or without maxInFlightBytes
+  admitted: number;           // images handed to a worker
+  deferred: number;           // images set aside because their decoded size did not fit the budget
+  waitMs: number;             // total time batches waited for budget before dispatching
+  peakInFlightBytes: number;  // most decoded bytes in flight at once in any batch, estimated under a budget
+}
+
+interface PixelPoolStats {
+  acquired: number;           // buffers handed out
+  reused: number;             // buffers handed out from the cache instead of allocated
+  oversized: number;          // requests above the largest size class, allocated and freed directly
+  inUseBytes: number;         // bytes of buffers held by images and scratch space
+  cachedBytes: number;        // bytes of released buffers kept for reuse
+  highWaterBytes: number;     // most in-use and cached bytes at once
+  trimmedBytes: number;       // cached bytes freed under memory pressure
+  reuseRate: number;          // reused / acquired
+}
+
+// Set as error.code on rejections from native recognition
+type OCRErrorCode =
+  | 'ERR_OCR_UNKNOWN'
+  | 'ERR_OCR_INVALID_ARGUMENT'
+  | 'ERR_OCR_OUT_OF_MEMORY'
+  | 'ERR_OCR_FILE_NOT_FOUND'
+  | 'ERR_OCR_FILE_READ'
+  | 'ERR_OCR_ACCESS_DENIED'
+  | 'ERR_OCR_UNSUPPORTED_FORMAT'
+  | 'ERR_OCR_DECODE_FAILED'
+  | 'ERR_OCR_IMAGE_TOO_LARGE'
+  | 'ERR_OCR_PREPROCESS_FAILED'
+  | 'ERR_OCR_RECOGNITION_FAILED'
+  | 'ERR_OCR_CANCELLED'
+  | 'ERR_OCR_DUPLICATE_FAILED'
+  | 'ERR_OCR_NO_INPUT'
+  | 'ERR_OCR_INVALID_PATTERN'
+  | 'ERR_OCR_TOO_MANY_IMAGES'
+  | 'ERR_OCR_INDEX_WRITE'
+  | 'ERR_OCR_INDEX_CORRUPT';
+
+interface OCRError extends Error {
+  code?: OCRErrorCode;
+}
+
+interface ImageInfo {
+  format: 'png' | 'jpeg' | 'tiff' | 'gif';
+  width: number;             // pixels as stored, before EXIF orientation
+  height: number;
+  bitsPerComponent: number;  // PNG bit depth, JPEG precision, TIFF BitsPerSample; 8 for GIF
+  components: number;        // samples per pixel as stored; 1 for palette images
+  frameCount: number;        // APNG frames, TIFF pages or GIF images; 1 for JPEG and plain PNG
+  decodedBytes: number;      // estimated size of the first frame decoded to RGBA
+}
+
+interface FrameRegion {
+  x: number;
+  y: number;
+  width: number;
+  height: number;
+}
+
+interface FrameDelta {
+  added: number[];                  // indices into observations recognized in this frame
+  removed: Omit<TextObservation, 'candidates'>[];  // previous observations replaced by this frame
+  carried: number;                  // previous observations carried forward unchanged
+  regions: FrameRegion[];           // regions recognized again (bottom-left origin)
+  tiles: number;                    // tiles compared
+  changedTiles: number;             // tiles that differed from the previous frame
+  fullFrame: boolean;               // the whole frame was recognized again
+  duplicate: boolean;               // near-duplicate of the last recognized frame, its result was reused
+}
+
+interface TextCandidate {
+  text: string;
+  confidence: number;
 }
 
 interface TextObservation {
@@ -19,6 +227,39 @@ interface TextObservation {
   y: number;       // y coordinate from Vision Framework (0.0-1.0, bottom-left origin)
   width: number;   // width from Vision Framework (0.0-1.0)
   height: number;  // height from Vision Framework (0.0-1.0)
+  /** Best readings in descending confidence, present when the candidates option is set */
+  candidates?: TextCandidate[];
+}
+
+interface LayoutNode {
+  x: number;       // x coordinate of the node bounding box (0.0-1.0)
+  y: number;       // y coordinate of the node bounding box (0.0-1.0, bottom-left origin)
+  width: number;   // width of the node bounding box (0.0-1.0)
+  height: number;  // height of the node bounding box (0.0-1.0)
+  start: number;   // index of the first child
+  count: number;   // number of children
+}
+
+interface TableBand {
+  start: number;   // bottom of a row or left edge of a column (0.0-1.0)
+  end: number;     // top of a row or right edge of a column (0.0-1.0)
+}
+
+interface TableCell {
+  row: number;            // row index, 0 is the top row
+  column: number;         // column index, 0 is the leftmost column
+  columnSpan: number;     // number of columns covered by the cell contents
+  x: number;
+  y: number;
+  width: number;
+  height: number;
+  observations: number[]; // indices into OCRResult.observations, left to right
+}
+
+interface Table {
+  rows: TableBand[];      // top to bottom
+  columns: TableBand[];   // left to right
+  cells: TableCell[];     // non-empty cells in row-major order
 }
 
 declare class OCRResult {
@@ -30,11 +271,141 @@ declare class OCRResult {
    * Coordinates are exactly as returned by Vision Framework without any conversion
    */
   observations: TextObservation[];
+
+  /** Number of observations discarded by minObservationConfidence or minBoxSize */
+  droppedObservations: number;
+
+  /** What the cascade re-recognized in accurate mode, null for the other levels */
+  cascade: CascadeStats | null;
+
+  /** Plan chosen for latencyBudgetMs, null without a budget */
+  budget: BudgetReport | null;
+  /** What pyramid detected and recognized, null without pyramid */
+  pyramid: PyramidReport | null;
+
+  /** Duplicate attempt made for hedgeAfterMs, null unless one was launched */
+  hedge: HedgeReport | null;
+
+  /** Rejected as blank by rejectBlank; text is empty and Vision did not run */
+  blank: boolean;
+  /** Clockwise degrees (0, 90, 180, 270) autoRotate turned the image; observations are relative to the turned image */
+  rotation: number;
+  /** Languages chosen by routeLanguages, null unless a script pass ran */
+  routing: RoutingReport | null;
+
+  /** Changes since the previous frame, set for FrameSession results only */
+  delta: FrameDelta | null;
+
+  /** Index of the batch input whose result was reused with skipDuplicates, null if recognized */
+  duplicateOf: number | null;
+
+  /** Why this batch input failed, null if it was recognized; text is null when set */
+  error: { code: OCRErrorCode; message: string } | null;
+
+  /** Times the image was decoded, more than 1 after retries of transient read errors */
+  attempts: number;
+
+  /**
+   * Lines in reading order, each covering observations[start, start + count)
+   */
+  lines: LayoutNode[];
+
+  /**
+   * Paragraphs in reading order, each covering lines[start, start + count)
+   */
+  paragraphs: LayoutNode[];
+
+  /**
+   * Columns in reading order, each covering paragraphs[start, start + count)
+   */
+  columns: LayoutNode[];
+
+  /**
+   * Table cell grid, null unless detectTable was set
+   */
+  table: Table | null;
+
+  /**
+   * Find the observations intersecting a rectangle using a native R-tree
+   * @param rect - Query rectangle (0.0-1.0, bottom-left origin)
+   * @returns Matching observations in reading order
+   */
+  query(rect: { x: number; y: number; width: number; height: number }): TextObservation[];
+
+  /**
+   * Find the observations closest to a point using a native R-tree
+   * @param point - Query point (0.0-1.0, bottom-left origin)
+   * @param k - Maximum number of observations to return (default 1)
+   * @returns Closest observations, nearest first
+   */
+  nearest(point: { x: number; y: number }, k?: number): TextObservation[];
+}
+
+interface FindTextOptions extends RecognizeBatchOptions {
+  /** Treat the pattern as a regular expression (ICU syntax) */
+  regex?: boolean;
+  caseInsensitive?: boolean;
+  /** Stop after this many matches and skip the images still queued, 0 means no limit */
+  stopAfter?: number;
+}
+
+interface TextMatch {
+  index: number;        // index of the image in the inputs array
+  observation: number;  // index of the observation in reading order
+  text: string;         // full text of the observation
+  start: number;        // offset of the match in text
+  length: number;       // length of the match
+  confidence: number;
+  x: number;
+  y: number;
+  width: number;
+  height: number;
+}
+
+interface FindTextResult {
+  matches: TextMatch[];
+  processed: number;    // images recognized
+  failed: number;       // images that failed to decode or recognize
+  skipped: number;      // images skipped after stopAfter was reached
+}
+
+interface IndexBuildResult {
+  documents: number;    // images indexed
+  failed: number;       // images that failed to decode or recognize
+  terms: number;        // distinct terms written
+  postings: number;     // term occurrences written
+}
+
+interface Posting {
+  image: number;        // index of the image in the indexed inputs
+  observation: number;  // index of the observation in reading order
+  position: number;     // index of the token inside the observation
+}
+
+declare class OCRIndex {
+  /** Find every occurrence of a single term */
+  lookup(term: string): Posting[];
+  /** Find the images containing every term of a query, in ascending order */
+  search(query: string): number[];
+  /** Unmap the index file */
+  close(): void;
+}
+
+declare class FrameSession {
+  /** Frames answered from the previous result because they were near-duplicates */
+  skippedFrames: number;
+  /** Recognize the next frame, re-reading only what changed since the previous one */
+  recognize(frame: string | Buffer | Uint8Array): Promise<OCRResult>;
+  /** Forget the previous frame once pending frames finish */
+  reset(): Promise<void>;
+  /** Release the session */
+  close(): void;
 }
 
 declare class MacOCR {
   static readonly RECOGNITION_LEVEL_FAST: 0;
   static readonly RECOGNITION_LEVEL_ACCURATE: 1;
+  static readonly RECOGNITION_LEVEL_CASCADE: 2;
 
   /**
    * Perform OCR text recognition
@@ -46,6 +417,17 @@ declare class MacOCR {
     options?: RecognizeOptions,
   ): Promise<OCRResult>;
 
+  /**
+   * Recognize one image under several option sets concurrently, decoding it once
+   * @param imagePath - Image file path
+   * @param options - OCR options shared by every set, and the option sets
+   * @returns One result per option set, in order
+   */
+  static recognizeFromPath(
+    imagePath: string,
+    options: RecognizeOptionSetsOptions,
+  ): Promise<OCRResult[]>;
+
   /**
    * Batch OCR text recognition
    * @param imagePaths - Image file path array
@@ -66,6 +448,17 @@ declare class MacOCR {
     options?: RecognizeOptions,
   ): Promise<OCRResult>;
 
+  /**
+   * Recognize one image buffer under several option sets concurrently, decoding it once
+   * @param imageBuffer - Image buffer data
+   * @param options - OCR options shared by every set, and the option sets
+   * @returns One result per option set, in order
+   */
+  static recognizeFromBuffer(
+    imageBuffer: Buffer | Uint8Array,
+    options: RecognizeOptionSetsOptions,
+  ): Promise<OCRResult[]>;
+
   /**
    * Perform batch OCR text recognition on image buffers
    * @param imageBuffers - Array of image buffer data
@@ -75,8 +468,75 @@ declare class MacOCR {
     imageBuffers: Array<Buffer | Uint8Array>,
     options?: RecognizeBatchOptions,
   ): Promise<OCRResult[]>;
+
+  /**
+   * Search for text across images, matching natively as each image is recognized
+   * @param inputs - Image file paths and/or image buffers
+   * @param pattern - Text or regular expression to search for
+   * @param options - Search options
+   */
+  static findText(
+    inputs: Array<string | Buffer | Uint8Array>,
+    pattern: string,
+    options?: FindTextOptions,
+  ): Promise<FindTextResult>;
+
+  /**
+   * Recognize images and write an inverted index of their text
+   * @param inputs - Image file paths and/or image buffers
+   * @param indexPath - Output index file path
+   * @param options - Batch processing options
+   */
+  static buildIndex(
+    inputs: Array<string | Buffer | Uint8Array>,
+    indexPath: string,
+    options?: RecognizeBatchOptions,
+  ): Promise<IndexBuildResult>;
+
+  /**
+   * Memory-map an index written by buildIndex()
+   * @param indexPath - Index file path
+   */
+  static openIndex(indexPath: string): OCRIndex;
+
+  /**
+   * Read an image's header without decoding its pixels
+   * @param input - Image path or encoded image bytes (PNG, JPEG, TIFF or GIF)
+   */
+  static probe(input: string | Buffer | Uint8Array): ImageInfo;
+
+  /**
+   * Hedging counters accumulated since the process started
+   */
+  static getHedgeStats(): HedgeStats;
+
+  /**
+   * Blank page counters accumulated since the process started
+   */
+  static getBlankStats(): BlankStats;
+
+  /**
+   * Language routing counters accumulated since the process started
+   */
+  static getRoutingStats(): RoutingStats;
+
+  /**
+   * Batch admission counters accumulated since the process started
+   */
+  static getAdmissionStats(): AdmissionStats;
+
+  /**
+   * Counters of the pixel buffer pool shared by decode and preprocessing
+   */
+  static getPixelPoolStats(): PixelPoolStats;
+
+  /**
+   * Create a session for a sequence of frames such as periodic screen captures
+   * @param options - OCR options applied to every frame
+   */
+  static createFrameSession(options?: FrameSessionOptions): FrameSession;
 }
 
-export { RecognizeOptions, RecognizeBatchOptions, OCRResult, TextObservation };
+export { RecognizeOptions, RecognizeOptionSetsOptions, RecognizeBatchOptions, FindTextOptions, TextMatch, FindTextResult, IndexBuildResult, Posting, OCRIndex, OCRResult, CascadeStats, BudgetReport, PyramidReport, RoutingReport, HedgeReport, HedgeStats, BlankStats, RoutingStats, AdmissionStats, PixelPoolStats, OCRErrorCode, OCRError, ImageInfo, FrameSession, FrameSessionOptions, FrameDelta, FrameRegion, TextObservation, TextCandidate, LayoutNode, Table, TableCell, TableBand };
 
 export default MacOCR;
@@ -1,4 +1,29 @@
-const { recognize, recognizeBatch, recognizeBuffer, recognizeBatchFromBuffer } = require('bindings')(
+const {
+  recognize,
+  recognizeBatch,
+  recognizeBuffer,
+  recognizeBatchFromBuffer,
+  findText,
+  createSpatialIndex,
+  querySpatialIndex,
+  nearestInSpatialIndex,
+  buildIndex,
+  openIndex,
+  lookupIndex,
+  searchIndex,
+  closeIndex,
+  getHedgeStats,
+  getBlankStats,
+  getRoutingStats,
+  getAdmissionStats,
+  getPixelPoolStats,
+  probe,
+  createFrameSession,
+  recognizeFrame,
+  resetFrameSession,
+  closeFrameSession,
+  recognizeOptionSets
+} = require('bindings')(
   { 
     bindings: 'mac_system_ocr' ,
     module_root: __dirname + '/..'
@@ -9,14 +34,312 @@ const fs = require('fs');
 const os = require('os');
 const { Buffer } = require('buffer');
 
+// Re-throw a native error with context; the code (e.g. ERR_OCR_DECODE_FAILED) is kept
+// so callers can branch on the failure without parsing the message
+function wrapError(context, error) {
+  const wrapped = new Error(`${context}: ${error.message}`);
+  if (error.code !== undefined) {
+    wrapped.code = error.code;
+  }
+  return wrapped;
+}
+
+// Argument errors caught in JS carry the code the native side uses for them
+function invalidArgument(message) {
+  const error = new Error(message);
+  error.code = 'ERR_OCR_INVALID_ARGUMENT';
+  return error;
+}
+
+// Whole-image passes a frame session never runs, since it recognizes changed regions only
+const FRAME_UNSUPPORTED_OPTIONS = ['rejectBlank', 'grayscale', 'normalizeContrast', 'autoRotate', 'pyramid', 'routeLanguages'];
+
 class OCRResult {
   constructor(data) {
     this.text = data.text;
     this.confidence = data.confidence;
     this.observations = data.observations || [];
+    this.droppedObservations = data.droppedObservations || 0;
+    this.cascade = data.cascade || null;
+    this.budget = data.budget || null;
+    this.pyramid = data.pyramid || null;
+    this.hedge = data.hedge || null;
+    this.delta = data.delta || null;
+    this.duplicateOf = data.duplicateOf ?? null;
+    this.error = data.error || null;
+    this.attempts = data.attempts || 1;
+    this.blank = data.blank === true;
+    this.rotation = data.rotation || 0;
+    this.routing = data.routing || null;
+    this.lines = data.lines || [];
+    this.paragraphs = data.paragraphs || [];
+    this.columns = data.columns || [];
+    this.table = data.table || null;
+    Object.defineProperty(this, '_spatialIndex', { value: data.spatialIndex || null, writable: true });
+  }
+
+  /**
+   * Find the observations intersecting a rectangle
+   * @param {{x: number, y: number, width: number, height: number}} rect - Query rectangle (0.0-1.0, bottom-left origin)
+   * @returns {Array<Object>} Matching observations in reading order
+   */
+  query(rect) {
+    const ids = querySpatialIndex(this._getSpatialIndex(), rect.x, rect.y, rect.width, rect.height);
+    return ids.map(id => this.observations[id]);
+  }
+
+  /**
+   * Find the observations closest to a point
+   * @param {{x: number, y: number}} point - Query point (0.0-1.0, bottom-left origin)
+   * @param {number} [k=1] - Maximum number of observations to return
+   * @returns {Array<Object>} Closest observations, nearest first
+   */
+  nearest(point, k = 1) {
+    const ids = nearestInSpatialIndex(this._getSpatialIndex(), point.x, point.y, k);
+    return ids.map(id => this.observations[id]);
+  }
+
+  // The index is built natively during recognition when options.spatialIndex is set,
+  // otherwise on the first query
+  _getSpatialIndex() {
+    if (!this._spatialIndex) {
+      const boxes = new Float64Array(this.observations.length * 4);
+      this.observations.forEach((obs, i) => {
+        boxes.set([obs.x, obs.y, obs.width, obs.height], i * 4);
+      });
+      this._spatialIndex = createSpatialIndex(boxes);
+    }
+    return this._spatialIndex;
   }
 }
 
+class OCRIndex {
+  constructor(handle) {
+    Object.defineProperty(this, '_handle', { value: handle });
+  }
+
+  /**
+   * Find every occurrence of a term
+   * @param {string} term - Single term, normalized like indexed text (ASCII is case-insensitive)
+   * @returns {Array<{image: number, observation: number, position: number}>} Postings ordered by image
+   */
+  lookup(term) {
+    return lookupIndex(this._handle, term);
+  }
+
+  /**
+   * Find the images containing every term of a query
+   * @param {string} query - Query text
+   * @returns {Array<number>} Indices of the matching inputs in ascending order
+   */
+  search(query) {
+    return searchIndex(this._handle, query);
+  }
+
+  /**
+   * Unmap the index file; it is also released when the object is garbage collected
+   */
+  close() {
+    closeIndex(this._handle);
+  }
+}
+
+class FrameSession {
+  constructor(handle) {
+    Object.defineProperty(this, '_handle', { value: handle });
+    Object.defineProperty(this, '_last', { value: Promise.resolve(), writable: true });
+    this.skippedFrames = 0;
+  }
+
+  /**
+   * Recognize the next frame; frames are processed in call order
+   * Only the tiles that changed since the previous frame are recognized again
+   * @param {string|Buffer|Uint8Array} frame - Image file path or image buffer
+   * @returns {Promise<OCRResult>} Result for the whole frame, with result.delta describing the changes
+   */
+  recognize(frame) {
+    if (typeof frame !== 'string' && !Buffer.isBuffer(frame) && !(frame instanceof Uint8Array)) {
+      return Promise.reject(new TypeError('Frame must be an image path or a Buffer'));
+    }
+    const input = typeof frame === 'string' || Buffer.isBuffer(frame) ? frame : Buffer.from(frame);
+    const run = this._last
+      .catch(() => {})
+      .then(() => recognizeFrame(this._handle, input));
+    this._last = run;
+    return run.then(
+      result => {
+        if (result.delta?.duplicate) {
+          this.skippedFrames++;
+        }
+        return new OCRResult(result);
+      },
+      error => {
+        throw wrapError('Frame OCR failed', error);
+      }
+    );
+  }
+
+  /**
+   * Forget the previous frame once pending frames finish, so the next one is recognized in full
+   * @returns {Promise<void>}
+   */
+  reset() {
+    const run = this._last
+      .catch(() => {})
+      .then(() => resetFrameSession(this._handle));
+    this._last = run;
+    return run;
+  }
+
+  /**
+   * Release the session; a frame in flight still completes
+   */
+  close() {
+    closeFrameSession(this._handle);
+  }
+}
+
+// Defaults and validation of the OCR options, shared by every entry point and option set
+function normalizeRecognizeOptions(options) {
+  const normalizedOptions = {
+    languages: options.languages || 'en-US',
+    recognitionLevel: options.recognitionLevel ?? MacOCR.RECOGNITION_LEVEL_ACCURATE,
+    cascadeThreshold: options.cascadeThreshold ?? 0.5,
+    latencyBudgetMs: options.latencyBudgetMs || 0,
+    hedgeAfterMs: options.hedgeAfterMs || 0,
+    hedgeFast: options.hedgeFast === true,
+    minConfidence: options.minConfidence || 0.0,
+    minObservationConfidence: options.minObservationConfidence || 0.0,
+    minBoxSize: options.minBoxSize || 0.0,
+    candidates: options.candidates || 0,
+    spatialIndex: options.spatialIndex === true,
+    detectTable: options.detectTable === true,
+    rejectBlank: options.rejectBlank === true,
+    blankMinStdDev: options.blankMinStdDev ?? 1.0,
+    blankMinEdgeDensity: options.blankMinEdgeDensity ?? 0.0002,
+    grayscale: options.grayscale === true,
+    normalizeContrast: options.normalizeContrast === true,
+    preprocessScale: options.preprocessScale ?? 1.0,
+    autoRotate: options.autoRotate === true,
+    autoRotateThreshold: options.autoRotateThreshold ?? 0.5,
+    pyramid: options.pyramid === true,
+    pyramidScale: options.pyramidScale ?? 0.25,
+    mode: options.mode ?? 'recognize',
+    routeLanguages: options.routeLanguages === true
+  };
+
+  if (![MacOCR.RECOGNITION_LEVEL_FAST, MacOCR.RECOGNITION_LEVEL_ACCURATE, MacOCR.RECOGNITION_LEVEL_CASCADE].includes(normalizedOptions.recognitionLevel)) {
+    throw new Error('Recognition level must be MacOCR.RECOGNITION_LEVEL_FAST or MacOCR.RECOGNITION_LEVEL_ACCURATE (or MacOCR.RECOGNITION_LEVEL_CASCADE)');
+  }
+
+  if (typeof normalizedOptions.cascadeThreshold !== 'number' || normalizedOptions.cascadeThreshold <= 0 || normalizedOptions.cascadeThreshold > 1) {
+    throw new Error('Cascade threshold must be greater than 0.0 and at most 1.0');
+  }
+
+  if (typeof normalizedOptions.latencyBudgetMs !== 'number' || normalizedOptions.latencyBudgetMs < 0) {
+    throw new Error('Latency budget must be a non-negative number of milliseconds');
+  }
+
+  if (typeof normalizedOptions.hedgeAfterMs !== 'number' || normalizedOptions.hedgeAfterMs < 0) {
+    throw new Error('Hedge delay must be a non-negative number of milliseconds');
+  }
+
+  if (typeof normalizedOptions.blankMinStdDev !== 'number' || normalizedOptions.blankMinStdDev < 0 ||
+      typeof normalizedOptions.blankMinEdgeDensity !== 'number' || normalizedOptions.blankMinEdgeDensity < 0 || normalizedOptions.blankMinEdgeDensity > 1) {
+    throw new Error('Blank thresholds must be a non-negative standard deviation and an edge density between 0.0 and 1.0');
+  }
+
+  if (typeof normalizedOptions.preprocessScale !== 'number' || normalizedOptions.preprocessScale <= 0 || normalizedOptions.preprocessScale > 1) {
+    throw new Error('Preprocess scale must be greater than 0.0 and at most 1.0');
+  }
+
+  if (typeof normalizedOptions.autoRotateThreshold !== 'number' || normalizedOptions.autoRotateThreshold <= 0 || normalizedOptions.autoRotateThreshold > 1) {
+    throw new Error('Auto-rotate threshold must be greater than 0.0 and at most 1.0');
+  }
+
+  if (typeof normalizedOptions.pyramidScale !== 'number' || normalizedOptions.pyramidScale <= 0 || normalizedOptions.pyramidScale >= 1) {
+    throw new Error('Pyramid scale must be greater than 0.0 and less than 1.0');
+  }
+
+  if (normalizedOptions.mode !== 'recognize' && normalizedOptions.mode !== 'detect') {
+    throw new Error("Mode must be 'recognize' or 'detect'");
+  }
+
+  if (normalizedOptions.minConfidence < 0 || normalizedOptions.minConfidence > 1) {
+    throw new Error('Minimum confidence must be between 0.0 and 1.0');
+  }
+
+  if (normalizedOptions.minObservationConfidence < 0 || normalizedOptions.minObservationConfidence > 1) {
+    throw new Error('Minimum observation confidence must be between 0.0 and 1.0');
+  }
+
+  if (normalizedOptions.minBoxSize < 0 || normalizedOptions.minBoxSize > 1) {
+    throw new Error('Minimum box size must be between 0.0 and 1.0');
+  }
+
+  if (!Number.isInteger(normalizedOptions.candidates) || normalizedOptions.candidates < 0 || normalizedOptions.candidates > 10) {
+    throw new Error('Candidates must be an integer between 0 and 10');
+  }
+
+  return normalizedOptions;
+}
+
+// Worker, memory and retry limits shared by batches, findText() and buildIndex()
+function normalizeBatchOptions(options) {
+  const normalizedOptions = {
+    ocrOptions: normalizeRecognizeOptions(options.ocrOptions || {}),
+    maxThreads: options.maxThreads || 0,
+    maxInFlightBytes: options.maxInFlightBytes ?? 0,
+    maxRetries: options.maxRetries ?? 0,
+    retryBackoffMs: options.retryBackoffMs ?? 0
+  };
+
+  if (normalizedOptions.maxThreads < 0) {
+    throw new Error('Maximum threads must be greater than or equal to 0');
+  }
+
+  if (!Number.isInteger(normalizedOptions.maxInFlightBytes) || normalizedOptions.maxInFlightBytes < 0) {
+    throw new Error('Maximum in-flight bytes must be a non-negative integer');
+  }
+
+  if (!Number.isInteger(normalizedOptions.maxRetries) || normalizedOptions.maxRetries < 0 ||
+      normalizedOptions.maxRetries > 10) {
+    throw new Error('Maximum retries must be an integer between 0 and 10');
+  }
+
+  if (typeof normalizedOptions.retryBackoffMs !== 'number' || !(normalizedOptions.retryBackoffMs >= 0)) {
+    throw new Error('Retry backoff must be a non-negative number');
+  }
+
+  return normalizedOptions;
+}
+
+// Near-duplicate skipping shared by batches and frame sessions
+function normalizeDuplicateOptions(options) {
+  const duplicateOptions = {
+    skipDuplicates: options.skipDuplicates === true,
+    duplicateDistance: options.duplicateDistance
+  };
+
+  // Left unset, the native default (OCR_DEFAULT_DUPLICATE_DISTANCE) applies
+  if (duplicateOptions.duplicateDistance !== undefined && (!Number.isInteger(duplicateOptions.duplicateDistance) ||
+      duplicateOptions.duplicateDistance < 0 || duplicateOptions.duplicateDistance > 64)) {
+    throw new Error('Duplicate distance must be an integer between 0 and 64');
+  }
+
+  return duplicateOptions;
+}
+
+// Each option set is layered over the top-level options and validated on its own
+function normalizeOptionSets(options) {
+  const { optionSets, ...base } = options;
+  if (!Array.isArray(optionSets) || optionSets.length === 0 ||
+      optionSets.some(set => set === null || typeof set !== 'object' || Array.isArray(set))) {
+    throw new Error('Option sets must be a non-empty array of option objects');
+  }
+  return optionSets.map(set => normalizeRecognizeOptions({ ...base, ...set }));
+}
+
 // Check operating system requirements
 const platform = os.platform();
 const release = os.release();
@@ -35,6 +358,7 @@ class MacOCR {
   // OCR recognition level constants
   static get RECOGNITION_LEVEL_FAST() { return 0; }
   static get RECOGNITION_LEVEL_ACCURATE() { return 1; }
+  static get RECOGNITION_LEVEL_CASCADE() { return 2; }
 
   /**
    * Perform OCR text recognition
@@ -42,40 +366,42 @@ class MacOCR {
    * @param {Object} [options] - OCR options
    * @param {string} [options.languages='en-US'] - Recognition language, multiple languages separated by commas
    * @param {number} [options.recognitionLevel=MacOCR.RECOGNITION_LEVEL_ACCURATE] - Recognition level: MacOCR.RECOGNITION_LEVEL_FAST or MacOCR.RECOGNITION_LEVEL_ACCURATE
+   * @param {number} [options.cascadeThreshold=0.5] - With RECOGNITION_LEVEL_CASCADE, fast observations below this confidence are re-recognized in accurate mode
+   * @param {number} [options.latencyBudgetMs=0] - Pick recognition level and downsampling to fit this latency (overrides recognitionLevel), 0 disables
+   * @param {number} [options.hedgeAfterMs=0] - Start a duplicate attempt if no result arrived after this long, the first to succeed wins, 0 disables
+   * @param {boolean} [options.hedgeFast=false] - Run the duplicate attempt at RECOGNITION_LEVEL_FAST
    * @param {number} [options.minConfidence=0.0] - Minimum confidence threshold 0.0-1.0
+   * @param {number} [options.minObservationConfidence=0.0] - Drop observations below this confidence before they are copied
+   * @param {number} [options.minBoxSize=0.0] - Drop observations narrower or shorter than this (0.0-1.0)
+   * @param {number} [options.candidates=0] - Return up to this many readings (0-10) per observation in observation.candidates
+   * @param {boolean} [options.spatialIndex=false] - Build the spatial index used by result.query() during recognition
+   * @param {boolean} [options.detectTable=false] - Reconstruct a table cell grid into result.table
+   * @param {boolean} [options.rejectBlank=false] - Return an empty result without running Vision for blank or near-uniform images
+   * @param {number} [options.blankMinStdDev=1.0] - With rejectBlank, images whose luminance standard deviation is below this are blank
+   * @param {number} [options.blankMinEdgeDensity=0.0002] - With rejectBlank, images with a smaller share of edge pixels are blank
+   * @param {boolean} [options.grayscale=false] - Convert to gray with the native SIMD kernels before recognition
+   * @param {boolean} [options.normalizeContrast=false] - Stretch gray levels to the full range before recognition (implies grayscale)
+   * @param {number} [options.preprocessScale=1.0] - Downscale by this factor with area averaging before recognition (implies grayscale)
+   * @param {boolean} [options.autoRotate=false] - When confidence is low, try the other 90° orientations and keep the best reading
+   * @param {number} [options.autoRotateThreshold=0.5] - With autoRotate, mean confidence below which other orientations are tried
+   * @param {boolean} [options.pyramid=false] - Detect text on a downscaled copy and recognize only those regions at full resolution
+   * @param {number} [options.pyramidScale=0.25] - With pyramid, scale of the copy text is detected on
+   * @param {string} [options.mode='recognize'] - 'detect' returns text boxes with empty text, without recognition
+   * @param {boolean} [options.routeLanguages=false] - Read a downscaled copy first and recognize with only the languages of the scripts found
+   * @param {Object[]} [options.optionSets] - Recognize once per set, each layered over these options; the image is decoded once
    * @param {string} [options.outputPath] - Output file path, if specified, the result will be saved to the file
-   * @returns {Promise<{text: string, confidence: number}>} Recognition result
+   * @returns {Promise<OCRResult|OCRResult[]>} Recognition result, or one result per option set in order
    */
   static async recognizeFromPath(imagePath, options = {}) {
     if (typeof imagePath !== 'string') {
       throw new TypeError('Image path must be a string');
     }
 
-    if (!fs.existsSync(imagePath)) {
-      throw new Error('Image file does not exist');
-    }
-
-    const ext = path.extname(imagePath).toLowerCase();
-    const validExts = ['.jpg', '.jpeg', '.png', '.tiff', '.tif', '.gif', '.bmp', 'webp'];
-    if (!validExts.includes(ext)) {
-      throw new Error(`Unsupported image format: ${ext}`);
-    }
-
     const normalizedOptions = {
-      languages: options.languages || 'en-US',
-      recognitionLevel: options.recognitionLevel ?? MacOCR.RECOGNITION_LEVEL_ACCURATE,
-      minConfidence: options.minConfidence || 0.0,
+      ...normalizeRecognizeOptions(options),
       outputPath: options.outputPath || null
     };
 
-    if (![MacOCR.RECOGNITION_LEVEL_FAST, MacOCR.RECOGNITION_LEVEL_ACCURATE].includes(normalizedOptions.recognitionLevel)) {
-      throw new Error('Recognition level must be MacOCR.RECOGNITION_LEVEL_FAST or MacOCR.RECOGNITION_LEVEL_ACCURATE');
-    }
-
-    if (normalizedOptions.minConfidence < 0 || normalizedOptions.minConfidence > 1) {
-      throw new Error('Minimum confidence must be between 0.0 and 1.0');
-    }
-
     if (normalizedOptions.outputPath) {
       const outputDir = path.dirname(normalizedOptions.outputPath);
       if (!fs.existsSync(outputDir)) {
@@ -86,11 +412,21 @@ class MacOCR {
       }
     }
 
+    if (options.optionSets !== undefined) {
+      const optionSets = normalizeOptionSets(options);
+      try {
+        const results = await recognizeOptionSets(imagePath, optionSets);
+        return results.map(result => new OCRResult(result));
+      } catch (error) {
+        throw wrapError('OCR failed', error);
+      }
+    }
+
     try {
       const result = await recognize(imagePath, normalizedOptions);
       return new OCRResult(result);
     } catch (error) {
-      throw new Error(`OCR failed: ${error.message}`);
+      throw wrapError('OCR failed', error);
     }
   }
 
@@ -101,8 +437,32 @@ class MacOCR {
    * @param {Object} [options.ocrOptions] - OCR options
    * @param {string} [options.ocrOptions.languages='en-US'] - Recognition language, multiple languages separated by commas
    * @param {number} [options.ocrOptions.recognitionLevel=MacOCR.RECOGNITION_LEVEL_ACCURATE] - Recognition level
+   * @param {number} [options.ocrOptions.cascadeThreshold=0.5] - With RECOGNITION_LEVEL_CASCADE, fast observations below this confidence are re-recognized in accurate mode
+   * @param {number} [options.ocrOptions.latencyBudgetMs=0] - Pick recognition level and downsampling to fit this latency (overrides recognitionLevel), 0 disables
    * @param {number} [options.ocrOptions.minConfidence=0.0] - Minimum confidence threshold 0.0-1.0
+   * @param {number} [options.ocrOptions.minObservationConfidence=0.0] - Drop observations below this confidence before they are copied
+   * @param {number} [options.ocrOptions.minBoxSize=0.0] - Drop observations narrower or shorter than this (0.0-1.0)
+   * @param {number} [options.ocrOptions.candidates=0] - Return up to this many readings (0-10) per observation in observation.candidates
+   * @param {boolean} [options.ocrOptions.spatialIndex=false] - Build spatial indexes during recognition
+   * @param {boolean} [options.ocrOptions.detectTable=false] - Reconstruct table cell grids
+   * @param {boolean} [options.ocrOptions.rejectBlank=false] - Return empty results without running Vision for blank or near-uniform images
+   * @param {number} [options.ocrOptions.blankMinStdDev=1.0] - With rejectBlank, luminance standard deviation below which an image is blank
+   * @param {number} [options.ocrOptions.blankMinEdgeDensity=0.0002] - With rejectBlank, share of edge pixels below which an image is blank
+   * @param {boolean} [options.ocrOptions.grayscale=false] - Convert to gray with the native SIMD kernels before recognition
+   * @param {boolean} [options.ocrOptions.normalizeContrast=false] - Stretch gray levels to the full range before recognition (implies grayscale)
+   * @param {number} [options.ocrOptions.preprocessScale=1.0] - Downscale by this factor with area averaging before recognition (implies grayscale)
+   * @param {boolean} [options.ocrOptions.autoRotate=false] - When confidence is low, try the other 90° orientations and keep the best reading
+   * @param {number} [options.ocrOptions.autoRotateThreshold=0.5] - With autoRotate, mean confidence below which other orientations are tried
+   * @param {boolean} [options.ocrOptions.pyramid=false] - Detect text on a downscaled copy and recognize only those regions at full resolution
+   * @param {number} [options.ocrOptions.pyramidScale=0.25] - With pyramid, scale of the copy text is detected on
+   * @param {string} [options.ocrOptions.mode='recognize'] - 'detect' returns text boxes with empty text, without recognition
+   * @param {boolean} [options.ocrOptions.routeLanguages=false] - Read a downscaled copy first and recognize with only the languages of the scripts found
+   * @param {boolean} [options.skipDuplicates=false] - Reuse the result of a near-duplicate image instead of recognizing it again
+   * @param {number} [options.duplicateDistance=3] - Largest perceptual hash distance (0-64) counted as a near-duplicate
    * @param {number} [options.maxThreads=0] - Maximum number of threads, 0 means using system CPU cores
+   * @param {number} [options.maxInFlightBytes=0] - Estimated decoded bytes of images in flight at once, 0 means no limit
+   * @param {number} [options.maxRetries=0] - Extra decode attempts (0-10) for an image failing with a transient read error
+   * @param {number} [options.retryBackoffMs=50] - Wait before the first retry, doubled before each next one
    * @param {number} [options.batchSize=1] - Batch size
    * @returns {Promise<Array<{text: string, confidence: number}>>} Recognition result array
    */
@@ -119,40 +479,11 @@ class MacOCR {
       if (typeof imagePath !== 'string') {
         throw new TypeError('Each image path must be a string');
       }
-
-      if (!fs.existsSync(imagePath)) {
-        throw new Error(`Image file does not exist: ${imagePath}`);
-      }
-
-      const ext = path.extname(imagePath).toLowerCase();
-      const validExts = ['.jpg', '.jpeg', '.png', '.tiff', '.tif', '.gif', '.bmp', '.webp'];
-      if (!validExts.includes(ext)) {
-        throw new Error(`Unsupported image format: ${ext}`);
-      }
-    }
-
-    const normalizedOptions = {
-      ocrOptions: {
-        languages: options.ocrOptions?.languages || 'en-US',
-        recognitionLevel: options.ocrOptions?.recognitionLevel ?? MacOCR.RECOGNITION_LEVEL_ACCURATE,
-        minConfidence: options.ocrOptions?.minConfidence || 0.0
-      },
-      maxThreads: options.maxThreads || 0,
-      batchSize: options.batchSize || 1
-    };
-
-    if (![MacOCR.RECOGNITION_LEVEL_FAST, MacOCR.RECOGNITION_LEVEL_ACCURATE]
-        .includes(normalizedOptions.ocrOptions.recognitionLevel)) {
-      throw new Error('Recognition level must be MacOCR.RECOGNITION_LEVEL_FAST or MacOCR.RECOGNITION_LEVEL_ACCURATE');
-    }
-
-    if (normalizedOptions.ocrOptions.minConfidence < 0 || normalizedOptions.ocrOptions.minConfidence > 1) {
-      throw new Error('Minimum confidence must be between 0.0 and 1.0');
     }
 
-    if (normalizedOptions.maxThreads < 0) {
-      throw new Error('Maximum threads must be greater than or equal to 0');
-    }
+    const normalizedOptions = normalizeBatchOptions(options);
+    Object.assign(normalizedOptions.ocrOptions, normalizeDuplicateOptions(options));
+    normalizedOptions.batchSize = options.batchSize || 1;
 
     if (normalizedOptions.batchSize < 1) {
       throw new Error('Batch size must be greater than 0');
@@ -162,7 +493,7 @@ class MacOCR {
       const results = await recognizeBatch(imagePaths, normalizedOptions);
       return results.map(result => new OCRResult(result));
     } catch (error) {
-      throw new Error(`Batch OCR failed: ${error.message}`);
+      throw wrapError('Batch OCR failed', error);
     }
   }
 
@@ -172,8 +503,30 @@ class MacOCR {
    * @param {Object} [options] - OCR options
    * @param {string} [options.languages='en-US'] - Recognition language, multiple languages separated by commas
    * @param {number} [options.recognitionLevel=MacOCR.RECOGNITION_LEVEL_ACCURATE] - Recognition level: MacOCR.RECOGNITION_LEVEL_FAST or MacOCR.RECOGNITION_LEVEL_ACCURATE
+   * @param {number} [options.cascadeThreshold=0.5] - With RECOGNITION_LEVEL_CASCADE, fast observations below this confidence are re-recognized in accurate mode
+   * @param {number} [options.latencyBudgetMs=0] - Pick recognition level and downsampling to fit this latency (overrides recognitionLevel), 0 disables
+   * @param {number} [options.hedgeAfterMs=0] - Start a duplicate attempt if no result arrived after this long, the first to succeed wins, 0 disables
+   * @param {boolean} [options.hedgeFast=false] - Run the duplicate attempt at RECOGNITION_LEVEL_FAST
    * @param {number} [options.minConfidence=0.0] - Minimum confidence threshold 0.0-1.0
-   * @returns {Promise<{text: string, confidence: number}>} Recognition result
+   * @param {number} [options.minObservationConfidence=0.0] - Drop observations below this confidence before they are copied
+   * @param {number} [options.minBoxSize=0.0] - Drop observations narrower or shorter than this (0.0-1.0)
+   * @param {number} [options.candidates=0] - Return up to this many readings (0-10) per observation in observation.candidates
+   * @param {boolean} [options.spatialIndex=false] - Build the spatial index used by result.query() during recognition
+   * @param {boolean} [options.detectTable=false] - Reconstruct a table cell grid into result.table
+   * @param {boolean} [options.rejectBlank=false] - Return an empty result without running Vision for blank or near-uniform images
+   * @param {number} [options.blankMinStdDev=1.0] - With rejectBlank, images whose luminance standard deviation is below this are blank
+   * @param {number} [options.blankMinEdgeDensity=0.0002] - With rejectBlank, images with a smaller share of edge pixels are blank
+   * @param {boolean} [options.grayscale=false] - Convert to gray with the native SIMD kernels before recognition
+   * @param {boolean} [options.normalizeContrast=false] - Stretch gray levels to the full range before recognition (implies grayscale)
+   * @param {number} [options.preprocessScale=1.0] - Downscale by this factor with area averaging before recognition (implies grayscale)
+   * @param {boolean} [options.autoRotate=false] - When confidence is low, try the other 90° orientations and keep the best reading
+   * @param {number} [options.autoRotateThreshold=0.5] - With autoRotate, mean confidence below which other orientations are tried
+   * @param {boolean} [options.pyramid=false] - Detect text on a downscaled copy and recognize only those regions at full resolution
+   * @param {number} [options.pyramidScale=0.25] - With pyramid, scale of the copy text is detected on
+   * @param {string} [options.mode='recognize'] - 'detect' returns text boxes with empty text, without recognition
+   * @param {boolean} [options.routeLanguages=false] - Read a downscaled copy first and recognize with only the languages of the scripts found
+   * @param {Object[]} [options.optionSets] - Recognize once per set, each layered over these options; the image is decoded once
+   * @returns {Promise<OCRResult|OCRResult[]>} Recognition result, or one result per option set in order
    */
   static async recognizeFromBuffer(imageBuffer, options = {}) {
 
@@ -187,18 +540,16 @@ class MacOCR {
       throw new Error('Image buffer cannot be empty');
     }
 
-    const normalizedOptions = {
-      languages: options.languages || 'en-US',
-      recognitionLevel: options.recognitionLevel ?? MacOCR.RECOGNITION_LEVEL_ACCURATE,
-      minConfidence: options.minConfidence || 0.0
-    };
+    const normalizedOptions = normalizeRecognizeOptions(options);
 
-    if (![MacOCR.RECOGNITION_LEVEL_FAST, MacOCR.RECOGNITION_LEVEL_ACCURATE].includes(normalizedOptions.recognitionLevel)) {
-      throw new Error('Recognition level must be MacOCR.RECOGNITION_LEVEL_FAST or MacOCR.RECOGNITION_LEVEL_ACCURATE');
-    }
-
-    if (normalizedOptions.minConfidence < 0 || normalizedOptions.minConfidence > 1) {
-      throw new Error('Minimum confidence must be between 0.0 and 1.0');
+    if (options.optionSets !== undefined) {
+      const optionSets = normalizeOptionSets(options);
+      try {
+        const results = await recognizeOptionSets(buffer, optionSets);
+        return results.map(result => new OCRResult(result));
+      } catch (error) {
+        throw wrapError('OCR failed', error);
+      }
     }
 
     try {
@@ -208,7 +559,7 @@ class MacOCR {
       if (error instanceof TypeError) {
         throw error;
       }
-      throw new Error(`OCR failed: ${error.message}`);
+      throw wrapError('OCR failed', error);
     }
   }
 
@@ -219,8 +570,32 @@ class MacOCR {
    * @param {Object} [options.ocrOptions] - OCR options for each image
    * @param {string} [options.ocrOptions.languages='en-US'] - Recognition language, multiple languages separated by commas
    * @param {number} [options.ocrOptions.recognitionLevel=MacOCR.RECOGNITION_LEVEL_ACCURATE] - Recognition level
+   * @param {number} [options.ocrOptions.cascadeThreshold=0.5] - With RECOGNITION_LEVEL_CASCADE, fast observations below this confidence are re-recognized in accurate mode
+   * @param {number} [options.ocrOptions.latencyBudgetMs=0] - Pick recognition level and downsampling to fit this latency (overrides recognitionLevel), 0 disables
    * @param {number} [options.ocrOptions.minConfidence=0.0] - Minimum confidence threshold 0.0-1.0
+   * @param {number} [options.ocrOptions.minObservationConfidence=0.0] - Drop observations below this confidence before they are copied
+   * @param {number} [options.ocrOptions.minBoxSize=0.0] - Drop observations narrower or shorter than this (0.0-1.0)
+   * @param {number} [options.ocrOptions.candidates=0] - Return up to this many readings (0-10) per observation in observation.candidates
+   * @param {boolean} [options.ocrOptions.spatialIndex=false] - Build spatial indexes during recognition
+   * @param {boolean} [options.ocrOptions.detectTable=false] - Reconstruct table cell grids
+   * @param {boolean} [options.ocrOptions.rejectBlank=false] - Return empty results without running Vision for blank or near-uniform images
+   * @param {number} [options.ocrOptions.blankMinStdDev=1.0] - With rejectBlank, luminance standard deviation below which an image is blank
+   * @param {number} [options.ocrOptions.blankMinEdgeDensity=0.0002] - With rejectBlank, share of edge pixels below which an image is blank
+   * @param {boolean} [options.ocrOptions.grayscale=false] - Convert to gray with the native SIMD kernels before recognition
+   * @param {boolean} [options.ocrOptions.normalizeContrast=false] - Stretch gray levels to the full range before recognition (implies grayscale)
+   * @param {number} [options.ocrOptions.preprocessScale=1.0] - Downscale by this factor with area averaging before recognition (implies grayscale)
+   * @param {boolean} [options.ocrOptions.autoRotate=false] - When confidence is low, try the other 90° orientations and keep the best reading
+   * @param {number} [options.ocrOptions.autoRotateThreshold=0.5] - With autoRotate, mean confidence below which other orientations are tried
+   * @param {boolean} [options.ocrOptions.pyramid=false] - Detect text on a downscaled copy and recognize only those regions at full resolution
+   * @param {number} [options.ocrOptions.pyramidScale=0.25] - With pyramid, scale of the copy text is detected on
+   * @param {string} [options.ocrOptions.mode='recognize'] - 'detect' returns text boxes with empty text, without recognition
+   * @param {boolean} [options.ocrOptions.routeLanguages=false] - Read a downscaled copy first and recognize with only the languages of the scripts found
+   * @param {boolean} [options.skipDuplicates=false] - Reuse the result of a near-duplicate image instead of recognizing it again
+   * @param {number} [options.duplicateDistance=3] - Largest perceptual hash distance (0-64) counted as a near-duplicate
    * @param {number} [options.maxThreads=0] - Maximum number of threads (0 = auto)
+   * @param {number} [options.maxInFlightBytes=0] - Estimated decoded bytes of images in flight at once (0 = no limit)
+   * @param {number} [options.maxRetries=0] - Extra decode attempts (0-10) for an image failing with a transient read error
+   * @param {number} [options.retryBackoffMs=50] - Wait before the first retry, doubled before each next one
    * @param {number} [options.batchSize=1] - Batch size
    * @returns {Promise<Array<{text: string, confidence: number}>>} Array of recognition results
    */
@@ -242,41 +617,266 @@ class MacOCR {
       }
     }
 
+    const normalizedOptions = normalizeBatchOptions(options);
+    Object.assign(normalizedOptions.ocrOptions, normalizeDuplicateOptions(options));
+    normalizedOptions.batchSize = options.batchSize || 1;
+
+    if (normalizedOptions.batchSize < 1) {
+      throw new Error('Batch size must be greater than 0');
+    }
+
+    try {
+      const buffers = imageBuffers.map(buffer => Buffer.isBuffer(buffer) ? buffer : Buffer.from(buffer));
+      const results = await recognizeBatchFromBuffer(buffers, normalizedOptions);
+      return results.map(result => new OCRResult(result));
+    } catch (error) {
+      if (error instanceof TypeError) {
+        throw error;
+      }
+      throw wrapError('Batch OCR failed', error);
+    }
+  }
+
+  /**
+   * Search for text across images without marshaling full results
+   * Matching runs natively as each image is recognized, and once stopAfter matches
+   * are found the images still queued are skipped without being decoded
+   * @param {Array<string|Buffer|Uint8Array>} inputs - Image file paths and/or image buffers
+   * @param {string} pattern - Text to search for, or a regular expression (ICU syntax) when options.regex is set
+   * @param {Object} [options] - Search options
+   * @param {boolean} [options.regex=false] - Treat pattern as a regular expression
+   * @param {boolean} [options.caseInsensitive=false] - Ignore case when matching
+   * @param {number} [options.stopAfter=0] - Stop after this many matches, 0 means no limit
+   * @param {Object} [options.ocrOptions] - OCR options, see recognizeBatchFromPath()
+   * @param {number} [options.maxThreads=0] - Maximum number of threads (0 = auto)
+   * @param {number} [options.maxInFlightBytes=0] - Estimated decoded bytes of images in flight at once (0 = no limit)
+   * @param {number} [options.maxRetries=0] - Extra decode attempts (0-10) for an image failing with a transient read error
+   * @param {number} [options.retryBackoffMs=50] - Wait before the first retry, doubled before each next one
+   * @returns {Promise<{matches: Array<Object>, processed: number, failed: number, skipped: number}>} Matches ordered by input
+   */
+  static async findText(inputs, pattern, options = {}) {
+    if (!Array.isArray(inputs)) {
+      throw new TypeError('Inputs must be an array');
+    }
+
+    if (inputs.length === 0) {
+      throw new Error('Inputs array cannot be empty');
+    }
+
+    for (const input of inputs) {
+      if (typeof input !== 'string' && !(Buffer.isBuffer(input) || input instanceof Uint8Array)) {
+        throw new TypeError('Each input must be an image path, a Buffer or a Uint8Array');
+      }
+    }
+
+    if (typeof pattern !== 'string' || pattern.length === 0) {
+      throw new TypeError('Pattern must be a non-empty string');
+    }
+
     const normalizedOptions = {
-      ocrOptions: {
-        languages: options.ocrOptions?.languages || 'en-US',
-        recognitionLevel: options.ocrOptions?.recognitionLevel ?? MacOCR.RECOGNITION_LEVEL_ACCURATE,
-        minConfidence: options.ocrOptions?.minConfidence || 0.0
-      },
-      maxThreads: options.maxThreads || 0,
-      batchSize: options.batchSize || 1
+      ...normalizeBatchOptions(options),
+      regex: options.regex === true,
+      caseInsensitive: options.caseInsensitive === true,
+      stopAfter: options.stopAfter || 0
     };
 
-    if (![MacOCR.RECOGNITION_LEVEL_FAST, MacOCR.RECOGNITION_LEVEL_ACCURATE].includes(normalizedOptions.ocrOptions.recognitionLevel)) {
-      throw new Error('Recognition level must be MacOCR.RECOGNITION_LEVEL_FAST or MacOCR.RECOGNITION_LEVEL_ACCURATE');
+    if (!Number.isInteger(normalizedOptions.stopAfter) || normalizedOptions.stopAfter < 0) {
+      throw new Error('stopAfter must be a non-negative integer');
+    }
+
+    try {
+      const nativeInputs = inputs.map(input =>
+        typeof input === 'string' || Buffer.isBuffer(input) ? input : Buffer.from(input)
+      );
+      return await findText(nativeInputs, pattern, normalizedOptions);
+    } catch (error) {
+      throw wrapError('Text search failed', error);
+    }
+  }
+
+  /**
+   * Recognize images and write an inverted index of their text
+   * Each image is tokenized natively as soon as it is recognized, so indexing
+   * overlaps with the recognition of the remaining images
+   * @param {Array<string|Buffer|Uint8Array>} inputs - Image file paths and/or image buffers
+   * @param {string} indexPath - Output index file path
+   * @param {Object} [options] - Batch options
+   * @param {Object} [options.ocrOptions] - OCR options, see recognizeBatchFromPath()
+   * @param {number} [options.maxThreads=0] - Maximum number of threads (0 = auto)
+   * @param {number} [options.maxInFlightBytes=0] - Estimated decoded bytes of images in flight at once (0 = no limit)
+   * @param {number} [options.maxRetries=0] - Extra decode attempts (0-10) for an image failing with a transient read error
+   * @param {number} [options.retryBackoffMs=50] - Wait before the first retry, doubled before each next one
+   * @returns {Promise<{documents: number, failed: number, terms: number, postings: number}>} Index statistics
+   */
+  static async buildIndex(inputs, indexPath, options = {}) {
+    if (!Array.isArray(inputs)) {
+      throw new TypeError('Inputs must be an array');
     }
 
-    if (normalizedOptions.ocrOptions.minConfidence < 0 || normalizedOptions.ocrOptions.minConfidence > 1) {
-      throw new Error('Minimum confidence must be between 0.0 and 1.0');
+    if (inputs.length === 0) {
+      throw new Error('Inputs array cannot be empty');
     }
 
-    if (normalizedOptions.maxThreads < 0) {
-      throw new Error('Maximum threads must be greater than or equal to 0');
+    for (const input of inputs) {
+      if (typeof input !== 'string' && !(Buffer.isBuffer(input) || input instanceof Uint8Array)) {
+        throw new TypeError('Each input must be an image path, a Buffer or a Uint8Array');
+      }
     }
 
-    if (normalizedOptions.batchSize < 1) {
-      throw new Error('Batch size must be greater than 0');
+    if (typeof indexPath !== 'string' || indexPath.length === 0) {
+      throw new TypeError('Index path must be a non-empty string');
     }
 
+    const normalizedOptions = normalizeBatchOptions(options);
+
     try {
-      const buffers = imageBuffers.map(buffer => Buffer.isBuffer(buffer) ? buffer : Buffer.from(buffer));
-      const results = await recognizeBatchFromBuffer(buffers, normalizedOptions);
-      return results.map(result => new OCRResult(result));
+      const nativeInputs = inputs.map(input =>
+        typeof input === 'string' || Buffer.isBuffer(input) ? input : Buffer.from(input)
+      );
+      return await buildIndex(nativeInputs, path.resolve(indexPath), normalizedOptions);
     } catch (error) {
-      if (error instanceof TypeError) {
-        throw error;
+      throw wrapError('Index build failed', error);
+    }
+  }
+
+  /**
+   * Create a session for a sequence of frames such as periodic screen captures
+   * Each frame is compared with the previous one in tiles; unchanged observations are
+   * carried forward and only the changed regions are recognized again
+   * @param {Object} [options] - OCR options applied to every frame
+   * @param {string} [options.languages='en-US'] - Recognition language, multiple languages separated by commas
+   * @param {number} [options.recognitionLevel=MacOCR.RECOGNITION_LEVEL_ACCURATE] - Recognition level for changed regions
+   * @param {number} [options.minConfidence=0.0] - Minimum confidence threshold 0.0-1.0
+   * @param {number} [options.minObservationConfidence=0.0] - Drop observations below this confidence before they are copied
+   * @param {number} [options.minBoxSize=0.0] - Drop observations narrower or shorter than this (0.0-1.0)
+   * @param {number} [options.candidates=0] - Return up to this many readings (0-10) per observation in observation.candidates
+   * @param {boolean} [options.spatialIndex=false] - Build the spatial index used by result.query() for each frame
+   * @param {boolean} [options.detectTable=false] - Reconstruct a table cell grid into result.table
+   * @param {string} [options.mode='recognize'] - 'detect' finds text boxes in changed regions without reading them
+   * @param {boolean} [options.skipDuplicates=false] - Reuse the last result for frames that are near-duplicates of the last recognized frame
+   * @param {number} [options.duplicateDistance=3] - Largest perceptual hash distance (0-64) counted as a near-duplicate
+   * @param {number} [options.tileSize=64] - Side of the tiles compared between frames, in pixels (8-1024)
+   * @returns {FrameSession} Session with recognize(), reset() and close()
+   */
+  static createFrameSession(options = {}) {
+    const normalizedOptions = {
+      ...normalizeRecognizeOptions(options),
+      ...normalizeDuplicateOptions(options)
+    };
+    const tileSize = options.tileSize ?? 64;
+
+    for (const name of FRAME_UNSUPPORTED_OPTIONS) {
+      if (normalizedOptions[name]) {
+        throw invalidArgument(`Frame sessions do not support ${name}`);
+      }
+    }
+    if (normalizedOptions.preprocessScale !== 1.0) {
+      throw invalidArgument('Frame sessions do not support preprocessScale');
+    }
+
+    if (!Number.isInteger(tileSize) || tileSize < 8 || tileSize > 1024) {
+      throw new Error('Tile size must be an integer between 8 and 1024');
+    }
+
+    return new FrameSession(createFrameSession(normalizedOptions, tileSize));
+  }
+
+  /**
+   * Hedging counters accumulated since the process started
+   * hedged / calls is the share of recognitions that paid for a second attempt
+   * @returns {{calls: number, hedged: number, hedgeWins: number, hedgeRate: number}} Hedging statistics
+   */
+  static getHedgeStats() {
+    const stats = getHedgeStats();
+    return {
+      ...stats,
+      hedgeRate: stats.calls > 0 ? stats.hedged / stats.calls : 0
+    };
+  }
+
+  /**
+   * Blank page counters accumulated since the process started
+   * Only recognitions with rejectBlank are checked
+   * @returns {{checked: number, rejected: number, rejectRate: number}} Blank rejection statistics
+   */
+  static getBlankStats() {
+    const stats = getBlankStats();
+    return {
+      ...stats,
+      rejectRate: stats.checked > 0 ? stats.rejected / stats.checked : 0
+    };
+  }
+
+  /**
+   * Language routing counters accumulated since the process started
+   * Accurate recognitions with more than one language are timed whether routed or not;
+   * savedMs prices narrowed images at the full-list cost per megapixel, less the script passes
+   * @returns {{routed: number, narrowed: number, probeMs: number, narrowedMs: number, narrowedMegapixels: number, fullMs: number, fullMegapixels: number, savedMs: number, narrowRate: number}} Routing statistics
+   */
+  static getRoutingStats() {
+    const stats = getRoutingStats();
+    return {
+      ...stats,
+      narrowRate: stats.routed > 0 ? stats.narrowed / stats.routed : 0
+    };
+  }
+
+  /**
+   * Batch admission counters accumulated since the process started
+   * peakInFlightBytes is the most estimated decoded bytes any one batch held at once
+   * @returns {{batches: number, admitted: number, deferred: number, waitMs: number, peakInFlightBytes: number}} Admission statistics
+   */
+  static getAdmissionStats() {
+    return getAdmissionStats();
+  }
+
+  /**
+   * Counters of the pixel buffer pool shared by decode and preprocessing
+   * highWaterBytes is the most memory the pool held at once, in use and cached together
+   * @returns {{acquired: number, reused: number, oversized: number, inUseBytes: number, cachedBytes: number, highWaterBytes: number, trimmedBytes: number, reuseRate: number}} Pool statistics
+   */
+  static getPixelPoolStats() {
+    const stats = getPixelPoolStats();
+    return {
+      ...stats,
+      reuseRate: stats.acquired > 0 ? stats.reused / stats.acquired : 0
+    };
+  }
+
+  /**
+   * Read an image's dimensions, bit depth and frame count from its header without decoding it
+   * PNG, JPEG, TIFF and GIF are understood; files are memory-mapped, so only the header is read
+   * @param {string|Buffer|Uint8Array} input - Image path or encoded image bytes
+   * @returns {{format: string, width: number, height: number, bitsPerComponent: number, components: number, frameCount: number, decodedBytes: number}} Header fields and the estimated decoded size in bytes
+   */
+  static probe(input) {
+    if (typeof input === 'string') {
+      if (input.length === 0) {
+        throw new TypeError('Image path must be a non-empty string');
       }
-      throw new Error(`Batch OCR failed: ${error.message}`);
+      return probe(input);
+    }
+    if (!(Buffer.isBuffer(input) || input instanceof Uint8Array)) {
+      throw new TypeError('Input must be an image path, Buffer or Uint8Array');
+    }
+    return probe(Buffer.isBuffer(input) ? input : Buffer.from(input.buffer, input.byteOffset, input.byteLength));
+  }
+
+  /**
+   * Open an index written by buildIndex()
+   * The file is memory-mapped, so opening is constant time and lookups read it in place
+   * @param {string} indexPath - Index file path
+   * @returns {OCRIndex} Index with lookup(), search() and close()
+   */
+  static openIndex(indexPath) {
+    if (typeof indexPath !== 'string' || indexPath.length === 0) {
+      throw new TypeError('Index path must be a non-empty string');
+    }
+
+    try {
+      return new OCRIndex(openIndex(path.resolve(indexPath)));
+    } catch (error) {
+      throw wrapError('Failed to open index', error);
     }
   }
 }
@@ -4,6 +4,7 @@ const fs = require('fs');
 const { Buffer } = require('buffer');
 const { createTestImage, createPrecisionTestImage } = require('./createTestImage');
 const { v4: uuidv4 } = require('uuid');
+const sharp = require('sharp');
 
 describe('MacOCR', () => {
   let testImagePath;
@@ -61,6 +62,10 @@ describe('MacOCR', () => {
     test('should have RECOGNITION_LEVEL_ACCURATE constant', () => {
       expect(MacOCR.RECOGNITION_LEVEL_ACCURATE).toBe(1);
     });
+
+    test('should have RECOGNITION_LEVEL_CASCADE constant', () => {
+      expect(MacOCR.RECOGNITION_LEVEL_CASCADE).toBe(2);
+    });
   });
 
   describe('recognize()', () => {
@@ -71,20 +76,33 @@ describe('MacOCR', () => {
     });
 
     test('should throw Error for non-existent image file', async () => {
-      await expect(MacOCR.recognizeFromPath('nonexistent.jpg')).rejects.toThrow(
-        'Image file does not exist'
-      );
+      await expect(MacOCR.recognizeFromPath('nonexistent.jpg')).rejects.toMatchObject({
+        message: expect.stringContaining('Image file does not exist'),
+        code: 'ERR_OCR_FILE_NOT_FOUND'
+      });
     });
 
     test('should throw Error for unsupported image format', async () => {
-      const badFileName = path.join(fixturesDir, `bad-format-${uuidv4()}.xyz`);
+      const badFileName = path.join(fixturesDir, `bad-format-${uuidv4()}.png`);
       await fs.promises.writeFile(badFileName, 'dummy content');
-      await expect(MacOCR.recognizeFromPath(badFileName)).rejects.toThrow(
-        'Unsupported image format'
-      );
+      await expect(MacOCR.recognizeFromPath(badFileName)).rejects.toMatchObject({
+        message: expect.stringContaining('Unsupported image format'),
+        code: 'ERR_OCR_UNSUPPORTED_FORMAT'
+      });
       await fs.promises.unlink(badFileName);
     });
 
+    test('should recognize an image by its content whatever its extension', async () => {
+      const misnamedPath = path.join(fixturesDir, `misnamed-${uuidv4()}.dat`);
+      await fs.promises.copyFile(testImagePath, misnamedPath);
+      try {
+        const result = await MacOCR.recognizeFromPath(misnamedPath);
+        expect(result.text).toContain('MacOCR');
+      } finally {
+        await fs.promises.unlink(misnamedPath);
+      }
+    });
+
     test('should throw Error for invalid recognition level', async () => {
       expect(fs.existsSync(testImagePath)).toBe(true);
       await expect(
@@ -104,6 +122,298 @@ describe('MacOCR', () => {
       );
     });
 
+    test('should drop observations below the native filters', async () => {
+      await expect(MacOCR.recognizeFromPath(testImagePath, { minObservationConfidence: 2 })).rejects.toThrow(
+        'Minimum observation confidence must be between 0.0 and 1.0'
+      );
+      await expect(MacOCR.recognizeFromPath(testImagePath, { minBoxSize: -0.1 })).rejects.toThrow(
+        'Minimum box size must be between 0.0 and 1.0'
+      );
+
+      const unfiltered = await MacOCR.recognizeFromPath(testImagePath);
+      expect(unfiltered.droppedObservations).toBe(0);
+
+      // No text box covers the whole image, so everything is dropped before assembly
+      const filtered = await MacOCR.recognizeFromPath(testImagePath, { minBoxSize: 1.0 });
+      expect(filtered.observations).toHaveLength(0);
+      expect(filtered.text).toBe('');
+      expect(filtered.droppedObservations).toBe(unfiltered.observations.length);
+    });
+
+    test('should return alternative candidates only when requested', async () => {
+      await expect(MacOCR.recognizeFromPath(testImagePath, { candidates: 11 })).rejects.toThrow(
+        'Candidates must be an integer between 0 and 10'
+      );
+
+      const plain = await MacOCR.recognizeFromPath(testImagePath);
+      plain.observations.forEach(obs => expect(obs.candidates).toBeUndefined());
+
+      const result = await MacOCR.recognizeFromPath(testImagePath, { candidates: 3 });
+      expect(result.observations.length).toBeGreaterThan(0);
+      result.observations.forEach(obs => {
+        expect(obs.candidates.length).toBeGreaterThanOrEqual(1);
+        expect(obs.candidates.length).toBeLessThanOrEqual(3);
+        expect(obs.candidates[0].text).toBe(obs.text);
+        for (let i = 1; i < obs.candidates.length; i++) {
+          expect(obs.candidates[i].confidence).toBeLessThanOrEqual(obs.candidates[i - 1].confidence);
+        }
+      });
+    });
+
+    test('should recognize in cascade mode and report escalation', async () => {
+      await expect(
+        MacOCR.recognizeFromPath(testImagePath, { recognitionLevel: MacOCR.RECOGNITION_LEVEL_CASCADE, cascadeThreshold: 0 })
+      ).rejects.toThrow('Cascade threshold must be greater than 0.0 and at most 1.0');
+
+      const result = await MacOCR.recognizeFromPath(testImagePath, {
+        recognitionLevel: MacOCR.RECOGNITION_LEVEL_CASCADE,
+      });
+      expect(result.text).toContain('MacOCR');
+      expect(result.cascade).not.toBeNull();
+      expect(result.cascade.escalatedObservations).toBeLessThanOrEqual(result.cascade.fastObservations);
+      // Uncertain observations are always re-read, either by region or with the whole image
+      if (result.cascade.escalatedObservations > 0) {
+        expect(result.cascade.imageEscalated || result.cascade.regions > 0).toBe(true);
+      }
+
+      const plain = await MacOCR.recognizeFromPath(testImagePath);
+      expect(plain.cascade).toBeNull();
+    });
+
+    test('should plan recognition for a latency budget', async () => {
+      await expect(MacOCR.recognizeFromPath(testImagePath, { latencyBudgetMs: -1 })).rejects.toThrow(
+        'Latency budget must be a non-negative number of milliseconds'
+      );
+
+      const plain = await MacOCR.recognizeFromPath(testImagePath);
+      expect(plain.budget).toBeNull();
+
+      const result = await MacOCR.recognizeFromPath(testImagePath, { latencyBudgetMs: 5000 });
+      expect(result.budget).not.toBeNull();
+      expect([MacOCR.RECOGNITION_LEVEL_FAST, MacOCR.RECOGNITION_LEVEL_ACCURATE]).toContain(result.budget.recognitionLevel);
+      expect(result.budget.scale).toBeGreaterThan(0);
+      expect(result.budget.scale).toBeLessThanOrEqual(1);
+      expect(result.budget.elapsedMs).toBeGreaterThan(0);
+      expect(result.text).toContain('MacOCR');
+
+      // An impossible budget still recognizes, with the cheapest plan
+      const tight = await MacOCR.recognizeFromPath(testImagePath, { latencyBudgetMs: 0.001 });
+      expect(tight.budget.withinBudget).toBe(false);
+      expect(tight.budget.recognitionLevel).toBe(MacOCR.RECOGNITION_LEVEL_FAST);
+    });
+
+    test('should hedge a slow recognition with a duplicate attempt', async () => {
+      await expect(MacOCR.recognizeFromPath(testImagePath, { hedgeAfterMs: -1 })).rejects.toThrow(
+        'Hedge delay must be a non-negative number of milliseconds'
+      );
+
+      const plain = await MacOCR.recognizeFromPath(testImagePath);
+      expect(plain.hedge).toBeNull();
+
+      const before = MacOCR.getHedgeStats();
+      // No recognition finishes in a microsecond, so the duplicate always starts
+      const result = await MacOCR.recognizeFromPath(testImagePath, { hedgeAfterMs: 0.001 });
+      expect(result.hedge).not.toBeNull();
+      expect(result.hedge.launched).toBe(true);
+      expect(typeof result.hedge.won).toBe('boolean');
+      expect(result.text).toContain('MacOCR');
+
+      const after = MacOCR.getHedgeStats();
+      expect(after.calls).toBe(before.calls + 1);
+      expect(after.hedged).toBe(before.hedged + 1);
+      expect(after.hedgeRate).toBeGreaterThan(0);
+      expect(after.hedgeRate).toBeLessThanOrEqual(1);
+    });
+
+    test('should reject blank pages without recognizing them', async () => {
+      await expect(MacOCR.recognizeFromPath(testImagePath, { rejectBlank: true, blankMinEdgeDensity: 2 })).rejects.toThrow(
+        'Blank thresholds must be a non-negative standard deviation and an edge density between 0.0 and 1.0'
+      );
+
+      const blankPage = await sharp({
+        create: { width: 400, height: 300, channels: 3, background: { r: 255, g: 255, b: 255 } }
+      }).png().toBuffer();
+
+      const before = MacOCR.getBlankStats();
+      const blank = await MacOCR.recognizeFromBuffer(blankPage, { rejectBlank: true });
+      expect(blank.blank).toBe(true);
+      expect(blank.text).toBe('');
+      expect(blank.observations).toHaveLength(0);
+
+      // Text pages pass the check and are recognized as usual
+      const page = await MacOCR.recognizeFromPath(testImagePath, { rejectBlank: true });
+      expect(page.blank).toBe(false);
+      expect(page.text).toContain('MacOCR');
+
+      const after = MacOCR.getBlankStats();
+      expect(after.checked).toBe(before.checked + 2);
+      expect(after.rejected).toBe(before.rejected + 1);
+    });
+
+    test('should preprocess images before recognizing them', async () => {
+      await expect(MacOCR.recognizeFromPath(testImagePath, { preprocessScale: 0 })).rejects.toThrow(
+        'Preprocess scale must be greater than 0.0 and at most 1.0'
+      );
+
+      const result = await MacOCR.recognizeFromPath(testImagePath, {
+        grayscale: true,
+        normalizeContrast: true,
+        preprocessScale: 0.75
+      });
+      expect(result.text).toContain('MacOCR');
+    });
+
+    test('should apply EXIF orientation when decoding', async () => {
+      // Pixels stored a quarter turn counter-clockwise, tagged to display turned back
+      const tagged = await sharp(testImagePath).rotate(270).withMetadata({ orientation: 6 }).jpeg().toBuffer();
+      const result = await MacOCR.recognizeFromBuffer(tagged);
+      expect(result.text).toContain('MacOCR');
+      expect(result.rotation).toBe(0);
+    });
+
+    test('should find the orientation of sideways images with autoRotate', async () => {
+      await expect(MacOCR.recognizeFromPath(testImagePath, { autoRotate: true, autoRotateThreshold: 0 })).rejects.toThrow(
+        'Auto-rotate threshold must be greater than 0.0 and at most 1.0'
+      );
+
+      const sideways = await sharp(testImagePath).rotate(270).png().toBuffer();
+      const result = await MacOCR.recognizeFromBuffer(sideways, { autoRotate: true, autoRotateThreshold: 1 });
+      expect(result.rotation).toBe(90);
+      expect(result.text).toContain('MacOCR');
+
+      const upright = await MacOCR.recognizeFromPath(testImagePath, { autoRotate: true });
+      expect(upright.rotation).toBe(0);
+    });
+
+    test('should recognize detected regions at full resolution with pyramid', async () => {
+      await expect(MacOCR.recognizeFromPath(testImagePath, { pyramid: true, pyramidScale: 1 })).rejects.toThrow(
+        'Pyramid scale must be greater than 0.0 and less than 1.0'
+      );
+
+      // The test image on a large empty canvas
+      const { width, height } = await sharp(testImagePath).metadata();
+      const poster = await sharp({
+        create: { width: width * 4, height: height * 4, channels: 3, background: { r: 255, g: 255, b: 255 } }
+      }).composite([{ input: testImagePath, left: width * 2, top: height }]).png().toBuffer();
+
+      const result = await MacOCR.recognizeFromBuffer(poster, { pyramid: true, pyramidScale: 0.5 });
+      expect(result.text).toContain('MacOCR');
+      expect(result.pyramid.detectedObservations).toBeGreaterThan(0);
+      expect(result.pyramid.regions).toBeGreaterThan(0);
+      expect(result.pyramid.coveredArea).toBeLessThan(0.6);
+      // Observations are mapped back into the quarter of the canvas holding the image
+      for (const obs of result.observations) {
+        expect(obs.x).toBeGreaterThanOrEqual(0.5);
+        expect(obs.y + obs.height).toBeLessThanOrEqual(0.75 + 1e-6);
+      }
+    });
+
+    test('should recognize one image under several option sets', async () => {
+      await expect(MacOCR.recognizeFromPath(testImagePath, { optionSets: [] })).rejects.toThrow(
+        'Option sets must be a non-empty array of option objects'
+      );
+      await expect(MacOCR.recognizeFromPath(testImagePath, { optionSets: [{}, { candidates: 11 }] })).rejects.toThrow(
+        'Candidates must be an integer between 0 and 10'
+      );
+
+      const results = await MacOCR.recognizeFromPath(testImagePath, {
+        minConfidence: 0.1,
+        optionSets: [
+          { languages: 'en-US' },
+          { languages: 'zh-Hans,en-US', recognitionLevel: MacOCR.RECOGNITION_LEVEL_FAST },
+          { mode: 'detect' }
+        ]
+      });
+      expect(results).toHaveLength(3);
+      expect(results[0].text).toContain('MacOCR');
+      expect(results[1].text).toContain('MacOCR');
+      expect(results[2].text).toBe('');
+      expect(results[2].observations.length).toBeGreaterThan(0);
+
+      const buffer = fs.readFileSync(testImagePath);
+      const fromBuffer = await MacOCR.recognizeFromBuffer(buffer, { optionSets: [{}, { candidates: 2 }] });
+      expect(fromBuffer).toHaveLength(2);
+      expect(fromBuffer[1].observations[0].candidates.length).toBeGreaterThan(0);
+    });
+
+    test('should detect text boxes without recognizing them', async () => {
+      await expect(MacOCR.recognizeFromPath(testImagePath, { mode: 'read' })).rejects.toThrow(
+        "Mode must be 'recognize' or 'detect'"
+      );
+
+      const result = await MacOCR.recognizeFromPath(testImagePath, { mode: 'detect' });
+      expect(result.text).toBe('');
+      expect(result.observations.length).toBeGreaterThan(0);
+      expect(result.lines.length).toBeGreaterThan(0);
+      for (const obs of result.observations) {
+        expect(obs.text).toBe('');
+        expect(obs.width).toBeGreaterThan(0);
+        expect(obs.height).toBeGreaterThan(0);
+      }
+    });
+
+    test('should route Latin pages to the Latin languages', async () => {
+      const before = MacOCR.getRoutingStats();
+      const result = await MacOCR.recognizeFromPath(testImagePath, {
+        languages: 'en-US,zh-Hans,ja-JP,ko-KR',
+        routeLanguages: true
+      });
+      expect(result.text).toContain('MacOCR');
+      expect(result.routing.scripts).toEqual(['latin']);
+      expect(result.routing.languages).toBe('en-US');
+      expect(result.routing.probeMs).toBeGreaterThan(0);
+      expect(result.routing.recognizeMs).toBeGreaterThan(0);
+
+      // A single language has nothing to narrow
+      const single = await MacOCR.recognizeFromPath(testImagePath, { routeLanguages: true });
+      expect(single.routing).toBeNull();
+
+      const after = MacOCR.getRoutingStats();
+      expect(after.routed).toBe(before.routed + 1);
+      expect(after.narrowed).toBe(before.narrowed + 1);
+      expect(after.probeMs).toBeGreaterThan(before.probeMs);
+      expect(after.narrowedMegapixels).toBeGreaterThan(before.narrowedMegapixels);
+    });
+
+    test('should reuse pooled pixel buffers across images', async () => {
+      const before = MacOCR.getPixelPoolStats();
+      for (let i = 0; i < 2; i++) {
+        const result = await MacOCR.recognizeFromPath(testImagePath, { grayscale: true });
+        expect(result.text).toContain('MacOCR');
+      }
+      const after = MacOCR.getPixelPoolStats();
+      // Decode and preprocessing each take buffers; the second pass finds them cached
+      expect(after.acquired).toBeGreaterThanOrEqual(before.acquired + 4);
+      expect(after.reused).toBeGreaterThan(before.reused);
+      expect(after.highWaterBytes).toBeGreaterThan(0);
+      expect(after.reuseRate).toBeGreaterThan(0);
+    });
+
+    test('should probe image headers without decoding', async () => {
+      const { width, height } = await sharp(testImagePath).metadata();
+      const info = MacOCR.probe(testImagePath);
+      expect(info.format).toBe('png');
+      expect(info.width).toBe(width);
+      expect(info.height).toBe(height);
+      expect(info.frameCount).toBe(1);
+      expect(info.decodedBytes).toBeGreaterThanOrEqual(width * height * 4);
+
+      const jpeg = await sharp(testImagePath).jpeg().toBuffer();
+      const fromBuffer = MacOCR.probe(new Uint8Array(jpeg));
+      expect(fromBuffer.format).toBe('jpeg');
+      expect(fromBuffer.bitsPerComponent).toBe(8);
+      expect(fromBuffer.width).toBe(width);
+
+      expect(() => MacOCR.probe(Buffer.from('not an image'))).toThrow(expect.objectContaining({
+        message: 'Unsupported image format',
+        code: 'ERR_OCR_UNSUPPORTED_FORMAT'
+      }));
+      expect(() => MacOCR.probe(path.join(fixturesDir, 'missing.png'))).toThrow(expect.objectContaining({
+        code: 'ERR_OCR_FILE_NOT_FOUND'
+      }));
+      expect(() => MacOCR.probe(42)).toThrow('Input must be an image path, Buffer or Uint8Array');
+    });
+
     test('should perform OCR with default options', async () => {
       expect(fs.existsSync(testImagePath)).toBe(true);
       const result = await MacOCR.recognizeFromPath(testImagePath);
@@ -167,6 +477,22 @@ describe('MacOCR', () => {
         }
       }
     });
+    test('should answer region and nearest-neighbour queries', async () => {
+      expect(fs.existsSync(testImagePath)).toBe(true);
+      const result = await MacOCR.recognizeFromPath(testImagePath, { spatialIndex: true });
+      const { observations } = result;
+
+      expect(result.query({ x: 0, y: 0, width: 1, height: 1 })).toEqual(observations);
+      expect(result.query({ x: 2, y: 2, width: 1, height: 1 })).toEqual([]);
+
+      if (observations.length > 0) {
+        const obs = observations[0];
+        const center = { x: obs.x + obs.width / 2, y: obs.y + obs.height / 2 };
+        expect(result.nearest(center, 1)).toEqual([obs]);
+        expect(result.query({ x: center.x, y: center.y, width: 0, height: 0 })).toContain(obs);
+      }
+      expect(result.nearest({ x: 0.5, y: 0.5 }, observations.length + 5)).toHaveLength(observations.length);
+    });
   });
 
   describe('recognizeBatch()', () => {
@@ -209,9 +535,28 @@ describe('MacOCR', () => {
       );
     });
 
-    test('should throw Error if any image in batch does not exist', async () => {
+    test('should report a missing image in a batch on its own result', async () => {
       const paths = [...testImagePaths, 'nonexistent.jpg'];
-      await expect(MacOCR.recognizeBatchFromPath(paths)).rejects.toThrow();
+      const results = await MacOCR.recognizeBatchFromPath(paths);
+      expect(results).toHaveLength(paths.length);
+      expect(results[paths.length - 1].error.code).toBe('ERR_OCR_FILE_NOT_FOUND');
+      expect(results[0].error).toBeNull();
+    });
+
+    test('should reuse the result of near-duplicate images', async () => {
+      await expect(MacOCR.recognizeBatchFromPath(testImagePaths, { duplicateDistance: 65 })).rejects.toThrow(
+        'Duplicate distance must be an integer between 0 and 64'
+      );
+
+      const paths = [testImagePaths[0], testImagePaths[0], testImagePaths[1]];
+      const results = await MacOCR.recognizeBatchFromPath(paths, { skipDuplicates: true, maxThreads: 1 });
+      expect(results[0].duplicateOf).toBeNull();
+      expect(results[1].duplicateOf).toBe(0);
+      expect(results[1].text).toBe(results[0].text);
+      expect(results[1].observations).toHaveLength(results[0].observations.length);
+
+      const plain = await MacOCR.recognizeBatchFromPath(paths);
+      expect(plain.every(result => result.duplicateOf === null)).toBe(true);
     });
 
     test('should perform batch OCR with default options', async () => {
@@ -298,6 +643,23 @@ describe('MacOCR', () => {
       await expect(MacOCR.recognizeBatchFromPath(testImagePaths, invalidOptions)).rejects.toThrow();
     });
 
+    test('should admit a batch under a decoded-byte budget', async () => {
+      const before = MacOCR.getAdmissionStats();
+      // Smaller than any one image, so each runs alone
+      const results = await MacOCR.recognizeBatchFromPath(testImagePaths, { maxInFlightBytes: 1024, maxThreads: 4 });
+      expect(results.length).toBe(testImagePaths.length);
+      for (const result of results) {
+        expect(result.text.length).toBeGreaterThan(0);
+      }
+
+      const after = MacOCR.getAdmissionStats();
+      expect(after.batches).toBe(before.batches + 1);
+      expect(after.admitted).toBe(before.admitted + testImagePaths.length);
+      expect(after.peakInFlightBytes).toBeGreaterThan(0);
+
+      await expect(MacOCR.recognizeBatchFromPath(testImagePaths, { maxInFlightBytes: -1 })).rejects.toThrow('Maximum in-flight bytes');
+    });
+
     test('should process large batches efficiently', async () => {
       const largeImageCount = 10;
       const largeBatchPaths = [];
@@ -443,6 +805,12 @@ describe('MacOCR', () => {
       await expect(MacOCR.recognizeFromBuffer(new Uint8Array(10))).rejects.toThrow(Error);
     });
 
+    test('should set error.code for undecodable image data', async () => {
+      await expect(MacOCR.recognizeFromBuffer(Buffer.alloc(10))).rejects.toMatchObject({
+        code: 'ERR_OCR_DECODE_FAILED'
+      });
+    });
+
     test('should throw Error for empty buffer', async () => {
       await expect(MacOCR.recognizeFromBuffer(Buffer.alloc(0))).rejects.toThrow(
         'Image buffer cannot be empty'
@@ -586,6 +954,27 @@ describe('MacOCR', () => {
       await expect(MacOCR.recognizeBatchFromBuffer(undefined)).rejects.toThrow(TypeError);
     });
 
+    test('should report failed inputs per item without stalling the batch', async () => {
+      const corrupt = Array.from({ length: 8 }, () => Buffer.alloc(10));
+      const results = await MacOCR.recognizeBatchFromBuffer([...corrupt, ...testImageBuffers], {
+        maxThreads: 1,
+        maxRetries: 2
+      });
+
+      expect(results).toHaveLength(corrupt.length + testImageBuffers.length);
+      results.slice(0, corrupt.length).forEach(result => {
+        expect(result.text).toBeNull();
+        expect(result.error.code).toBe('ERR_OCR_DECODE_FAILED');
+        expect(result.attempts).toBe(1);
+      });
+      results.slice(corrupt.length).forEach(result => {
+        expect(result.error).toBeNull();
+        expect(typeof result.text).toBe('string');
+      });
+
+      await expect(MacOCR.recognizeBatchFromBuffer(testImageBuffers, { maxRetries: 11 })).rejects.toThrow('Maximum retries');
+    });
+
     test('should throw Error for empty array of image buffers', async () => {
       await expect(MacOCR.recognizeBatchFromBuffer([])).rejects.toThrow(
         'Image buffers array cannot be empty'
@@ -773,6 +1162,216 @@ describe('MacOCR', () => {
     });
   });
 
+  describe('findText()', () => {
+    let searchImagePaths = [];
+
+    beforeEach(async () => {
+      for (let i = 0; i < 3; i++) {
+        const uniqueName = `macocr-find-test-${uuidv4()}.png`;
+        searchImagePaths.push(await createTestImage(`Find item ${i + 1}`, uniqueName, { width: 400 }));
+      }
+    });
+
+    afterEach(async () => {
+      for (const imagePath of searchImagePaths) {
+        if (fs.existsSync(imagePath)) {
+          await fs.promises.unlink(imagePath);
+        }
+      }
+      searchImagePaths = [];
+    });
+
+    test('should validate arguments', async () => {
+      await expect(MacOCR.findText('not-an-array', 'x')).rejects.toThrow(TypeError);
+      await expect(MacOCR.findText([], 'x')).rejects.toThrow('Inputs array cannot be empty');
+      await expect(MacOCR.findText([123], 'x')).rejects.toThrow(TypeError);
+      await expect(MacOCR.findText(searchImagePaths, '')).rejects.toThrow(TypeError);
+      await expect(MacOCR.findText(searchImagePaths, 'x', { stopAfter: -1 })).rejects.toThrow('stopAfter');
+      // OCR options are validated as for a single image
+      await expect(MacOCR.findText(searchImagePaths, 'x', { ocrOptions: { minBoxSize: -1 } })).rejects.toThrow(
+        'Minimum box size must be between 0.0 and 1.0'
+      );
+    });
+
+    test('should return matches with their boxes', async () => {
+      const buffer = await fs.promises.readFile(searchImagePaths[2]);
+      const result = await MacOCR.findText([searchImagePaths[0], searchImagePaths[1], buffer], 'ITEM 2', {
+        caseInsensitive: true,
+      });
+
+      expect(result.processed + result.failed + result.skipped).toBe(3);
+      expect(result.skipped).toBe(0);
+      for (const match of result.matches) {
+        expect(match.index).toBe(1);
+        expect(match.text.substr(match.start, match.length).toLowerCase()).toBe('item 2');
+        expect(match.width).toBeGreaterThan(0);
+        expect(match.height).toBeGreaterThan(0);
+      }
+    });
+
+    test('should support regular expressions and stop early', async () => {
+      const result = await MacOCR.findText(searchImagePaths, 'item\\s+\\d', {
+        regex: true,
+        caseInsensitive: true,
+        stopAfter: 1,
+        maxThreads: 1,
+      });
+
+      expect(result.matches.length).toBeLessThanOrEqual(1);
+      expect(result.processed + result.failed + result.skipped).toBe(3);
+      if (result.matches.length === 1) {
+        expect(result.matches[0].index).toBe(0);
+      }
+    });
+
+    test('should reject invalid regular expressions', async () => {
+      await expect(MacOCR.findText(searchImagePaths, '(', { regex: true })).rejects.toThrow('Text search failed');
+    });
+  });
+
+  describe('buildIndex() / openIndex()', () => {
+    let indexImagePaths = [];
+    let indexPath;
+
+    beforeEach(async () => {
+      const texts = ['Invoice alpha', 'Receipt beta', 'Invoice gamma'];
+      for (const text of texts) {
+        const uniqueName = `macocr-index-test-${uuidv4()}.png`;
+        indexImagePaths.push(await createTestImage(text, uniqueName, { width: 400 }));
+      }
+      indexPath = path.join(fixturesDir, `macocr-index-${uuidv4()}.idx`);
+    });
+
+    afterEach(async () => {
+      for (const filePath of [...indexImagePaths, indexPath]) {
+        if (fs.existsSync(filePath)) {
+          await fs.promises.unlink(filePath);
+        }
+      }
+      indexImagePaths = [];
+    });
+
+    test('should validate arguments', async () => {
+      await expect(MacOCR.buildIndex('not-an-array', indexPath)).rejects.toThrow(TypeError);
+      await expect(MacOCR.buildIndex([], indexPath)).rejects.toThrow('Inputs array cannot be empty');
+      await expect(MacOCR.buildIndex(indexImagePaths, '')).rejects.toThrow(TypeError);
+      expect(() => MacOCR.openIndex(path.join(fixturesDir, 'missing.idx'))).toThrow(expect.objectContaining({
+        message: expect.stringContaining('Failed to open index'),
+        code: 'ERR_OCR_FILE_NOT_FOUND'
+      }));
+    });
+
+    test('should reject an index whose section sizes overflow', async () => {
+      // Header, one term and a one-byte string table; the posting count times the 12-byte
+      // posting size wraps to 8 bytes, and the term claims postings far past the file
+      const file = Buffer.alloc(89);
+      file.write('OCRIDX01', 0, 'latin1');
+      file.writeUInt32LE(1, 8);
+      file.writeUInt32LE(1, 12);
+      file.writeBigUInt64LE((2n ** 64n + 8n) / 12n, 16);
+      file.writeBigUInt64LE(56n, 24);
+      file.writeBigUInt64LE(80n, 32);
+      file.writeBigUInt64LE(88n, 40);
+      file.writeBigUInt64LE(1n, 48);
+      file.writeUInt32LE(0, 56);
+      file.writeUInt32LE(1, 60);
+      file.writeBigUInt64LE(0n, 64);
+      file.writeUInt32LE(100000, 72);
+      file.write('a', 88, 'latin1');
+      await fs.promises.writeFile(indexPath, file);
+
+      expect(() => MacOCR.openIndex(indexPath)).toThrow(expect.objectContaining({
+        message: expect.stringContaining('Invalid index file'),
+        code: 'ERR_OCR_INDEX_CORRUPT'
+      }));
+    });
+
+    test('should index recognized text and search it', async () => {
+      const stats = await MacOCR.buildIndex(indexImagePaths, indexPath);
+      expect(stats.documents + stats.failed).toBe(3);
+      expect(fs.existsSync(indexPath)).toBe(true);
+
+      const index = MacOCR.openIndex(indexPath);
+      try {
+        if (stats.documents === 3) {
+          expect(index.search('invoice')).toEqual([0, 2]);
+          expect(index.search('INVOICE gamma')).toEqual([2]);
+          expect(index.search('invoice beta')).toEqual([]);
+
+          const postings = index.lookup('receipt');
+          expect(postings.length).toBeGreaterThan(0);
+          expect(postings[0].image).toBe(1);
+        }
+        expect(index.lookup('missingterm')).toEqual([]);
+      } finally {
+        index.close();
+      }
+      expect(() => index.search('invoice')).toThrow('Index is closed');
+    });
+  });
+
+  describe('createFrameSession()', () => {
+    test('should reject invalid tile sizes', () => {
+      expect(() => MacOCR.createFrameSession({ tileSize: 4 })).toThrow(
+        'Tile size must be an integer between 8 and 1024'
+      );
+    });
+
+    test('should reject options that only apply to whole images', () => {
+      for (const options of [{ rejectBlank: true }, { grayscale: true }, { preprocessScale: 0.5 }, { pyramid: true },
+        { autoRotate: true }, { routeLanguages: true }]) {
+        expect(() => MacOCR.createFrameSession(options)).toThrow(expect.objectContaining({
+          code: 'ERR_OCR_INVALID_ARGUMENT'
+        }));
+      }
+    });
+
+    test('should find boxes in changed regions without reading them in detect mode', async () => {
+      const session = MacOCR.createFrameSession({ mode: 'detect' });
+      try {
+        const first = await session.recognize(testImagePath);
+        expect(first.observations.length).toBeGreaterThan(0);
+        expect(first.text).toBe('');
+        first.observations.forEach(obs => expect(obs.text).toBe(''));
+      } finally {
+        session.close();
+      }
+    });
+
+    test('should carry unchanged observations forward between frames', async () => {
+      const session = MacOCR.createFrameSession();
+      const otherPath = await createTestImage('Frame changed', `macocr-frame-${uuidv4()}.png`);
+      try {
+        const first = await session.recognize(testImagePath);
+        expect(first.text).toContain('MacOCR');
+        expect(first.delta.fullFrame).toBe(true);
+        expect(first.delta.added.length).toBe(first.observations.length);
+
+        // An identical frame compares equal in every tile and recognizes nothing
+        const same = await session.recognize(fs.readFileSync(testImagePath));
+        expect(same.delta.changedTiles).toBe(0);
+        expect(same.delta.regions).toHaveLength(0);
+        expect(same.delta.added).toHaveLength(0);
+        expect(same.delta.carried).toBe(first.observations.length);
+        expect(same.text).toBe(first.text);
+
+        const changed = await session.recognize(otherPath);
+        expect(changed.delta.changedTiles).toBeGreaterThan(0);
+        expect(changed.delta.removed.length).toBeGreaterThan(0);
+        expect(changed.text).toContain('Frame');
+
+        await session.reset();
+        const reset = await session.recognize(otherPath);
+        expect(reset.delta.fullFrame).toBe(true);
+      } finally {
+        session.close();
+        await fs.promises.unlink(otherPath);
+      }
+
+      await expect(session.recognize(testImagePath)).rejects.toThrow('Frame session is closed');
+    });
+  });
+
   describe('Precise Coordinate Validation', () => {
     let testImageData;
 
@@ -902,6 +1501,79 @@ describe('MacOCR', () => {
         }
       }
     });
+
+    test('should reconstruct lines and paragraphs in reading order', async () => {
+      const result = await MacOCR.recognizeFromPath(testImageData.imagePath);
+      const { observations, lines, paragraphs, columns } = result;
+
+      expect(Array.isArray(lines)).toBe(true);
+      expect(Array.isArray(paragraphs)).toBe(true);
+      expect(Array.isArray(columns)).toBe(true);
+
+      // Every observation belongs to exactly one line, lines to paragraphs, paragraphs to columns
+      expect(lines.reduce((sum, line) => sum + line.count, 0)).toBe(observations.length);
+      expect(paragraphs.reduce((sum, paragraph) => sum + paragraph.count, 0)).toBe(lines.length);
+      expect(columns.reduce((sum, column) => sum + column.count, 0)).toBe(paragraphs.length);
+
+      const top = result.text.indexOf('TOP');
+      const bottom = result.text.indexOf('BOTTOM');
+      if (top >= 0 && bottom >= 0) {
+        // Separate lines are joined with newlines, top of the page first
+        expect(top).toBeLessThan(bottom);
+        expect(result.text.slice(top, bottom)).toContain('\n');
+      }
+    });
+  });
+
+  describe('Table Reconstruction', () => {
+    let tableImage;
+
+    beforeEach(async () => {
+      const textBlocks = [];
+      ['Item', 'Qty', 'Price'].forEach((header, column) => {
+        textBlocks.push({ text: header, x: 40 + column * 160, y: 40, fontSize: 24 });
+      });
+      [['Apple', '3', '1.50'], ['Pear', '12', '0.75']].forEach((row, r) => {
+        row.forEach((text, column) => {
+          textBlocks.push({ text, x: 40 + column * 160, y: 110 + r * 70, fontSize: 24 });
+        });
+      });
+
+      const uniqueName = `table-test-${uuidv4()}.png`;
+      tableImage = await createPrecisionTestImage(textBlocks, uniqueName, { width: 520, height: 300 });
+    });
+
+    afterEach(async () => {
+      if (tableImage?.imagePath && fs.existsSync(tableImage.imagePath)) {
+        await fs.promises.unlink(tableImage.imagePath);
+      }
+    });
+
+    test('should return a cell grid covering every observation', async () => {
+      const result = await MacOCR.recognizeFromPath(tableImage.imagePath, { detectTable: true });
+      const { observations, table } = result;
+
+      expect(table).not.toBeNull();
+      expect(table.rows.length).toBeGreaterThan(0);
+      expect(table.columns.length).toBeGreaterThan(0);
+
+      const ids = table.cells.flatMap((cell) => cell.observations).sort((a, b) => a - b);
+      expect(ids).toEqual(observations.map((_, i) => i));
+      for (const cell of table.cells) {
+        expect(cell.row).toBeLessThan(table.rows.length);
+        expect(cell.column + cell.columnSpan).toBeLessThanOrEqual(table.columns.length);
+      }
+
+      if (observations.length === 9) {
+        expect(table.rows).toHaveLength(3);
+        expect(table.columns).toHaveLength(3);
+      }
+    });
+
+    test('should not compute a table unless requested', async () => {
+      const result = await MacOCR.recognizeFromPath(tableImage.imagePath);
+      expect(result.table).toBeNull();
+    });
   });
 
   describe('Coordinate System Validation', () => {